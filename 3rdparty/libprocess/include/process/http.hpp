@@ -393,6 +393,12 @@ public:
     // was unable to continue reading!
     Future<Nothing> readerClosed() const;
 
+    // Returns Nothing once the reader has read all of the data
+    // written to the pipe so far. This lets a writer pace itself
+    // on a slow reader rather than buffering unbounded data in the
+    // pipe. Fails if the read-end of the pipe is closed first.
+    Future<Nothing> drained() const;
+
     // Comparison operators useful for checking connection equality.
     bool operator==(const Writer& other) const { return data == other.data; }
     bool operator!=(const Writer& other) const { return !(*this == other); }
@@ -440,6 +446,9 @@ private:
     // empty strings as they serve as a signal for end-of-file.
     std::queue<std::string> writes;
 
+    // Represents writers waiting for the unread writes to be read.
+    std::queue<Owned<Promise<Nothing>>> drains;
+
     // Signals when the read-end is closed before the write-end.
     Promise<Nothing> readerClosure;
 
@@ -14,6 +14,12 @@
 #define __PROCESS_POSIX_SUBPROCESS_HPP__
 
 #ifdef __linux__
+#include <limits.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+
+#include <sys/mman.h>
 #include <sys/prctl.h>
 #endif // __linux__
 #include <sys/types.h>
@@ -70,6 +76,164 @@ inline pid_t defaultClone(const lambda::function<int()>& func)
 
 namespace internal {
 
+#ifdef __linux__
+// Arguments of `vforkMain`, which live on the stack of the parent.
+struct VforkArgs
+{
+  const lambda::function<int()>* func;
+  const sigset_t* mask;
+};
+
+
+// The entry of a child created by `vforkClone`.
+//
+// NOTE: This function has to be async signal safe.
+inline int vforkMain(void* _args)
+{
+  const VforkArgs* args = static_cast<const VforkArgs*>(_args);
+
+  // Reset the signal handlers of the parent, which would otherwise
+  // run in the child on the memory of the parent, before unblocking
+  // the signals that were blocked across the clone.
+  for (int signal = 1; signal < NSIG; signal++) {
+    struct sigaction action;
+    if (::sigaction(signal, nullptr, &action) == 0 &&
+        action.sa_handler != SIG_DFL &&
+        action.sa_handler != SIG_IGN) {
+      action.sa_handler = SIG_DFL;
+      ::sigaction(signal, &action, nullptr);
+    }
+  }
+
+  ::sigprocmask(SIG_SETMASK, args->mask, nullptr);
+
+  ::_exit((*args->func)());
+}
+
+
+// Like `defaultClone`, but creates the child with
+// `clone(CLONE_VM | CLONE_VFORK)` so that the page tables of the
+// parent are not copied, which is what makes forking from a parent
+// with a large address space (e.g., the agent) slow. The calling
+// thread is suspended until the child exec's or exits.
+//
+// NOTE: Until it exec's, the child shares the memory of the parent,
+// so 'func' must not modify any memory of the parent and must not
+// wait for the parent. The child runs on a stack of its own.
+inline pid_t vforkClone(const lambda::function<int()>& func)
+{
+  // NOTE: The stack only needs to be large enough for `childMain`
+  // and exec, we guard its end to fail safely if it is not.
+  const size_t size = 1024 * 1024;
+  const size_t guard = os::pagesize();
+
+  void* stack = ::mmap(
+      nullptr,
+      size,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+      -1,
+      0);
+
+  if (stack == MAP_FAILED) {
+    return -1;
+  }
+
+  if (::mprotect(stack, guard, PROT_NONE) != 0) {
+    const int error = errno;
+    ::munmap(stack, size);
+    errno = error;
+    return -1;
+  }
+
+  // Block all signals so that no signal handler of the parent runs
+  // in the child before it has reset them (see `vforkMain`).
+  sigset_t all;
+  sigset_t mask;
+  ::sigfillset(&all);
+  ::pthread_sigmask(SIG_SETMASK, &all, &mask);
+
+  VforkArgs args = {&func, &mask};
+
+  pid_t pid = ::clone(
+      &vforkMain,
+      static_cast<char*>(stack) + size, // The stack grows down.
+      CLONE_VM | CLONE_VFORK | SIGCHLD,
+      &args);
+
+  // NOTE: We only look at 'errno' if the clone failed, otherwise it
+  // might have been set by the child (which shares it with us).
+  const int error = errno;
+
+  ::pthread_sigmask(SIG_SETMASK, &mask, nullptr);
+  ::munmap(stack, size);
+
+  errno = error;
+  return pid;
+}
+
+
+// Like `os::execvpe`, but looks up 'file' in the PATH of 'envp'
+// without setting 'environ', which a child created by `vforkClone`
+// shares with the parent.
+//
+// NOTE: This function is async signal safe.
+inline int execvpe(const char* file, char** argv, char** envp)
+{
+  if (::strchr(file, '/') != nullptr) {
+    return ::execvpe(file, argv, envp);
+  }
+
+  // Same as 'execvp' if there is no PATH.
+  const char* path = "/bin:/usr/bin";
+  for (char** entry = envp; *entry != nullptr; entry++) {
+    if (::strncmp(*entry, "PATH=", 5) == 0) {
+      path = *entry + 5;
+      break;
+    }
+  }
+
+  const size_t length = ::strlen(file);
+  bool denied = false;
+
+  char candidate[PATH_MAX];
+
+  while (true) {
+    const char* end = ::strchrnul(path, ':');
+
+    // An empty entry denotes the current directory.
+    const char* directory = end == path ? "." : path;
+    const size_t size = end == path ? 1 : end - path;
+
+    if (size + 1 + length < sizeof(candidate)) {
+      ::memcpy(candidate, directory, size);
+      candidate[size] = '/';
+      ::memcpy(candidate + size + 1, file, length + 1);
+
+      // NOTE: Since 'candidate' contains a '/', this does not look at
+      // the PATH of 'environ'.
+      ::execvpe(candidate, argv, envp);
+
+      if (errno == EACCES) {
+        denied = true;
+      } else if (errno != ENOENT && errno != ENOTDIR) {
+        return -1;
+      }
+    }
+
+    if (*end == '\0') {
+      break;
+    }
+
+    path = end + 1;
+  }
+
+  errno = denied ? EACCES : ENOENT;
+  return -1;
+}
+#endif // __linux__
+
+
 // This function will invoke `os::close` on all specified file
 // descriptors that are valid (i.e., not `None` and >= 0).
 inline void close(
@@ -302,9 +466,28 @@ inline int childMain(
     watchdogProcess();
   }
 
+#ifdef __linux__
+  internal::execvpe(path.c_str(), argv, envp);
+#else
   os::execvpe(path.c_str(), argv, envp);
+#endif // __linux__
+
+  // NOTE: The child may share the parent's memory (see `CLONE_VM`
+  // above), so we must not allocate here. Write a fixed message and
+  // exit with the `errno` of the failed exec.
+  const int error = errno;
+
+  const char message[] = "Failed to os::execvpe on path '";
+  const char suffix[] = "'\n";
 
-  ABORT("Failed to os::execvpe on path '" + path + "': " + os::strerror(errno));
+  while (::write(STDERR_FILENO, message, sizeof(message) - 1) == -1 &&
+         errno == EINTR);
+  while (::write(STDERR_FILENO, path.c_str(), path.size()) == -1 &&
+         errno == EINTR);
+  while (::write(STDERR_FILENO, suffix, sizeof(suffix) - 1) == -1 &&
+         errno == EINTR);
+
+  ::_exit(error);
 }
 
 
@@ -351,15 +534,24 @@ inline Try<pid_t> cloneChild(
     envp[index] = nullptr;
   }
 
+  // Currently we will block the child's execution of the new process
+  // until all the `parent_hooks` (if any) have executed.
+  int pipes[2];
+  const bool blocking = !parent_hooks.empty();
+
   // Determine the function to clone the child process. If the user
   // does not specify the clone function, we will use the default.
   lambda::function<pid_t(const lambda::function<int()>&)> clone =
     (_clone.isSome() ? _clone.get() : defaultClone);
 
-  // Currently we will block the child's execution of the new process
-  // until all the `parent_hooks` (if any) have executed.
-  int pipes[2];
-  const bool blocking = !parent_hooks.empty();
+#ifdef __linux__
+  // If nothing has to run in the parent before the child exec's, and
+  // the child does not stay around as a watchdog without exec'ing, we
+  // can avoid copying the page tables of the parent.
+  if (_clone.isNone() && !blocking && watchdog == NO_MONITOR) {
+    clone = vforkClone;
+  }
+#endif // __linux__
 
   if (blocking) {
     // We assume this should not fail under reasonable conditions so we
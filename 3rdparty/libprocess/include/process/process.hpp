@@ -15,7 +15,9 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <queue>
 #include <vector>
 
@@ -39,6 +41,7 @@
 namespace process {
 
 // Forward declaration.
+class EventQueue;
 class Logging;
 class Sequence;
 
@@ -357,18 +360,12 @@ protected:
   /**
    * Returns the number of events of the given type currently on the event
    * queue.
+   *
+   * Only specialized for `MessageEvent`, `DispatchEvent`, `HttpEvent`,
+   * `ExitedEvent` and `TerminateEvent`.
    */
   template <typename T>
-  size_t eventCount()
-  {
-    size_t count = 0U;
-
-    synchronized (mutex) {
-      count = std::count_if(events.begin(), events.end(), isEventType<T>);
-    }
-
-    return count;
-  }
+  size_t eventCount();
 
 private:
   friend class SocketManager;
@@ -377,7 +374,7 @@ private:
   friend void* schedule(void*);
 
   // Process states.
-  enum
+  enum State
   {
     BOTTOM,
     READY,
@@ -385,17 +382,12 @@ private:
     BLOCKED,
     TERMINATING,
     TERMINATED
-  } state;
-
-  template <typename T>
-  static bool isEventType(const Event* event)
-  {
-    return event->is<T>();
-  }
+  };
 
-  // Mutex protecting internals.
-  // TODO(benh): Consider replacing with a spinlock, on multi-core systems.
-  std::recursive_mutex mutex;
+  // NOTE: the state is atomic rather than protected by a lock so that
+  // events can be enqueued without locking, see `ProcessBase::enqueue`
+  // and `ProcessManager::resume` for the transitions.
+  std::atomic<State> state;
 
   // Enqueue the specified message, request, or function call.
   void enqueue(Event* event, bool inject = false);
@@ -446,17 +438,43 @@ private:
   // Static assets(s) to provide.
   std::map<std::string, Asset> assets;
 
-  // Queue of received events, requires lock()ed access!
-  std::deque<Event*> events;
+  // Queue of received events, lock-free for producers but must only
+  // be dequeued from by the thread running this process.
+  std::unique_ptr<EventQueue> events;
 
   // Active references.
   std::atomic_long refs;
 
+  // Index of the processing thread that last ran this process (or -1
+  // if it has not run yet). Used as a hint for which run queue to
+  // enqueue the process on when work stealing is enabled.
+  std::atomic_long affinity;
+
   // Process PID.
   UPID pid;
 };
 
 
+template <>
+size_t ProcessBase::eventCount<MessageEvent>();
+
+
+template <>
+size_t ProcessBase::eventCount<DispatchEvent>();
+
+
+template <>
+size_t ProcessBase::eventCount<HttpEvent>();
+
+
+template <>
+size_t ProcessBase::eventCount<ExitedEvent>();
+
+
+template <>
+size_t ProcessBase::eventCount<TerminateEvent>();
+
+
 template <typename T>
 class Process : public virtual ProcessBase {
 public:
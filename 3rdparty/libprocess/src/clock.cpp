@@ -31,6 +31,7 @@
 #include <stout/unreachable.hpp>
 
 #include "event_loop.hpp"
+#include "timer_wheel.hpp"
 
 using std::list;
 using std::map;
@@ -39,10 +40,9 @@ using std::set;
 
 namespace process {
 
-// We store the timers in a map of lists indexed by the timeout of the
-// timer so that we can have two timers that have the same timeout. We
-// exploit that the map is SORTED!
-static map<Time, list<Timer>>* timers = new map<Time, list<Timer>>();
+// We store the timers in a hierarchical timing wheel so that creating
+// and canceling a timer takes constant time (see 'TimerWheel').
+static TimerWheel* timers = new TimerWheel();
 static recursive_mutex* timers_mutex = new recursive_mutex();
 
 
@@ -83,26 +83,26 @@ set<Time>* ticks = new set<Time>();
 // so that it's clear from the callsite that the use of 'timers' is
 // within a 'synchronized' block.
 //
-// TODO(benh): Create a generic 'Timers' abstraction which hides this
-// and more away (i.e., all manipulations of 'timers' below).
-Option<Time> next(const map<Time, list<Timer>>& timers)
+// NOTE: The time returned might be before the time the next timer
+// actually elapses (see 'TimerWheel::next'), in which case the 'tick'
+// at that time just turns the wheel and schedules the next 'tick'.
+Option<Time> next(TimerWheel* timers)
 {
-  if (!timers.empty()) {
-    Time first = timers.begin()->first;
+  const Option<Time> first = timers->next();
+
+  if (first.isSome()) {
 
     // If the clock is paused and no timers are expired, the
     // timers cannot fire until the clock is advanced, so we
     // return None() here. Note that we pass nullptr to ensure
     // that this looks at the global clock, since this can be
     // called from a Process context through Clock::timer.
-    if (Clock::paused() && first > Clock::now(nullptr)) {
+    if (Clock::paused() && first.get() > Clock::now(nullptr)) {
       return None();
     }
-
-    return first;
   }
 
-  return None();
+  return first;
 }
 
 
@@ -116,7 +116,7 @@ void tick(const Time& time);
 // a 'synchronized' block.
 // TODO(bmahler): Consider taking an optional 'now' to avoid
 // excessive syscalls via Clock::now(nullptr).
-void scheduleTick(const map<Time, list<Timer>>& timers, set<Time>* ticks)
+void scheduleTick(TimerWheel* timers, set<Time>* ticks)
 {
   // Determine when the next 'tick' should fire.
   const Option<Time> next = clock::next(timers);
@@ -151,12 +151,10 @@ void tick(const Time& time)
 
     VLOG(3) << "Handling timers up to " << now;
 
-    foreachkey (const Time& timeout, *timers) {
-      if (timeout > now) {
-        break;
-      }
+    timedout = timers->expire(now);
 
-      VLOG(3) << "Have timeout(s) at " << timeout;
+    if (!timedout.empty()) {
+      VLOG(3) << "Have " << timedout.size() << " timeout(s)";
 
       // Need to toggle 'settling' so that we don't prematurely say
       // we're settled until after the timers are executed below,
@@ -164,15 +162,10 @@ void tick(const Time& time)
       if (clock::paused) {
         clock::settling = true;
       }
-
-      timedout.splice(timedout.end(), (*timers)[timeout]);
     }
 
-    // Now erase the range of timers that timed out.
-    timers->erase(timers->begin(), timers->upper_bound(now));
-
     // Okay, so the timeout for the next timer should not have fired.
-    CHECK(timers->empty() || (timers->begin()->first > now));
+    CHECK(timers->next().isNone() || timers->next().get() > now);
 
     // Remove this tick from the scheduled 'ticks', it may have
     // been removed already if the clock was paused / manipulated
@@ -180,7 +173,7 @@ void tick(const Time& time)
     ticks->erase(time);
 
     // Schedule another "tick" if necessary.
-    scheduleTick(*timers, ticks);
+    scheduleTick(timers, ticks);
   }
 
   (*clock::callback)(timedout);
@@ -190,8 +183,8 @@ void tick(const Time& time)
   // executing expired timers.
   synchronized (timers_mutex) {
     if (clock::paused &&
-        (timers->size() == 0 ||
-         timers->begin()->first > *clock::current)) {
+        (timers->next().isNone() ||
+         timers->next().get() > *clock::current)) {
       VLOG(3) << "Clock has settled";
       clock::settling = false;
     }
@@ -219,7 +212,7 @@ void Clock::finalize()
     // This, along with the `timers_mutex`, is all that is required to clean
     // up any pending timers.  Timers are triggered via "ticks".  However,
     // we do not need to clear `ticks` because a "tick" with an empty `timers`
-    // map will effectively be a no-op.
+    // wheel will effectively be a no-op.
     timers->clear();
   }
 }
@@ -279,17 +272,13 @@ Timer Clock::timer(
 
   // Add the timer.
   synchronized (timers_mutex) {
-    if (timers->size() == 0 ||
-        timer.timeout().time() < timers->begin()->first) {
-      // Need to interrupt the loop to update/set timer repeat.
-      (*timers)[timer.timeout().time()].push_back(timer);
+    const Option<Time> next = timers->next();
 
-      // Schedule another "tick" if necessary.
-      clock::scheduleTick(*timers, clock::ticks);
-    } else {
-      // Timer repeat is adequate, just add the timeout.
-      CHECK(timers->size() >= 1);
-      (*timers)[timer.timeout().time()].push_back(timer);
+    timers->add(timer.id, timer);
+
+    if (next.isNone() || timer.timeout().time() < next.get()) {
+      // Need to interrupt the loop to update/set timer repeat.
+      clock::scheduleTick(timers, clock::ticks);
     }
   }
 
@@ -301,17 +290,8 @@ bool Clock::cancel(const Timer& timer)
 {
   bool canceled = false;
   synchronized (timers_mutex) {
-    // Check if the timeout is still pending, and if so, erase it. In
-    // addition, erase an empty list if we just removed the last
-    // timeout.
-    Time time = timer.timeout().time();
-    if (timers->count(time) > 0) {
-      canceled = true;
-      (*timers)[time].remove(timer);
-      if ((*timers)[time].empty()) {
-        timers->erase(time);
-      }
-    }
+    // Check if the timer is still pending, and if so, remove it.
+    canceled = timers->remove(timer.id);
   }
 
   return canceled;
@@ -363,7 +343,7 @@ void Clock::resume()
       clock::currents->clear();
 
       // Schedule another "tick" if necessary.
-      clock::scheduleTick(*timers, clock::ticks);
+      clock::scheduleTick(timers, clock::ticks);
     }
   }
 }
@@ -381,7 +361,7 @@ void Clock::advance(const Duration& duration)
       // Schedule another "tick" if necessary. Only "ticks" that
       // fire immediately will be scheduled here, since the clock
       // is paused.
-      clock::scheduleTick(*timers, clock::ticks);
+      clock::scheduleTick(timers, clock::ticks);
     }
   }
 }
@@ -418,7 +398,7 @@ void Clock::update(const Time& time)
         // Schedule another "tick" if necessary. Only "ticks" that
         // fire immediately will be scheduled here, since the clock
         // is paused.
-        clock::scheduleTick(*timers, clock::ticks);
+        clock::scheduleTick(timers, clock::ticks);
       }
     }
   }
@@ -458,8 +438,8 @@ bool Clock::settled()
     if (clock::settling) {
       VLOG(3) << "Clock still not settled";
       return false;
-    } else if (timers->size() == 0 ||
-               timers->begin()->first > *clock::current) {
+    } else if (timers->next().isNone() ||
+               timers->next().get() > *clock::current) {
       VLOG(3) << "Clock is settled";
       return true;
     }
@@ -22,13 +22,17 @@
 #include <vector>
 
 #include <process/http.hpp>
+#include <process/message.hpp>
+#include <process/pid.hpp>
 #include <process/socket.hpp>
 
+#include <stout/check.hpp>
 #include <stout/foreach.hpp>
 #include <stout/gzip.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
 
+#include "encoder.hpp"
 
 #if !(HTTP_PARSER_VERSION_MAJOR >= 2)
 #error HTTP Parser version >= 2 required.
@@ -42,8 +46,16 @@ namespace process {
 class DataDecoder
 {
 public:
-  explicit DataDecoder(const network::Socket& _s)
-    : s(_s), failure(false), request(nullptr)
+  // Requests to upgrade the connection to binary framed messages are
+  // only honored if `_binary_framing` is set, otherwise they are
+  // decoded like any other HTTP request.
+  explicit DataDecoder(
+      const network::Socket& _s,
+      bool _binary_framing = false)
+    : s(_s),
+      binary_framing(_binary_framing),
+      failure(false),
+      request(nullptr)
   {
     settings.on_message_begin = &DataDecoder::on_message_begin;
     settings.on_url = &DataDecoder::on_url;
@@ -62,8 +74,24 @@ public:
 
   std::deque<http::Request*> decode(const char* data, size_t length)
   {
+    CHECK_NONE(remainder) << "Decoding data after an upgrade";
+
     size_t parsed = http_parser_execute(&parser, &settings, data, length);
 
+    // The parser stops after a request that upgrades the connection,
+    // if it's an upgrade to binary framed messages we keep the data
+    // that follows it (if any) for the caller to decode.
+    if (binary_framing && parser.upgrade && !requests.empty()) {
+      Option<std::string> upgrade = requests.back()->headers.get("Upgrade");
+      if (upgrade.isSome() && upgrade.get() == BINARY_FRAMING) {
+        delete requests.back();
+        requests.pop_back();
+
+        remainder = std::string(data + parsed, length - parsed);
+        parsed = length;
+      }
+    }
+
     if (parsed != length) {
       // TODO(bmahler): joyent/http-parser exposes error reasons.
       failure = true;
@@ -83,6 +111,15 @@ public:
     return failure;
   }
 
+  // Returns the data that followed a request upgrading the connection
+  // to binary framed messages (see `UpgradeEncoder`), or
+  // none if there was no such request. Any subsequent data must be
+  // decoded with a `MessageDecoder`.
+  const Option<std::string>& upgraded() const
+  {
+    return remainder;
+  }
+
   network::Socket socket() const
   {
     return s;
@@ -250,6 +287,8 @@ private:
 
   const network::Socket s; // The socket this decoder is associated with.
 
+  const bool binary_framing;
+
   bool failure;
 
   http_parser parser;
@@ -269,6 +308,100 @@ private:
   http::Request* request;
 
   std::deque<http::Request*> requests;
+
+  Option<std::string> remainder;
+};
+
+
+// Decodes binary framed messages (see `MessageEncoder::frame`).
+class MessageDecoder
+{
+public:
+  explicit MessageDecoder(const network::Socket& _s)
+    : s(_s), failure(false) {}
+
+  std::deque<Message*> decode(const char* data, size_t length)
+  {
+    buffer.append(data, length);
+
+    std::deque<Message*> messages;
+
+    size_t index = 0;
+
+    while (buffer.size() - index >= BINARY_FRAME_HEADER_SIZE) {
+      const char* header = buffer.data() + index;
+
+      const size_t name = read(header);
+      const size_t from = read(header + sizeof(uint32_t));
+      const size_t to = read(header + 2 * sizeof(uint32_t));
+      const size_t body = read(header + 3 * sizeof(uint32_t));
+
+      const size_t size = BINARY_FRAME_HEADER_SIZE + name + from + to + body;
+
+      // Do not buffer a frame that is larger than any peer would send.
+      if (size > BINARY_FRAME_MAX_SIZE) {
+        failure = true;
+        break;
+      }
+
+      if (buffer.size() - index < size) {
+        break;
+      }
+
+      const char* payload = header + BINARY_FRAME_HEADER_SIZE;
+
+      // A malformed 'from' or 'to' means we've lost track of the frames.
+      const UPID sender(std::string(payload + name, from));
+      const UPID receiver(std::string(payload + name + from, to));
+
+      if (!sender || !receiver) {
+        failure = true;
+        break;
+      }
+
+      Message* message = new Message();
+      message->name.assign(payload, name);
+      message->from = sender;
+      message->to = receiver;
+      message->body.assign(payload + name + from + to, body);
+
+      messages.push_back(message);
+
+      index += size;
+    }
+
+    // Only keep the data of a partially received frame.
+    buffer.erase(0, index);
+
+    return messages;
+  }
+
+  bool failed() const
+  {
+    return failure;
+  }
+
+  network::Socket socket() const
+  {
+    return s;
+  }
+
+private:
+  static size_t read(const char* data)
+  {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+    return (static_cast<uint32_t>(bytes[0]) << 24) |
+           (static_cast<uint32_t>(bytes[1]) << 16) |
+           (static_cast<uint32_t>(bytes[2]) << 8) |
+           static_cast<uint32_t>(bytes[3]);
+  }
+
+  const network::Socket s; // The socket this decoder is associated with.
+
+  bool failure;
+
+  std::string buffer;
 };
 
 
@@ -16,8 +16,10 @@
 #include <stdint.h>
 #include <time.h>
 
+#include <limits>
 #include <map>
 #include <sstream>
+#include <string>
 
 #include <process/http.hpp>
 #include <process/process.hpp>
@@ -27,6 +29,7 @@
 #include <stout/hashmap.hpp>
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
+#include <stout/stringify.hpp>
 
 
 namespace process {
@@ -104,11 +107,46 @@ private:
 };
 
 
+// The value of the 'Libprocess-Framing' header with which libprocess
+// advertises that it can decode binary framed messages, and of the
+// 'Upgrade' header of the request that switches a connection over to
+// them (see `UpgradeEncoder`).
+const char BINARY_FRAMING[] = "libprocess-binary/1";
+
+// The size of the header of a binary frame, i.e., the lengths of the
+// name, 'from', 'to' and body of the message, each of which is a 32
+// bit unsigned integer in network byte order.
+const size_t BINARY_FRAME_HEADER_SIZE = 4 * sizeof(uint32_t);
+
+// The maximum size of a binary frame (including its header). This
+// bounds the data that a peer can make us buffer for a single frame,
+// a decoder fails if it receives the header of a larger frame.
+const size_t BINARY_FRAME_MAX_SIZE = 256 * 1024 * 1024;
+
+
 class MessageEncoder : public DataEncoder
 {
 public:
-  MessageEncoder(const network::Socket& s, Message* _message)
-    : DataEncoder(s, encode(_message)), message(_message) {}
+  // How a message gets framed on the wire. Messages are sent as HTTP
+  // requests unless the connection has been upgraded to binary frames
+  // which avoid building (and parsing) the request line and headers.
+  enum Framing
+  {
+    HTTP,
+    BINARY
+  };
+
+  // With HTTP framing, 'advertise' determines whether the request
+  // tells the peer that we can decode binary framed messages, which
+  // we only do if binary framing is enabled.
+  MessageEncoder(
+      const network::Socket& s,
+      Message* _message,
+      Framing _framing = HTTP,
+      bool advertise = false)
+    : DataEncoder(s, encode(_message, _framing, advertise)),
+      message(_message),
+      framing(_framing) {}
 
   virtual ~MessageEncoder()
   {
@@ -117,8 +155,20 @@ public:
     }
   }
 
-  static std::string encode(Message* message)
+  bool binary() const
+  {
+    return framing == BINARY;
+  }
+
+  static std::string encode(
+      Message* message,
+      Framing framing = HTTP,
+      bool advertise = false)
   {
+    if (framing == BINARY) {
+      return frame(message);
+    }
+
     std::ostringstream out;
 
     if (message != nullptr) {
@@ -134,8 +184,13 @@ public:
 
       out << "/" << message->name << " HTTP/1.1\r\n"
           << "User-Agent: libprocess/" << message->from << "\r\n"
-          << "Libprocess-From: " << message->from << "\r\n"
-          << "Connection: Keep-Alive\r\n"
+          << "Libprocess-From: " << message->from << "\r\n";
+
+      if (advertise) {
+        out << "Libprocess-Framing: " << BINARY_FRAMING << "\r\n";
+      }
+
+      out << "Connection: Keep-Alive\r\n"
           << "Host: \r\n";
 
       if (message->body.size() > 0) {
@@ -153,8 +208,84 @@ public:
     return out.str();
   }
 
+  // Returns the size of the message as a binary frame.
+  static size_t size(const Message& message)
+  {
+    return BINARY_FRAME_HEADER_SIZE +
+      message.name.size() +
+      stringify(message.from).size() +
+      stringify(message.to).size() +
+      message.body.size();
+  }
+
 private:
+  static std::string frame(Message* message)
+  {
+    std::string data;
+
+    if (message != nullptr) {
+      const std::string from = stringify(message->from);
+      const std::string to = stringify(message->to);
+
+      data.reserve(
+          BINARY_FRAME_HEADER_SIZE +
+          message->name.size() +
+          from.size() +
+          to.size() +
+          message->body.size());
+
+      append(&data, message->name.size());
+      append(&data, from.size());
+      append(&data, to.size());
+      append(&data, message->body.size());
+
+      data.append(message->name);
+      data.append(from);
+      data.append(to);
+      data.append(message->body);
+    }
+
+    return data;
+  }
+
+  static void append(std::string* data, size_t length)
+  {
+    CHECK_LE(length, std::numeric_limits<uint32_t>::max());
+
+    const uint32_t value = static_cast<uint32_t>(length);
+
+    data->push_back(static_cast<char>((value >> 24) & 0xff));
+    data->push_back(static_cast<char>((value >> 16) & 0xff));
+    data->push_back(static_cast<char>((value >> 8) & 0xff));
+    data->push_back(static_cast<char>(value & 0xff));
+  }
+
   Message* message;
+  const Framing framing;
+};
+
+
+// Switches a connection over to binary framed messages, i.e.,
+// everything sent after this request on the connection must be a
+// binary frame (see `MessageDecoder`).
+class UpgradeEncoder : public DataEncoder
+{
+public:
+  explicit UpgradeEncoder(const network::Socket& s)
+    : DataEncoder(s, encode()) {}
+
+  static std::string encode()
+  {
+    std::ostringstream out;
+
+    out << "POST / HTTP/1.1\r\n"
+        << "Connection: Upgrade\r\n"
+        << "Upgrade: " << BINARY_FRAMING << "\r\n"
+        << "Host: \r\n"
+        << "\r\n";
+
+    return out.str();
+  }
 };
 
 
@@ -251,8 +382,14 @@ public:
 class FileEncoder : public Encoder
 {
 public:
-  FileEncoder(const network::Socket& s, int _fd, size_t _size)
-    : Encoder(s), fd(_fd), size(_size), index(0) {}
+  // Sends the bytes of the file from 'offset' (inclusive) up to
+  // 'size' (exclusive), i.e., the whole file by default.
+  FileEncoder(
+      const network::Socket& s,
+      int _fd,
+      size_t _size,
+      off_t _offset = 0)
+    : Encoder(s), fd(_fd), size(_size), index(_offset) {}
 
   virtual ~FileEncoder()
   {
@@ -0,0 +1,414 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_EVENT_QUEUE_HPP__
+#define __PROCESS_EVENT_QUEUE_HPP__
+
+#include <atomic>
+
+#include <glog/logging.h>
+
+#include <process/event.hpp>
+
+#include <stout/synchronized.hpp>
+#include <stout/thread_local.hpp>
+
+namespace process {
+
+// A multi-producer, single-consumer queue of events for a process.
+//
+// Any thread can enqueue an event without taking a lock (a single
+// atomic exchange), while only the thread currently running the
+// process may dequeue. The queue is an intrusive linked list with a
+// stub node (see Dmitry Vyukov's "Non-intrusive MPSC node-based
+// queue"), and the nodes are pooled across all queues so that the
+// steady state does not allocate.
+//
+// Events can also be "injected", i.e., dequeued ahead of all the
+// other events, including the ones that have been injected before.
+// Injected events are kept in a lock-free stack that the consumer
+// always drains first.
+//
+// NOTE: a producer might have swapped itself in as the new head but
+// not yet linked the previous head to it, in which case the consumer
+// treats the queue as empty. This is fine because the producer will
+// subsequently (re-)schedule the process (see `ProcessBase::enqueue`
+// and `ProcessManager::resume`).
+class EventQueue
+{
+public:
+  EventQueue() : commissioned(true)
+  {
+    events.initialize();
+    injected.initialize();
+
+    lock.clear();
+  }
+
+  ~EventQueue()
+  {
+    // Delete any events that were enqueued after the queue was
+    // decommissioned (and before all producers released their
+    // references to the process).
+    while (Event* event = dequeue()) {
+      delete event;
+    }
+
+    events.finalize();
+    injected.finalize();
+  }
+
+  // Enqueues the event, can be called from any thread. Returns false
+  // if the queue has been decommissioned, in which case the caller
+  // retains ownership of the event.
+  bool enqueue(Event* event, bool inject = false)
+  {
+    if (!commissioned.load()) {
+      return false;
+    }
+
+    if (inject) {
+      injected.push(event);
+    } else {
+      events.push(event);
+    }
+
+    return true;
+  }
+
+  // Returns the next event or nullptr if the queue is empty. Must
+  // only be called by the consumer.
+  Event* dequeue()
+  {
+    Event* event = nullptr;
+
+    synchronized (lock) {
+      event = injected.pop();
+
+      if (event == nullptr) {
+        event = events.pop();
+      }
+    }
+
+    return event;
+  }
+
+  // Must only be called by the consumer.
+  bool empty()
+  {
+    return injected.empty() && events.empty();
+  }
+
+  // Stops accepting new events and deletes all pending events. Must
+  // only be called by the consumer.
+  void decommission()
+  {
+    commissioned.store(false);
+
+    while (Event* event = dequeue()) {
+      delete event;
+    }
+  }
+
+  // Returns the number of events of type `T` in the queue. This can
+  // be called from any thread since the consumer holds `lock`
+  // whenever it removes a node.
+  template <typename T>
+  size_t count()
+  {
+    size_t count = 0;
+
+    synchronized (lock) {
+      auto counter = [&count](Event* event) {
+        if (event->is<T>()) {
+          count++;
+        }
+      };
+
+      injected.apply(counter);
+      events.apply(counter);
+    }
+
+    return count;
+  }
+
+  // Visits each event in the queue in the order it will be dequeued.
+  // Like `count` this can be called from any thread.
+  void visit(EventVisitor* visitor)
+  {
+    synchronized (lock) {
+      auto f = [visitor](Event* event) {
+        event->visit(visitor);
+      };
+
+      injected.apply(f);
+      events.apply(f);
+    }
+  }
+
+private:
+  struct Node
+  {
+    std::atomic<Node*> next;
+    Event* event;
+  };
+
+  // A pool of nodes shared by all event queues. The consumer of a
+  // queue returns nodes to the shared free list, from which each
+  // producer thread takes the whole list at once (an exchange, which
+  // avoids the ABA problem of popping single nodes) into a thread
+  // local cache that it then allocates from without synchronization.
+  //
+  // NOTE: only the nodes in the shared free list count towards the
+  // size of the pool. The nodes cached by a thread that exits are
+  // leaked, but since they are no longer counted they can not end up
+  // disabling the pool.
+  class NodePool
+  {
+  public:
+    static Node* allocate()
+    {
+      Node*& cache = local();
+
+      if (cache == nullptr) {
+        cache = shared().exchange(nullptr, std::memory_order_acquire);
+
+        long count = 0;
+        for (Node* node = cache;
+             node != nullptr;
+             node = node->next.load(std::memory_order_relaxed)) {
+          count++;
+        }
+
+        size().fetch_sub(count, std::memory_order_relaxed);
+      }
+
+      if (cache == nullptr) {
+        return new Node();
+      }
+
+      Node* node = cache;
+      cache = node->next.load(std::memory_order_relaxed);
+      return node;
+    }
+
+    static void deallocate(Node* node)
+    {
+      // Bound the number of pooled nodes so that a burst of events
+      // does not permanently pin memory.
+      if (size().load(std::memory_order_relaxed) >= MAX_SIZE) {
+        delete node;
+        return;
+      }
+
+      size().fetch_add(1, std::memory_order_relaxed);
+
+      Node* top = shared().load(std::memory_order_relaxed);
+      do {
+        node->next.store(top, std::memory_order_relaxed);
+      } while (!shared().compare_exchange_weak(
+          top, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+  private:
+    static const long MAX_SIZE = 1024 * 1024;
+
+    static std::atomic<Node*>& shared()
+    {
+      static std::atomic<Node*>* nodes = new std::atomic<Node*>(nullptr);
+      return *nodes;
+    }
+
+    static std::atomic_long& size()
+    {
+      static std::atomic_long* size = new std::atomic_long(0);
+      return *size;
+    }
+
+    static Node*& local()
+    {
+      static THREAD_LOCAL Node* cache = nullptr;
+      return cache;
+    }
+  };
+
+  // The lock-free queue itself. Producers exchange `head`, the
+  // consumer owns `tail`, which always points at a (consumed) stub.
+  struct Queue
+  {
+    void initialize()
+    {
+      Node* stub = NodePool::allocate();
+      stub->next.store(nullptr, std::memory_order_relaxed);
+      stub->event = nullptr;
+
+      head.store(stub);
+      tail = stub;
+    }
+
+    void finalize()
+    {
+      CHECK(empty());
+      NodePool::deallocate(tail);
+    }
+
+    void push(Event* event)
+    {
+      Node* node = NodePool::allocate();
+      node->next.store(nullptr, std::memory_order_relaxed);
+      node->event = event;
+
+      Node* previous = head.exchange(node, std::memory_order_acq_rel);
+
+      // NOTE: this store (and the load in `empty`) is sequentially
+      // consistent so that a producer linking an event and then
+      // checking whether the process is blocked can not race with the
+      // consumer blocking the process and then checking for events.
+      previous->next.store(node);
+    }
+
+    Event* pop()
+    {
+      Node* next = tail->next.load(std::memory_order_acquire);
+
+      if (next == nullptr) {
+        return nullptr;
+      }
+
+      Event* event = next->event;
+      next->event = nullptr;
+
+      NodePool::deallocate(tail);
+      tail = next;
+
+      return event;
+    }
+
+    bool empty()
+    {
+      return tail->next.load() == nullptr;
+    }
+
+    // Applies `f` to each queued event, oldest first.
+    template <typename F>
+    void apply(const F& f)
+    {
+      Node* node = tail->next.load(std::memory_order_acquire);
+
+      while (node != nullptr) {
+        f(node->event);
+        node = node->next.load(std::memory_order_acquire);
+      }
+    }
+
+    std::atomic<Node*> head;
+    Node* tail;
+  };
+
+  // The lock-free stack of injected events. Producers push onto
+  // `top`, and the consumer moves all the pushed nodes at once in
+  // front of `pending`, which only it pops from.
+  struct Stack
+  {
+    void initialize()
+    {
+      top.store(nullptr);
+      pending = nullptr;
+    }
+
+    void finalize()
+    {
+      CHECK(empty());
+    }
+
+    void push(Event* event)
+    {
+      Node* node = NodePool::allocate();
+      node->event = event;
+
+      // NOTE: the exchange is sequentially consistent for the same
+      // reason as the store in `Queue::push`.
+      Node* previous = top.load(std::memory_order_relaxed);
+      do {
+        node->next.store(previous, std::memory_order_relaxed);
+      } while (!top.compare_exchange_weak(previous, node));
+    }
+
+    Event* pop()
+    {
+      Node* nodes = top.exchange(nullptr, std::memory_order_acquire);
+
+      if (nodes != nullptr) {
+        Node* last = nodes;
+        while (last->next.load(std::memory_order_relaxed) != nullptr) {
+          last = last->next.load(std::memory_order_relaxed);
+        }
+
+        last->next.store(pending, std::memory_order_relaxed);
+        pending = nodes;
+      }
+
+      if (pending == nullptr) {
+        return nullptr;
+      }
+
+      Node* node = pending;
+      pending = node->next.load(std::memory_order_relaxed);
+
+      Event* event = node->event;
+      NodePool::deallocate(node);
+
+      return event;
+    }
+
+    bool empty()
+    {
+      return pending == nullptr && top.load() == nullptr;
+    }
+
+    // Applies `f` to each injected event, newest first.
+    template <typename F>
+    void apply(const F& f)
+    {
+      Node* node = top.load(std::memory_order_acquire);
+
+      while (node != nullptr) {
+        f(node->event);
+        node = node->next.load(std::memory_order_acquire);
+      }
+
+      for (node = pending;
+           node != nullptr;
+           node = node->next.load(std::memory_order_relaxed)) {
+        f(node->event);
+      }
+    }
+
+    std::atomic<Node*> top;
+    Node* pending;
+  };
+
+  Queue events;
+  Stack injected;
+
+  // Whether or not the queue still accepts events.
+  std::atomic_bool commissioned;
+
+  // Serializes the consumer removing nodes with other threads
+  // inspecting the queue (see `count` and `visit`). Producers never
+  // acquire it.
+  std::atomic_flag lock;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_EVENT_QUEUE_HPP__
@@ -396,6 +396,7 @@ Pipe::Writer Pipe::writer() const
 Future<string> Pipe::Reader::read()
 {
   Future<string> future;
+  queue<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::CLOSED) {
@@ -403,6 +404,11 @@ Future<string> Pipe::Reader::read()
     } else if (!data->writes.empty()) {
       future = data->writes.front();
       data->writes.pop();
+
+      // Extract the waiting writers if this was the last unread write.
+      if (data->writes.empty()) {
+        std::swap(data->drains, drains);
+      }
     } else if (data->writeEnd == Writer::CLOSED) {
       future = ""; // End-of-file.
     } else if (data->writeEnd == Writer::FAILED) {
@@ -414,6 +420,13 @@ Future<string> Pipe::Reader::read()
     }
   }
 
+  // NOTE: We set the promises outside the critical section to avoid
+  // triggering callbacks that try to reacquire the lock.
+  while (!drains.empty()) {
+    drains.front()->set(Nothing());
+    drains.pop();
+  }
+
   return future;
 }
 
@@ -423,6 +436,7 @@ bool Pipe::Reader::close()
   bool closed = false;
   bool notify = false;
   queue<Owned<Promise<string>>> reads;
+  queue<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::OPEN) {
@@ -431,8 +445,10 @@ bool Pipe::Reader::close()
         data->writes.pop();
       }
 
-      // Extract the pending reads so we can fail them.
+      // Extract the pending reads and the waiting writers so we can
+      // fail them.
       std::swap(data->reads, reads);
+      std::swap(data->drains, drains);
 
       closed = true;
       data->readEnd = Reader::CLOSED;
@@ -450,6 +466,11 @@ bool Pipe::Reader::close()
       reads.pop();
     }
 
+    while (!drains.empty()) {
+      drains.front()->fail("closed");
+      drains.pop();
+    }
+
     if (notify) {
       data->readerClosure.set(Nothing());
     }
@@ -549,6 +570,25 @@ Future<Nothing> Pipe::Writer::readerClosed() const
 }
 
 
+Future<Nothing> Pipe::Writer::drained() const
+{
+  Future<Nothing> future;
+
+  synchronized (data->lock) {
+    if (data->readEnd == Reader::CLOSED) {
+      future = Failure("closed");
+    } else if (data->writes.empty()) {
+      future = Nothing();
+    } else {
+      data->drains.push(Owned<Promise<Nothing>>(new Promise<Nothing>()));
+      future = data->drains.back()->future();
+    }
+  }
+
+  return future;
+}
+
+
 OK::OK(const JSON::Value& value, const Option<string>& jsonp)
   : Response(Status::OK)
 {
@@ -14,58 +14,54 @@
 
 #include <mutex>
 #include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glog/logging.h>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
 #include <stout/thread_local.hpp>
+#include <stout/try.hpp>
 
 #include "event_loop.hpp"
 #include "libev.hpp"
 
 namespace process {
 
-ev_async async_watcher;
-// We need an asynchronous watcher to receive the request to shutdown.
-ev_async shutdown_watcher;
-
 // Define the initial values for all of the declarations made in
 // libev.hpp (since these need to live in the static data space).
-struct ev_loop* loop = nullptr;
-
-std::queue<ev_io*>* watchers = new std::queue<ev_io*>();
+std::vector<EventLoopShard*>* shards = new std::vector<EventLoopShard*>();
 
-std::mutex* watchers_mutex = new std::mutex();
-
-std::queue<lambda::function<void()>>* functions =
-  new std::queue<lambda::function<void()>>();
+struct ev_loop* loop = nullptr;
 
-THREAD_LOCAL bool* _in_event_loop_ = nullptr;
+THREAD_LOCAL EventLoopShard* _in_event_loop_ = nullptr;
 
 
-void handle_async(struct ev_loop* loop, ev_async* _, int revents)
+void handle_async(struct ev_loop* loop, ev_async* watcher, int revents)
 {
-  std::queue<lambda::function<void()>> run_functions;
-  synchronized (watchers_mutex) {
-    // Start all the new I/O watchers.
-    while (!watchers->empty()) {
-      ev_io* watcher = watchers->front();
-      watchers->pop();
-      ev_io_start(loop, watcher);
-    }
+  EventLoopShard* shard = reinterpret_cast<EventLoopShard*>(watcher->data);
 
+  std::queue<lambda::function<void()>> run_functions;
+  synchronized (shard->mutex) {
     // Swap the functions into a temporary queue so that we can invoke
     // them outside of the mutex.
-    std::swap(run_functions, *functions);
+    std::swap(run_functions, shard->functions);
   }
 
   // Running the functions outside of the mutex reduces locking
   // contention as these are arbitrary functions that can take a long
   // time to execute. Doing this also avoids a deadlock scenario where
   // (A) mutexes are acquired before calling `run_in_event_loop`,
-  // followed by locking (B) `watchers_mutex`. If we executed the
+  // followed by locking (B) the shard's `mutex`. If we executed the
   // functions inside the mutex, then the locking order violation
-  // would be this function acquiring the (B) `watchers_mutex`
+  // would be this function acquiring the (B) shard's `mutex`
   // followed by the arbitrary function acquiring the (A) mutexes.
   while (!run_functions.empty()) {
     (run_functions.front())();
@@ -82,13 +78,50 @@ void handle_shutdown(struct ev_loop* loop, ev_async* _, int revents)
 
 void EventLoop::initialize()
 {
-  loop = ev_default_loop(EVFLAG_AUTO);
+  long num_event_loops = 1;
+
+  constexpr char env_var[] = "LIBPROCESS_NUM_EVENT_LOOPS";
+  Option<std::string> value = os::getenv(env_var);
+  if (value.isSome()) {
+    constexpr long maxval = 64;
+    Try<long> number = numify<long>(value.get().c_str());
+    if (number.isSome() && number.get() > 0L && number.get() <= maxval) {
+      VLOG(1) << "Overriding default number of event loops "
+              << num_event_loops << ", using the value "
+              << env_var << "=" << number.get() << " instead";
+      num_event_loops = number.get();
+    } else {
+      LOG(WARNING) << "Ignoring invalid value " << value.get()
+                   << " for " << env_var
+                   << ", using default value " << num_event_loops
+                   << ". Valid values are integers in the range 1 to "
+                   << maxval;
+    }
+  }
+
+  for (long i = 0; i < num_event_loops; i++) {
+    EventLoopShard* shard = new EventLoopShard();
+
+    // NOTE: Only the default loop handles signals and child watchers,
+    // which we do not use in the other loops.
+    shard->loop = i == 0
+      ? ev_default_loop(EVFLAG_AUTO)
+      : ev_loop_new(EVFLAG_AUTO);
+
+    CHECK(shard->loop != nullptr) << "Failed to create event loop " << i;
+
+    ev_async_init(&shard->async_watcher, handle_async);
+    ev_async_init(&shard->shutdown_watcher, handle_shutdown);
+
+    shard->async_watcher.data = shard;
 
-  ev_async_init(&async_watcher, handle_async);
-  ev_async_init(&shutdown_watcher, handle_shutdown);
+    ev_async_start(shard->loop, &shard->async_watcher);
+    ev_async_start(shard->loop, &shard->shutdown_watcher);
 
-  ev_async_start(loop, &async_watcher);
-  ev_async_start(loop, &shutdown_watcher);
+    shards->push_back(shard);
+  }
+
+  loop = shards->front()->loop;
 }
 
 
@@ -149,18 +182,41 @@ double EventLoop::time()
 }
 
 
+namespace internal {
+
+void run_loop(EventLoopShard* shard)
+{
+  _in_event_loop_ = shard;
+
+  ev_loop(shard->loop, 0);
+
+  _in_event_loop_ = nullptr;
+}
+
+} // namespace internal {
+
+
 void EventLoop::run()
 {
-  __in_event_loop__ = true;
+  // The first loop is run by the calling thread, the others each get
+  // a thread of their own which we wait for when stopping.
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < shards->size(); i++) {
+    threads.emplace_back(&internal::run_loop, (*shards)[i]);
+  }
 
-  ev_loop(loop, 0);
+  internal::run_loop(shards->front());
 
-  __in_event_loop__ = false;
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
 }
 
 void EventLoop::stop()
 {
-  ev_async_send(loop, &shutdown_watcher);
+  foreach (EventLoopShard* shard, *shards) {
+    ev_async_send(shard->loop, &shard->shutdown_watcher);
+  }
 }
 
 } // namespace process {
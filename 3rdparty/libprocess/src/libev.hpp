@@ -17,6 +17,7 @@
 
 #include <mutex>
 #include <queue>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/owned.hpp>
@@ -27,30 +28,45 @@
 
 namespace process {
 
-// Event loop.
-extern struct ev_loop* loop;
+// An event loop along with what is needed to run functions within it
+// from other threads (via run_in_event_loop).
+struct EventLoopShard
+{
+  struct ev_loop* loop;
+
+  // Asynchronous watcher for interrupting the loop to specifically
+  // deal with functions (via run_in_event_loop).
+  ev_async async_watcher;
 
-// Asynchronous watcher for interrupting loop to specifically deal
-// with IO watchers and functions (via run_in_event_loop).
-extern ev_async async_watcher;
+  // Asynchronous watcher to receive the request to shutdown.
+  ev_async shutdown_watcher;
 
-// Queue of I/O watchers to be asynchronously added to the event loop
-// (protected by 'watchers' below).
-// TODO(benh): Replace this queue with functions that we put in
-// 'functions' below that perform the ev_io_start themselves.
-extern std::queue<ev_io*>* watchers;
-extern std::mutex* watchers_mutex;
+  // Queue of functions to be invoked asynchronously within the loop
+  // (protected by 'mutex' below).
+  std::queue<lambda::function<void()>> functions;
+  std::mutex mutex;
+};
 
-// Queue of functions to be invoked asynchronously within the vent
-// loop (protected by 'watchers' above).
-extern std::queue<lambda::function<void()>>* functions;
 
-// Per thread bool pointer. We use a pointer to lazily construct the
-// actual bool.
-extern THREAD_LOCAL bool* _in_event_loop_;
+// The event loops, each run by its own thread. The first one is the
+// default libev loop, which also runs the timers (see
+// 'EventLoop::delay'), and the I/O watchers are assigned across all
+// of them by file descriptor (see 'shard' below). The number of loops
+// can be set with LIBPROCESS_NUM_EVENT_LOOPS.
+extern std::vector<EventLoopShard*>* shards;
 
-#define __in_event_loop__ *(_in_event_loop_ == nullptr ?                \
-  _in_event_loop_ = new bool(false) : _in_event_loop_)
+// Event loop (the loop of the first shard).
+extern struct ev_loop* loop;
+
+// Returns the shard whose loop watches the file descriptor 'fd'.
+inline EventLoopShard* shard(int fd)
+{
+  return (*shards)[fd % shards->size()];
+}
+
+// Per thread pointer to the shard whose loop is run by the thread, or
+// nullptr if the thread is not running an event loop.
+extern THREAD_LOCAL EventLoopShard* _in_event_loop_;
 
 
 // Wrapper around function we want to run in the event loop.
@@ -68,12 +84,19 @@ void _run_in_event_loop(
 }
 
 
-// Helper for running a function in the event loop.
+// Helper for running a function in the event loop of 'shard' (which
+// defaults to the first one).
 template <typename T>
-Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
+Future<T> run_in_event_loop(
+    const lambda::function<Future<T>()>& f,
+    EventLoopShard* shard = nullptr)
 {
+  if (shard == nullptr) {
+    shard = shards->front();
+  }
+
   // If this is already the event loop then just run the function.
-  if (__in_event_loop__) {
+  if (_in_event_loop_ == shard) {
     return f();
   }
 
@@ -82,12 +105,12 @@ Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
   Future<T> future = promise->future();
 
   // Enqueue the function.
-  synchronized (watchers_mutex) {
-    functions->push(lambda::bind(&_run_in_event_loop<T>, f, promise));
+  synchronized (shard->mutex) {
+    shard->functions.push(lambda::bind(&_run_in_event_loop<T>, f, promise));
   }
 
   // Interrupt the loop.
-  ev_async_send(loop, &async_watcher);
+  ev_async_send(shard->loop, &shard->async_watcher);
 
   return future;
 }
@@ -89,6 +89,7 @@
 
 #include <process/ssl/flags.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
@@ -98,6 +99,8 @@
 #include <stout/os.hpp>
 #include <stout/os/strerror.hpp>
 #include <stout/path.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/synchronized.hpp>
 #include <stout/thread_local.hpp>
@@ -107,6 +110,7 @@
 #include "decoder.hpp"
 #include "encoder.hpp"
 #include "event_loop.hpp"
+#include "event_queue.hpp"
 #include "gate.hpp"
 #include "process_reference.hpp"
 
@@ -325,6 +329,14 @@ public:
 
   void close(int s);
 
+  // Invoked when the libprocess at 'address' advertised that it can
+  // decode binary framed messages.
+  void advertised(const Address& address);
+
+  // Returns whether binary framing is enabled locally, i.e., whether
+  // inbound connections may be upgraded to binary framed messages.
+  bool binary_framing_enabled() const;
+
   void exited(const Address& address);
   void exited(ProcessBase* process);
 
@@ -386,6 +398,17 @@ private:
   // Map from outbound socket to outgoing queue.
   map<int, queue<Encoder*>> outgoing;
 
+  // Whether or not messages are sent with binary framing to the
+  // peers that can decode them (see LIBPROCESS_ENABLE_BINARY_FRAMING).
+  bool binary_framing;
+
+  // Socket addresses of the peers that advertised that they can
+  // decode binary framed messages.
+  set<Address> binaries;
+
+  // Outbound sockets that have been upgraded to binary framing.
+  set<int> upgraded;
+
   // HTTP proxies.
   map<int, HttpProxy*> proxies;
 
@@ -458,6 +481,26 @@ private:
   list<ProcessBase*> runq;
   std::recursive_mutex runq_mutex;
 
+  // Run queue owned by a single processing thread, used instead of
+  // the global `runq` when work stealing is enabled.
+  struct RunQueue
+  {
+    std::deque<ProcessBase*> processes;
+    std::mutex mutex;
+  };
+
+  // Whether each processing thread has its own run queue and steals
+  // from the other run queues when it runs out of work (see
+  // LIBPROCESS_ENABLE_WORK_STEALING).
+  bool work_stealing;
+
+  // Per processing thread run queues, indexed by worker.
+  vector<Owned<RunQueue>> runqs;
+
+  // Used to spread processes enqueued from non-processing threads
+  // (e.g., the event loop) across the run queues.
+  std::atomic_ulong next_runq;
+
   // Number of running processes, to support Clock::settle operation.
   std::atomic_long running;
 
@@ -476,6 +519,10 @@ private:
 // Server socket listen backlog.
 static const int LISTEN_BACKLOG = 500000;
 
+// Upper bound on the size of a batch of binary framed messages that
+// get written to a socket together (see SocketManager::next).
+static const size_t MAX_BATCH_SIZE = 64 * 1024;
+
 // Local server socket.
 static Socket* __s__ = nullptr;
 
@@ -521,6 +568,10 @@ THREAD_LOCAL ProcessBase* __process__ = nullptr;
 // Per thread executor pointer.
 THREAD_LOCAL Executor* _executor_ = nullptr;
 
+// Per thread index of the processing thread (-1 if this thread is
+// not a processing thread).
+static THREAD_LOCAL long __worker__ = -1;
+
 
 namespace http {
 
@@ -672,6 +723,60 @@ static Message* parse(Request* request)
 
 namespace internal {
 
+// Decodes binary framed messages and delivers them, returns false if
+// the data could not be decoded.
+static bool decode_messages(
+    MessageDecoder* decoder,
+    const char* data,
+    size_t length)
+{
+  const deque<Message*> messages = decoder->decode(data, length);
+
+  foreach (Message* message, messages) {
+    VLOG(2) << "Decoded message name '" << message->name
+            << "' for " << message->to << " from " << message->from;
+
+    // TODO(benh): Use the sender PID when delivering in order to
+    // capture happens-before timing relationships for testing.
+    process_manager->deliver(message->to, new MessageEvent(message));
+  }
+
+  return !decoder->failed();
+}
+
+
+void decode_recv_messages(
+    const Future<size_t>& length,
+    char* data,
+    size_t size,
+    Socket socket,
+    MessageDecoder* decoder)
+{
+  if (length.isDiscarded() || length.isFailed() || length.get() == 0) {
+    if (length.isFailed()) {
+      VLOG(1) << "Decode failure: " << length.failure();
+    }
+
+    socket_manager->close(socket);
+    delete[] data;
+    delete decoder;
+    return;
+  }
+
+  if (!decode_messages(decoder, data, length.get())) {
+    VLOG(1) << "Decoder error while receiving messages";
+    socket_manager->close(socket);
+    delete[] data;
+    delete decoder;
+    return;
+  }
+
+  socket.recv(data, size)
+    .onAny(lambda::bind(
+        &decode_recv_messages, lambda::_1, data, size, socket, decoder));
+}
+
+
 void decode_recv(
     const Future<size_t>& length,
     char* data,
@@ -727,6 +832,29 @@ void decode_recv(
     }
   }
 
+  // The rest of the data on an upgraded connection are binary framed
+  // messages, including whatever followed the upgrade request.
+  if (decoder->upgraded().isSome()) {
+    const string remainder = decoder->upgraded().get();
+
+    MessageDecoder* messages = new MessageDecoder(socket);
+    delete decoder;
+
+    if (!remainder.empty() &&
+        !decode_messages(messages, remainder.data(), remainder.size())) {
+      socket_manager->close(socket);
+      delete[] data;
+      delete messages;
+      return;
+    }
+
+    socket.recv(data, size)
+      .onAny(lambda::bind(
+          &decode_recv_messages, lambda::_1, data, size, socket, messages));
+
+    return;
+  }
+
   socket.recv(data, size)
     .onAny(lambda::bind(&decode_recv, lambda::_1, data, size, socket, decoder));
 }
@@ -783,7 +911,8 @@ void on_accept(const Future<Socket>& socket)
     const size_t size = 80 * 1024;
     char* data = new char[size];
 
-    DataDecoder* decoder = new DataDecoder(socket.get());
+    DataDecoder* decoder = new DataDecoder(
+        socket.get(), socket_manager->binary_framing_enabled());
 
     socket.get().recv(data, size)
       .onAny(lambda::bind(
@@ -1224,6 +1353,65 @@ void HttpProxy::waited(const Future<Response>& future)
 }
 
 
+// Returns the first and last byte (both inclusive) of a file of
+// 'size' bytes requested by a 'Range' header, see RFC 7233. Returns
+// None if the header must be ignored, i.e., if it is malformed or asks
+// for multiple ranges (we then send the whole file, as permitted by
+// the RFC), and an Error if the range cannot be satisfied.
+static Result<pair<off_t, off_t>> range(const string& header, off_t size)
+{
+  if (!strings::startsWith(header, "bytes=")) {
+    return None();
+  }
+
+  const string spec = strings::trim(header.substr(strlen("bytes=")));
+
+  const size_t dash = spec.find('-');
+  if (dash == string::npos || spec.find(',') != string::npos) {
+    return None();
+  }
+
+  const string first = strings::trim(spec.substr(0, dash));
+  const string last = strings::trim(spec.substr(dash + 1));
+
+  // A suffix range, i.e., the last 'N' bytes.
+  if (first.empty()) {
+    Try<off_t> suffix = numify<off_t>(last);
+    if (suffix.isError() || suffix.get() < 0) {
+      return None();
+    }
+
+    if (suffix.get() == 0 || size == 0) {
+      return Error("Empty suffix range");
+    }
+
+    return std::make_pair(std::max<off_t>(size - suffix.get(), 0), size - 1);
+  }
+
+  Try<off_t> start = numify<off_t>(first);
+  if (start.isError() || start.get() < 0) {
+    return None();
+  }
+
+  off_t end = size - 1;
+
+  if (!last.empty()) {
+    Try<off_t> _end = numify<off_t>(last);
+    if (_end.isError() || _end.get() < start.get()) {
+      return None();
+    }
+
+    end = std::min(_end.get(), size - 1);
+  }
+
+  if (start.get() >= size) {
+    return Error("Range starts after the end of the file");
+  }
+
+  return std::make_pair(start.get(), end);
+}
+
+
 bool HttpProxy::process(const Future<Response>& future, const Request& request)
 {
   if (!future.isReady()) {
@@ -1274,18 +1462,61 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
         VLOG(1) << "Returning '404 Not Found' for directory '" << path << "'";
         socket_manager->send(NotFound(), request, socket);
       } else {
+        response.headers["Accept-Ranges"] = "bytes";
+
+        // Only send the requested range of an 'OK' response, if any.
+        off_t first = 0;
+        off_t last = s.st_size - 1;
+
+        Option<string> header = request.headers.get("Range");
+
+        if (header.isSome() && response.code == http::Status::OK) {
+          Result<pair<off_t, off_t>> requested = range(header.get(), s.st_size);
+
+          if (requested.isError()) {
+            VLOG(1) << "Returning '416 Requested range not satisfiable' for"
+                    << " range '" << header.get() << "' of file at '" << path
+                    << "': " << requested.error();
+
+            os::close(fd);
+
+            Response unsatisfiable(
+                http::Status::REQUESTED_RANGE_NOT_SATISFIABLE);
+            unsatisfiable.headers["Content-Range"] =
+              "bytes */" + stringify(s.st_size);
+
+            socket_manager->send(unsatisfiable, request, socket);
+            return true; // All done, can process next request.
+          }
+
+          if (requested.isSome()) {
+            first = requested.get().first;
+            last = requested.get().second;
+
+            response.code = http::Status::PARTIAL_CONTENT;
+            response.status = http::Status::string(response.code);
+            response.headers["Content-Range"] =
+              "bytes " + stringify(first) + "-" + stringify(last) + "/" +
+              stringify(s.st_size);
+          }
+        }
+
+        const off_t length = last - first + 1;
+
         // While the user is expected to properly set a 'Content-Type'
         // header, we fill in (or overwrite) 'Content-Length' header.
         stringstream out;
-        out << s.st_size;
+        out << length;
         response.headers["Content-Length"] = out.str();
 
-        if (s.st_size == 0) {
+        if (length == 0) {
+          os::close(fd);
           socket_manager->send(response, request, socket);
           return true; // All done, can process next request.
         }
 
-        VLOG(1) << "Sending file at '" << path << "' with length " << s.st_size;
+        VLOG(1) << "Sending file at '" << path << "' from offset " << first
+                << " with length " << length;
 
         // TODO(benh): Consider a way to have the socket manager turn
         // on TCP_CORK for both sends and then turn it off.
@@ -1295,7 +1526,7 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
 
         // Note the file descriptor gets closed by FileEncoder.
         socket_manager->send(
-            new FileEncoder(socket, fd, s.st_size),
+            new FileEncoder(socket, fd, last + 1, first),
             request.keepAlive);
       }
     }
@@ -1389,7 +1620,26 @@ void HttpProxy::stream(
 }
 
 
-SocketManager::SocketManager() {}
+SocketManager::SocketManager()
+  : binary_framing(false)
+{
+  // We allow the operator to send messages to other instances of
+  // libprocess as length-prefixed binary frames instead of HTTP
+  // requests, which is cheaper to encode and decode. A connection is
+  // only upgraded to binary framing once the peer has advertised
+  // that it can decode it, all other peers keep getting HTTP.
+  Option<string> value = os::getenv("LIBPROCESS_ENABLE_BINARY_FRAMING");
+  if (value.isSome()) {
+    Try<bool> enabled = numify<bool>(value.get());
+    if (enabled.isSome()) {
+      binary_framing = enabled.get();
+    } else {
+      LOG(WARNING) << "Ignoring invalid value " << value.get()
+                   << " for LIBPROCESS_ENABLE_BINARY_FRAMING"
+                   << ", binary framing remains disabled";
+    }
+  }
+}
 
 
 SocketManager::~SocketManager() {}
@@ -1863,7 +2113,8 @@ void SocketManager::send_connect(
     return;
   }
 
-  Encoder* encoder = new MessageEncoder(socket, message);
+  Encoder* encoder = new MessageEncoder(
+      socket, message, MessageEncoder::HTTP, binary_framing);
 
   // Receive and ignore data from this socket. Note that we don't
   // expect to receive anything other than HTTP '202 Accepted'
@@ -1890,6 +2141,7 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
   const Address& address = message->to.address;
 
   Option<Socket> socket = None();
+  Encoder* encoder = nullptr;
   bool connect = false;
 
   synchronized (mutex) {
@@ -1907,12 +2159,53 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
         dispose.insert(socket.get());
       }
 
+      // Use binary framing if the peer can decode it, which requires
+      // upgrading the connection first. Once upgraded, everything
+      // sent on the connection must be binary framed.
+      MessageEncoder::Framing framing = MessageEncoder::HTTP;
+      Encoder* upgrade = nullptr;
+
+      // A message that does not fit in a binary frame can only be
+      // sent on a connection that has not been upgraded (yet).
+      const bool fits =
+        MessageEncoder::size(*message) <= BINARY_FRAME_MAX_SIZE;
+
+      if (upgraded.count(s) > 0) {
+        if (!fits) {
+          LOG(ERROR) << "Dropping message " << message->name << " from "
+                     << message->from << " to " << message->to
+                     << " as it exceeds the maximum binary frame size of "
+                     << Bytes(BINARY_FRAME_MAX_SIZE);
+          delete message;
+          return;
+        }
+
+        framing = MessageEncoder::BINARY;
+      } else if (binary_framing && binaries.count(address) > 0 && fits) {
+        framing = MessageEncoder::BINARY;
+        upgraded.insert(s);
+        upgrade = new UpgradeEncoder(socket.get());
+      }
+
+      encoder =
+        new MessageEncoder(socket.get(), message, framing, binary_framing);
+
       if (outgoing.count(socket.get()) > 0) {
-        outgoing[socket.get()].push(new MessageEncoder(socket.get(), message));
+        if (upgrade != nullptr) {
+          outgoing[socket.get()].push(upgrade);
+        }
+
+        outgoing[socket.get()].push(encoder);
         return;
       } else {
         // Initialize the outgoing queue.
         outgoing[socket.get()];
+
+        // Send the upgrade right away and the message after it.
+        if (upgrade != nullptr) {
+          outgoing[socket.get()].push(encoder);
+          encoder = upgrade;
+        }
       }
 
     } else {
@@ -1957,9 +2250,8 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
   } else {
     // If we're not connecting and we haven't added the encoder to
     // the 'outgoing' queue then schedule it to be sent.
-    internal::send(
-        new MessageEncoder(socket.get(), message),
-        socket.get());
+    CHECK_NOTNULL(encoder);
+    internal::send(encoder, socket.get());
   }
 }
 
@@ -1989,6 +2281,40 @@ Encoder* SocketManager::next(int s)
         // More messages!
         Encoder* encoder = outgoing[s].front();
         outgoing[s].pop();
+
+        // Binary framed messages that have queued up behind each
+        // other (e.g., while the previous write was in progress) are
+        // written to the socket together.
+        auto binary = [](Encoder* encoder) -> MessageEncoder* {
+          MessageEncoder* message = dynamic_cast<MessageEncoder*>(encoder);
+          return message != nullptr && message->binary() ? message : nullptr;
+        };
+
+        MessageEncoder* message = binary(encoder);
+        if (message != nullptr &&
+            !outgoing[s].empty() &&
+            binary(outgoing[s].front()) != nullptr) {
+          string data;
+
+          while (message != nullptr) {
+            size_t length = 0;
+            const char* bytes = message->next(&length);
+            data.append(bytes, length);
+            delete message;
+
+            message = nullptr;
+
+            if (!outgoing[s].empty() && data.size() < MAX_BATCH_SIZE) {
+              message = binary(outgoing[s].front());
+              if (message != nullptr) {
+                outgoing[s].pop();
+              }
+            }
+          }
+
+          encoder = new DataEncoder(sockets.at(s), data);
+        }
+
         return encoder;
       } else {
         // No more messages ... erase the outgoing queue.
@@ -2011,6 +2337,7 @@ Encoder* SocketManager::next(int s)
           }
 
           dispose.erase(s);
+          upgraded.erase(s);
 
           auto iterator = sockets.find(s);
 
@@ -2068,10 +2395,17 @@ void SocketManager::close(int s)
         outgoing.erase(s);
       }
 
+      upgraded.erase(s);
+
       // Clean up after sockets used for remote communication.
       if (addresses.count(s) > 0) {
         const Address& address = addresses[s];
 
+        // The peer might come back as a different libprocess (e.g.,
+        // an older version) so it needs to advertise binary framing
+        // again.
+        binaries.erase(address);
+
         // Don't bother invoking `exited` unless socket was persistent.
         if (persists.count(address) > 0 && persists[address] == s) {
           persists.erase(address);
@@ -2142,6 +2476,26 @@ void SocketManager::close(int s)
 }
 
 
+void SocketManager::advertised(const Address& address)
+{
+  if (!binary_framing) {
+    return;
+  }
+
+  synchronized (mutex) {
+    binaries.insert(address);
+  }
+}
+
+
+bool SocketManager::binary_framing_enabled() const
+{
+  // NOTE: This is only set when the socket manager is created so it
+  // does not need to be synchronized.
+  return binary_framing;
+}
+
+
 void SocketManager::exited(const Address& address)
 {
   // TODO(benh): It would be cleaner if this routine could call back
@@ -2283,6 +2637,30 @@ void SocketManager::swap_implementing_socket(
     outgoing[to_fd] = std::move(outgoing[from_fd]);
     outgoing.erase(from_fd);
 
+    // The new socket needs to be upgraded to binary framing before
+    // any of the queued binary framed messages, regardless of whether
+    // the upgrade of the old socket was already sent or is queued.
+    if (upgraded.count(from_fd) > 0) {
+      upgraded.erase(from_fd);
+      upgraded.insert(to_fd);
+
+      queue<Encoder*> encoders;
+      encoders.push(new UpgradeEncoder(to));
+
+      while (!outgoing[to_fd].empty()) {
+        Encoder* encoder = outgoing[to_fd].front();
+        outgoing[to_fd].pop();
+
+        if (dynamic_cast<UpgradeEncoder*>(encoder) != nullptr) {
+          delete encoder;
+        } else {
+          encoders.push(encoder);
+        }
+      }
+
+      outgoing[to_fd] = std::move(encoders);
+    }
+
     // Update the fd any proxies are associated with.
     if (proxies.count(from_fd) > 0) {
       proxies[to_fd] = proxies[from_fd];
@@ -2293,9 +2671,11 @@ void SocketManager::swap_implementing_socket(
 
 
 ProcessManager::ProcessManager(const Option<string>& _delegate)
-  : delegate(_delegate)
+  : delegate(_delegate),
+    work_stealing(false)
 {
   running.store(0);
+  next_runq.store(0);
 }
 
 
@@ -2397,12 +2777,40 @@ long ProcessManager::init_threads()
     }
   }
 
+  // We allow the operator to give each processing thread its own run
+  // queue. Processes are enqueued on the run queue of the thread that
+  // last ran them (to keep their state warm in that core's caches)
+  // and idle threads steal from the other run queues. This avoids all
+  // processing threads contending on the single global run queue.
+  value = os::getenv("LIBPROCESS_ENABLE_WORK_STEALING");
+  if (value.isSome()) {
+    Try<bool> enabled = numify<bool>(value.get());
+    if (enabled.isSome()) {
+      work_stealing = enabled.get();
+    } else {
+      LOG(WARNING) << "Ignoring invalid value " << value.get()
+                   << " for LIBPROCESS_ENABLE_WORK_STEALING"
+                   << ", work stealing remains disabled";
+    }
+  }
+
+  if (work_stealing) {
+    VLOG(1) << "Using per worker run queues with work stealing";
+
+    runqs.reserve(num_worker_threads);
+    for (long i = 0; i < num_worker_threads; i++) {
+      runqs.push_back(Owned<RunQueue>(new RunQueue()));
+    }
+  }
+
   threads.reserve(num_worker_threads + 1);
 
-  struct
+  struct Worker
   {
     void operator()() const
     {
+      __worker__ = index;
+
       do {
         ProcessBase* process = process_manager->dequeue();
         if (process == nullptr) {
@@ -2425,12 +2833,15 @@ long ProcessManager::init_threads()
     // We hold a constant reference to `joining_threads` to make it clear that
     // this value is only being tested (read), and not manipulated.
     const std::atomic_bool& joining_threads;
-  } worker{joining_threads};
+
+    // Index of this processing thread (and its run queue).
+    const long index;
+  };
 
   // Create processing threads.
   for (long i = 0; i < num_worker_threads; i++) {
     // Retain the thread handles so that we can join when shutting down.
-    threads.emplace_back(new std::thread(worker));
+    threads.emplace_back(new std::thread(Worker{joining_threads, i}));
   }
 
   // Create a thread for the event loop.
@@ -2468,6 +2879,23 @@ void ProcessManager::handle(
   if (libprocess(request)) {
     Message* message = parse(request);
     if (message != nullptr) {
+      // Remember whether the sender can decode binary framed
+      // messages so we can switch our connection to it over. Since
+      // anyone can claim any 'from', we only believe it if the
+      // request came from the IP of that address (the port is the one
+      // the peer connected from, not the one it listens on).
+      Option<string> framing = request->headers.get("Libprocess-Framing");
+      if (framing.isSome() && framing.get() == BINARY_FRAMING) {
+        Try<Address> peer = socket.peer();
+        if (peer.isSome() && peer->ip == message->from.address.ip) {
+          socket_manager->advertised(message->from.address);
+        } else {
+          VLOG(1) << "Ignoring binary framing advertised by "
+                  << message->from << " from "
+                  << (peer.isSome() ? stringify(peer.get()) : "unknown peer");
+        }
+      }
+
       // TODO(benh): Use the sender PID when delivering in order to
       // capture happens-before timing relationships for testing.
       bool accepted = deliver(message->to, new MessageEvent(message));
@@ -2719,17 +3147,27 @@ void ProcessManager::resume(ProcessBase* process)
   }
 
   while (!terminate && !blocked) {
-    Event* event = nullptr;
+    Event* event = process->events->dequeue();
 
-    synchronized (process->mutex) {
-      if (process->events.size() > 0) {
-        event = process->events.front();
-        process->events.pop_front();
-        process->state = ProcessBase::RUNNING;
-      } else {
-        process->state = ProcessBase::BLOCKED;
-        blocked = true;
+    if (event != nullptr) {
+      process->state = ProcessBase::RUNNING;
+    } else {
+      process->state = ProcessBase::BLOCKED;
+
+      // A producer that enqueued an event before we set the state to
+      // BLOCKED will not have scheduled the process, so check for
+      // events again and, if there are any, try to unblock ourselves.
+      // If that fails then a producer has already set the process to
+      // READY and scheduled it, in which case we must stop running it.
+      if (!process->events->empty()) {
+        ProcessBase::State expected = ProcessBase::BLOCKED;
+        if (process->state.compare_exchange_strong(
+                expected, ProcessBase::RUNNING)) {
+          continue;
+        }
       }
+
+      blocked = true;
     }
 
     if (!blocked) {
@@ -2821,20 +3259,12 @@ void ProcessManager::cleanup(ProcessBase* process)
   // the process we are cleaning up will get dropped (since it's
   // terminating) and eliminates the potential of enqueueing them on
   // another process that gets spawned with the same PID.
-  deque<Event*> events;
-
-  synchronized (process->mutex) {
-    process->state = ProcessBase::TERMINATING;
-    events = process->events;
-    process->events.clear();
-  }
-
-  // Delete pending events.
-  while (!events.empty()) {
-    Event* event = events.front();
-    events.pop_front();
-    delete event;
-  }
+  //
+  // NOTE: a producer that raced with decommissioning the event queue
+  // may still enqueue an event, which is then deleted along with the
+  // event queue when the process is deleted.
+  process->state = ProcessBase::TERMINATING;
+  process->events->decommission();
 
   // Remove help strings for all installed routes for this process.
   dispatch(help, &Help::remove, process->pid.id);
@@ -2851,23 +3281,19 @@ void ProcessManager::cleanup(ProcessBase* process)
 #endif
     }
 
-    synchronized (process->mutex) {
-      CHECK(process->events.empty());
+    processes.erase(process->pid.id);
 
-      processes.erase(process->pid.id);
-
-      // Lookup gate to wake up waiting threads.
-      map<ProcessBase*, Gate*>::iterator it = gates.find(process);
-      if (it != gates.end()) {
-        gate = it->second;
-        // N.B. The last thread that leaves the gate also free's it.
-        gates.erase(it);
-      }
-
-      CHECK(process->refs.load() == 0);
-      process->state = ProcessBase::TERMINATED;
+    // Lookup gate to wake up waiting threads.
+    map<ProcessBase*, Gate*>::iterator it = gates.find(process);
+    if (it != gates.end()) {
+      gate = it->second;
+      // N.B. The last thread that leaves the gate also free's it.
+      gates.erase(it);
     }
 
+    CHECK(process->refs.load() == 0);
+    process->state = ProcessBase::TERMINATED;
+
     // Note that we don't remove the process from the clock during
     // cleanup, but rather the clock is reset for a process when it is
     // created (see ProcessBase::ProcessBase). We do this so that
@@ -2981,8 +3407,36 @@ bool ProcessManager::wait(const UPID& pid)
       old = gate->approach();
 
       // Check if it is runnable in order to donate this thread.
-      if (process->state == ProcessBase::BOTTOM ||
-          process->state == ProcessBase::READY) {
+      if ((process->state == ProcessBase::BOTTOM ||
+           process->state == ProcessBase::READY) &&
+          work_stealing) {
+        bool found = false;
+
+        foreach (const Owned<RunQueue>& runq, runqs) {
+          synchronized (runq->mutex) {
+            std::deque<ProcessBase*>::iterator it = find(
+                runq->processes.begin(), runq->processes.end(), process);
+
+            if (it != runq->processes.end()) {
+              // See the comment below on why we increment 'running'
+              // before leaving this critical section.
+              runq->processes.erase(it);
+              running.fetch_add(1);
+              found = true;
+            }
+          }
+
+          if (found) {
+            break;
+          }
+        }
+
+        if (!found) {
+          // Another thread has resumed (or stolen) the process ...
+          process = nullptr;
+        }
+      } else if (process->state == ProcessBase::BOTTOM ||
+                 process->state == ProcessBase::READY) {
         synchronized (runq_mutex) {
           list<ProcessBase*>::iterator it =
             find(runq.begin(), runq.end(), process);
@@ -3086,14 +3540,34 @@ void ProcessManager::enqueue(ProcessBase* process)
     return;
   }
 
-  // TODO(benh): Check and see if this process has it's own thread. If
-  // it does, push it on that threads runq, and wake up that thread if
-  // it's not running. Otherwise, check and see which thread this
-  // process was last running on, and put it on that threads runq.
+  if (work_stealing) {
+    // Put the process on the run queue of the thread it last ran on,
+    // otherwise (i.e., it has never run) on the run queue of the
+    // current processing thread, falling back to round robin when
+    // enqueued from a non-processing thread.
+    long index = process->affinity.load();
 
-  synchronized (runq_mutex) {
-    CHECK(find(runq.begin(), runq.end(), process) == runq.end());
-    runq.push_back(process);
+    if (index < 0) {
+      index = __worker__;
+    }
+
+    if (index < 0) {
+      index = next_runq.fetch_add(1) % runqs.size();
+    }
+
+    RunQueue* runq = runqs[index].get();
+
+    synchronized (runq->mutex) {
+      runq->processes.push_back(process);
+    }
+  } else {
+    // TODO(benh): Check and see if this process has it's own thread.
+    // If it does, push it on that threads runq, and wake up that
+    // thread if it's not running.
+    synchronized (runq_mutex) {
+      CHECK(find(runq.begin(), runq.end(), process) == runq.end());
+      runq.push_back(process);
+    }
   }
 
   // Wake up the processing thread if necessary.
@@ -3103,12 +3577,45 @@ void ProcessManager::enqueue(ProcessBase* process)
 
 ProcessBase* ProcessManager::dequeue()
 {
-  // TODO(benh): Remove a process from this thread's runq. If there
-  // are no processes to run, and this is not a dedicated thread, then
-  // steal one from another threads runq.
-
   ProcessBase* process = nullptr;
 
+  if (work_stealing) {
+    CHECK_GE(__worker__, 0) << "Only processing threads can dequeue";
+
+    // Take the oldest process from this thread's run queue. If there
+    // are no processes to run then steal the newest process from
+    // another thread's run queue, starting with our neighbour so that
+    // idle threads do not all contend on the same victim.
+    const size_t size = runqs.size();
+
+    for (size_t i = 0; i < size && process == nullptr; i++) {
+      RunQueue* runq = runqs[(__worker__ + i) % size].get();
+
+      synchronized (runq->mutex) {
+        if (!runq->processes.empty()) {
+          if (i == 0) {
+            process = runq->processes.front();
+            runq->processes.pop_front();
+          } else {
+            process = runq->processes.back();
+            runq->processes.pop_back();
+          }
+
+          // Increment the running count of processes in order to
+          // support the Clock::settle() operation (this must be done
+          // atomically with removing the process from the run queue).
+          running.fetch_add(1);
+        }
+      }
+    }
+
+    if (process != nullptr) {
+      process->affinity.store(__worker__);
+    }
+
+    return process;
+  }
+
   synchronized (runq_mutex) {
     if (!runq.empty()) {
       process = runq.front();
@@ -3130,6 +3637,30 @@ void ProcessManager::settle()
   do {
     done = true; // Assume to start that we are settled.
 
+    if (work_stealing) {
+      // We hold every run queue lock while checking 'running' so that
+      // a process can not move from a run queue to running (or be
+      // enqueued by a process that is about to stop running) without
+      // us noticing, i.e., the equivalent of holding 'runq_mutex'.
+      vector<std::unique_lock<std::mutex>> locks;
+      locks.reserve(runqs.size());
+
+      foreach (const Owned<RunQueue>& runq, runqs) {
+        locks.emplace_back(runq->mutex);
+
+        if (!runq->processes.empty()) {
+          done = false;
+          break;
+        }
+      }
+
+      if (done && (running.load() > 0 || !Clock::settled())) {
+        done = false;
+      }
+
+      continue;
+    }
+
     synchronized (runq_mutex) {
       if (!runq.empty()) {
         done = false;
@@ -3217,11 +3748,7 @@ Future<Response> ProcessManager::__processes__(const Request&)
         JSON::Array* events;
       } visitor(&events);
 
-      synchronized (process->mutex) {
-        foreach (Event* event, process->events) {
-          event->visit(&visitor);
-        }
-      }
+      process->events->visit(&visitor);
 
       object.values["events"] = events;
       array.values.push_back(object);
@@ -3238,8 +3765,12 @@ ProcessBase::ProcessBase(const string& id)
 
   state = ProcessBase::BOTTOM;
 
+  events.reset(new EventQueue());
+
   refs = 0;
 
+  affinity = -1;
+
   pid.id = id != "" ? id : ID::generate();
   pid.address = __address__;
 
@@ -3259,29 +3790,59 @@ void ProcessBase::enqueue(Event* event, bool inject)
 {
   CHECK(event != nullptr);
 
-  synchronized (mutex) {
-    if (state != TERMINATING && state != TERMINATED) {
-      if (!inject) {
-        events.push_back(event);
-      } else {
-        events.push_front(event);
-      }
-
-      if (state == BLOCKED) {
-        state = READY;
-        process_manager->enqueue(this);
-      }
+  // The event queue stops accepting events once the process starts
+  // terminating, at which point we are responsible for the event.
+  if (!events->enqueue(event, inject)) {
+    delete event;
+    return;
+  }
 
-      CHECK(state == BOTTOM ||
-            state == READY ||
-            state == RUNNING);
-    } else {
-      delete event;
-    }
+  // Schedule the process if it was blocked. If the process is not
+  // blocked it is either about to run (BOTTOM or READY) or running,
+  // in which case it will dequeue this event (see the corresponding
+  // check in `ProcessManager::resume`).
+  State expected = BLOCKED;
+  if (state.compare_exchange_strong(expected, READY)) {
+    process_manager->enqueue(this);
   }
 }
 
 
+template <>
+size_t ProcessBase::eventCount<MessageEvent>()
+{
+  return events->count<MessageEvent>();
+}
+
+
+template <>
+size_t ProcessBase::eventCount<DispatchEvent>()
+{
+  return events->count<DispatchEvent>();
+}
+
+
+template <>
+size_t ProcessBase::eventCount<HttpEvent>()
+{
+  return events->count<HttpEvent>();
+}
+
+
+template <>
+size_t ProcessBase::eventCount<ExitedEvent>()
+{
+  return events->count<ExitedEvent>();
+}
+
+
+template <>
+size_t ProcessBase::eventCount<TerminateEvent>()
+{
+  return events->count<TerminateEvent>();
+}
+
+
 void ProcessBase::inject(
     const UPID& from,
     const string& name,
@@ -14,18 +14,25 @@
 
 #include <sys/types.h>
 #ifndef __WINDOWS__
+#include <sys/resource.h>
 #include <sys/wait.h>
 #endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
+#include <process/io.hpp>
 #include <process/once.hpp>
 #include <process/owned.hpp>
 #include <process/reap.hpp>
 
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/os.hpp>
@@ -35,9 +42,10 @@
 namespace process {
 
 
-// TODO(bmahler): This can be optimized to use a thread per pid, where
-// each thread makes a blocking call to waitpid. This eliminates the
-// unfortunate poll delay.
+// Where supported (Linux 5.3+), the reaper is notified of the exit of
+// a process through a pidfd, which becomes readable when the process
+// terminates. Otherwise (or if no pidfd can be opened), the reaper
+// falls back to polling the process with 'waitpid'.
 //
 // Simple bounded linear model for computing the poll interval.
 // Values were chosen such that at (50 pids, 100 ms) the CPU usage is
@@ -61,6 +69,22 @@ const size_t HIGH_PID_COUNT = 500;
 Duration MAX_REAP_INTERVAL() { return Seconds(1); }
 
 
+// The maximum number of pidfds open at once: a quarter of the file
+// descriptors the process can open.
+static size_t MAX_PIDFDS()
+{
+#ifndef __WINDOWS__
+  struct rlimit limit;
+  if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+      limit.rlim_cur != RLIM_INFINITY) {
+    return limit.rlim_cur / 4;
+  }
+#endif // __WINDOWS__
+
+  return 1024;
+}
+
+
 class ReaperProcess : public Process<ReaperProcess>
 {
 public:
@@ -72,6 +96,11 @@ public:
     if (os::exists(pid)) {
       Owned<Promise<Option<int>>> promise(new Promise<Option<int>>());
       promises.put(pid, promise);
+
+      if (!pidfds.contains(pid)) {
+        watch(pid);
+      }
+
       return promise->future();
     } else {
       return None();
@@ -81,6 +110,66 @@ public:
 protected:
   virtual void initialize() { wait(); }
 
+  virtual void finalize()
+  {
+    foreachvalue (int pidfd, pidfds) {
+      os::close(pidfd);
+    }
+  }
+
+  // Opens a pidfd for the process and waits for it to be readable,
+  // i.e., for the process to terminate. If this is not possible the
+  // process is left to be polled by 'wait()'.
+  void watch(pid_t pid)
+  {
+#if defined(__linux__) && defined(__NR_pidfd_open)
+    // Leave most of the file descriptors to the rest of the process.
+    if (pidfds.size() >= MAX_PIDFDS()) {
+      return;
+    }
+
+    int pidfd = ::syscall(__NR_pidfd_open, pid, 0);
+    if (pidfd < 0) {
+      VLOG(2) << "Failed to open a pidfd for process " << pid
+              << ", falling back to polling: " << os::strerror(errno);
+      return;
+    }
+
+    Try<Nothing> cloexec = os::cloexec(pidfd);
+    if (cloexec.isError()) {
+      os::close(pidfd);
+      return;
+    }
+
+    pidfds.put(pid, pidfd);
+
+    io::poll(pidfd, io::READ)
+      .onAny(defer(self(), &ReaperProcess::exited, pid, pidfd));
+#endif // __linux__ && __NR_pidfd_open
+  }
+
+  void exited(pid_t pid, int pidfd)
+  {
+    CHECK(pidfds.get(pid) == pidfd);
+
+    pidfds.erase(pid);
+    os::close(pidfd);
+
+    int status;
+    Result<pid_t> child_pid = os::waitpid(pid, &status, WNOHANG);
+    if (child_pid.isSome()) {
+      // We have reaped a child.
+      notify(pid, status);
+    } else if (!os::exists(pid)) {
+      // The process no longer exists and has been reaped by someone else.
+      notify(pid, None());
+    }
+
+    // Otherwise this is a terminated process that is not our child and
+    // has not been reaped yet (or the poll failed), which is left to
+    // be polled until it no longer exists.
+  }
+
   void wait()
   {
     // There are two cases to consider for each pid when it terminates:
@@ -94,6 +183,12 @@ protected:
     // between waitpid and the (!exists) conditional it will still exist as a
     // zombie; it will be reaped by us on the next loop.
     foreach (pid_t pid, promises.keys()) {
+      // We get notified of the termination of the processes we
+      // have a pidfd for.
+      if (pidfds.contains(pid)) {
+        continue;
+      }
+
       int status;
       Result<pid_t> child_pid = os::waitpid(pid, &status, WNOHANG);
       if (child_pid.isSome()) {
@@ -125,7 +220,7 @@ protected:
 private:
   const Duration interval()
   {
-    size_t count = promises.size();
+    size_t count = promises.size() - pidfds.size();
 
     if (count <= LOW_PID_COUNT) {
       return MIN_REAP_INTERVAL();
@@ -142,6 +237,10 @@ private:
   }
 
   multihashmap<pid_t, Owned<Promise<Option<int>>>> promises;
+
+  // The pidfds of the processes whose termination we wait for
+  // without polling.
+  hashmap<pid_t, int> pidfds;
 };
 
 
@@ -18,30 +18,52 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/http.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/reap.hpp>
+#include <process/subprocess.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashset.hpp>
+#include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
 
+#include <stout/os/killtree.hpp>
+
 namespace http = process::http;
 
+using process::Clock;
+using process::Failure;
 using process::Future;
+using process::Message;
 using process::Owned;
+using process::PID;
 using process::Process;
 using process::ProcessBase;
 using process::Promise;
+using process::Subprocess;
+using process::Timer;
 using process::UPID;
 
 using std::cout;
@@ -51,8 +73,24 @@ using std::ostringstream;
 using std::string;
 using std::vector;
 
+using testing::_;
+
+// The path of this binary, which also runs the server side of the
+// client / server benchmark (see `serve`).
+static string benchmarks;
+
+static int serve(const UPID& coordinator);
+
 int main(int argc, char** argv)
 {
+  // The client / server benchmark launches this binary with the UPID
+  // of a coordinator to run the server in its own process.
+  if (argc == 3 && string(argv[1]) == "--server") {
+    return serve(UPID(argv[2]));
+  }
+
+  benchmarks = argv[0];
+
   // Initialize Google Mock/Test.
   testing::InitGoogleMock(&argc, argv);
 
@@ -66,10 +104,6 @@ int main(int argc, char** argv)
   return RUN_ALL_TESTS();
 }
 
-// TODO(jmlvanre): Factor out the client / server behavior so that we
-// can make separate binaries for the client and server. This is
-// useful to attach performance tools to them separately.
-
 // A process that emulates the 'client' side of a ping pong game.
 // An HTTP '/run' request performs a run and returns the time elapsed.
 class ClientProcess : public Process<ClientProcess>
@@ -219,12 +253,27 @@ private:
   hashset<UPID> links;
 };
 
-// TODO(bmahler): Since there is no forking here, libprocess
-// avoids going through sockets for local messages. Either fork
-// or have the ability to disable local messages in libprocess.
+
+// Runs the server of the client / server benchmark until killed,
+// after letting the coordinator know its UPID.
+static int serve(const UPID& coordinator)
+{
+  ServerProcess server;
+  spawn(server);
+
+  process::post(server.self(), coordinator, "alive", nullptr, 0);
+
+  wait(server);
+
+  return EXIT_SUCCESS;
+}
+
 
 // Launches many clients against a central server and measures
-// client throughput.
+// client throughput. The server runs in its own process so that the
+// messages go through sockets. Run with
+// LIBPROCESS_ENABLE_BINARY_FRAMING=1 to compare binary framing with
+// HTTP framing.
 TEST(ProcessTest, Process_BENCHMARK_ClientServer)
 {
   const size_t numRequests = 10000;
@@ -232,8 +281,32 @@ TEST(ProcessTest, Process_BENCHMARK_ClientServer)
   const size_t numClients = 8;
   const Bytes messageSize = Bytes(3);
 
-  ServerProcess server;
-  const UPID serverPid = spawn(&server);
+  Option<string> binaryFraming = os::getenv("LIBPROCESS_ENABLE_BINARY_FRAMING");
+
+  cout << "Binary framing: "
+       << (binaryFraming.isSome() && binaryFraming.get() == "1"
+             ? "enabled" : "disabled")
+       << endl;
+
+  // Launch the server, it inherits our environment (and thus the
+  // framing) and tells the coordinator its UPID once it's ready.
+  ProcessBase coordinator;
+  spawn(coordinator);
+
+  Future<Message> alive = FUTURE_MESSAGE("alive", _, coordinator.self());
+
+  Try<Subprocess> server = process::subprocess(
+      benchmarks,
+      {benchmarks, "--server", stringify(coordinator.self())});
+
+  ASSERT_SOME(server);
+
+  AWAIT_READY(alive);
+
+  const UPID serverPid = alive->from;
+
+  terminate(coordinator);
+  wait(coordinator);
 
   // Launch the clients.
   vector<Owned<ClientProcess>> clients;
@@ -286,10 +359,8 @@ TEST(ProcessTest, Process_BENCHMARK_ClientServer)
     wait(*client);
   }
 
-  terminate(server);
-  wait(server);
-
-  return;
+  os::killtree(server->pid(), SIGKILL);
+  AWAIT_READY(server->status());
 }
 
 
@@ -374,3 +445,464 @@ TEST(ProcessTest, Process_BENCHMARK_LargeNumberOfLinks)
     delete process;
   }
 }
+
+
+// A process that bounces a dispatch back and forth with a peer until
+// it has done the requested number of round trips.
+class PingPongProcess : public Process<PingPongProcess>
+{
+public:
+  explicit PingPongProcess(size_t _rounds) : rounds(_rounds) {}
+
+  void start(const PID<PingPongProcess>& peer)
+  {
+    pong(peer);
+  }
+
+  void ping(const PID<PingPongProcess>& from)
+  {
+    dispatch(from, &PingPongProcess::pong, self());
+  }
+
+  void pong(const PID<PingPongProcess>& from)
+  {
+    if (rounds-- == 0) {
+      done.set(Nothing());
+      return;
+    }
+
+    dispatch(from, &PingPongProcess::ping, self());
+  }
+
+  Future<Nothing> finished() { return done.future(); }
+
+private:
+  size_t rounds;
+  Promise<Nothing> done;
+};
+
+
+// Measures the dispatch throughput of an increasing number of
+// independent pairs of processes, to show how the processing threads
+// scale. Run with LIBPROCESS_ENABLE_WORK_STEALING=1 to compare the
+// per worker run queues against the global run queue.
+TEST(ProcessTest, Process_BENCHMARK_DispatchScaling)
+{
+  const size_t rounds = 100000;
+
+  Option<string> workStealing = os::getenv("LIBPROCESS_ENABLE_WORK_STEALING");
+
+  cout << "Work stealing: "
+       << (workStealing.isSome() && workStealing.get() == "1"
+             ? "enabled" : "disabled")
+       << endl;
+
+  const vector<size_t> numPairs = {1, 2, 4, 8, 16, 32, 64};
+
+  foreach (size_t pairs, numPairs) {
+    vector<Owned<PingPongProcess>> processes;
+    list<Future<Nothing>> futures;
+
+    for (size_t i = 0; i < pairs * 2; i++) {
+      processes.push_back(Owned<PingPongProcess>(new PingPongProcess(rounds)));
+      spawn(processes.back().get());
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < pairs; i++) {
+      PingPongProcess* first = processes[i * 2].get();
+      PingPongProcess* second = processes[i * 2 + 1].get();
+
+      futures.push_back(first->finished());
+
+      dispatch(first, &PingPongProcess::start, second->self());
+    }
+
+    AWAIT_READY_FOR(collect(futures), Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    // Each round trip is two dispatches.
+    double throughput = (2 * rounds * pairs) / elapsed.secs();
+
+    cout << pairs << " pairs of processes: " << throughput
+         << " dispatches / sec" << endl;
+
+    foreach (const Owned<PingPongProcess>& process, processes) {
+      terminate(process.get());
+      wait(process.get());
+    }
+  }
+}
+
+
+// A process that records how long each dispatch waited in its event
+// queue before being serviced.
+class LatencyProcess : public Process<LatencyProcess>
+{
+public:
+  explicit LatencyProcess(size_t _expected)
+    : expected(_expected)
+  {
+    latencies.reserve(expected);
+  }
+
+  void handle(const std::chrono::steady_clock::time_point& sent)
+  {
+    latencies.push_back(std::chrono::steady_clock::now() - sent);
+
+    if (latencies.size() == expected) {
+      done.set(Nothing());
+    }
+  }
+
+  Future<Nothing> finished() { return done.future(); }
+
+  vector<std::chrono::steady_clock::duration> latencies;
+
+private:
+  const size_t expected;
+  Promise<Nothing> done;
+};
+
+
+// Measures the throughput and the queueing latency of dispatches sent
+// from many threads to a single process, i.e., the contention on the
+// event queue of a single process (e.g., the master).
+TEST(ProcessTest, Process_BENCHMARK_ManyProducersSingleConsumer)
+{
+  const size_t dispatches = 4000000;
+  const vector<size_t> numThreads = {1, 2, 4, 8, 16};
+
+  foreach (size_t threads, numThreads) {
+    const size_t perThread = dispatches / threads;
+
+    LatencyProcess process(perThread * threads);
+    spawn(process);
+
+    Stopwatch watch;
+    watch.start();
+
+    vector<std::thread> producers;
+    for (size_t i = 0; i < threads; i++) {
+      producers.emplace_back([&process, perThread]() {
+        for (size_t j = 0; j < perThread; j++) {
+          dispatch(
+              process.self(),
+              &LatencyProcess::handle,
+              std::chrono::steady_clock::now());
+        }
+      });
+    }
+
+    foreach (std::thread& producer, producers) {
+      producer.join();
+    }
+
+    AWAIT_READY_FOR(process.finished(), Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    vector<std::chrono::steady_clock::duration>& latencies = process.latencies;
+    std::sort(latencies.begin(), latencies.end());
+
+    auto percentile = [&latencies](double p) {
+      size_t index = static_cast<size_t>(p * (latencies.size() - 1));
+      return Nanoseconds(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          latencies[index]).count());
+    };
+
+    cout << threads << " threads: "
+         << latencies.size() / elapsed.secs() << " dispatches / sec"
+         << ", p50 " << percentile(0.5)
+         << ", p99 " << percentile(0.99)
+         << ", p99.9 " << percentile(0.999)
+         << ", max " << percentile(1.0) << endl;
+
+    terminate(process);
+    wait(process);
+  }
+}
+
+
+// Measures the cost of creating, canceling and expiring a large
+// number of outstanding timers, e.g., the timeouts of many pending
+// operations. The clock is paused so that no timer fires until the
+// clock is advanced.
+TEST(ProcessTest, Process_BENCHMARK_Timers)
+{
+  const size_t count = 1000000;
+
+  // Spread the timeouts over an hour.
+  const Duration interval = Hours(1) / count;
+
+  Clock::pause();
+
+  std::atomic<size_t> fired(0);
+
+  vector<Timer> timers;
+  timers.reserve(count);
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < count; i++) {
+    timers.push_back(Clock::timer(interval * (i + 1), [&fired]() {
+      fired++;
+    }));
+  }
+
+  cout << "Created " << count << " timers in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  foreach (const Timer& timer, timers) {
+    Clock::cancel(timer);
+  }
+
+  cout << "Canceled " << count << " timers in " << watch.elapsed() << endl;
+
+  timers.clear();
+
+  for (size_t i = 0; i < count; i++) {
+    timers.push_back(Clock::timer(interval * (i + 1), [&fired]() {
+      fired++;
+    }));
+  }
+
+  watch.start();
+
+  Clock::advance(Hours(1));
+  Clock::settle();
+
+  cout << "Expired " << fired.load() << " timers in " << watch.elapsed()
+       << endl;
+
+  EXPECT_EQ(count, fired.load());
+
+  Clock::resume();
+}
+
+
+// Measures how long it takes the reaper to notice the exit of a child
+// while it is waiting for many children, which are killed gradually.
+TEST(ProcessTest, Process_BENCHMARK_ReapLatency)
+{
+  const size_t count = 10000;
+
+  // Kill this many children every 10 milliseconds.
+  const size_t batch = 100;
+
+  vector<pid_t> children;
+  children.reserve(count);
+
+  for (size_t i = 0; i < count; i++) {
+    pid_t pid = ::fork();
+    ASSERT_NE(-1, pid);
+
+    if (pid == 0) {
+      ::execlp("sleep", "sleep", "1000", nullptr);
+      ::_exit(EXIT_FAILURE);
+    }
+
+    children.push_back(pid);
+  }
+
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
+  vector<TimePoint> killed(count);
+  vector<TimePoint> reaped(count);
+
+  list<Future<Option<int>>> futures;
+
+  for (size_t i = 0; i < count; i++) {
+    futures.push_back(process::reap(children[i])
+      .onAny([&reaped, i]() {
+        reaped[i] = std::chrono::steady_clock::now();
+      }));
+  }
+
+  // Let the reaper start waiting for all the children.
+  os::sleep(Seconds(1));
+
+  for (size_t i = 0; i < count; i++) {
+    killed[i] = std::chrono::steady_clock::now();
+    ASSERT_EQ(0, ::kill(children[i], SIGKILL));
+
+    if ((i + 1) % batch == 0) {
+      os::sleep(Milliseconds(10));
+    }
+  }
+
+  AWAIT_READY_FOR(collect(futures), Minutes(5));
+
+  vector<Duration> latencies;
+  latencies.reserve(count);
+
+  for (size_t i = 0; i < count; i++) {
+    latencies.push_back(Nanoseconds(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            reaped[i] - killed[i]).count()));
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  cout << "Reaped " << count << " children"
+       << ": p50 " << latencies[count / 2]
+       << ", p99 " << latencies[count * 99 / 100]
+       << ", max " << latencies.back() << endl;
+}
+
+
+// Measures how many subprocesses can be launched per second from a
+// parent with an increasing amount of resident memory, comparing the
+// default way of creating the child (which avoids copying the page
+// tables of the parent where possible) with a plain 'fork()'.
+TEST(ProcessTest, Process_BENCHMARK_SubprocessLaunch)
+{
+  const size_t launches = 500;
+
+  const vector<Bytes> heapSizes = {Bytes(0), Megabytes(256), Gigabytes(2)};
+
+  foreach (const Bytes& heapSize, heapSizes) {
+    // Touch the memory so that it is actually mapped.
+    std::unique_ptr<char[]> heap(new char[heapSize.bytes() + 1]);
+    memset(heap.get(), 1, heapSize.bytes() + 1);
+
+    const vector<std::pair<string, Option<lambda::function<
+        pid_t(const lambda::function<int()>&)>>>> clones = {
+      {"default", None()},
+      {"fork", process::defaultClone},
+    };
+
+    foreach (const auto& clone, clones) {
+      list<Future<Option<int>>> statuses;
+
+      Stopwatch watch;
+      watch.start();
+
+      for (size_t i = 0; i < launches; i++) {
+        Try<Subprocess> s = process::subprocess(
+            "true",
+            {"true"},
+            Subprocess::FD(STDIN_FILENO),
+            Subprocess::FD(STDOUT_FILENO),
+            Subprocess::FD(STDERR_FILENO),
+            process::NO_SETSID,
+            nullptr,
+            None(),
+            clone.second);
+
+        ASSERT_SOME(s);
+        statuses.push_back(s->status());
+      }
+
+      Duration elapsed = watch.elapsed();
+
+      AWAIT_READY_FOR(collect(statuses), Minutes(1));
+
+      cout << heapSize << " heap, " << clone.first << ": "
+           << launches / elapsed.secs() << " launches / sec" << endl;
+    }
+  }
+}
+
+
+// A process that serves a trivial HTTP endpoint.
+class PingServerProcess : public Process<PingServerProcess>
+{
+protected:
+  virtual void initialize()
+  {
+    route("/ping", None(), &PingServerProcess::ping);
+  }
+
+private:
+  Future<http::Response> ping(const http::Request& request)
+  {
+    return http::OK("pong");
+  }
+};
+
+
+// Sends 'remaining' requests on 'connection', one after the other.
+static Future<Nothing> sendRequests(
+    http::Connection connection,
+    const http::Request& request,
+    size_t remaining)
+{
+  if (remaining == 0) {
+    return connection.disconnect();
+  }
+
+  return connection.send(request)
+    .then([=](const http::Response& response) -> Future<Nothing> {
+      if (response.code != http::Status::OK) {
+        return Failure("Unexpected response status " + response.status);
+      }
+
+      return sendRequests(connection, request, remaining - 1);
+    });
+}
+
+
+// Measures the HTTP request throughput over an increasing number of
+// concurrent connections, i.e., how well the event loops handle many
+// sockets. Run with LIBPROCESS_NUM_EVENT_LOOPS to compare a single
+// event loop with several.
+TEST(ProcessTest, Process_BENCHMARK_ManyConnectionsHTTP)
+{
+  const size_t requests = 50000;
+
+  Option<string> eventLoops = os::getenv("LIBPROCESS_NUM_EVENT_LOOPS");
+
+  cout << "Event loops: "
+       << (eventLoops.isSome() ? eventLoops.get() : "1") << endl;
+
+  PingServerProcess server;
+  spawn(server);
+
+  http::URL url(
+      "http",
+      server.self().address.ip,
+      server.self().address.port,
+      server.self().id + "/ping");
+
+  http::Request request;
+  request.method = "GET";
+  request.url = url;
+  request.keepAlive = true;
+
+  const vector<size_t> numConnections = {10, 100, 1000, 5000};
+
+  foreach (size_t connections, numConnections) {
+    list<Future<http::Connection>> connects;
+    for (size_t i = 0; i < connections; i++) {
+      connects.push_back(http::connect(url));
+    }
+
+    Future<list<http::Connection>> connected = collect(connects);
+    AWAIT_READY_FOR(connected, Minutes(1));
+
+    Stopwatch watch;
+    watch.start();
+
+    list<Future<Nothing>> futures;
+    foreach (const http::Connection& connection, connected.get()) {
+      futures.push_back(
+          sendRequests(connection, request, requests / connections));
+    }
+
+    AWAIT_READY_FOR(collect(futures), Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << connections << " connections: "
+         << requests / elapsed.secs() << " requests / sec" << endl;
+  }
+
+  terminate(server);
+  wait(server);
+}
@@ -15,20 +15,29 @@
 #include <deque>
 #include <string>
 
+#include <process/message.hpp>
 #include <process/owned.hpp>
+#include <process/pid.hpp>
 #include <process/socket.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 
 #include "decoder.hpp"
+#include "encoder.hpp"
 
 namespace http = process::http;
 
 using process::DataDecoder;
 using process::Future;
+using process::Message;
+using process::MessageDecoder;
+using process::MessageEncoder;
 using process::Owned;
 using process::ResponseDecoder;
 using process::StreamingResponseDecoder;
+using process::UPID;
+using process::UpgradeEncoder;
 
 using process::network::Socket;
 
@@ -119,6 +128,146 @@ TEST(DecoderTest, RequestHeaderCaseInsensitive)
 }
 
 
+// Tests that the data following a request that upgrades the
+// connection to binary framing is left for a `MessageDecoder`, which
+// decodes frames that are split across reads.
+TEST(DecoderTest, Upgrade)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+  DataDecoder decoder = DataDecoder(socket.get(), true);
+
+  Message message;
+  message.name = "name";
+  message.from = UPID("sender@127.0.0.1:5050");
+  message.to = UPID("receiver@127.0.0.1:5051");
+  message.body = string("bo\0dy", 5);
+
+  const string frames =
+    MessageEncoder::encode(&message, MessageEncoder::BINARY) +
+    MessageEncoder::encode(&message, MessageEncoder::BINARY);
+
+  const string data =
+    MessageEncoder::encode(&message, MessageEncoder::HTTP, true) +
+    UpgradeEncoder::encode() +
+    frames.substr(0, 10);
+
+  deque<http::Request*> requests = decoder.decode(data.data(), data.length());
+  ASSERT_FALSE(decoder.failed());
+
+  // Only the message sent before the upgrade is an HTTP request.
+  ASSERT_EQ(1u, requests.size());
+
+  Owned<http::Request> request(requests[0]);
+  EXPECT_EQ("/receiver/name", request->url.path);
+  EXPECT_EQ(message.body, request->body);
+  EXPECT_SOME_EQ(
+      string(process::BINARY_FRAMING),
+      request->headers.get("Libprocess-Framing"));
+
+  ASSERT_SOME(decoder.upgraded());
+
+  MessageDecoder messages(socket.get());
+
+  deque<Message*> decoded =
+    messages.decode(decoder.upgraded()->data(), decoder.upgraded()->size());
+
+  ASSERT_FALSE(messages.failed());
+  EXPECT_TRUE(decoded.empty());
+
+  decoded = messages.decode(frames.data() + 10, frames.size() - 10);
+  ASSERT_FALSE(messages.failed());
+  ASSERT_EQ(2u, decoded.size());
+
+  foreach (Message* m, decoded) {
+    Owned<Message> owned(m);
+
+    EXPECT_EQ(message.name, owned->name);
+    EXPECT_EQ(message.from, owned->from);
+    EXPECT_EQ(message.to, owned->to);
+    EXPECT_EQ(message.body, owned->body);
+  }
+}
+
+
+// Tests that a request to upgrade the connection to binary framing is
+// decoded as a plain HTTP request when binary framing is disabled.
+TEST(DecoderTest, UpgradeDisabled)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+  DataDecoder decoder = DataDecoder(socket.get(), false);
+
+  const string data = UpgradeEncoder::encode();
+
+  deque<http::Request*> requests = decoder.decode(data.data(), data.length());
+  ASSERT_FALSE(decoder.failed());
+  EXPECT_NONE(decoder.upgraded());
+
+  ASSERT_EQ(1u, requests.size());
+
+  Owned<http::Request> request(requests[0]);
+  EXPECT_SOME_EQ(
+      string(process::BINARY_FRAMING),
+      request->headers.get("Upgrade"));
+}
+
+
+// Tests that messages only advertise binary framing when asked to,
+// i.e., when binary framing is enabled.
+TEST(DecoderTest, AdvertiseBinaryFraming)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+  DataDecoder decoder = DataDecoder(socket.get());
+
+  Message message;
+  message.name = "name";
+  message.from = UPID("sender@127.0.0.1:5050");
+  message.to = UPID("receiver@127.0.0.1:5051");
+
+  const string data =
+    MessageEncoder::encode(&message) +
+    MessageEncoder::encode(&message, MessageEncoder::HTTP, true);
+
+  deque<http::Request*> requests = decoder.decode(data.data(), data.length());
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(2u, requests.size());
+
+  Owned<http::Request> plain(requests[0]);
+  Owned<http::Request> advertising(requests[1]);
+
+  EXPECT_NONE(plain->headers.get("Libprocess-Framing"));
+  EXPECT_SOME_EQ(
+      string(process::BINARY_FRAMING),
+      advertising->headers.get("Libprocess-Framing"));
+}
+
+
+// Tests that a `MessageDecoder` fails as soon as it receives the
+// header of a frame that is larger than the maximum frame size,
+// rather than buffering the frame.
+TEST(DecoderTest, MessageFrameTooLarge)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+
+  MessageDecoder decoder(socket.get());
+
+  // The lengths of the name, 'from', 'to' and body of the frame.
+  const string header =
+    string("\0\0\0\0", 4) +
+    string("\0\0\0\0", 4) +
+    string("\0\0\0\0", 4) +
+    string("\x7f\xff\xff\xff", 4);
+
+  deque<Message*> decoded = decoder.decode(header.data(), header.size());
+
+  EXPECT_TRUE(decoded.empty());
+  EXPECT_TRUE(decoder.failed());
+}
+
+
 TEST(DecoderTest, Response)
 {
   ResponseDecoder decoder;
@@ -411,6 +411,43 @@ TEST(HTTPTest, PipeReaderCloses)
 }
 
 
+TEST(HTTPTest, PipeDrained)
+{
+  http::Pipe pipe;
+  http::Pipe::Reader reader = pipe.reader();
+  http::Pipe::Writer writer = pipe.writer();
+
+  // Nothing has been written yet.
+  AWAIT_READY(writer.drained());
+
+  EXPECT_TRUE(writer.write("hello"));
+  EXPECT_TRUE(writer.write("world"));
+
+  // The writer is only notified once all the writes have been read.
+  Future<Nothing> drained = writer.drained();
+  EXPECT_TRUE(drained.isPending());
+
+  AWAIT_EQ("hello", reader.read());
+  EXPECT_TRUE(drained.isPending());
+
+  AWAIT_EQ("world", reader.read());
+  AWAIT_READY(drained);
+
+  // Writes that satisfy a pending read are never buffered.
+  Future<string> read = reader.read();
+  EXPECT_TRUE(writer.write("!"));
+  AWAIT_EQ("!", read);
+  AWAIT_READY(writer.drained());
+
+  // Closing the read end fails the waiting writers.
+  EXPECT_TRUE(writer.write("hello"));
+  drained = writer.drained();
+  EXPECT_TRUE(reader.close());
+  AWAIT_FAILED(drained);
+  AWAIT_FAILED(writer.drained());
+}
+
+
 TEST(HTTPTest, Encode)
 {
   string unencoded = "a$&+,/:;=?@ \"<>#%{}|\\^~[]`\x19\x80\xFF";
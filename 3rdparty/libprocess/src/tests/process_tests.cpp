@@ -20,7 +20,9 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 
+#include <algorithm>
 #include <atomic>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <tuple>
@@ -55,6 +57,7 @@
 #include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/try.hpp>
 
 #include <stout/os/killtree.hpp>
@@ -83,6 +86,7 @@ using process::run;
 using process::Subprocess;
 using process::TerminateEvent;
 using process::Time;
+using process::Timer;
 using process::UPID;
 
 using process::firewall::DisabledEndpointsFirewallRule;
@@ -596,6 +600,73 @@ TEST(ProcessTest, Delay)
 }
 
 
+// Tests that timers spread over all the levels of the clock's timer
+// wheel (and beyond) fire in order and never before their timeout.
+TEST(ProcessTest, Timers)
+{
+  Clock::pause();
+
+  const vector<Duration> timeouts = {
+    Days(60),
+    Milliseconds(1),
+    Seconds(5),
+    Hours(2),
+    Microseconds(1500),
+    Milliseconds(300),
+    Days(3),
+    Minutes(5),
+    Microseconds(1200)
+  };
+
+  std::mutex mutex;
+  vector<Duration> fired;
+
+  vector<Timer> timers;
+  foreach (const Duration& timeout, timeouts) {
+    timers.push_back(Clock::timer(timeout, [&mutex, &fired, timeout]() {
+      synchronized (mutex) {
+        fired.push_back(timeout);
+      }
+    }));
+  }
+
+  // A canceled timer must not fire.
+  Timer canceled = Clock::timer(Minutes(5), []() { FAIL(); });
+  EXPECT_TRUE(Clock::cancel(canceled));
+  EXPECT_FALSE(Clock::cancel(canceled));
+
+  vector<Duration> sorted = timeouts;
+  std::sort(sorted.begin(), sorted.end());
+
+  Duration elapsed = Duration::zero();
+
+  for (size_t i = 0; i < sorted.size(); i++) {
+    Clock::advance(sorted[i] - elapsed - Microseconds(1));
+    Clock::settle();
+
+    synchronized (mutex) {
+      EXPECT_EQ(i, fired.size());
+    }
+
+    Clock::advance(Microseconds(1));
+    Clock::settle();
+
+    elapsed = sorted[i];
+
+    synchronized (mutex) {
+      ASSERT_EQ(i + 1, fired.size());
+      EXPECT_EQ(sorted[i], fired.back());
+    }
+  }
+
+  foreach (const Timer& timer, timers) {
+    EXPECT_FALSE(Clock::cancel(timer));
+  }
+
+  Clock::resume();
+}
+
+
 class OrderProcess : public Process<OrderProcess>
 {
 public:
@@ -1509,6 +1580,70 @@ TEST(ProcessTest, Provide)
 }
 
 
+// Tests that a single byte range of a file can be requested with a
+// 'Range' header.
+TEST(ProcessTest, ProvideRange)
+{
+  const Try<string> mkdtemp = os::mkdtemp();
+  ASSERT_SOME(mkdtemp);
+
+  const string DATA = "0123456789";
+
+  const string path = path::join(mkdtemp.get(), "data.txt");
+  ASSERT_SOME(os::write(path, DATA));
+
+  FileServer server(path);
+  PID<FileServer> pid = spawn(server);
+
+  http::Headers headers;
+
+  headers["Range"] = "bytes=2-5";
+  Future<http::Response> response = http::get(pid, None(), None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::Status::string(http::Status::PARTIAL_CONTENT), response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 2-5/10", "Content-Range", response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("2345", response);
+
+  // An open ended range.
+  headers["Range"] = "bytes=7-";
+  response = http::get(pid, None(), None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::Status::string(http::Status::PARTIAL_CONTENT), response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("789", response);
+
+  // A suffix range.
+  headers["Range"] = "bytes=-3";
+  response = http::get(pid, None(), None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::Status::string(http::Status::PARTIAL_CONTENT), response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("789", response);
+
+  // A range after the end of the file cannot be satisfied.
+  headers["Range"] = "bytes=10-";
+  response = http::get(pid, None(), None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::Status::string(http::Status::REQUESTED_RANGE_NOT_SATISFIABLE),
+      response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes */10", "Content-Range", response);
+
+  // Multiple ranges are ignored.
+  headers["Range"] = "bytes=0-1,4-5";
+  response = http::get(pid, None(), None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(DATA, response);
+
+  terminate(server);
+  wait(server);
+
+  ASSERT_SOME(os::rmdir(mkdtemp.get()));
+}
+
+
 static int baz(string s) { return 42; }
 
 
@@ -15,6 +15,10 @@
 
 #include <sys/wait.h>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 #include <gtest/gtest.h>
 
 #include <process/clock.hpp>
@@ -191,3 +195,45 @@ TEST(ReapTest, TerminatedChildProcess)
 
   Clock::resume();
 }
+
+
+#if defined(__linux__) && defined(__NR_pidfd_open)
+// Checks that the termination of a child is noticed without polling
+// (i.e., without advancing the clock) where pidfds are supported.
+TEST(ReapTest, ChildProcessWithoutPolling)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  // Check that pidfds are supported (Linux 5.3+).
+  int pidfd = ::syscall(__NR_pidfd_open, ::getpid(), 0);
+  if (pidfd < 0) {
+    LOG(WARNING) << "Skipping test: pidfds are not supported: "
+                 << os::strerror(errno);
+    return;
+  }
+
+  ASSERT_SOME(os::close(pidfd));
+
+  Try<ProcessTree> tree = Fork(None(),
+                               Exec("sleep 10"))();
+
+  ASSERT_SOME(tree);
+  pid_t child = tree.get();
+
+  // Pausing the clock stops the reaper from polling.
+  Clock::pause();
+
+  Future<Option<int>> status = process::reap(child);
+
+  EXPECT_EQ(0, kill(child, SIGKILL));
+
+  AWAIT_READY(status);
+
+  ASSERT_SOME(status.get());
+  int status_ = status.get().get();
+  ASSERT_TRUE(WIFSIGNALED(status_));
+  ASSERT_EQ(SIGKILL, WTERMSIG(status_));
+
+  Clock::resume();
+}
+#endif // __linux__ && __NR_pidfd_open
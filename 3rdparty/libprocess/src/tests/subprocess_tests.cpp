@@ -30,6 +30,7 @@
 #include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/path.hpp>
+#include <stout/strings.hpp>
 #include <stout/uuid.hpp>
 
 #include <stout/os/close.hpp>
@@ -41,6 +42,7 @@
 namespace io = process::io;
 
 using process::Clock;
+using process::Future;
 using process::subprocess;
 using process::Subprocess;
 using process::MAX_REAP_INTERVAL;
@@ -994,6 +996,88 @@ TEST_F(SubprocessTest, EnvironmentOverride)
   int status = s.get().status().get().get();
   EXPECT_TRUE(WIFEXITED(status));
   EXPECT_EQ(0, WEXITSTATUS(status));
+
+  // The environment of the parent is left untouched.
+  EXPECT_SOME_EQ("world", os::getenv("MESSAGE2"));
+}
+
+
+// Ensures that the executable is looked up in the PATH of the child.
+TEST_F(SubprocessTest, EnvironmentPath)
+{
+  const string script = path::join(sandbox.get(), "hello");
+  ASSERT_SOME(os::write(script, "#!/bin/sh\necho hello\n"));
+  ASSERT_SOME(os::chmod(script, 0755));
+
+  map<string, string> environment;
+  environment["PATH"] = "/nonexistent:" + sandbox.get();
+
+  Try<Subprocess> s = subprocess(
+      "hello",
+      {"hello"},
+      Subprocess::FD(STDIN_FILENO),
+      Subprocess::PIPE(),
+      Subprocess::FD(STDERR_FILENO),
+      process::NO_SETSID,
+      nullptr,
+      environment);
+
+  ASSERT_SOME(s);
+  ASSERT_SOME(s.get().out());
+  AWAIT_EXPECT_EQ("hello\n", io::read(s.get().out().get()));
+
+  // Advance time until the internal reaper reaps the subprocess.
+  Clock::pause();
+  while (s.get().status().isPending()) {
+    Clock::advance(MAX_REAP_INTERVAL());
+    Clock::settle();
+  }
+  Clock::resume();
+
+  AWAIT_ASSERT_READY(s.get().status());
+  ASSERT_SOME(s.get().status().get());
+
+  int status = s.get().status().get().get();
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+
+// Ensures that a child that fails to exec exits with the `errno` of
+// the exec without affecting the parent, whose memory it might share
+// until it exec's.
+TEST_F(SubprocessTest, ExecFailure)
+{
+  const string path = path::join(sandbox.get(), "nonexistent");
+
+  Try<Subprocess> s = subprocess(
+      path,
+      {path},
+      Subprocess::FD(STDIN_FILENO),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::PIPE());
+
+  ASSERT_SOME(s);
+  ASSERT_SOME(s.get().err());
+
+  Future<string> err = io::read(s.get().err().get());
+  AWAIT_READY(err);
+  EXPECT_TRUE(strings::contains(err.get(), "Failed to os::execvpe"));
+
+  // Advance time until the internal reaper reaps the subprocess.
+  Clock::pause();
+  while (s.get().status().isPending()) {
+    Clock::advance(MAX_REAP_INTERVAL());
+    Clock::settle();
+  }
+  Clock::resume();
+
+  AWAIT_ASSERT_READY(s.get().status());
+  ASSERT_SOME(s.get().status().get());
+
+  int status = s.get().status().get().get();
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(ENOENT, WEXITSTATUS(status));
 }
 #endif // __WINDOWS__
 
@@ -0,0 +1,344 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <algorithm>
+#include <list>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+
+#include "timer_wheel.hpp"
+
+using std::list;
+using std::vector;
+
+namespace process {
+
+// Number of bits of a tick used to index the slots of the first
+// level, and of each of the following levels.
+static const int FIRST_LEVEL_BITS = 8;
+static const int LEVEL_BITS = 6;
+
+static const int64_t FIRST_LEVEL_MASK = (1 << FIRST_LEVEL_BITS) - 1;
+static const int64_t LEVEL_MASK = (1 << LEVEL_BITS) - 1;
+
+
+TimerWheel::TimerWheel()
+  : current(0),
+    stale(false)
+{
+  levels[0].resize(1 << FIRST_LEVEL_BITS);
+  for (int level = 1; level < LEVELS; level++) {
+    levels[level].resize(1 << LEVEL_BITS);
+  }
+
+  std::fill(counts, counts + LEVELS + 1, 0);
+}
+
+
+int64_t TimerWheel::ticks(const Time& time)
+{
+  return time.duration().ns() / Milliseconds(1).ns();
+}
+
+
+int TimerWheel::shift(int level)
+{
+  return level == 0 ? 0 : FIRST_LEVEL_BITS + (level - 1) * LEVEL_BITS;
+}
+
+
+void TimerWheel::add(uint64_t id, const Timer& timer)
+{
+  const Time time = timer.timeout().time();
+  const int64_t tick = ticks(time);
+
+  // Nothing is pending, so the wheel can be turned freely.
+  if (index.empty()) {
+    current = tick;
+  }
+
+  Slot entries;
+  entries.push_back(Entry{id, tick, time, timer});
+  place(&entries);
+
+  if (!stale && (earliest.isNone() || time < earliest.get())) {
+    earliest = time;
+  }
+}
+
+
+bool TimerWheel::remove(uint64_t id)
+{
+  auto it = index.find(id);
+  if (it == index.end()) {
+    return false;
+  }
+
+  const Location& location = it->second;
+
+  // NOTE: A lower bound stays a lower bound when a timer is removed,
+  // we only recompute it to avoid firing a tick too early.
+  if (earliest.isSome() &&
+      location.entry->time == earliest.get()) {
+    stale = true;
+  }
+
+  const int64_t tick = location.entry->tick;
+
+  counts[location.level]--;
+  location.slot->erase(location.entry);
+
+  if (location.level == LEVELS && location.slot->empty()) {
+    overflow.erase(tick);
+  }
+
+  index.erase(it);
+
+  return true;
+}
+
+
+list<Timer> TimerWheel::expire(const Time& now)
+{
+  const int64_t tick = ticks(now);
+
+  // The timers of a tick are sorted by their exact timeout as they are
+  // expired, the ticks themselves are expired in order.
+  auto before = [](const Entry& left, const Entry& right) {
+    if (left.time != right.time) {
+      return left.time < right.time;
+    }
+    return left.id < right.id;
+  };
+
+  Slot expired;
+
+  while (current < tick) {
+    // All the timers of a tick before 'now' are expired.
+    Slot entries;
+    take(0, &levels[0][current & FIRST_LEVEL_MASK], &entries);
+
+    entries.sort(before);
+    expired.splice(expired.end(), entries);
+
+    int64_t next = current + 1;
+
+    if (index.size() == expired.size()) {
+      // Only the expired timers are left in the index.
+      next = tick;
+    } else {
+      // Skip over the ticks for which no timers can be due: if the
+      // lowest levels are empty, nothing happens until the next slot
+      // of the first non-empty level has to be cascaded.
+      for (int level = 0; level < LEVELS && counts[level] == 0; level++) {
+        const int bits = shift(level + 1);
+        next = std::max(next, ((current >> bits) + 1) << bits);
+      }
+
+      next = std::min(next, tick);
+    }
+
+    const int64_t previous = current;
+
+    current = next;
+
+    // Cascade if we entered a new slot of the second level.
+    if ((previous >> FIRST_LEVEL_BITS) != (current >> FIRST_LEVEL_BITS)) {
+      cascade();
+    }
+  }
+
+  // The timers of the current tick are only expired once their exact
+  // timeout has elapsed.
+  Slot& slot = levels[0][current & FIRST_LEVEL_MASK];
+  Slot entries;
+
+  for (auto entry = slot.begin(); entry != slot.end();) {
+    if (entry->time <= now) {
+      counts[0]--;
+      entries.splice(entries.end(), slot, entry++);
+    } else {
+      ++entry;
+    }
+  }
+
+  entries.sort(before);
+  expired.splice(expired.end(), entries);
+
+  stale = true;
+
+  list<Timer> timers;
+  foreach (Entry& entry, expired) {
+    index.erase(entry.id);
+    timers.push_back(std::move(entry.timer));
+  }
+
+  return timers;
+}
+
+
+Option<Time> TimerWheel::next()
+{
+  if (!stale) {
+    return earliest;
+  }
+
+  stale = false;
+  earliest = None();
+
+  if (index.empty()) {
+    return earliest;
+  }
+
+  // The first non-empty slot of the first level holds the earliest
+  // timers of that level, which we look at individually.
+  if (counts[0] > 0) {
+    for (int64_t i = 0; i <= FIRST_LEVEL_MASK; i++) {
+      const Slot& slot = levels[0][(current + i) & FIRST_LEVEL_MASK];
+      if (!slot.empty()) {
+        foreach (const Entry& entry, slot) {
+          if (earliest.isNone() || entry.time < earliest.get()) {
+            earliest = entry.time;
+          }
+        }
+        break;
+      }
+    }
+  }
+
+  // For the other levels we use the start of their first non-empty
+  // slot, which is where the timers will be cascaded.
+  //
+  // NOTE: The slot 'current' is in on each level has already been
+  // cascaded, so we start with the one after it. The timers in that
+  // slot are a full turn of the level ahead.
+  for (int level = 1; level < LEVELS; level++) {
+    if (counts[level] == 0) {
+      continue;
+    }
+
+    const int bits = shift(level);
+    for (int64_t i = 1; i <= LEVEL_MASK + 1; i++) {
+      const int64_t slot = (current >> bits) + i;
+      if (!levels[level][slot & LEVEL_MASK].empty()) {
+        const Time start = Time::epoch() + Milliseconds(slot << bits);
+        if (earliest.isNone() || start < earliest.get()) {
+          earliest = start;
+        }
+        break;
+      }
+    }
+  }
+
+  if (!overflow.empty()) {
+    const Time start = Time::epoch() + Milliseconds(overflow.begin()->first);
+    if (earliest.isNone() || start < earliest.get()) {
+      earliest = start;
+    }
+  }
+
+  return earliest;
+}
+
+
+void TimerWheel::clear()
+{
+  for (int level = 0; level < LEVELS; level++) {
+    foreach (Slot& slot, levels[level]) {
+      slot.clear();
+    }
+  }
+
+  std::fill(counts, counts + LEVELS + 1, 0);
+
+  overflow.clear();
+  index.clear();
+
+  earliest = None();
+  stale = false;
+}
+
+
+void TimerWheel::take(int level, Slot* slot, Slot* to)
+{
+  counts[level] -= slot->size();
+  to->splice(to->end(), *slot);
+}
+
+
+void TimerWheel::place(Slot* entries)
+{
+  while (!entries->empty()) {
+    const int64_t tick = entries->front().tick;
+    const int64_t delta = tick - current;
+
+    int level = 0;
+    Slot* slot = nullptr;
+
+    if (delta < (1 << FIRST_LEVEL_BITS)) {
+      // NOTE: Timers that are already due go in the current slot.
+      slot = &levels[0][std::max(tick, current) & FIRST_LEVEL_MASK];
+    } else {
+      for (level = 1; level < LEVELS; level++) {
+        if (delta < (int64_t(1) << shift(level + 1))) {
+          slot = &levels[level][(tick >> shift(level)) & LEVEL_MASK];
+          break;
+        }
+      }
+
+      if (slot == nullptr) {
+        slot = &overflow[tick];
+      }
+    }
+
+    counts[level]++;
+    slot->splice(slot->end(), *entries, entries->begin());
+    index[slot->back().id] = Location{level, slot, std::prev(slot->end())};
+  }
+}
+
+
+void TimerWheel::cascade()
+{
+  // The timers of a slot are cascaded when 'current' enters that slot.
+  // Since 'current' might skip over several slots of the first level
+  // at once (but never over a non-empty one on any level), we cascade
+  // the slot of each level that 'current' is in, as long as 'current'
+  // is at the start of the slot of the previous level.
+  for (int level = 1; level < LEVELS; level++) {
+    const int bits = shift(level);
+
+    Slot entries;
+    take(level, &levels[level][(current >> bits) & LEVEL_MASK], &entries);
+    place(&entries);
+
+    if (((current >> shift(level + 1)) << shift(level + 1)) != current) {
+      return;
+    }
+  }
+
+  // Bring the overflowing timers that are now within range.
+  const int64_t limit = current + (int64_t(1) << shift(LEVELS));
+
+  while (!overflow.empty() && overflow.begin()->first < limit) {
+    Slot entries;
+    take(LEVELS, &overflow.begin()->second, &entries);
+    overflow.erase(overflow.begin());
+    place(&entries);
+  }
+}
+
+} // namespace process {
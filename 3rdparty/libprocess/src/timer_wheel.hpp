@@ -0,0 +1,136 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_TIMER_WHEEL_HPP__
+#define __PROCESS_TIMER_WHEEL_HPP__
+
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <process/time.hpp>
+#include <process/timer.hpp>
+
+#include <stout/option.hpp>
+
+namespace process {
+
+// Stores pending timers in a hierarchical timing wheel (see Varghese
+// and Lauck, "Hashed and Hierarchical Timing Wheels"), so that adding
+// and removing a timer takes constant time regardless of the number
+// of pending timers.
+//
+// Time is divided into 1 millisecond ticks. The first level of the
+// wheel has a slot for each of the next 256 ticks, and each of the
+// following four levels has 64 slots, each spanning all the slots of
+// the previous level. A timer is put in the lowest level that covers
+// its timeout and is moved ("cascaded") down one level at a time as
+// the wheel turns. Timers beyond the last level (about 49 days) are
+// kept in an ordered overflow map until they come within range.
+//
+// Expiration is batched per tick: all the timers of a tick are
+// expired at once, except for the current tick, whose timers are
+// only expired once their exact timeout has elapsed.
+//
+// NOTE: This is not thread-safe, the clock serializes all access.
+class TimerWheel
+{
+public:
+  TimerWheel();
+
+  // Adds a timer. The 'id' must be unique among the pending timers,
+  // and it orders the timers that have the same timeout.
+  void add(uint64_t id, const Timer& timer);
+
+  // Removes a pending timer. Returns false if there is no pending
+  // timer with this 'id'.
+  bool remove(uint64_t id);
+
+  // Removes and returns all the timers whose timeout is not after
+  // 'now', ordered by their timeout (and then by 'id').
+  std::list<Timer> expire(const Time& now);
+
+  // Returns a lower bound of the earliest timeout, or None if there
+  // are no pending timers. The bound is exact for the timers that are
+  // due within the first level of the wheel, and otherwise the start
+  // of the slot holding the earliest timers, which is always after
+  // the last time passed to 'expire()'.
+  Option<Time> next();
+
+  size_t size() const { return index.size(); }
+  bool empty() const { return index.empty(); }
+
+  void clear();
+
+private:
+  static const int LEVELS = 5;
+
+  struct Entry
+  {
+    uint64_t id;
+    int64_t tick;
+    Time time; // The timeout of the timer.
+    Timer timer;
+  };
+
+  typedef std::list<Entry> Slot;
+
+  // Where an entry is stored, so that it can be removed in constant
+  // time. A 'level' of 'LEVELS' denotes the overflow map.
+  struct Location
+  {
+    int level;
+    Slot* slot;
+    Slot::iterator entry;
+  };
+
+  static int64_t ticks(const Time& time);
+
+  // Returns the number of low bits of a tick used by the levels below
+  // 'level', i.e., the span of a slot at 'level' is '1 << shift(level)'.
+  static int shift(int level);
+
+  // Moves 'slot' (which is 'level') to the end of 'to', maintaining
+  // the counts. The entries are left in the index, to be updated by
+  // 'place()' or erased once expired.
+  void take(int level, Slot* slot, Slot* to);
+
+  // Puts the given entries into their slots relative to 'current',
+  // updating their location in the index.
+  void place(Slot* entries);
+
+  // Cascades the slots that are due as 'current' enters a new slot
+  // of the first level.
+  void cascade();
+
+  std::vector<Slot> levels[LEVELS];
+  size_t counts[LEVELS + 1];
+
+  std::map<int64_t, Slot> overflow;
+
+  std::unordered_map<uint64_t, Location> index;
+
+  // The tick that is being expired. All the ticks before it have been
+  // expired and the wheel has been turned accordingly.
+  int64_t current;
+
+  // Cached result of 'next()', recomputed if 'stale'.
+  Option<Time> earliest;
+  bool stale;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_TIMER_WHEEL_HPP__
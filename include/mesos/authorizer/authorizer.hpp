@@ -17,6 +17,8 @@
 #ifndef __MESOS_AUTHORIZER_AUTHORIZER_HPP__
 #define __MESOS_AUTHORIZER_AUTHORIZER_HPP__
 
+#include <vector>
+
 #include <mesos/mesos.hpp>
 
 // ONLY USEFUL AFTER RUNNING PROTOC.
@@ -144,6 +146,26 @@ public:
   virtual process::Future<bool> authorized(
       const authorization::Request& request) = 0;
 
+  /**
+   * Checks a batch of requests with the identity server back end,
+   * see `authorized()` above. This allows callers that need many
+   * decisions at once (e.g., the master authorizing all the tasks
+   * of an accept call) to make a single call to the authorizer.
+   *
+   * The default implementation calls `authorized()` for each of
+   * the requests, implementations can override it in order to
+   * evaluate the whole batch at once.
+   *
+   * @param requests The `authorization::Request` instances to check.
+   *
+   * @return One result per request, in the same order as the
+   *     requests. Each result has the same semantics as the result of
+   *     `authorized()` for that request, i.e., a failed future only
+   *     indicates a problem processing that request.
+   */
+  virtual std::vector<process::Future<bool>> authorized(
+      const std::vector<authorization::Request>& requests);
+
   /**
    * Creates an `ObjectApprover` which can synchronously check authorization on
    * an object.
@@ -173,7 +173,9 @@ public:
     // Attempts to append the specified data to the log. Returns the
     // new ending position of the log or 'none' if this writer has
     // lost it's promise to exclusively write (which can be reacquired
-    // by invoking Writer::start).
+    // by invoking Writer::start). An append does not need to wait for
+    // the previous appends (or truncates) to be done, the returned
+    // futures are completed in the order of their positions.
     process::Future<Option<Position>> append(const std::string& data);
 
     // Attempts to truncate the log up to but not including the
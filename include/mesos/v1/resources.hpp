@@ -17,6 +17,8 @@
 #ifndef __MESOS_V1_RESOURCES_HPP__
 #define __MESOS_V1_RESOURCES_HPP__
 
+#include <stdint.h>
+
 #include <map>
 #include <iosfwd>
 #include <set>
@@ -92,6 +94,8 @@ private:
       if (resource.has_shared()) {
         sharedCount = 1;
       }
+
+      intern();
     }
 
     // By implicitly converting to Resource we are able to keep Resource_
@@ -141,6 +145,18 @@ private:
     // 'resource' is non-shared. This is an int so as to support arithmetic
     // operations involving subtraction.
     Option<int> sharedCount;
+
+    // The interned name of the 'resource' if it is a plain quantity,
+    // i.e., an unreserved, non-revocable, non-shared scalar without
+    // DiskInfo (e.g., "cpus:1"), otherwise None. Two such resources
+    // can be combined iff their interned names are equal, which lets
+    // the arithmetic and 'contains()' compare integers instead of the
+    // protobufs field by field.
+    Option<uint32_t> scalar;
+
+    // (Re-)computes 'scalar', must be called whenever anything but
+    // the scalar value of 'resource' has been modified.
+    void intern();
   };
 
 public:
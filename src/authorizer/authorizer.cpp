@@ -14,12 +14,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <vector>
+
 #include <mesos/authorizer/authorizer.hpp>
 
 #include <mesos/authorizer/acls.hpp>
 
 #include <mesos/module/authorizer.hpp>
 
+#include <process/future.hpp>
+
+#include <stout/foreach.hpp>
 #include <stout/path.hpp>
 
 #include "authorizer/local/authorizer.hpp"
@@ -30,8 +35,11 @@
 
 #include "module/manager.hpp"
 
+using process::Future;
+
 using std::ostream;
 using std::string;
+using std::vector;
 
 using mesos::internal::LocalAuthorizer;
 
@@ -47,4 +55,18 @@ Try<Authorizer*> Authorizer::create(const ACLs& acls)
   return LocalAuthorizer::create(acls);
 }
 
+
+vector<Future<bool>> Authorizer::authorized(
+    const vector<authorization::Request>& requests)
+{
+  vector<Future<bool>> authorizations;
+  authorizations.reserve(requests.size());
+
+  foreach (const authorization::Request& request, requests) {
+    authorizations.push_back(authorized(request));
+  }
+
+  return authorizations;
+}
+
 } // namespace mesos {
@@ -16,6 +16,8 @@
 
 #include "authorizer/local/authorizer.hpp"
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -29,11 +31,15 @@
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
+#include <stout/cache.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/path.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/try.hpp>
 #include <stout/unreachable.hpp>
 
@@ -45,6 +51,7 @@ using process::Failure;
 using process::Future;
 using process::Owned;
 
+using std::shared_ptr;
 using std::string;
 using std::vector;
 
@@ -58,25 +65,19 @@ struct GenericACL
 };
 
 
-// TODO(mpark): This class exists to optionally carry `ACL::SetQuota` and
-// `ACL::RemoveQuota` ACLs. This is a hack to support the deprecation cycle for
-// `ACL::SetQuota` and `ACL::RemoveQuota`. This can be removed / replaced with
-// `vector<GenericACL>` at the end of deprecation cycle which started with 1.0.
-struct GenericACLs
+// An `ACL::Entity` of an ACL with its values kept in a hashset so
+// that requests can be checked against it in constant time.
+struct CompiledEntity
 {
-  GenericACLs(const vector<GenericACL>& acls_) : acls(acls_) {}
-
-  GenericACLs(
-      const vector<GenericACL>& acls_,
-      const vector<GenericACL>& set_quotas_,
-      const vector<GenericACL>& remove_quotas_)
-    : acls(acls_), set_quotas(set_quotas_), remove_quotas(remove_quotas_) {}
-
-  vector<GenericACL> acls;
+  explicit CompiledEntity(const ACL::Entity& entity) : type(entity.type())
+  {
+    foreach (const string& value, entity.values()) {
+      values.insert(value);
+    }
+  }
 
-  // These ACLs are set iff the authorization action is `UPDATE_QUOTA`.
-  Option<vector<GenericACL>> set_quotas;
-  Option<vector<GenericACL>> remove_quotas;
+  ACL::Entity::Type type;
+  hashset<string> values;
 };
 
 
@@ -92,36 +93,28 @@ struct GenericACLs
 //  |       -------|-------|-------|-------
 //  |        ANY   |  No   |  Yes  |   Yes
 //          -------|-------|-------|-------
-static bool matches(const ACL::Entity& request, const ACL::Entity& acl)
+static bool matches(const ACL::Entity& request, const CompiledEntity& acl)
 {
   // NONE only matches with NONE.
   if (request.type() == ACL::Entity::NONE) {
-    return acl.type() == ACL::Entity::NONE;
+    return acl.type == ACL::Entity::NONE;
   }
 
   // ANY matches with ANY or NONE.
   if (request.type() == ACL::Entity::ANY) {
-    return acl.type() == ACL::Entity::ANY || acl.type() == ACL::Entity::NONE;
+    return acl.type == ACL::Entity::ANY || acl.type == ACL::Entity::NONE;
   }
 
   if (request.type() == ACL::Entity::SOME) {
     // SOME matches with ANY or NONE.
-    if (acl.type() == ACL::Entity::ANY || acl.type() == ACL::Entity::NONE) {
+    if (acl.type == ACL::Entity::ANY || acl.type == ACL::Entity::NONE) {
       return true;
     }
 
     // SOME is allowed if the request values are a subset of ACL
     // values.
     foreach (const string& value, request.values()) {
-      bool found = false;
-      foreach (const string& value_, acl.values()) {
-        if (value == value_) {
-          found = true;
-          break;
-        }
-      }
-
-      if (!found) {
+      if (!acl.values.contains(value)) {
         return false;
       }
     }
@@ -143,41 +136,33 @@ static bool matches(const ACL::Entity& request, const ACL::Entity& acl)
 //  |       -------|-------|-------|-------
 //  |        ANY   |  No   |  No   |   Yes
 //          -------|-------|-------|-------
-static bool allows(const ACL::Entity& request, const ACL::Entity& acl)
+static bool allows(const ACL::Entity& request, const CompiledEntity& acl)
 {
   // NONE is only allowed by NONE.
   if (request.type() == ACL::Entity::NONE) {
-    return acl.type() == ACL::Entity::NONE;
+    return acl.type == ACL::Entity::NONE;
   }
 
   // ANY is only allowed by ANY.
   if (request.type() == ACL::Entity::ANY) {
-    return acl.type() == ACL::Entity::ANY;
+    return acl.type == ACL::Entity::ANY;
   }
 
   if (request.type() == ACL::Entity::SOME) {
     // SOME is allowed by ANY.
-    if (acl.type() == ACL::Entity::ANY) {
+    if (acl.type == ACL::Entity::ANY) {
       return true;
     }
 
     // SOME is not allowed by NONE.
-    if (acl.type() == ACL::Entity::NONE) {
+    if (acl.type == ACL::Entity::NONE) {
       return false;
     }
 
     // SOME is allowed if the request values are a subset of ACL
     // values.
     foreach (const string& value, request.values()) {
-      bool found = false;
-      foreach (const string& value_, acl.values()) {
-        if (value == value_) {
-          found = true;
-          break;
-        }
-      }
-
-      if (!found) {
+      if (!acl.values.contains(value)) {
         return false;
       }
     }
@@ -188,6 +173,266 @@ static bool allows(const ACL::Entity& request, const ACL::Entity& acl)
 }
 
 
+// An ordered list of `GenericACL`s compiled into a two level index,
+// first by subject and then by object value, so that finding the
+// first ACL that matches a request does not require a linear scan.
+//
+// ACLs whose subjects (or objects) are ANY or NONE can match any
+// request and are hence kept in "wildcard" lists. The candidates for
+// a request are the ACLs in the (up to) four lists selected by its
+// subject and object, each of which is sorted by the position of the
+// ACL in the original list. Walking these lists in merged order
+// preserves the "first match wins" semantics of the ACLs.
+//
+// Decisions are memoized in a bounded LRU cache since the same
+// principals tend to launch tasks as the same users over and over.
+// The ACLs never change after the authorizer has been created, hence
+// the cache is only ever invalidated by eviction.
+//
+// NOTE: An ACL with `m` subject and `n` object values is indexed
+// under all `m * n` combinations of them.
+class CompiledACLs
+{
+public:
+  explicit CompiledACLs(const vector<GenericACL>& acls)
+    : decisions(DECISIONS_CAPACITY)
+  {
+    for (size_t i = 0; i < acls.size(); i++) {
+      entries.push_back(Entry(acls[i]));
+
+      const Entry& entry = entries.back();
+
+      vector<Objects*> subjects;
+      if (entry.subjects.type == ACL::Entity::SOME) {
+        foreach (const string& subject, entry.subjects.values) {
+          subjects.push_back(&indexed[subject]);
+        }
+      } else {
+        subjects.push_back(&wildcards);
+      }
+
+      foreach (Objects* objects, subjects) {
+        if (entry.objects.type == ACL::Entity::SOME) {
+          foreach (const string& object, entry.objects.values) {
+            objects->indexed[object].push_back(i);
+          }
+        } else {
+          objects->wildcards.push_back(i);
+        }
+      }
+    }
+  }
+
+  size_t size() const { return entries.size(); }
+
+  // Returns whether the first ACL that matches the subject and the
+  // object allows them, or none if no ACL matches.
+  Option<bool> approved(
+      const ACL::Entity& subject,
+      const ACL::Entity& object) const
+  {
+    const string key = CompiledACLs::key(subject) + CompiledACLs::key(object);
+
+    synchronized (mutex) {
+      Option<Option<bool>> decision = decisions.get(key);
+      if (decision.isSome()) {
+        return decision.get();
+      }
+    }
+
+    Option<bool> decision = lookup(subject, object);
+
+    synchronized (mutex) {
+      decisions.put(key, decision);
+    }
+
+    return decision;
+  }
+
+private:
+  static const size_t DECISIONS_CAPACITY = 1024;
+
+  struct Entry
+  {
+    explicit Entry(const GenericACL& acl)
+      : subjects(acl.subjects), objects(acl.objects) {}
+
+    CompiledEntity subjects;
+    CompiledEntity objects;
+  };
+
+  // Indices (into `entries`) of ACLs, in ascending order.
+  struct Objects
+  {
+    vector<size_t> wildcards;
+    hashmap<string, vector<size_t>> indexed;
+  };
+
+  // Returns the first value of a SOME entity, i.e., the value by
+  // which a request selects its candidate ACLs.
+  static Option<string> first(const ACL::Entity& entity)
+  {
+    if (entity.type() == ACL::Entity::SOME && entity.values_size() > 0) {
+      return entity.values(0);
+    }
+
+    return None();
+  }
+
+  // Returns an unambiguous encoding of the entity for the decision
+  // cache, each value being prefixed by its length.
+  static string key(const ACL::Entity& entity)
+  {
+    string key = std::to_string(entity.type()) + ";" +
+                 std::to_string(entity.values_size()) + ";";
+
+    foreach (const string& value, entity.values()) {
+      key += std::to_string(value.size()) + ":" + value;
+    }
+
+    return key;
+  }
+
+  bool matches(
+      size_t index,
+      const ACL::Entity& subject,
+      const ACL::Entity& object) const
+  {
+    const Entry& entry = entries[index];
+
+    return mesos::internal::matches(subject, entry.subjects) &&
+           mesos::internal::matches(object, entry.objects);
+  }
+
+  Option<bool> decide(
+      size_t index,
+      const ACL::Entity& subject,
+      const ACL::Entity& object) const
+  {
+    const Entry& entry = entries[index];
+
+    return allows(subject, entry.subjects) && allows(object, entry.objects);
+  }
+
+  Option<bool> lookup(
+      const ACL::Entity& subject,
+      const ACL::Entity& object) const
+  {
+    // A SOME entity without any values is a subset of all SOME ACL
+    // entities, so it can not be used to select candidates.
+    if ((subject.type() == ACL::Entity::SOME && subject.values_size() == 0) ||
+        (object.type() == ACL::Entity::SOME && object.values_size() == 0)) {
+      for (size_t i = 0; i < entries.size(); i++) {
+        if (matches(i, subject, object)) {
+          return decide(i, subject, object);
+        }
+      }
+
+      return None();
+    }
+
+    const Option<string> subject_ = first(subject);
+    const Option<string> object_ = first(object);
+
+    // Collect the candidate lists, all of which are sorted.
+    vector<const vector<size_t>*> candidates;
+
+    auto collect = [&candidates, &object_](const Objects& objects) {
+      candidates.push_back(&objects.wildcards);
+
+      if (object_.isSome()) {
+        auto indexed = objects.indexed.find(object_.get());
+        if (indexed != objects.indexed.end()) {
+          candidates.push_back(&indexed->second);
+        }
+      }
+    };
+
+    collect(wildcards);
+
+    if (subject_.isSome()) {
+      auto indexed_ = indexed.find(subject_.get());
+      if (indexed_ != indexed.end()) {
+        collect(indexed_->second);
+      }
+    }
+
+    // Walk the candidates in the order of the ACLs. Candidates still
+    // need to be matched since requests with more than one value (or
+    // with ANY or NONE) are only partially covered by the index.
+    vector<size_t> positions(candidates.size(), 0);
+
+    while (true) {
+      Option<size_t> next = None();
+      size_t list = 0;
+
+      for (size_t i = 0; i < candidates.size(); i++) {
+        if (positions[i] < candidates[i]->size()) {
+          size_t index = (*candidates[i])[positions[i]];
+          if (next.isNone() || index < next.get()) {
+            next = index;
+            list = i;
+          }
+        }
+      }
+
+      if (next.isNone()) {
+        return None();
+      }
+
+      positions[list]++;
+
+      if (matches(next.get(), subject, object)) {
+        return decide(next.get(), subject, object);
+      }
+    }
+  }
+
+  vector<Entry> entries;
+
+  // ACLs whose subjects are ANY or NONE.
+  Objects wildcards;
+
+  // ACLs whose subjects are SOME, by subject value.
+  hashmap<string, Objects> indexed;
+
+  // Approvers are used outside of the authorizer process, hence the
+  // decision cache needs to be synchronized.
+  mutable std::mutex mutex;
+  mutable Cache<string, Option<bool>> decisions;
+};
+
+
+// TODO(mpark): This class exists to optionally carry `ACL::SetQuota` and
+// `ACL::RemoveQuota` ACLs. This is a hack to support the deprecation cycle for
+// `ACL::SetQuota` and `ACL::RemoveQuota`. This can be removed / replaced with
+// `CompiledACLs` at the end of deprecation cycle which started with 1.0.
+//
+// NOTE: The ACLs are compiled once when the authorizer is initialized
+// and then shared (read-only) by all object approvers.
+struct GenericACLs
+{
+  GenericACLs(const vector<GenericACL>& acls_)
+    : acls(new CompiledACLs(acls_)) {}
+
+  GenericACLs(
+      const vector<GenericACL>& acls_,
+      const vector<GenericACL>& set_quotas_,
+      const vector<GenericACL>& remove_quotas_)
+    : acls(new CompiledACLs(acls_)),
+      set_quotas(shared_ptr<const CompiledACLs>(
+          new CompiledACLs(set_quotas_))),
+      remove_quotas(shared_ptr<const CompiledACLs>(
+          new CompiledACLs(remove_quotas_))) {}
+
+  shared_ptr<const CompiledACLs> acls;
+
+  // These ACLs are set iff the authorization action is `UPDATE_QUOTA`.
+  Option<shared_ptr<const CompiledACLs>> set_quotas;
+  Option<shared_ptr<const CompiledACLs>> remove_quotas;
+};
+
+
 class LocalAuthorizerObjectApprover : public ObjectApprover
 {
 public:
@@ -286,14 +531,15 @@ public:
           // TODO(mpark): This is a hack to support the deprecation cycle for
           // `ACL::SetQuota` and `ACL::RemoveQuota`. This block of code can be
           // removed at the end of deprecation cycle which started with 1.0.
-          if (acls_.set_quotas->size() > 0 || acls_.remove_quotas->size() > 0) {
+          if (acls_.set_quotas.get()->size() > 0 ||
+              acls_.remove_quotas.get()->size() > 0) {
             CHECK_NOTNULL(object->value);
             if (*object->value == "SetQuota") {
               aclObject.add_values(object->quota_info->role());
               aclObject.set_type(mesos::ACL::Entity::SOME);
 
               CHECK_SOME(acls_.set_quotas);
-              return approved(acls_.set_quotas.get(), aclSubject, aclObject);
+              return approved(*acls_.set_quotas.get(), aclSubject, aclObject);
             } else if (*object->value == "RemoveQuota") {
               if (object->quota_info->has_principal()) {
                 aclObject.add_values(object->quota_info->principal());
@@ -303,7 +549,8 @@ public:
               }
 
               CHECK_SOME(acls_.remove_quotas);
-              return approved(acls_.remove_quotas.get(), aclSubject, aclObject);
+              return approved(
+                  *acls_.remove_quotas.get(), aclSubject, aclObject);
             }
           }
 
@@ -374,20 +621,19 @@ public:
       }
     }
 
-    return approved(acls_.acls, aclSubject, aclObject);
+    return approved(*acls_.acls, aclSubject, aclObject);
   }
 
 private:
   bool approved(
-      const vector<GenericACL>& acls,
+      const CompiledACLs& acls,
       const ACL::Entity& subject,
       const ACL::Entity& object) const
   {
     // Authorize subject/object.
-    foreach (const GenericACL& acl, acls) {
-      if (matches(subject, acl.subjects) && matches(object, acl.objects)) {
-        return allows(subject, acl.subjects) && allows(object, acl.objects);
-      }
+    Option<bool> approved = acls.approved(subject, object);
+    if (approved.isSome()) {
+      return approved.get();
     }
 
     return permissive_; // None of the ACLs match.
@@ -423,12 +669,9 @@ public:
         acls.teardown_frameworks_size() > 0) {
       LOG(WARNING) << "ACLs defined for both ShutdownFramework and "
                    << "TeardownFramework; only the latter will be used";
-      return;
-    }
-
-    // Move contents of `acls.shutdown_frameworks` to
-    // `acls.teardown_frameworks`
-    if (acls.shutdown_frameworks_size() > 0) {
+    } else if (acls.shutdown_frameworks_size() > 0) {
+      // Move contents of `acls.shutdown_frameworks` to
+      // `acls.teardown_frameworks`
       LOG(WARNING) << "ShutdownFramework ACL is deprecated; please use "
                    << "TeardownFramework";
       foreach (const ACL::ShutdownFramework& acl, acls.shutdown_frameworks()) {
@@ -439,23 +682,53 @@ public:
       }
     }
     acls.clear_shutdown_frameworks();
+
+    // Compile the ACLs of each action once, rather than for each
+    // authorization request. No ACLs are compiled for actions we
+    // can not generate ACLs for (e.g., `UNKNOWN`).
+    for (int action = authorization::Action_MIN;
+         action <= authorization::Action_MAX;
+         action++) {
+      if (!authorization::Action_IsValid(action)) {
+        continue;
+      }
+
+      Option<GenericACLs> genericACLs =
+        createGenericACLs(static_cast<authorization::Action>(action), acls);
+
+      if (genericACLs.isSome()) {
+        compiled.put(action, genericACLs.get());
+      }
+    }
   }
 
   Future<bool> authorized(const authorization::Request& request)
   {
-    return getObjectApprover(request.subject(), request.action())
-      .then([=](const Owned<ObjectApprover>& objectApprover) -> Future<bool> {
-        Option<ObjectApprover::Object> object = None();
-        if (request.has_object()) {
-          object = ObjectApprover::Object(request.object());
-        }
+    Try<bool> result = approved(request);
+    if (result.isError()) {
+      return Failure(result.error());
+    }
+    return result.get();
+  }
 
-        Try<bool> result = objectApprover->approved(object);
-        if (result.isError()) {
-          return Failure(result.error());
-        }
-        return result.get();
-      });
+  // NOTE: A request that cannot be evaluated only fails its own
+  // result, not the whole batch.
+  vector<Future<bool>> authorized(
+      const vector<authorization::Request>& requests)
+  {
+    vector<Future<bool>> results;
+    results.reserve(requests.size());
+
+    foreach (const authorization::Request& request, requests) {
+      Try<bool> result = approved(request);
+      if (result.isError()) {
+        results.push_back(Failure(result.error()));
+      } else {
+        results.push_back(result.get());
+      }
+    }
+
+    return results;
   }
 
   Future<Owned<ObjectApprover>> getObjectApprover(
@@ -473,12 +746,7 @@ public:
       }
     };
 
-    // Generate GenericACLs.
-    Result<GenericACLs> genericACLs = createGenericACLs(action, acls);
-    if (genericACLs.isError()) {
-      return Failure(genericACLs.error());
-    }
-
+    Option<GenericACLs> genericACLs = compiled.get(action);
     if (genericACLs.isNone()) {
       // If we could not create acls, we deny all objects.
       return Owned<ObjectApprover>(new RejectingObjectApprover());
@@ -490,7 +758,29 @@ public:
   }
 
 private:
-  static Result<GenericACLs> createGenericACLs(
+  // Evaluates the request synchronously, i.e., the same way as an
+  // object approver returned by `getObjectApprover()` would.
+  Try<bool> approved(const authorization::Request& request)
+  {
+    Option<GenericACLs> genericACLs = compiled.get(request.action());
+    if (genericACLs.isNone()) {
+      // If we could not create acls, we deny all objects.
+      return false;
+    }
+
+    Option<ObjectApprover::Object> object = None();
+    if (request.has_object()) {
+      object = ObjectApprover::Object(request.object());
+    }
+
+    return LocalAuthorizerObjectApprover(
+        genericACLs.get(),
+        request.subject(),
+        request.action(),
+        acls.permissive()).approved(object);
+  }
+
+  static Option<GenericACLs> createGenericACLs(
       const authorization::Action& action,
       const ACLs& acls)
   {
@@ -727,6 +1017,9 @@ private:
   }
 
   ACLs acls;
+
+  // The compiled ACLs by action, see `initialize()`.
+  hashmap<int, GenericACLs> compiled;
 };
 
 
@@ -823,10 +1116,9 @@ LocalAuthorizer::~LocalAuthorizer()
 }
 
 
-process::Future<bool> LocalAuthorizer::authorized(
-  const authorization::Request& request)
+// Request sanity checks.
+static void sanityCheck(const authorization::Request& request)
 {
-  // Request sanity checks.
   // A set `subject` should always come with a set `value`.
   CHECK(
     !request.has_subject() ||
@@ -846,6 +1138,13 @@ process::Future<bool> LocalAuthorizer::authorized(
       request.object().has_task_info() ||
       request.object().has_executor_info() ||
       request.object().has_quota_info())));
+}
+
+
+process::Future<bool> LocalAuthorizer::authorized(
+  const authorization::Request& request)
+{
+  sanityCheck(request);
 
   typedef Future<bool> (LocalAuthorizerProcess::*F)(
       const authorization::Request&);
@@ -857,6 +1156,36 @@ process::Future<bool> LocalAuthorizer::authorized(
 }
 
 
+vector<process::Future<bool>> LocalAuthorizer::authorized(
+  const vector<authorization::Request>& requests)
+{
+  foreach (const authorization::Request& request, requests) {
+    sanityCheck(request);
+  }
+
+  typedef vector<Future<bool>> (LocalAuthorizerProcess::*F)(
+      const vector<authorization::Request>&);
+
+  // All the requests are evaluated with a single dispatch, the
+  // result of each request is then picked out of the batch.
+  Future<vector<Future<bool>>> batch = dispatch(
+      process,
+      static_cast<F>(&LocalAuthorizerProcess::authorized),
+      requests);
+
+  vector<Future<bool>> results;
+  results.reserve(requests.size());
+
+  for (size_t i = 0; i < requests.size(); i++) {
+    results.push_back(batch.then([i](const vector<Future<bool>>& results) {
+      return results[i];
+    }));
+  }
+
+  return results;
+}
+
+
 Future<Owned<ObjectApprover>> LocalAuthorizer::getObjectApprover(
       const Option<authorization::Subject>& subject,
       const authorization::Action& action)
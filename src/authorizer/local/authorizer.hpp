@@ -17,6 +17,8 @@
 #ifndef __AUTHORIZER_AUTHORIZER_HPP__
 #define __AUTHORIZER_AUTHORIZER_HPP__
 
+#include <vector>
+
 #include <mesos/authorizer/authorizer.hpp>
 
 #include <process/future.hpp>
@@ -65,6 +67,11 @@ public:
   virtual process::Future<bool> authorized(
       const authorization::Request& request);
 
+  // Evaluates all the requests with a single dispatch to the
+  // authorizer process.
+  virtual std::vector<process::Future<bool>> authorized(
+      const std::vector<authorization::Request>& requests);
+
   virtual process::Future<process::Owned<ObjectApprover>> getObjectApprover(
       const Option<authorization::Subject>& subject,
       const authorization::Action& action);
@@ -22,6 +22,7 @@
 #include <process/subprocess.hpp>
 
 #include <stout/os.hpp>
+#include <stout/stringify.hpp>
 #include <stout/unreachable.hpp>
 
 #include "common/command_utils.hpp"
@@ -167,10 +168,12 @@ Future<Nothing> untar(
 }
 
 
-Future<string> sha512(const Path& input)
+// Computes the SHA checksum of a file with the given algorithm
+// (e.g., 256 or 512).
+static Future<string> shasum(const Path& input, int algorithm)
 {
 #ifdef __linux__
-  const string cmd = "sha512sum";
+  const string cmd = "sha" + stringify(algorithm) + "sum";
   vector<string> argv = {
     cmd,
     input             // Input file to compute shasum.
@@ -179,7 +182,7 @@ Future<string> sha512(const Path& input)
   const string cmd = "shasum";
   vector<string> argv = {
     cmd,
-    "-a", "512",      // Shasum type.
+    "-a", stringify(algorithm), // Shasum type.
     input             // Input file to compute shasum.
   };
 #endif // __linux__
@@ -199,6 +202,18 @@ Future<string> sha512(const Path& input)
 }
 
 
+Future<string> sha256(const Path& input)
+{
+  return shasum(input, 256);
+}
+
+
+Future<string> sha512(const Path& input)
+{
+  return shasum(input, 512);
+}
+
+
 Future<Nothing> gzip(const Path& input)
 {
   vector<string> argv = {
@@ -0,0 +1,237 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __WINDOWS__
+#include <errno.h>
+#include <fnmatch.h>
+#include <time.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif // __WINDOWS__
+
+#include <iterator>
+#include <list>
+#include <set>
+#include <utility>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/option.hpp>
+#include <stout/path.hpp>
+
+#include <stout/os/exists.hpp>
+#include <stout/os/ls.hpp>
+
+#include "common/disk_usage.hpp"
+
+using std::list;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+
+const list<string>* DiskUsageCache::get(
+    const string& directory,
+    const Version& version)
+{
+  Option<Listings::iterator> listing = index.get(directory);
+
+  if (listing.isNone()) {
+    return nullptr;
+  }
+
+  const Version& cached = listing.get()->second.version;
+
+  if (cached.device != version.device ||
+      cached.inode != version.inode ||
+      cached.modified != version.modified) {
+    erase(listing.get());
+    return nullptr;
+  }
+
+  // Move the listing to the most recently used end.
+  listings.splice(listings.end(), listings, listing.get());
+
+  return &listing.get()->second.names;
+}
+
+
+void DiskUsageCache::put(
+    const string& directory,
+    const Version& version,
+    const list<string>& names)
+{
+  Option<Listings::iterator> listing = index.get(directory);
+  if (listing.isSome()) {
+    erase(listing.get());
+  }
+
+  // The modification time only has a resolution of a second, so a
+  // directory that was modified in the current second might be
+  // modified again without its version changing. Its listing is not
+  // cached until the next walk.
+  if (version.modified >= ::time(nullptr) || names.size() > capacity) {
+    return;
+  }
+
+  listings.push_back({directory, Listing{version, names}});
+  index[directory] = std::prev(listings.end());
+  size += names.size();
+
+  while (size > capacity) {
+    erase(listings.begin());
+  }
+}
+
+
+void DiskUsageCache::erase(Listings::iterator listing)
+{
+  size -= listing->second.names.size();
+  index.erase(listing->first);
+  listings.erase(listing);
+}
+
+
+#ifndef __WINDOWS__
+// Returns true if 'path' matches one of the 'excludes' patterns, see
+// `diskUsage()`. So a relative pattern like 'file' matches 'file' in
+// every directory, while an absolute pattern only matches if the walk
+// started at an absolute path.
+static bool excluded(const string& path, const vector<string>& excludes)
+{
+  foreach (const string& exclude, excludes) {
+    if (::fnmatch(exclude.c_str(), path.c_str(), 0) == 0) {
+      return true;
+    }
+
+    for (size_t i = path.find('/');
+         i != string::npos;
+         i = path.find('/', i + 1)) {
+      if (i + 1 < path.size() && path[i + 1] != '/' &&
+          ::fnmatch(exclude.c_str(), path.c_str() + i + 1, 0) == 0) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+
+static DiskUsageCache::Version version(const struct stat& s)
+{
+  return DiskUsageCache::Version{
+      static_cast<uint64_t>(s.st_dev),
+      static_cast<uint64_t>(s.st_ino),
+      static_cast<int64_t>(s.st_mtime)};
+}
+#endif // __WINDOWS__
+
+
+Try<Bytes> diskUsage(
+    const string& path,
+    const vector<string>& excludes,
+    DiskUsageCache* cache)
+{
+#ifdef __WINDOWS__
+  // NOTE: The disk usage is not accounted for on Windows (see
+  // MESOS-5610), every tree is accounted as empty.
+  return Bytes(0);
+#else
+  // Inodes with more than one link which have been counted already.
+  std::set<std::pair<dev_t, ino_t>> inodes;
+
+  Bytes total;
+
+  struct stat s;
+  if (::lstat(path.c_str(), &s) < 0) {
+    return ErrnoError("Failed to stat '" + path + "'");
+  }
+
+  total += Bytes(s.st_blocks * 512);
+
+  // Directories left to be walked.
+  vector<pair<string, DiskUsageCache::Version>> directories;
+  if (S_ISDIR(s.st_mode)) {
+    directories.push_back({path, version(s)});
+  }
+
+  while (!directories.empty()) {
+    const string directory = directories.back().first;
+    const DiskUsageCache::Version _version = directories.back().second;
+    directories.pop_back();
+
+    const list<string>* names =
+      cache != nullptr ? cache->get(directory, _version) : nullptr;
+
+    Try<list<string>> listed = list<string>();
+
+    if (names == nullptr) {
+      listed = os::ls(directory);
+      if (listed.isError()) {
+        // The directory might have been removed after it was reached.
+        if (!os::exists(directory)) {
+          continue;
+        }
+
+        return Error(
+            "Failed to list directory '" + directory + "': " +
+            listed.error());
+      }
+
+      if (cache != nullptr) {
+        cache->put(directory, _version, listed.get());
+      }
+
+      names = &listed.get();
+    }
+
+    foreach (const string& name, *names) {
+      const string child = path::join(directory, name);
+
+      if (excluded(child, excludes)) {
+        continue;
+      }
+
+      if (::lstat(child.c_str(), &s) < 0) {
+        // The entry might have been removed after it was listed.
+        if (errno == ENOENT) {
+          continue;
+        }
+
+        return ErrnoError("Failed to stat '" + child + "'");
+      }
+
+      if (S_ISDIR(s.st_mode)) {
+        directories.push_back({child, version(s)});
+      } else if (s.st_nlink > 1 &&
+                 !inodes.insert({s.st_dev, s.st_ino}).second) {
+        continue;
+      }
+
+      total += Bytes(s.st_blocks * 512);
+    }
+  }
+
+  return total;
+#endif // __WINDOWS__
+}
+
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,113 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __COMMON_DISK_USAGE_HPP__
+#define __COMMON_DISK_USAGE_HPP__
+
+#include <stdint.h>
+
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stout/bytes.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+
+// Caches the listings of the directories walked by `diskUsage()`, so
+// that a directory that has not been modified since it was listed is
+// not listed again. Only the listings can be reused: writing to a file
+// does not modify the directory it is in, so the entries of every
+// directory are still stat'ed. The listings of the least recently
+// walked directories are dropped once more than 'capacity' names are
+// cached.
+//
+// NOTE: This class is not thread safe.
+class DiskUsageCache
+{
+public:
+  // Identifies a directory as it was listed, see `get()`.
+  struct Version
+  {
+    uint64_t device;
+    uint64_t inode;
+    int64_t modified; // In seconds since the epoch.
+  };
+
+  explicit DiskUsageCache(size_t _capacity) : capacity(_capacity), size(0) {}
+
+  // Returns the cached names of the entries of 'directory' if it is at
+  // the same version as when it was listed, otherwise `nullptr`. The
+  // names remain valid until the next call to `put()`.
+  const std::list<std::string>* get(
+      const std::string& directory,
+      const Version& version);
+
+  // Caches the names of the entries of 'directory' at 'version'.
+  void put(
+      const std::string& directory,
+      const Version& version,
+      const std::list<std::string>& names);
+
+private:
+  struct Listing
+  {
+    Version version;
+    std::list<std::string> names;
+  };
+
+  typedef std::list<std::pair<std::string, Listing>> Listings;
+
+  void erase(Listings::iterator listing);
+
+  const size_t capacity;
+
+  // The listings in least recently used order, and the total number
+  // of names in them.
+  Listings listings;
+  size_t size;
+
+  hashmap<std::string, Listings::iterator> index;
+};
+
+
+// Walks the file tree rooted at 'path' and returns the number of
+// bytes allocated to it, counting each inode once. Like `du`, symbolic
+// links are not followed, except for a root 'path' that ends with a
+// '/'. An entry that matches one of the 'excludes' patterns is skipped
+// along with everything below it, following the semantics of
+// `du --exclude`: a pattern is matched with fnmatch(3) against the
+// whole path as it was reached during the walk, or against any suffix
+// of it that starts after a '/'.
+//
+// If a 'cache' is given, the listings of the directories that have not
+// been modified since they were cached are reused (see `DiskUsageCache`).
+//
+// NOTE: This blocks until the whole tree has been walked, which can
+// take a long time, see `JobThreads`.
+Try<Bytes> diskUsage(
+    const std::string& path,
+    const std::vector<std::string>& excludes = std::vector<std::string>(),
+    DiskUsageCache* cache = nullptr);
+
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __COMMON_DISK_USAGE_HPP__
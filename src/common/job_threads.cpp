@@ -0,0 +1,116 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+
+#include <stout/foreach.hpp>
+
+#include "common/job_threads.hpp"
+
+using std::deque;
+using std::function;
+
+namespace mesos {
+namespace internal {
+
+JobThreads::JobThreads(size_t count)
+  : running(0),
+    stopping(false)
+{
+  CHECK_GT(count, 0u);
+
+  for (size_t i = 0; i < count; i++) {
+    threads.emplace_back(&JobThreads::work, this);
+  }
+}
+
+
+JobThreads::~JobThreads()
+{
+  deque<Job> discarded;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    discarded.swap(jobs);
+  }
+
+  queued.notify_all();
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+
+  foreach (const Job& job, discarded) {
+    job.discard();
+  }
+}
+
+
+void JobThreads::post(const function<void()>& job)
+{
+  enqueue(job, []() {});
+}
+
+
+void JobThreads::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+
+  idle.wait(lock, [this]() { return jobs.empty() && running == 0; });
+}
+
+
+void JobThreads::enqueue(
+    const function<void()>& run,
+    const function<void()>& discard)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(Job{run, discard});
+  }
+
+  queued.notify_one();
+}
+
+
+void JobThreads::work()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+
+  while (true) {
+    queued.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+    if (stopping) {
+      return;
+    }
+
+    Job job = std::move(jobs.front());
+    jobs.pop_front();
+    ++running;
+
+    lock.unlock();
+    job.run();
+    lock.lock();
+
+    if (--running == 0 && jobs.empty()) {
+      idle.notify_all();
+    }
+  }
+}
+
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,107 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __COMMON_JOB_THREADS_HPP__
+#define __COMMON_JOB_THREADS_HPP__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+
+// A fixed set of threads that run jobs in the order they are queued.
+// This is meant for jobs that block for a long time, e.g., walking or
+// removing a large file tree, which must not tie up the threads that
+// libprocess runs the processes on. With a single thread (the
+// default) the jobs run one at a time.
+class JobThreads
+{
+public:
+  explicit JobThreads(size_t count = 1);
+
+  // Waits for the running jobs to finish. The queued jobs are not
+  // run, the futures returned for them by `run()` are discarded.
+  ~JobThreads();
+
+  // Queues the job and returns its result. The future is completed on
+  // the thread that ran the job, so callers that need to get back onto
+  // their process must `defer` the callbacks.
+  template <typename T>
+  process::Future<T> run(const std::function<Try<T>()>& job)
+  {
+    process::Owned<process::Promise<T>> promise(new process::Promise<T>());
+
+    enqueue(
+        [job, promise]() {
+          const Try<T> result = job();
+
+          if (result.isError()) {
+            promise->fail(result.error());
+          } else {
+            promise->set(result.get());
+          }
+        },
+        [promise]() { promise->discard(); });
+
+    return promise->future();
+  }
+
+  // Queues a job without a result, see `wait()`.
+  void post(const std::function<void()>& job);
+
+  // Blocks until all queued jobs have finished.
+  void wait();
+
+private:
+  JobThreads(const JobThreads&) = delete; // Not copyable.
+  JobThreads& operator=(const JobThreads&) = delete; // Not assignable.
+
+  struct Job
+  {
+    std::function<void()> run;
+    std::function<void()> discard; // Invoked if the job is never run.
+  };
+
+  void enqueue(
+      const std::function<void()>& run,
+      const std::function<void()>& discard);
+
+  // Body of the threads.
+  void work();
+
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable queued;
+  std::condition_variable idle;
+  std::deque<Job> jobs;
+  size_t running;
+  bool stopping;
+};
+
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __COMMON_JOB_THREADS_HPP__
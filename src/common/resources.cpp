@@ -16,6 +16,8 @@
 
 #include <stdint.h>
 
+#include <atomic>
+#include <mutex>
 #include <ostream>
 #include <set>
 #include <string>
@@ -36,6 +38,7 @@
 #include <stout/lambda.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/strings.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/unreachable.hpp>
 
 using std::map;
@@ -837,6 +840,64 @@ bool Resources::isShared(const Resource& resource)
 // Public member functions.
 /////////////////////////////////////////////////
 
+// Returns a small integer that uniquely identifies the resource name.
+//
+// NOTE: This is called whenever a `Resource_` is constructed, possibly
+// from multiple threads, so the names that have already been interned
+// are looked up without taking a lock. The table of names is immutable
+// once it has been published; interning a new name publishes a copy of
+// the table that includes it. The set of resource names in a cluster
+// is small, so this only happens a handful of times. The replaced
+// tables are never freed since concurrent lookups might still use them.
+static uint32_t internName(const string& name)
+{
+  typedef hashmap<string, uint32_t> Names;
+
+  static std::atomic<const Names*>* names =
+    new std::atomic<const Names*>(new Names());
+
+  static std::mutex* mutex = new std::mutex();
+
+  Option<uint32_t> id = names->load(std::memory_order_acquire)->get(name);
+  if (id.isSome()) {
+    return id.get();
+  }
+
+  synchronized (mutex) {
+    // The name might have been interned while we were waiting.
+    const Names* current = names->load(std::memory_order_acquire);
+
+    id = current->get(name);
+    if (id.isSome()) {
+      return id.get();
+    }
+
+    Names* updated = new Names(*current);
+
+    uint32_t size = static_cast<uint32_t>(updated->size());
+    updated->put(name, size);
+
+    names->store(updated, std::memory_order_release);
+    return size;
+  }
+}
+
+
+void Resources::Resource_::intern()
+{
+  if (resource.type() == Value::SCALAR &&
+      resource.role() == "*" &&
+      !resource.has_reservation() &&
+      !resource.has_disk() &&
+      !resource.has_revocable() &&
+      !resource.has_shared()) {
+    scalar = internName(resource.name());
+  } else {
+    scalar = None();
+  }
+}
+
+
 Option<Error> Resources::Resource_::validate() const
 {
   if (isShared() && sharedCount.get() < 0) {
@@ -872,6 +933,13 @@ bool Resources::Resource_::contains(const Resource_& that) const
            resource == that.resource;
   }
 
+  // Plain quantities are only comparable with one another, in which
+  // case comparing the interned names and the values is sufficient.
+  if (scalar.isSome() || that.scalar.isSome()) {
+    return scalar == that.scalar &&
+           that.resource.scalar() <= resource.scalar();
+  }
+
   // For non-shared resources just compare the protobufs.
   return internal::contains(resource, that.resource);
 }
@@ -964,18 +1032,25 @@ Resources::Resources(const RepeatedPtrField<Resource>& _resources)
 
 bool Resources::contains(const Resources& that) const
 {
-  Resources remaining = *this;
+  // NOTE: We only need to copy the resources once we have to subtract
+  // a persistent volume, which keeps the common case (e.g., checking
+  // whether an agent can hold some scalar quantities) from allocating.
+  Option<Resources> remaining;
 
   foreach (const Resource_& resource_, that.resources) {
     // NOTE: We use _contains because Resources only contain valid
     // Resource objects, and we don't want the performance hit of the
     // validity check.
-    if (!remaining._contains(resource_)) {
+    if (!(remaining.isSome() ? remaining.get() : *this)._contains(resource_)) {
       return false;
     }
 
     if (isPersistentVolume(resource_.resource)) {
-      remaining.subtract(resource_);
+      if (remaining.isNone()) {
+        remaining = *this;
+      }
+
+      remaining->subtract(resource_);
     }
   }
 
@@ -1104,6 +1179,7 @@ Try<Resources> Resources::flatten(
     } else {
       resource_.resource.mutable_reservation()->CopyFrom(reservation.get());
     }
+    resource_.intern();
     flattened.add(resource_);
   }
 
@@ -1613,11 +1689,19 @@ void Resources::add(const Resource_& that)
 
   bool found = false;
   foreach (Resource_& resource_, resources) {
-    if (internal::addable(resource_.resource, that)) {
-      resource_ += that;
-      found = true;
-      break;
+    // Plain quantities can only be added to one another, in which
+    // case it is sufficient to compare the interned names.
+    if (resource_.scalar.isSome() || that.scalar.isSome()) {
+      if (resource_.scalar != that.scalar) {
+        continue;
+      }
+    } else if (!internal::addable(resource_.resource, that)) {
+      continue;
     }
+
+    resource_ += that;
+    found = true;
+    break;
   }
 
   // Cannot be combined with any existing Resource object.
@@ -1688,33 +1772,40 @@ void Resources::subtract(const Resource_& that)
   for (size_t i = 0; i < resources.size(); i++) {
     Resource_& resource_ = resources[i];
 
-    if (internal::subtractable(resource_.resource, that)) {
-      resource_ -= that;
-
-      // Remove the resource if it has become negative or empty.
-      // Note that a negative resource means the caller is
-      // subtracting more than they should!
-      //
-      // TODO(gyliu513): Provide a stronger interface to avoid
-      // silently allowing this to occur.
-
-      // A "negative" Resource_ either has a negative sharedCount or
-      // a negative scalar value.
-      bool negative =
-        (resource_.isShared() && resource_.sharedCount.get() < 0) ||
-        (resource_.resource.type() == Value::SCALAR &&
-         resource_.resource.scalar().value() < 0);
-
-      if (negative || resource_.isEmpty()) {
-        // As `resources` is not ordered, and erasing an element
-        // from the middle is expensive, we swap with the last element
-        // and then shrink the vector by one.
-        resources[i] = resources.back();
-        resources.pop_back();
+    // See the comment in `add` on plain quantities.
+    if (resource_.scalar.isSome() || that.scalar.isSome()) {
+      if (resource_.scalar != that.scalar) {
+        continue;
       }
+    } else if (!internal::subtractable(resource_.resource, that)) {
+      continue;
+    }
 
-      break;
+    resource_ -= that;
+
+    // Remove the resource if it has become negative or empty.
+    // Note that a negative resource means the caller is
+    // subtracting more than they should!
+    //
+    // TODO(gyliu513): Provide a stronger interface to avoid
+    // silently allowing this to occur.
+
+    // A "negative" Resource_ either has a negative sharedCount or
+    // a negative scalar value.
+    bool negative =
+      (resource_.isShared() && resource_.sharedCount.get() < 0) ||
+      (resource_.resource.type() == Value::SCALAR &&
+       resource_.resource.scalar().value() < 0);
+
+    if (negative || resource_.isEmpty()) {
+      // As `resources` is not ordered, and erasing an element
+      // from the middle is expensive, we swap with the last element
+      // and then shrink the vector by one.
+      resources[i] = resources.back();
+      resources.pop_back();
     }
+
+    break;
   }
 }
 
@@ -29,14 +29,19 @@
 
 #include <process/defer.hpp>
 #include <process/deferred.hpp> // TODO(benh): This is required by Clang.
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/help.hpp>
 #include <process/http.hpp>
 #include <process/io.hpp>
 #include <process/mime.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/timeout.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
@@ -79,7 +84,10 @@ using process::DESCRIPTION;
 using process::Failure;
 using process::Future;
 using process::HELP;
+using process::Owned;
 using process::Process;
+using process::Promise;
+using process::Timeout;
 using process::TLDR;
 using process::wait; // Necessary on some OS's to disambiguate.
 
@@ -92,6 +100,13 @@ using std::vector;
 namespace mesos {
 namespace internal {
 
+// How long a read that follows a file waits for the file to change
+// before returning no data, and how often the followed files are
+// checked for changes.
+static const Duration FOLLOW_TIMEOUT = Seconds(10);
+static const Duration FOLLOW_INTERVAL = Milliseconds(250);
+
+
 class FilesProcess : public Process<FilesProcess>
 {
 public:
@@ -111,11 +126,14 @@ public:
       const string& path,
       const Option<string>& principal);
 
+  // If 'follow' is set and there is no data at 'offset' yet, waits
+  // for the file to change (see `FOLLOW_TIMEOUT`) before reading.
   Future<Try<tuple<size_t, string>, FilesError>> read(
       const size_t offset,
       const Option<size_t>& length,
       const string& path,
-      const Option<string>& principal);
+      const Option<string>& principal,
+      bool follow);
 
 protected:
   virtual void initialize();
@@ -145,7 +163,8 @@ private:
   Future<Try<tuple<size_t, string>, FilesError>> _read(
       size_t offset,
       Option<size_t> length,
-      const string& path);
+      const string& path,
+      bool follow);
 
   // Reads data from a file at a given offset and for a given length.
   // See the jquery pailer for the expected behavior.
@@ -153,6 +172,22 @@ private:
       const http::Request& request,
       const Option<string>& principal);
 
+  // Returns the raw contents of a file, which libprocess sends with
+  // `sendfile`, honoring the byte range of a 'Range' header if any.
+  // If 'follow' is set, first waits for the file to grow beyond
+  // the byte offset 'follow' (see `FOLLOW_TIMEOUT`).
+  Future<http::Response> readRaw(
+      const string& path,
+      const Option<size_t>& follow);
+
+  // Returns a future that is satisfied once the size of the file at
+  // the (resolved) path is no longer 'size', or after
+  // `FOLLOW_TIMEOUT`.
+  Future<Nothing> watch(const string& path, size_t size);
+
+  // Checks the files being watched, periodically while there are any.
+  void _watch();
+
   // Returns the raw file contents for a given path.
   // Requests have the following parameters:
   //   path: The directory to browse. Required.
@@ -174,6 +209,18 @@ private:
 
   hashmap<string, string> paths;
 
+  // Reads waiting for a file to change, checked all at once so that
+  // many clients following files do not each poll them.
+  struct Watch
+  {
+    string path;
+    size_t size;
+    Timeout timeout;
+    Owned<Promise<Nothing>> promise;
+  };
+
+  list<Watch> watches;
+
   // Set of authorization functions. They will be called whenever
   // access to the path used as key is requested, and will pass
   // as parameter the principal returned by the HTTP authenticator.
@@ -469,7 +516,20 @@ const string FilesProcess::READ_HELP = HELP(
         ">        path=VALUE          The path of directory to browse.",
         ">        offset=VALUE        Value added to base address to obtain "
         "a second address",
-        ">        length=VALUE        Length of file to read."),
+        ">        length=VALUE        Length of file to read.",
+        ">        raw=true|false      Whether to return the raw contents",
+        ">                            of the file rather than a JSON object.",
+        ">        follow=true|false   Whether to wait for the file to grow",
+        ">                            when there is no data to read yet.",
+        "",
+        "With 'raw=true', the 'offset' and 'length' parameters are not",
+        "supported: a byte range of the file can be requested with a",
+        "'Range' header instead (e.g., 'Range: bytes=1024-'), and the",
+        "response is '206 Partial Content'.",
+        "",
+        "With 'follow=true', a read at the end of the file waits up to",
+        stringify(FOLLOW_TIMEOUT) + " for the file to change before",
+        "returning, so that the file can be tailed without polling."),
     AUTHENTICATION(true),
     AUTHORIZATION(
         "Reading files requires that the request principal is",
@@ -492,6 +552,52 @@ Future<http::Response> FilesProcess::__read(
     return BadRequest("Expecting 'path=value' in query.\n");
   }
 
+  const bool raw = request.url.query.get("raw") == string("true");
+
+  bool follow = request.url.query.get("follow") == string("true");
+
+  if (raw) {
+    if (request.url.query.get("offset").isSome() ||
+        request.url.query.get("length").isSome()) {
+      return BadRequest(
+          "Expecting a 'Range' header rather than 'offset' or 'length'"
+          " with 'raw=true'.\n");
+    }
+
+    // Follow from the first byte of the requested range, if any.
+    Option<size_t> first;
+
+    if (follow) {
+      first = 0;
+
+      Option<string> range = request.headers.get("Range");
+      if (range.isSome() && strings::startsWith(range.get(), "bytes=")) {
+        Try<size_t> result = numify<size_t>(strings::trim(strings::split(
+            range.get().substr(strlen("bytes=")), "-")[0]));
+
+        // NOTE: Suffix ranges (i.e., 'bytes=-N') are not followed.
+        if (result.isSome()) {
+          first = result.get();
+        } else {
+          first = None();
+        }
+      }
+    }
+
+    const string requestedPath = path.get();
+
+    return authorize(requestedPath, principal)
+      .then(defer(self(),
+          [this, requestedPath, first](bool authorized)
+            -> Future<http::Response> {
+        if (!authorized) {
+          return Forbidden();
+        }
+
+        return readRaw(requestedPath, first);
+      }));
+  }
+
   off_t offset = -1;
 
   if (request.url.query.get("offset").isSome()) {
@@ -544,9 +650,15 @@ Future<http::Response> FilesProcess::__read(
     length = 0;
   }
 
+  // There is nothing to follow when only the size of the file is
+  // requested.
+  if (length == 0) {
+    follow = false;
+  }
+
   Option<string> jsonp = request.url.query.get("jsonp");
 
-  return read(offset_, length, path.get(), principal)
+  return read(offset_, length, path.get(), principal, follow)
     .then([offset, jsonp](const Try<tuple<size_t, string>, FilesError>& result)
         -> Future<http::Response> {
       if (result.isError()) {
@@ -584,17 +696,18 @@ Future<Try<tuple<size_t, string>, FilesError>> FilesProcess::read(
     const size_t offset,
     const Option<size_t>& length,
     const string& path,
-    const Option<string>& principal)
+    const Option<string>& principal,
+    bool follow)
 {
   return authorize(path, principal)
     .then(defer(self(),
-        [this, offset, length, path](bool authorized)
+        [this, offset, length, path, follow](bool authorized)
           -> Future<Try<tuple<size_t, string>, FilesError>> {
       if (!authorized) {
         return FilesError(FilesError::Type::UNAUTHORIZED);
       }
 
-      return _read(offset, length, path);
+      return _read(offset, length, path, follow);
     }));
 }
 
@@ -602,7 +715,8 @@ Future<Try<tuple<size_t, string>, FilesError>> FilesProcess::read(
 Future<Try<tuple<size_t, string>, FilesError>> FilesProcess::_read(
     size_t offset,
     Option<size_t> length,
-    const string& path)
+    const string& path,
+    bool follow)
 {
   Result<string> resolvedPath = resolve(path);
 
@@ -643,6 +757,17 @@ Future<Try<tuple<size_t, string>, FilesError>> FilesProcess::_read(
     return FilesError(FilesError::Type::UNKNOWN, error + ".\n");
   }
 
+  // Wait for data to read at the end of the file, and then read
+  // again (without following, the wait is over).
+  if (follow && offset == static_cast<size_t>(size)) {
+    os::close(fd.get());
+
+    return watch(resolvedPath.get(), size)
+      .then(defer(self(), [this, offset, length, path]() {
+        return _read(offset, length, path, false);
+      }));
+  }
+
   if (offset >= static_cast<size_t>(size)) {
     os::close(fd.get());
     return std::make_tuple(size, "");
@@ -694,6 +819,95 @@ Future<Try<tuple<size_t, string>, FilesError>> FilesProcess::_read(
 }
 
 
+Future<http::Response> FilesProcess::readRaw(
+    const string& path,
+    const Option<size_t>& follow)
+{
+  Result<string> resolvedPath = resolve(path);
+
+  if (resolvedPath.isError()) {
+    return BadRequest(resolvedPath.error() + ".\n");
+  } else if (!resolvedPath.isSome()) {
+    return NotFound();
+  }
+
+  // Don't read directories.
+  if (os::stat::isdir(resolvedPath.get())) {
+    return BadRequest("Cannot read a directory.\n");
+  }
+
+  if (follow.isSome()) {
+    Try<Bytes> size = os::stat::size(resolvedPath.get());
+
+    if (size.isSome() && size.get().bytes() == follow.get()) {
+      return watch(resolvedPath.get(), follow.get())
+        .then(defer(self(), [this, path]() {
+          return readRaw(path, None());
+        }));
+    }
+  }
+
+  // NOTE: libprocess sends the file with `sendfile` (i.e., without
+  // copying it into the response) and handles the 'Range' header.
+  OK response;
+  response.type = response.PATH;
+  response.path = resolvedPath.get();
+  response.headers["Content-Type"] = "application/octet-stream";
+
+  return response;
+}
+
+
+Future<Nothing> FilesProcess::watch(const string& path, size_t size)
+{
+  Watch watch{
+      path,
+      size,
+      Timeout::in(FOLLOW_TIMEOUT),
+      Owned<Promise<Nothing>>(new Promise<Nothing>())};
+
+  watches.push_back(watch);
+
+  if (watches.size() == 1) {
+    delay(FOLLOW_INTERVAL, self(), &FilesProcess::_watch);
+  }
+
+  return watch.promise->future();
+}
+
+
+void FilesProcess::_watch()
+{
+  auto it = watches.begin();
+
+  while (it != watches.end()) {
+    if (it->promise->future().hasDiscard()) {
+      it->promise->discard();
+      it = watches.erase(it);
+      continue;
+    }
+
+    // The file has changed if it grew, shrank (e.g., was truncated
+    // or rotated) or is gone, the read tells which.
+    Try<Bytes> size = os::stat::size(it->path);
+
+    if (size.isError() ||
+        size.get().bytes() != it->size ||
+        it->timeout.expired()) {
+      it->promise->set(Nothing());
+      it = watches.erase(it);
+      continue;
+    }
+
+    ++it;
+  }
+
+  if (!watches.empty()) {
+    delay(FOLLOW_INTERVAL, self(), &FilesProcess::_watch);
+  }
+}
+
+
 const string FilesProcess::DOWNLOAD_HELP = HELP(
     TLDR(
         "Returns the raw file contents for a given path."),
@@ -933,7 +1147,8 @@ Future<Try<tuple<size_t, string>, FilesError>> Files::read(
                   offset,
                   length,
                   path,
-                  principal);
+                  principal,
+                  false);
 }
 
 } // namespace internal {
@@ -16,7 +16,9 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <list>
+#include <set>
 
 #include <process/collect.hpp>
 #include <process/id.hpp>
@@ -24,6 +26,8 @@
 #include <process/timer.hpp>
 
 #include <stout/lambda.hpp>
+#include <stout/none.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
 #include "log/catchup.hpp"
@@ -34,11 +38,19 @@
 using namespace process;
 
 using std::list;
+using std::set;
 
 namespace mesos {
 namespace internal {
 namespace log {
 
+// How long to wait for the other replicas to respond with a batch of
+// learned positions. This is shorter than the timeout of catching-up
+// a position using consensus so that replicas that do not respond
+// (e.g., because they are down) only delay the catch-up slightly.
+static const Duration STREAM_CATCHUP_TIMEOUT = Seconds(1);
+
+
 class CatchUpProcess : public Process<CatchUpProcess>
 {
 public:
@@ -285,6 +297,246 @@ private:
 };
 
 
+// Copies the actions that other replicas have learned within a range
+// of positions into the local replica, in batches. Since a learned
+// action never changes, this is safe without running consensus, and
+// it is much faster than catching-up each position. Each batch is
+// requested from all the other replicas, and we keep the first
+// response that has some of the actions we are missing. As replicas
+// bound the size of a response and there is only one batch in flight,
+// the memory used is bounded by the size of a response times the
+// number of replicas.
+//
+// We stop as soon as a quorum of replicas (including the local one)
+// has none of the positions we are missing, or when no replica has
+// responded in time (e.g., replicas running an older version ignore
+// the request). The positions that are still missing (e.g., the ones
+// that are not learned yet) are left for the caller to catch-up using
+// consensus.
+class StreamCatchUpProcess : public Process<StreamCatchUpProcess>
+{
+public:
+  StreamCatchUpProcess(
+      size_t _quorum,
+      const Shared<Replica>& _replica,
+      const Shared<Network>& _network,
+      const Interval<uint64_t>& _positions)
+    : ProcessBase(ID::generate("log-stream-catch-up")),
+      quorum(_quorum),
+      replica(_replica),
+      network(_network),
+      positions(_positions) {}
+
+  virtual ~StreamCatchUpProcess() {}
+
+  Future<Nothing> future() { return promise.future(); }
+
+protected:
+  virtual void initialize()
+  {
+    // Stop when no one cares.
+    promise.future().onDiscard(lambda::bind(
+        static_cast<void(*)(const UPID&, bool)>(terminate), self(), true));
+
+    current = positions.lower();
+    learned = 0;
+
+    watch.start();
+
+    fetch();
+  }
+
+  virtual void finalize()
+  {
+    fetching.discard();
+    learning.discard();
+    process::discard(responses);
+
+    // TODO(benh): Discard our promise only after 'fetching' and
+    // 'learning' have completed (ready, failed, or discarded).
+    promise.discard();
+  }
+
+private:
+  static Future<Option<CatchUpResponse>> timedout(
+      Future<Option<CatchUpResponse>> future)
+  {
+    future.discard();
+    return None();
+  }
+
+  void fetch()
+  {
+    if (current >= positions.upper()) {
+      done();
+      return;
+    }
+
+    CatchUpRequest request;
+    request.set_from(current);
+    request.set_to(positions.upper() - 1);
+
+    // The local replica does not have what we are missing.
+    set<UPID> filter = {replica->pid()};
+
+    // The local replica counts as having none of the positions.
+    ignored = 1;
+
+    fetching = network->broadcast(protocol::catchup, request, filter)
+      .then(defer(self(), &Self::broadcasted, lambda::_1))
+      .after(
+          STREAM_CATCHUP_TIMEOUT,
+          lambda::bind(&Self::timedout, lambda::_1));
+
+    fetching.onAny(defer(self(), &Self::fetched));
+  }
+
+  Future<Option<CatchUpResponse>> broadcasted(
+      const set<Future<CatchUpResponse>>& _responses)
+  {
+    responses = _responses;
+    return receive();
+  }
+
+  // Returns None if no replica has any of the actions we are missing.
+  Future<Option<CatchUpResponse>> receive()
+  {
+    // A quorum of replicas must have learned a position for it to be
+    // learned by any replica, so it is very unlikely that the rest of
+    // the replicas have it if a quorum does not.
+    if (responses.empty() || ignored >= quorum) {
+      return None();
+    }
+
+    // We use select to process the responses one after another so
+    // that we can ignore the rest once we get a useful one.
+    return select(responses)
+      .then(defer(self(), &Self::received, lambda::_1));
+  }
+
+  Future<Option<CatchUpResponse>> received(
+      const Future<CatchUpResponse>& future)
+  {
+    // Enforced by the select semantics.
+    CHECK_READY(future);
+
+    // Remove this future from 'responses' so that we do not listen on
+    // it the next time we invoke select.
+    responses.erase(future);
+
+    const CatchUpResponse& response = future.get();
+
+    if (!response.okay() ||
+        response.actions_size() == 0 ||
+        !response.has_next() ||
+        response.next() <= current) {
+      ignored++;
+      return receive();
+    }
+
+    return response;
+  }
+
+  void fetched()
+  {
+    // We only use one response per batch.
+    process::discard(responses);
+    responses.clear();
+
+    // The future 'fetching' can only be discarded in 'finalize'.
+    CHECK(!fetching.isDiscarded());
+
+    if (fetching.isFailed()) {
+      promise.fail(
+          "Failed to fetch learned positions from " + stringify(current) +
+          ": " + fetching.failure());
+      terminate(self());
+      return;
+    }
+
+    if (fetching->isNone()) {
+      done();
+      return;
+    }
+
+    const CatchUpResponse& response = fetching->get();
+
+    current = std::min(response.next(), positions.upper());
+    learned += response.actions_size();
+
+    list<Action> actions(
+        response.actions().begin(),
+        response.actions().end());
+
+    learning = replica->learn(actions);
+    learning.onAny(defer(self(), &Self::_learned));
+  }
+
+  void _learned()
+  {
+    // The future 'learning' can only be discarded in 'finalize'.
+    CHECK(!learning.isDiscarded());
+
+    if (!learning.isReady() || !learning.get()) {
+      promise.fail(
+          "Failed to persist learned positions: " +
+          (learning.isFailed() ? learning.failure() : "unknown error"));
+      terminate(self());
+      return;
+    }
+
+    fetch();
+  }
+
+  void done()
+  {
+    LOG(INFO) << "Fetched " << learned << " learned positions between "
+              << positions.lower() << " and " << positions.upper() - 1
+              << " from other replicas in " << watch.elapsed();
+
+    promise.set(Nothing());
+    terminate(self());
+  }
+
+  const size_t quorum;
+  const Shared<Replica> replica;
+  const Shared<Network> network;
+  const Interval<uint64_t> positions;
+
+  uint64_t current;
+  size_t learned;
+
+  // The number of replicas that have none of the positions of the
+  // current batch.
+  size_t ignored;
+  Stopwatch watch;
+
+  process::Promise<Nothing> promise;
+  set<Future<CatchUpResponse>> responses;
+  Future<Option<CatchUpResponse>> fetching;
+  Future<bool> learning;
+};
+
+
+static Future<Nothing> stream(
+    size_t quorum,
+    const Shared<Replica>& replica,
+    const Shared<Network>& network,
+    const Interval<uint64_t>& positions)
+{
+  StreamCatchUpProcess* process =
+    new StreamCatchUpProcess(
+        quorum,
+        replica,
+        network,
+        positions);
+
+  Future<Nothing> future = process->future();
+  spawn(process, true);
+  return future;
+}
+
+
 static Future<Nothing> catchup(
     size_t quorum,
     const Shared<Replica>& replica,
@@ -332,16 +584,31 @@ Future<Nothing> catchup(
 
   Future<Nothing> future = Nothing();
 
+  // We first copy what the other replicas have learned, and then run
+  // consensus for the positions that are still missing.
   foreach (const Interval<uint64_t>& interval, positions) {
-    future = future.then(
-        lambda::bind(
-            f,
-            quorum,
-            replica,
-            network,
-            proposal,
-            interval,
-            timeout));
+    future = future
+      .then(lambda::bind(&stream, quorum, replica, network, interval))
+      .then([=]() {
+        return replica->missing(interval.lower(), interval.upper() - 1);
+      })
+      .then([=](const IntervalSet<uint64_t>& missing) {
+        Future<Nothing> future = Nothing();
+
+        foreach (const Interval<uint64_t>& interval, missing) {
+          future = future.then(
+              lambda::bind(
+                  f,
+                  quorum,
+                  replica,
+                  network,
+                  proposal,
+                  interval,
+                  timeout));
+        }
+
+        return future;
+      });
   }
 
   return future;
@@ -41,7 +41,9 @@ namespace log {
 // use, he can just use none. We also allow the user to specify a
 // timeout for the catch-up operation on each position and retry the
 // operation if timeout happens. This can help us tolerate network
-// blips.
+// blips. The positions that other replicas have already learned are
+// copied from them in batches, and consensus is only run for the
+// remaining ones.
 extern process::Future<Nothing> catchup(
     size_t quorum,
     const process::Shared<Replica>& replica,
@@ -17,14 +17,17 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <deque>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
 
 #include "log/catchup.hpp"
@@ -35,6 +38,7 @@
 
 using namespace process;
 
+using std::deque;
 using std::string;
 
 namespace mesos {
@@ -68,7 +72,11 @@ protected:
   virtual void finalize()
   {
     electing.discard();
-    writing.discard();
+
+    foreach (Write& write, writes) {
+      write.future.discard();
+      write.promise->discard();
+    }
   }
 
 private:
@@ -99,10 +107,10 @@ private:
       const WriteResponse& response);
   Future<Nothing> runLearnPhase(const Action& action);
   Future<bool> checkLearnPhase(const Action& action);
-  Future<Option<uint64_t>> updateIndexAfterWritten(bool missing);
+  Future<Option<uint64_t>> checkLocalReplica(
+      const Action& action,
+      bool missing);
   void writingFinished();
-  void writingFailed();
-  void writingAborted();
 
   const size_t quorum;
   const Shared<Replica> replica;
@@ -115,7 +123,8 @@ private:
   // coordinator does not declare itself as elected until it wins the
   // election and has filled all existing positions. A coordinator is
   // put in electing state after it decides to go for an election and
-  // before it is elected.
+  // before it is elected. An elected coordinator is in writing state
+  // while it has outstanding writes.
   enum
   {
     INITIAL,
@@ -131,7 +140,23 @@ private:
   uint64_t index;
 
   Future<Option<uint64_t>> electing;
-  Future<Option<uint64_t>> writing;
+
+  // A write that has been started at a position but that has not been
+  // completed yet. Writes are pipelined, i.e., we do not wait for a
+  // write to be done before starting the next one, but we complete
+  // them in the order of their positions. A position that is reported
+  // as written therefore never follows one that has not been written.
+  struct Write
+  {
+    // The result of the write phase and the learn phase.
+    Future<Option<uint64_t>> future;
+
+    // Completed once all the previous writes have been completed.
+    Owned<process::Promise<Option<uint64_t>>> promise;
+  };
+
+  // The outstanding writes, ordered by position.
+  deque<Write> writes;
 };
 
 
@@ -307,8 +332,6 @@ Future<Option<uint64_t>> CoordinatorProcess::append(const string& bytes)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
@@ -327,8 +350,6 @@ Future<Option<uint64_t>> CoordinatorProcess::truncate(uint64_t to)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
@@ -348,18 +369,30 @@ Future<Option<uint64_t>> CoordinatorProcess::write(const Action& action)
   LOG(INFO) << "Coordinator attempting to write " << action.type()
             << " action at position " << action.position();
 
-  CHECK_EQ(state, ELECTED);
+  CHECK(state == ELECTED || state == WRITING);
   CHECK(action.has_performed() && action.has_type());
+  CHECK_EQ(action.position(), index);
 
   state = WRITING;
 
-  writing = runWritePhase(action)
-    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1))
-    .onReady(defer(self(), &Self::writingFinished))
-    .onFailed(defer(self(), &Self::writingFailed))
-    .onDiscarded(defer(self(), &Self::writingAborted));
+  // The position is taken even if the write fails, in which case the
+  // coordinator is demoted and the next election will fill it.
+  index++;
+
+  Write write;
+  write.future = runWritePhase(action)
+    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1));
+  write.promise.reset(new process::Promise<Option<uint64_t>>());
 
-  return writing;
+  write.future.onAny(defer(self(), &Self::writingFinished));
+
+  // Propagate the discard of the returned future to the write.
+  write.promise->future().onDiscard(
+      lambda::bind(&Future<Option<uint64_t>>::discard, write.future));
+
+  writes.push_back(write);
+
+  return write.promise->future();
 }
 
 
@@ -375,15 +408,18 @@ Future<Option<uint64_t>> CoordinatorProcess::checkWritePhase(
 {
   if (!response.okay()) {
     // Received a NACK. Save the proposal number.
-    CHECK_LE(proposal, response.proposal());
-    proposal = response.proposal();
+    //
+    // NOTE: The proposal number might already be higher if we got a
+    // NACK for another outstanding write, or if we have been elected
+    // again since this write was started.
+    proposal = std::max(proposal, response.proposal());
 
     return None();
   }
 
   return runLearnPhase(action)
     .then(defer(self(), &Self::checkLearnPhase, action))
-    .then(defer(self(), &Self::updateIndexAfterWritten, lambda::_1));
+    .then(defer(self(), &Self::checkLocalReplica, action, lambda::_1));
 }
 
 
@@ -402,39 +438,60 @@ Future<bool> CoordinatorProcess::checkLearnPhase(const Action& action)
 }
 
 
-Future<Option<uint64_t>> CoordinatorProcess::updateIndexAfterWritten(
+Future<Option<uint64_t>> CoordinatorProcess::checkLocalReplica(
+    const Action& action,
     bool missing)
 {
   CHECK(!missing) << "Not expecting local replica to be missing position "
-                  << index << " after the writing is done";
+                  << action.position() << " after the writing is done";
 
-  return index++;
+  return action.position();
 }
 
 
 void CoordinatorProcess::writingFinished()
 {
-  CHECK_EQ(state, WRITING);
-  state = ELECTED;
-}
-
-
-void CoordinatorProcess::writingFailed()
-{
-  CHECK_EQ(state, WRITING);
-  state = INITIAL;
-}
-
+  // Complete the writes in order, up to the first one that is still
+  // outstanding.
+  while (!writes.empty() && !writes.front().future.isPending()) {
+    Write write = writes.front();
+    writes.pop_front();
+
+    if (write.future.isReady() && write.future->isSome()) {
+      write.promise->set(write.future.get());
+      continue;
+    }
+
+    CHECK_EQ(state, WRITING);
+
+    // Whether the write was rejected (i.e., we have been demoted),
+    // failed, or discarded, we don't actually know if the following
+    // writes will be learned and really need to "catch-up" their
+    // positions before we try and do another write (see MESOS-1038
+    // for more details). We therefore demote the coordinator, and
+    // report the following writes as if they had been rejected.
+    state = INITIAL;
 
-void CoordinatorProcess::writingAborted()
-{
-  CHECK_EQ(state, WRITING);
+    if (write.future.isReady()) {
+      write.promise->set(write.future.get());
+    } else if (write.future.isFailed()) {
+      write.promise->fail(write.future.failure());
+    } else {
+      write.promise->discard();
+    }
+
+    foreach (Write& following, writes) {
+      following.future.discard();
+      following.promise->set(Option<uint64_t>::none());
+    }
+
+    writes.clear();
+    return;
+  }
 
-  // Demote the coordinator if a write operation is discarded since we
-  // don't actually know the write was successful or not and we really
-  // need to "catch-up" that position before we try and do another
-  // write (see MESOS-1038 for more details).
-  state = INITIAL;
+  if (state == WRITING && writes.empty()) {
+    state = ELECTED;
+  }
 }
 
 
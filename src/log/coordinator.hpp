@@ -60,7 +60,10 @@ public:
 
   // Appends the specified bytes to the end of the log. Returns the
   // position of the appended entry if the operation succeeds or none
-  // if the coordinator was demoted.
+  // if the coordinator was demoted. Appends (and truncates) do not
+  // wait for the previous ones to be done, but they are completed in
+  // order: if a write fails, the coordinator is demoted and all the
+  // writes that follow it return none.
   process::Future<Option<uint64_t>> append(const std::string& bytes);
 
   // Removes all log entries preceding the log entry at the given
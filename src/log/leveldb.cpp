@@ -23,8 +23,11 @@
 
 #include <stdint.h>
 
+#include <memory>
+
 #include <stout/check.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
@@ -33,6 +36,7 @@
 #include "log/leveldb.hpp"
 
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -309,96 +313,64 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
 
 
 Try<Nothing> LevelDBStorage::persist(const Action& action)
+{
+  return persist(vector<Action>({action}));
+}
+
+
+Try<Nothing> LevelDBStorage::persist(const vector<Action>& actions)
 {
   Stopwatch stopwatch;
   stopwatch.start();
 
-  Record record;
-  record.set_type(Record::ACTION);
-  record.mutable_action()->MergeFrom(action);
+  // All the actions are written using a single batch so that they
+  // share a single sync (i.e., a group commit). Note that a batch
+  // applies its updates in order, so a position that is written
+  // more than once ends up with its last action.
+  leveldb::WriteBatch batch;
 
-  string value;
+  size_t size = 0;
 
-  if (!record.SerializeToString(&value)) {
-    return Error("Failed to serialize record");
+  foreach (const Action& action, actions) {
+    Record record;
+    record.set_type(Record::ACTION);
+    record.mutable_action()->MergeFrom(action);
+
+    string value;
+
+    if (!record.SerializeToString(&value)) {
+      return Error("Failed to serialize record");
+    }
+
+    batch.Put(encode(action.position()), value);
+    size += value.size();
   }
 
   leveldb::WriteOptions options;
   options.sync = true;
 
-  leveldb::Status status = db->Put(options, encode(action.position()), value);
+  leveldb::Status status = db->Write(options, &batch);
 
   if (!status.ok()) {
     return Error(status.ToString());
   }
 
-  // Updated the first position. Notice that we use 'min' here instead
-  // of checking 'isNone()' because it's likely that log entries are
-  // written out of order during catch-up (e.g. if a random bulk
-  // catch-up policy is used).
-  first = min(first, action.position());
+  foreach (const Action& action, actions) {
+    // Updated the first position. Notice that we use 'min' here
+    // instead of checking 'isNone()' because it's likely that log
+    // entries are written out of order during catch-up (e.g. if a
+    // random bulk catch-up policy is used).
+    first = min(first, action.position());
+  }
 
-  VLOG(1) << "Persisting action (" << value.size()
+  VLOG(1) << "Persisting " << actions.size() << " action(s) (" << size
           << " bytes) to leveldb took " << stopwatch.elapsed();
 
-  // Delete positions if a truncate action has been *learned*. Note
-  // that we do this in a best-effort fashion (i.e., we ignore any
-  // failures to the database since we can always try again).
-  if (action.has_type() && action.type() == Action::TRUNCATE &&
-      action.has_learned() && action.learned()) {
-    CHECK(action.has_truncate());
-
-    stopwatch.start(); // Restart the stopwatch.
-
-    // To actually perform the truncation in leveldb we need to remove
-    // all the keys that represent positions no longer in the log. We
-    // do this by attempting to delete all keys that represent the
-    // first position we know is still in leveldb up to (but
-    // excluding) the truncate position. Note that this works because
-    // the semantics of WriteBatch are such that even if the position
-    // doesn't exist (which is possible because this replica has some
-    // holes), we can attempt to delete the key that represents it and
-    // it will just ignore that key. This is *much* cheaper than
-    // actually iterating through the entire database instead (which
-    // was, for posterity, the original implementation). In addition,
-    // caching the "first" position we know is in the database is
-    // cheaper than using an iterator to determine the first position
-    // (which was, for posterity, the second implementation).
-
-    leveldb::WriteBatch batch;
-
-    CHECK_SOME(first);
-
-    // Add positions up to (but excluding) the truncate position to
-    // the batch starting at the first position still in leveldb. It's
-    // likely that the first position is greater than the truncate
-    // position (e.g., during catch-up). In that case, we do nothing
-    // because there is nothing we can truncate.
-    // TODO(jieyu): We might miss a truncation if we do random (i.e.,
-    // out of order) bulk catch-up and the truncate operation is
-    // caught up first.
-    uint64_t index = 0;
-    while ((first.get() + index) < action.truncate().to()) {
-      batch.Delete(encode(first.get() + index));
-      index++;
-    }
-
-    // If we added any positions, attempt to delete them!
-    if (index > 0) {
-      // We do this write asynchronously (e.g., using default options).
-      leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
-
-      if (!status.ok()) {
-        LOG(WARNING) << "Ignoring leveldb batch delete failure: "
-                     << status.ToString();
-      } else {
-        // Save the new first position!
-        CHECK_LT(first.get(), action.truncate().to());
-        first = action.truncate().to();
-
-        VLOG(1) << "Deleting ~" << index
-                << " keys from leveldb took " << stopwatch.elapsed();
-      }
+  // Delete positions if a truncate action has been *learned*.
+  foreach (const Action& action, actions) {
+    if (action.has_type() && action.type() == Action::TRUNCATE &&
+        action.has_learned() && action.learned()) {
+      truncate(action);
     }
   }
 
@@ -406,6 +378,68 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
 }
 
 
+void LevelDBStorage::truncate(const Action& action)
+{
+  // NOTE: We do this in a best-effort fashion (i.e., we ignore any
+  // failures to the database since we can always try again).
+  CHECK(action.has_truncate());
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  // To actually perform the truncation in leveldb we need to remove
+  // all the keys that represent positions no longer in the log. We
+  // do this by attempting to delete all keys that represent the
+  // first position we know is still in leveldb up to (but
+  // excluding) the truncate position. Note that this works because
+  // the semantics of WriteBatch are such that even if the position
+  // doesn't exist (which is possible because this replica has some
+  // holes), we can attempt to delete the key that represents it and
+  // it will just ignore that key. This is *much* cheaper than
+  // actually iterating through the entire database instead (which
+  // was, for posterity, the original implementation). In addition,
+  // caching the "first" position we know is in the database is
+  // cheaper than using an iterator to determine the first position
+  // (which was, for posterity, the second implementation).
+
+  leveldb::WriteBatch batch;
+
+  CHECK_SOME(first);
+
+  // Add positions up to (but excluding) the truncate position to
+  // the batch starting at the first position still in leveldb. It's
+  // likely that the first position is greater than the truncate
+  // position (e.g., during catch-up). In that case, we do nothing
+  // because there is nothing we can truncate.
+  // TODO(jieyu): We might miss a truncation if we do random (i.e.,
+  // out of order) bulk catch-up and the truncate operation is
+  // caught up first.
+  uint64_t index = 0;
+  while ((first.get() + index) < action.truncate().to()) {
+    batch.Delete(encode(first.get() + index));
+    index++;
+  }
+
+  // If we added any positions, attempt to delete them!
+  if (index > 0) {
+    // We do this write asynchronously (e.g., using default options).
+    leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+
+    if (!status.ok()) {
+      LOG(WARNING) << "Ignoring leveldb batch delete failure: "
+                   << status.ToString();
+    } else {
+      // Save the new first position!
+      CHECK_LT(first.get(), action.truncate().to());
+      first = action.truncate().to();
+
+      VLOG(1) << "Deleting ~" << index
+              << " keys from leveldb took " << stopwatch.elapsed();
+    }
+  }
+}
+
+
 Try<Action> LevelDBStorage::read(uint64_t position)
 {
   Stopwatch stopwatch;
@@ -438,6 +472,59 @@ Try<Action> LevelDBStorage::read(uint64_t position)
   return record.action();
 }
 
+
+Try<vector<Action>> LevelDBStorage::read(
+    uint64_t from,
+    uint64_t to,
+    const Option<Bytes>& limit)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  vector<Action> actions;
+  Bytes size;
+
+  // NOTE: The keys are ordered by position (see 'encode'), so we can
+  // read the range with a single iterator rather than looking up
+  // each position.
+  std::unique_ptr<leveldb::Iterator> iterator(
+      db->NewIterator(leveldb::ReadOptions()));
+
+  for (iterator->Seek(encode(from));
+       iterator->Valid() && (limit.isNone() || size < limit.get());
+       iterator->Next()) {
+    const leveldb::Slice& slice = iterator->value();
+
+    google::protobuf::io::ArrayInputStream stream(slice.data(), slice.size());
+
+    Record record;
+
+    if (!record.ParseFromZeroCopyStream(&stream)) {
+      return Error("Failed to deserialize record");
+    }
+
+    if (record.type() != Record::ACTION) {
+      return Error("Bad record");
+    }
+
+    if (record.action().position() > to) {
+      break;
+    }
+
+    size += Bytes(slice.size());
+    actions.push_back(record.action());
+  }
+
+  if (!iterator->status().ok()) {
+    return Error(iterator->status().ToString());
+  }
+
+  VLOG(1) << "Reading " << actions.size() << " positions from leveldb took "
+          << stopwatch.elapsed();
+
+  return actions;
+}
+
 } // namespace log {
 } // namespace internal {
 } // namespace mesos {
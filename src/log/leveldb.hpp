@@ -21,6 +21,9 @@
 
 #include <stdint.h>
 
+#include <vector>
+
+#include <stout/bytes.hpp>
 #include <stout/option.hpp>
 
 #include "log/storage.hpp"
@@ -39,9 +42,17 @@ public:
   virtual Try<State> restore(const std::string& path);
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> persist(const std::vector<Action>& actions);
   virtual Try<Action> read(uint64_t position);
+  virtual Try<std::vector<Action>> read(
+      uint64_t from,
+      uint64_t to,
+      const Option<Bytes>& limit = None());
 
 private:
+  // Deletes the positions below a *learned* truncate action.
+  void truncate(const Action& action);
+
   leveldb::DB* db;
 
   // First position still in leveldb, used during truncation.
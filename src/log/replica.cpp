@@ -17,12 +17,15 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/check.hpp>
 #include <stout/error.hpp>
 #include <stout/exit.hpp>
@@ -40,7 +43,9 @@
 using namespace process;
 
 using std::list;
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -52,10 +57,16 @@ namespace protocol {
 Protocol<PromiseRequest, PromiseResponse> promise;
 Protocol<WriteRequest, WriteResponse> write;
 Protocol<RecoverRequest, RecoverResponse> recover;
+Protocol<CatchUpRequest, CatchUpResponse> catchup;
 
 } // namespace protocol {
 
 
+// The total size of the actions a replica puts in a response to a
+// catch-up request (unless a single action is larger).
+static const Bytes MAX_CATCHUP_RESPONSE_SIZE = Megabytes(4);
+
+
 class ReplicaProcess : public ProtobufProcess<ReplicaProcess>
 {
 public:
@@ -97,6 +108,11 @@ public:
   // Returns the highest implicit promise this replica has given.
   uint64_t promised();
 
+  // Persists the specified learned actions, skipping the positions
+  // that are not missing. Returns true on success and false
+  // otherwise.
+  bool learn(const list<Action>& actions);
+
   // Updates the status of this replica. The update will be persisted
   // to storage. Returns true on success and false otherwise.
   bool update(const Metadata::Status& status);
@@ -115,10 +131,36 @@ private:
   // Handles a message notifying of a learned action.
   void learned(const UPID& from, const Action& action);
 
+  // Handles a request from a catch-up process for learned actions.
+  void catchup(const UPID& from, const CatchUpRequest& request);
+
   // Persists the specified action to storage. Returns true on success
   // and false otherwise.
   bool persist(const Action& action);
 
+  // Persists the specified actions to storage using a single sync.
+  // Returns true on success and false otherwise.
+  bool persist(const vector<Action>& actions);
+
+  // Updates the in-memory state of the log after the specified
+  // action has been persisted.
+  void persisted(const Action& action);
+
+  // Queues the specified action to be persisted by the next group
+  // commit, optionally along with a response to send to 'from' once
+  // the action has been persisted.
+  void enqueue(
+      const Action& action,
+      const Option<pair<UPID, WriteResponse>>& response = None());
+
+  // Persists all the queued actions with a single sync and sends the
+  // queued responses. This gets dispatched when the first action is
+  // queued, so that all the write requests and learned notices that
+  // are already in our mailbox join the same commit. It is also
+  // invoked before handling anything that inspects the state of the
+  // log other than via 'read(position)', which sees queued actions.
+  void commit();
+
   // Updates the highest promise this replica has given. The update
   // will be persisted to storage. Returns true on success and false
   // otherwise.
@@ -145,6 +187,12 @@ private:
 
   // Unlearned positions in the log.
   IntervalSet<uint64_t> unlearned;
+
+  // Actions (in order) waiting for the next group commit.
+  vector<Action> pending;
+
+  // Responses to send once the pending actions have been persisted.
+  vector<pair<UPID, WriteResponse>> responses;
 };
 
 
@@ -171,6 +219,9 @@ ReplicaProcess::ReplicaProcess(const string& path)
   install<LearnedMessage>(
       &ReplicaProcess::learned,
       &LearnedMessage::action);
+
+  install<CatchUpRequest>(
+      &ReplicaProcess::catchup);
 }
 
 
@@ -184,7 +235,17 @@ Result<Action> ReplicaProcess::read(uint64_t position)
 {
   if (position < begin) {
     return Error("Attempted to read truncated position");
-  } else if (end < position) {
+  }
+
+  // The most recently queued action for this position (if any) is
+  // the one that will end up in storage.
+  for (auto it = pending.rbegin(); it != pending.rend(); ++it) {
+    if (it->position() == position) {
+      return *it;
+    }
+  }
+
+  if (end < position) {
     return None(); // These semantics are assumed above!
   } else if (holes.contains(position)) {
     return None();
@@ -205,6 +266,8 @@ Result<Action> ReplicaProcess::read(uint64_t position)
 // the future semantics to not include failures.
 Future<list<Action>> ReplicaProcess::read(uint64_t from, uint64_t to)
 {
+  commit();
+
   if (to < from) {
     process::Promise<list<Action>> promise;
     promise.fail("Bad read range (to < from)");
@@ -242,6 +305,8 @@ Future<list<Action>> ReplicaProcess::read(uint64_t from, uint64_t to)
 
 bool ReplicaProcess::missing(uint64_t position)
 {
+  commit();
+
   if (position < begin) {
     return false; // Truncated positions are treated as learned.
   } else if (position > end) {
@@ -255,6 +320,8 @@ bool ReplicaProcess::missing(uint64_t position)
 // TODO(jieyu): Allow this method to take an Interval.
 IntervalSet<uint64_t> ReplicaProcess::missing(uint64_t from, uint64_t to)
 {
+  commit();
+
   if (from > to) {
     // Empty interval.
     return IntervalSet<uint64_t>();
@@ -282,12 +349,16 @@ IntervalSet<uint64_t> ReplicaProcess::missing(uint64_t from, uint64_t to)
 
 uint64_t ReplicaProcess::beginning()
 {
+  commit();
+
   return begin;
 }
 
 
 uint64_t ReplicaProcess::ending()
 {
+  commit();
+
   return end;
 }
 
@@ -304,8 +375,35 @@ uint64_t ReplicaProcess::promised()
 }
 
 
+bool ReplicaProcess::learn(const list<Action>& actions)
+{
+  vector<Action> missing_;
+
+  foreach (const Action& action, actions) {
+    CHECK(action.has_learned() && action.learned());
+
+    // NOTE: We don't overwrite learned positions (see 'write()').
+    if (missing(action.position())) {
+      missing_.push_back(action);
+    }
+  }
+
+  if (missing_.empty()) {
+    return true;
+  }
+
+  VLOG(1) << "Replica learning " << missing_.size() << " positions from "
+          << missing_.front().position() << " to "
+          << missing_.back().position();
+
+  return persist(missing_);
+}
+
+
 bool ReplicaProcess::update(const Metadata::Status& status)
 {
+  commit();
+
   Metadata metadata_;
   metadata_.set_status(status);
   metadata_.set_promised(promised());
@@ -370,6 +468,9 @@ bool ReplicaProcess::updatePromised(uint64_t promised)
 
 void ReplicaProcess::promise(const UPID& from, const PromiseRequest& request)
 {
+  // Any accepted writes must be persisted before we make a promise.
+  commit();
+
   // Ignore promise requests if this replica is not in VOTING status;
   // we also inform the requester, so that they can retry promptly.
   if (status() != Metadata::VOTING) {
@@ -575,14 +676,13 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
           LOG(FATAL) << "Unknown Action::Type!";
       }
 
-      if (persist(action)) {
-        WriteResponse response;
-        response.set_type(WriteResponse::ACCEPT);
-        response.set_okay(true);
-        response.set_proposal(request.proposal());
-        response.set_position(request.position());
-        reply(response);
-      }
+      WriteResponse response;
+      response.set_type(WriteResponse::ACCEPT);
+      response.set_okay(true);
+      response.set_proposal(request.proposal());
+      response.set_position(request.position());
+
+      enqueue(action, std::make_pair(from, response));
     }
   } else if (result.isSome()) {
     Action action = result.get();
@@ -654,14 +754,13 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
             LOG(FATAL) << "Unknown Action::Type!";
         }
 
-        if (persist(action)) {
-          WriteResponse response;
-          response.set_type(WriteResponse::ACCEPT);
-          response.set_okay(true);
-          response.set_proposal(request.proposal());
-          response.set_position(request.position());
-          reply(response);
-        }
+        WriteResponse response;
+        response.set_type(WriteResponse::ACCEPT);
+        response.set_okay(true);
+        response.set_proposal(request.proposal());
+        response.set_position(request.position());
+
+        enqueue(action, std::make_pair(from, response));
       }
     }
   }
@@ -670,6 +769,8 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
 
 void ReplicaProcess::recover(const UPID& from, const RecoverRequest& request)
 {
+  commit();
+
   LOG(INFO) << "Replica in " << status()
             << " status received a broadcasted recover request from "
             << from;
@@ -692,19 +793,90 @@ void ReplicaProcess::learned(const UPID& from, const Action& action)
             << action.position() << " from " << from;
 
   CHECK(action.learned());
-  persist(action);
+  enqueue(action);
+}
+
+
+void ReplicaProcess::catchup(const UPID& from, const CatchUpRequest& request)
+{
+  commit();
+
+  CatchUpResponse response;
+
+  // Only a VOTING replica is known to have all the positions it has
+  // learned (e.g., a RECOVERING replica might be catching up).
+  if (status() != Metadata::VOTING) {
+    LOG(INFO) << "Replica ignoring catch-up request from " << from
+              << " as it is in " << status() << " status";
+
+    response.set_okay(false);
+    reply(response);
+    return;
+  }
+
+  VLOG(1) << "Replica received catch-up request for positions "
+          << request.from() << " to " << request.to() << " from " << from;
+
+  // We don't have anything past our end, and the truncated positions
+  // are no longer in storage.
+  const uint64_t first = std::max(request.from(), begin);
+  const uint64_t last = std::min(request.to(), end);
+
+  uint64_t next = std::max(first, last + 1);
+
+  if (first <= last) {
+    Try<vector<Action>> actions =
+      storage->read(first, last, MAX_CATCHUP_RESPONSE_SIZE);
+
+    if (actions.isError()) {
+      LOG(ERROR) << "Error reading log records from " << first << " to "
+                 << last << ": " << actions.error();
+      return;
+    }
+
+    foreach (const Action& action, actions.get()) {
+      if (action.has_learned() && action.learned()) {
+        response.add_actions()->CopyFrom(action);
+      }
+    }
+
+    // Continue after the last position read if we hit the limit.
+    if (!actions->empty() && actions->back().position() < last) {
+      next = actions->back().position() + 1;
+    }
+  }
+
+  response.set_okay(true);
+  response.set_next(next);
+  reply(response);
 }
 
 
 bool ReplicaProcess::persist(const Action& action)
 {
-  Try<Nothing> persisted = storage->persist(action);
+  return persist(vector<Action>({action}));
+}
 
-  if (persisted.isError()) {
-    LOG(ERROR) << "Error writing to log: " << persisted.error();
+
+bool ReplicaProcess::persist(const vector<Action>& actions)
+{
+  Try<Nothing> result = storage->persist(actions);
+
+  if (result.isError()) {
+    LOG(ERROR) << "Error writing to log: " << result.error();
     return false;
   }
 
+  foreach (const Action& action, actions) {
+    persisted(action);
+  }
+
+  return true;
+}
+
+
+void ReplicaProcess::persisted(const Action& action)
+{
   VLOG(1) << "Persisted action " << action.type()
           << " at position " << action.position();
 
@@ -742,8 +914,52 @@ bool ReplicaProcess::persist(const Action& action)
 
   // And update the end position.
   end = std::max(end, action.position());
+}
 
-  return true;
+
+void ReplicaProcess::enqueue(
+    const Action& action,
+    const Option<pair<UPID, WriteResponse>>& response)
+{
+  if (pending.empty()) {
+    dispatch(self(), &ReplicaProcess::commit);
+  }
+
+  pending.push_back(action);
+
+  if (response.isSome()) {
+    responses.push_back(response.get());
+  }
+
+  // A learned truncation changes which positions may be written, so
+  // we commit it right away rather than queueing more actions behind
+  // it (see 'write()').
+  if (action.has_type() && action.type() == Action::TRUNCATE &&
+      action.has_learned() && action.learned()) {
+    commit();
+  }
+}
+
+
+void ReplicaProcess::commit()
+{
+  if (pending.empty()) {
+    return;
+  }
+
+  vector<Action> actions;
+  std::swap(actions, pending);
+
+  vector<pair<UPID, WriteResponse>> responses_;
+  std::swap(responses_, responses);
+
+  // NOTE: Like for a single write, we don't respond if we fail to
+  // persist the actions (see the comment above 'promise()').
+  if (persist(actions)) {
+    foreach (const auto& response, responses_) {
+      send(response.first, response.second);
+    }
+  }
 }
 
 
@@ -838,6 +1054,12 @@ Future<uint64_t> Replica::promised() const
 }
 
 
+Future<bool> Replica::learn(const list<Action>& actions) const
+{
+  return dispatch(process, &ReplicaProcess::learn, actions);
+}
+
+
 Future<bool> Replica::update(const Metadata::Status& status)
 {
   return dispatch(process, &ReplicaProcess::update, status);
@@ -40,6 +40,7 @@ namespace protocol {
 extern Protocol<PromiseRequest, PromiseResponse> promise;
 extern Protocol<WriteRequest, WriteResponse> write;
 extern Protocol<RecoverRequest, RecoverResponse> recover;
+extern Protocol<CatchUpRequest, CatchUpResponse> catchup;
 
 } // namespace protocol {
 
@@ -89,6 +90,14 @@ public:
   // Returns the highest implicit promise this replica has given.
   process::Future<uint64_t> promised() const;
 
+  // Persists the specified learned actions (e.g., as received from
+  // other replicas during catch-up), skipping the positions that are
+  // not missing. Returns true on success, false otherwise.
+  //
+  // NOTE: This is const so that it can be used through a shared
+  // replica, like the catch-up does (see log/catchup.hpp).
+  process::Future<bool> learn(const std::list<Action>& actions) const;
+
   // Updates the status of this replica. Returns true if status was
   // updated successfully, false otherwise. Made "virtual" for
   // mocking in tests.
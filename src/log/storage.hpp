@@ -20,9 +20,13 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
+#include <stout/bytes.hpp>
 #include <stout/interval.hpp>
+#include <stout/none.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/try.hpp>
 
 #include "messages/log.hpp"
@@ -53,7 +57,20 @@ public:
   virtual Try<State> restore(const std::string& path) = 0;
   virtual Try<Nothing> persist(const Metadata& metadata) = 0;
   virtual Try<Nothing> persist(const Action& action) = 0;
+
+  // Persists all the actions atomically and with a single sync (i.e.,
+  // a group commit), in order, as if they were persisted one by one.
+  virtual Try<Nothing> persist(const std::vector<Action>& actions) = 0;
+
   virtual Try<Action> read(uint64_t position) = 0;
+
+  // Reads the actions within the positions [from, to] that are in
+  // storage, in order. Stops after the first action at which the
+  // total size of the actions read reaches 'limit' (if any).
+  virtual Try<std::vector<Action>> read(
+      uint64_t from,
+      uint64_t to,
+      const Option<Bytes>& limit = None()) = 0;
 };
 
 } // namespace log {
@@ -27,6 +27,7 @@
 using std::string;
 
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
+using mesos::internal::master::allocator::ShardedHierarchicalDRFAllocator;
 
 namespace mesos {
 namespace allocator {
@@ -41,6 +42,10 @@ Try<Allocator*> Allocator::create(const string& name)
     return HierarchicalDRFAllocator::create();
   }
 
+  if (name == mesos::internal::master::SHARDED_ALLOCATOR) {
+    return ShardedHierarchicalDRFAllocator::create();
+  }
+
   return modules::ModuleManager::create<Allocator>(name);
 }
 
@@ -1550,100 +1550,85 @@ void HierarchicalAllocatorProcess::allocate(
 
   // At this point resources for quotas are allocated or accounted for.
   // Proceed with allocating the remaining free pool.
-  foreach (const SlaveID& slaveId, slaveIds) {
-    // If there are no resources available for the second stage, stop.
-    if (!allocatable(remainingClusterResources - allocatedStage2)) {
-      break;
+  //
+  // With sharding the slaves are partitioned into shards which are
+  // evaluated in parallel against a snapshot of the sort order (see
+  // `propose()`). Since each shard only knows about its own proposals
+  // the proposals are then reconciled in shard order, dropping any
+  // proposal that would exceed `remainingClusterResources` given the
+  // proposals of the preceding shards. The slaves of dropped proposals
+  // are reconsidered in the next allocation cycle.
+  //
+  // If every shard started from the same sort order, every shard would
+  // propose to the same roles and frameworks first. Instead, shard `i`
+  // starts from the `i`th role and, within each role, from the `i`th
+  // framework of the sort order, wrapping around at the end.
+  if (allocationShards > 1 && slaveIds.size() > 1) {
+    const size_t shards = std::min(allocationShards, slaveIds.size());
+
+    if (workers.get() == nullptr) {
+      workers.reset(new JobThreads(allocationShards));
     }
 
-    foreach (const string& role, roleSorter->sort()) {
-      // NOTE: Suppressed frameworks are not included in the sort.
-      foreach (const string& frameworkId_,
-               frameworkSorters[role]->sort()) {
-        FrameworkID frameworkId;
-        frameworkId.set_value(frameworkId_);
+    vector<string> roleOrder = roleSorter->sort();
 
-        // Only offer resources from slaves that have GPUs to
-        // frameworks that are capable of receiving GPUs.
-        // See MESOS-5634.
-        if (!frameworks[frameworkId].gpuAware &&
-            slaves[slaveId].total.gpus().getOrElse(0) > 0) {
-          continue;
-        }
+    hashmap<string, vector<string>> frameworkOrder;
+    foreach (const string& role, roleOrder) {
+      frameworkOrder[role] = frameworkSorters[role]->sort();
+    }
 
-        // Calculate the currently available resources on the slave, which
-        // is the difference in non-shared resources between total and
-        // allocated, plus all shared resources on the agent (if applicable).
-        // Since shared resources are offerable even when they are in use, we
-        // make one copy of the shared resources available regardless of the
-        // past allocations.
-        Resources available =
-          (slaves[slaveId].total - slaves[slaveId].allocated).nonShared();
+    // Returns `order` rotated to start at its `i`th element.
+    auto rotate = [](vector<string> order, size_t i) {
+      if (!order.empty()) {
+        std::rotate(
+            order.begin(), order.begin() + (i % order.size()), order.end());
+      }
+      return order;
+    };
+
+    vector<vector<Proposal>> proposals(shards);
+
+    // The allocator state is only read by `propose()` while we are
+    // blocked below, which `propose()` checks through `proposing`.
+    proposing = true;
+
+    for (size_t i = 0; i < shards; i++) {
+      // Use contiguous ranges, the slaves have already been shuffled.
+      vector<SlaveID> shard(
+          slaveIds.begin() + (i * slaveIds.size()) / shards,
+          slaveIds.begin() + ((i + 1) * slaveIds.size()) / shards);
+
+      hashmap<string, vector<string>> shardFrameworkOrder;
+      foreachpair (const string& role,
+                   const vector<string>& order,
+                   frameworkOrder) {
+        shardFrameworkOrder[role] = rotate(order, i);
+      }
 
-        // Offer a shared resource only if it has not been offered in
-        // this offer cycle to a framework.
-        if (frameworks[frameworkId].shared) {
-          available += slaves[slaveId].total.shared();
-          if (offeredSharedResources.contains(slaveId)) {
-            available -= offeredSharedResources[slaveId];
-          }
-        }
+      vector<string> shardRoleOrder = rotate(roleOrder, i);
 
-        // The resources we offer are the unreserved resources as well as the
-        // reserved resources for this particular role. This is necessary to
-        // ensure that we don't offer resources that are reserved for another
-        // role.
-        //
-        // NOTE: Currently, frameworks are allowed to have '*' role.
-        // Calling reserved('*') returns an empty Resources object.
-        //
-        // NOTE: We do not offer roles with quota any more non-revocable
-        // resources once their quota is satisfied. However, note that this is
-        // not strictly true due to the coarse-grained nature (per agent) of the
-        // allocation algorithm in stage 1.
-        //
-        // TODO(mpark): Offer unreserved resources as revocable beyond quota.
-        Resources resources = available.reserved(role);
-        if (!quotas.contains(role)) {
-          resources += available.unreserved();
-        }
-
-        // It is safe to break here, because all frameworks under a role would
-        // consider the same resources, so in case we don't have allocatable
-        // resources, we don't have to check for other frameworks under the
-        // same role. We only break out of the innermost loop, so the next step
-        // will use the same slaveId, but a different role.
-        //
-        // The difference to the second `allocatable` check is that here we also
-        // check for revocable resources, which can be disabled on a per frame-
-        // work basis, which requires us to go through all frameworks in case we
-        // have allocatable revocable resources.
-        if (!allocatable(resources)) {
-          break;
-        }
+      workers->post([=, &proposals, &offeredSharedResources]() {
+        proposals[i] = propose(
+            shard,
+            shardRoleOrder,
+            shardFrameworkOrder,
+            offeredSharedResources,
+            remainingClusterResources);
+      });
+    }
 
-        // Remove revocable resources if the framework has not opted for them.
-        if (!frameworks[frameworkId].revocable) {
-          resources = resources.nonRevocable();
-        }
+    workers->wait();
+    proposing = false;
 
-        // If the resources are not allocatable, ignore. We can not break
-        // here, because another framework under the same role could accept
-        // revocable resources and breaking would skip all other frameworks.
-        if (!allocatable(resources)) {
-          continue;
-        }
+    size_t dropped = 0;
 
-        // If the framework filters these resources, ignore.
-        if (isFiltered(frameworkId, slaveId, resources)) {
-          continue;
-        }
+    foreach (const vector<Proposal>& shard, proposals) {
+      foreach (const Proposal& proposal, shard) {
+        const SlaveID& slaveId = proposal.slaveId;
+        const FrameworkID& frameworkId = proposal.frameworkId;
+        const string& role = proposal.role;
+        const Resources& resources = proposal.resources;
 
-        // If the offer generated by `resources` would force the second
-        // stage to use more than `remainingClusterResources`, move along.
-        // We do not terminate early, as offers generated further in the
-        // loop may be small enough to fit within `remainingClusterResources`.
-        //
         // We exclude shared resources from over-allocation check because
         // shared resources are always allocatable.
         const Resources scalarQuantity =
@@ -1651,17 +1636,13 @@ void HierarchicalAllocatorProcess::allocate(
 
         if (!remainingClusterResources.contains(
                 allocatedStage2 + scalarQuantity)) {
+          ++dropped;
           continue;
         }
 
         VLOG(2) << "Allocating " << resources << " on agent " << slaveId
                 << " to framework " << frameworkId;
 
-        // NOTE: We perform "coarse-grained" allocation, meaning that we always
-        // allocate the entire remaining slave resources to a single framework.
-        //
-        // NOTE: We may have already allocated some resources on the current
-        // agent as part of quota.
         offerable[frameworkId][slaveId] += resources;
         offeredSharedResources[slaveId] += resources.shared();
         allocatedStage2 += scalarQuantity;
@@ -1669,7 +1650,8 @@ void HierarchicalAllocatorProcess::allocate(
         slaves[slaveId].allocated += resources;
 
         frameworkSorters[role]->add(slaveId, resources);
-        frameworkSorters[role]->allocated(frameworkId_, slaveId, resources);
+        frameworkSorters[role]->allocated(
+            frameworkId.value(), slaveId, resources);
         roleSorter->allocated(role, slaveId, resources);
 
         if (quotas.contains(role)) {
@@ -1679,6 +1661,141 @@ void HierarchicalAllocatorProcess::allocate(
         }
       }
     }
+
+    VLOG(1) << "Reconciled the allocations of " << shards << " shards, "
+            << "dropped " << dropped << " conflicting allocations";
+  } else {
+    foreach (const SlaveID& slaveId, slaveIds) {
+      // If there are no resources available for the second stage, stop.
+      if (!allocatable(remainingClusterResources - allocatedStage2)) {
+        break;
+      }
+
+      foreach (const string& role, roleSorter->sort()) {
+        // NOTE: Suppressed frameworks are not included in the sort.
+        foreach (const string& frameworkId_,
+                 frameworkSorters[role]->sort()) {
+          FrameworkID frameworkId;
+          frameworkId.set_value(frameworkId_);
+
+          // Only offer resources from slaves that have GPUs to
+          // frameworks that are capable of receiving GPUs.
+          // See MESOS-5634.
+          if (!frameworks[frameworkId].gpuAware &&
+              slaves[slaveId].total.gpus().getOrElse(0) > 0) {
+            continue;
+          }
+
+          // Calculate the currently available resources on the slave, which
+          // is the difference in non-shared resources between total and
+          // allocated, plus all shared resources on the agent (if applicable).
+          // Since shared resources are offerable even when they are in use, we
+          // make one copy of the shared resources available regardless of the
+          // past allocations.
+          Resources available =
+            (slaves[slaveId].total - slaves[slaveId].allocated).nonShared();
+
+          // Offer a shared resource only if it has not been offered in
+          // this offer cycle to a framework.
+          if (frameworks[frameworkId].shared) {
+            available += slaves[slaveId].total.shared();
+            if (offeredSharedResources.contains(slaveId)) {
+              available -= offeredSharedResources[slaveId];
+            }
+          }
+
+          // The resources we offer are the unreserved resources as well as the
+          // reserved resources for this particular role. This is necessary to
+          // ensure that we don't offer resources that are reserved for another
+          // role.
+          //
+          // NOTE: Currently, frameworks are allowed to have '*' role.
+          // Calling reserved('*') returns an empty Resources object.
+          //
+          // NOTE: We do not offer roles with quota any more non-revocable
+          // resources once their quota is satisfied. However, note that this
+          // is not strictly true due to the coarse-grained nature (per agent)
+          // of the allocation algorithm in stage 1.
+          //
+          // TODO(mpark): Offer unreserved resources as revocable beyond quota.
+          Resources resources = available.reserved(role);
+          if (!quotas.contains(role)) {
+            resources += available.unreserved();
+          }
+
+          // It is safe to break here, because all frameworks under a role
+          // would consider the same resources, so in case we don't have
+          // allocatable resources, we don't have to check for other frameworks
+          // under the same role. We only break out of the innermost loop, so
+          // the next step will use the same slaveId, but a different role.
+          //
+          // The difference to the second `allocatable` check is that here we
+          // also check for revocable resources, which can be disabled on a per
+          // framework basis, which requires us to go through all frameworks in
+          // case we have allocatable revocable resources.
+          if (!allocatable(resources)) {
+            break;
+          }
+
+          // Remove revocable resources if the framework has not opted for them.
+          if (!frameworks[frameworkId].revocable) {
+            resources = resources.nonRevocable();
+          }
+
+          // If the resources are not allocatable, ignore. We can not break
+          // here, because another framework under the same role could accept
+          // revocable resources and breaking would skip all other frameworks.
+          if (!allocatable(resources)) {
+            continue;
+          }
+
+          // If the framework filters these resources, ignore.
+          if (isFiltered(frameworkId, slaveId, resources)) {
+            continue;
+          }
+
+          // If the offer generated by `resources` would force the second
+          // stage to use more than `remainingClusterResources`, move along.
+          // We do not terminate early, as offers generated further in the
+          // loop may be small enough to fit within `remainingClusterResources`.
+          //
+          // We exclude shared resources from over-allocation check because
+          // shared resources are always allocatable.
+          const Resources scalarQuantity =
+            resources.nonShared().createStrippedScalarQuantity();
+
+          if (!remainingClusterResources.contains(
+                  allocatedStage2 + scalarQuantity)) {
+            continue;
+          }
+
+          VLOG(2) << "Allocating " << resources << " on agent " << slaveId
+                  << " to framework " << frameworkId;
+
+          // NOTE: We perform "coarse-grained" allocation, meaning that we
+          // always allocate the entire remaining slave resources to a single
+          // framework.
+          //
+          // NOTE: We may have already allocated some resources on the current
+          // agent as part of quota.
+          offerable[frameworkId][slaveId] += resources;
+          offeredSharedResources[slaveId] += resources.shared();
+          allocatedStage2 += scalarQuantity;
+
+          slaves[slaveId].allocated += resources;
+
+          frameworkSorters[role]->add(slaveId, resources);
+          frameworkSorters[role]->allocated(frameworkId_, slaveId, resources);
+          roleSorter->allocated(role, slaveId, resources);
+
+          if (quotas.contains(role)) {
+            // See comment at `quotaRoleSorter` declaration regarding
+            // non-revocable.
+            quotaRoleSorter->allocated(role, slaveId, resources.nonRevocable());
+          }
+        }
+      }
+    }
   }
 
   if (offerable.empty()) {
@@ -1697,6 +1814,129 @@ void HierarchicalAllocatorProcess::allocate(
 }
 
 
+vector<HierarchicalAllocatorProcess::Proposal>
+HierarchicalAllocatorProcess::propose(
+    const vector<SlaveID>& slaveIds,
+    vector<string> roleOrder,
+    hashmap<string, vector<string>> frameworkOrder,
+    const hashmap<SlaveID, Resources>& offeredSharedResources,
+    const Resources& remainingClusterResources) const
+{
+  // This is run concurrently for multiple shards, which is only safe
+  // while `allocate()` blocks the allocator and no state is modified.
+  // This function and those it calls are `const` so that they can
+  // only read the allocator state.
+  CHECK(proposing);
+
+  // This mirrors the fair share stage of `allocate()`, see the
+  // comments there for the rationale of each step.
+  vector<Proposal> proposals;
+
+  Resources allocatedStage2;
+
+  foreach (const SlaveID& slaveId, slaveIds) {
+    if (!allocatable(remainingClusterResources - allocatedStage2)) {
+      break;
+    }
+
+    const Slave& slave = slaves.at(slaveId);
+
+    // What this shard has allocated on the slave so far.
+    Resources allocated = slave.allocated;
+    Resources offeredShared = offeredSharedResources.contains(slaveId)
+      ? offeredSharedResources.at(slaveId)
+      : Resources();
+
+    // The roles and frameworks allocated to on this slave.
+    hashmap<string, hashset<string>> recipients;
+
+    foreach (const string& role, roleOrder) {
+      foreach (const string& frameworkId_, frameworkOrder.at(role)) {
+        FrameworkID frameworkId;
+        frameworkId.set_value(frameworkId_);
+
+        const Framework& framework = frameworks.at(frameworkId);
+
+        if (!framework.gpuAware && slave.total.gpus().getOrElse(0) > 0) {
+          continue;
+        }
+
+        Resources available = (slave.total - allocated).nonShared();
+
+        if (framework.shared) {
+          available += slave.total.shared();
+          available -= offeredShared;
+        }
+
+        Resources resources = available.reserved(role);
+        if (!quotas.contains(role)) {
+          resources += available.unreserved();
+        }
+
+        if (!allocatable(resources)) {
+          break;
+        }
+
+        if (!framework.revocable) {
+          resources = resources.nonRevocable();
+        }
+
+        if (!allocatable(resources)) {
+          continue;
+        }
+
+        if (isFiltered(frameworkId, slaveId, resources)) {
+          continue;
+        }
+
+        const Resources scalarQuantity =
+          resources.nonShared().createStrippedScalarQuantity();
+
+        if (!remainingClusterResources.contains(
+                allocatedStage2 + scalarQuantity)) {
+          continue;
+        }
+
+        proposals.push_back(Proposal{slaveId, role, frameworkId, resources});
+
+        allocated += resources;
+        offeredShared += resources.shared();
+        allocatedStage2 += scalarQuantity;
+
+        recipients[role].insert(frameworkId_);
+      }
+    }
+
+    // Since the shard can not consult the sorters, we approximate the
+    // increase in the share of the recipients by moving them to the
+    // back of the sort order (in their current relative order).
+    if (!recipients.empty()) {
+      std::stable_partition(
+          roleOrder.begin(),
+          roleOrder.end(),
+          [&recipients](const string& role) {
+            return !recipients.contains(role);
+          });
+
+      foreachpair (const string& role,
+                   const hashset<string>& frameworkIds,
+                   recipients) {
+        vector<string>& order = frameworkOrder.at(role);
+
+        std::stable_partition(
+            order.begin(),
+            order.end(),
+            [&frameworkIds](const string& frameworkId) {
+              return !frameworkIds.contains(frameworkId);
+            });
+      }
+    }
+  }
+
+  return proposals;
+}
+
+
 void HierarchicalAllocatorProcess::deallocate(
     const hashset<SlaveID>& slaveIds_)
 {
@@ -1859,14 +2099,17 @@ bool HierarchicalAllocatorProcess::isWhitelisted(
 bool HierarchicalAllocatorProcess::isFiltered(
     const FrameworkID& frameworkId,
     const SlaveID& slaveId,
-    const Resources& resources)
+    const Resources& resources) const
 {
   CHECK(frameworks.contains(frameworkId));
   CHECK(slaves.contains(slaveId));
 
-  if (frameworks[frameworkId].offerFilters.contains(slaveId)) {
-    foreach (
-      OfferFilter* offerFilter, frameworks[frameworkId].offerFilters[slaveId]) {
+  // NOTE: This is also called concurrently by the shards of an
+  // allocation cycle, see `propose()`.
+  const Framework& framework = frameworks.at(frameworkId);
+
+  if (framework.offerFilters.contains(slaveId)) {
+    foreach (OfferFilter* offerFilter, framework.offerFilters.at(slaveId)) {
       if (offerFilter->filter(resources)) {
         VLOG(1) << "Filtered offer with " << resources
                 << " on agent " << slaveId
@@ -1906,7 +2149,7 @@ bool HierarchicalAllocatorProcess::isFiltered(
 
 
 bool HierarchicalAllocatorProcess::allocatable(
-    const Resources& resources)
+    const Resources& resources) const
 {
   Option<double> cpus = resources.cpus();
   Option<Bytes> mem = resources.mem();
@@ -17,8 +17,10 @@
 #ifndef __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 #define __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 
+#include <algorithm>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 
@@ -31,6 +33,10 @@
 #include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
 #include <stout/option.hpp>
+#include <stout/os.hpp>
+#include <stout/try.hpp>
+
+#include "common/job_threads.hpp"
 
 #include "master/allocator/mesos/allocator.hpp"
 #include "master/allocator/mesos/metrics.hpp"
@@ -77,6 +83,8 @@ public:
       const std::function<Sorter*()>& quotaRoleSorterFactory)
     : initialized(false),
       paused(true),
+      allocationShards(1),
+      proposing(false),
       metrics(*this),
       roleSorter(roleSorterFactory()),
       quotaRoleSorter(quotaRoleSorterFactory()),
@@ -220,6 +228,28 @@ protected:
   // Allocate resources from the specified slaves.
   void allocate(const hashset<SlaveID>& slaveIds);
 
+  // An allocation proposed by a shard of agents, see `allocate()`.
+  struct Proposal
+  {
+    SlaveID slaveId;
+    std::string role;
+    FrameworkID frameworkId;
+    Resources resources;
+  };
+
+  // Evaluates the fair share stage of an allocation cycle for the
+  // specified (shard of) slaves against a snapshot of the role and
+  // framework sort orders, and returns the allocations it would make.
+  // This does not modify any allocator state so that multiple shards
+  // can be evaluated in parallel, and must only be called while
+  // `allocate()` is blocked waiting for the shards (see `proposing`).
+  std::vector<Proposal> propose(
+      const std::vector<SlaveID>& slaveIds,
+      std::vector<std::string> roleOrder,
+      hashmap<std::string, std::vector<std::string>> frameworkOrder,
+      const hashmap<SlaveID, Resources>& offeredSharedResources,
+      const Resources& remainingClusterResources) const;
+
   // Send inverse offers from the specified slaves.
   void deallocate(const hashset<SlaveID>& slaveIds);
 
@@ -246,7 +276,7 @@ protected:
   bool isFiltered(
       const FrameworkID& frameworkId,
       const SlaveID& slaveId,
-      const Resources& resources);
+      const Resources& resources) const;
 
   // Returns true if there is an inverse offer filter for this framework
   // on this slave.
@@ -254,11 +284,26 @@ protected:
       const FrameworkID& frameworkID,
       const SlaveID& slaveID);
 
-  bool allocatable(const Resources& resources);
+  bool allocatable(const Resources& resources) const;
 
   bool initialized;
   bool paused;
 
+  // The number of shards the slaves are partitioned into during the
+  // fair share stage of an allocation cycle. The shards are evaluated
+  // in parallel (see `propose()`) and the proposed allocations are then
+  // reconciled in shard order. A value of 1 allocates the slaves one
+  // after the other, updating the sorters after each allocation.
+  size_t allocationShards;
+
+  // The threads that evaluate the shards, created by the first
+  // allocation cycle that uses more than one shard.
+  process::Owned<JobThreads> workers;
+
+  // Whether `allocate()` is blocked waiting for the shards, during
+  // which `propose()` may read the allocator state from the shards.
+  bool proposing;
+
   // Recovery data.
   Option<int> expectedAgentCount;
 
@@ -498,6 +543,39 @@ public:
           []() -> Sorter* { return new QuotaRoleSorter(); }) {}
 };
 
+
+// A hierarchical allocator that partitions the agents into one shard
+// per CPU and evaluates the fair share stage of each allocation cycle
+// for the shards in parallel. This trades some precision of the fair
+// share (each shard starts from the same sort order) for shorter
+// allocation cycles on large clusters.
+template <
+    typename RoleSorter,
+    typename FrameworkSorter,
+    typename QuotaRoleSorter>
+class ShardedHierarchicalAllocatorProcess
+  : public HierarchicalAllocatorProcess<
+        RoleSorter,
+        FrameworkSorter,
+        QuotaRoleSorter>
+{
+public:
+  ShardedHierarchicalAllocatorProcess()
+    : process::ProcessBase(process::ID::generate("hierarchical-allocator"))
+  {
+    Try<long> cpus = os::cpus();
+    this->allocationShards =
+      cpus.isSome() ? static_cast<size_t>(std::max(1L, cpus.get())) : 1;
+  }
+};
+
+
+typedef ShardedHierarchicalAllocatorProcess<DRFSorter, DRFSorter, DRFSorter>
+ShardedHierarchicalDRFAllocatorProcess;
+
+typedef MesosAllocator<ShardedHierarchicalDRFAllocatorProcess>
+ShardedHierarchicalDRFAllocator;
+
 } // namespace allocator {
 } // namespace master {
 } // namespace internal {
@@ -15,8 +15,10 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <iterator>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <mesos/mesos.hpp>
@@ -65,6 +67,10 @@ void DRFSorter::initialize(
     const Option<set<string>>& _fairnessExcludeResourceNames)
 {
   fairnessExcludeResourceNames = _fairnessExcludeResourceNames;
+
+  // The resources considered for fair sharing have changed.
+  dirty = true;
+  totals.clear();
 }
 
 
@@ -73,7 +79,7 @@ void DRFSorter::add(const string& name, double weight)
   CHECK(!contains(name));
 
   Client client(name, 0, 0);
-  clients.insert(client);
+  insert(client);
 
   allocations[name] = Allocation();
   weights[name] = weight;
@@ -103,9 +109,10 @@ void DRFSorter::remove(const string& name)
   set<Client, DRFComparator>::iterator it = find(name);
 
   if (it != clients.end()) {
-    clients.erase(it);
+    erase(it);
   }
 
+  pending.erase(name);
   allocations.erase(name);
   weights.erase(name);
 
@@ -122,7 +129,7 @@ void DRFSorter::activate(const string& name)
   set<Client, DRFComparator>::iterator it = find(name);
   if (it == clients.end()) {
     Client client(name, calculateShare(name), 0);
-    clients.insert(client);
+    insert(client);
   }
 }
 
@@ -136,8 +143,10 @@ void DRFSorter::deactivate(const string& name)
     // because we lose information such as the number of allocations
     // for this client which means the fairness can be gamed by a
     // framework disconnecting and reconnecting.
-    clients.erase(it);
+    erase(it);
   }
+
+  pending.erase(name);
 }
 
 
@@ -149,15 +158,9 @@ void DRFSorter::allocated(
   set<Client, DRFComparator>::iterator it = find(name);
 
   if (it != clients.end()) { // TODO(benh): This should really be a CHECK.
-    // TODO(benh): Refactor 'update' to be able to reuse it here.
-    Client client(*it);
-
-    // Update the 'allocations' to reflect the allocator decision.
-    client.allocations++;
-
-    // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
+    // Update the 'allocations' to reflect the allocator decision, the
+    // client is moved accordingly by the next sort().
+    pending[name]++;
   }
 
   // Add shared resources to the allocated quantities when the same
@@ -318,6 +321,7 @@ void DRFSorter::add(const SlaveID& slaveId, const Resources& resources)
     // something else changes before the next allocation we don't
     // recalculate everything twice.
     dirty = true;
+    totals.clear();
   }
 }
 
@@ -348,41 +352,60 @@ void DRFSorter::remove(const SlaveID& slaveId, const Resources& resources)
     }
 
     dirty = true;
+    totals.clear();
   }
 }
 
 
-vector<string> DRFSorter::sort()
+Sorter::Clients DRFSorter::sort()
 {
   if (dirty) {
     set<Client, DRFComparator> temp;
 
-    set<Client, DRFComparator>::iterator it;
-    for (it = clients.begin(); it != clients.end(); it++) {
-      Client client(*it);
-
+    foreach (Client client, clients) {
       // Update the 'share' to get proper sorting.
       client.share = calculateShare(client.name);
 
+      if (pending.contains(client.name)) {
+        client.allocations += pending.at(client.name);
+      }
+
       temp.insert(client);
     }
 
-    clients = temp;
+    clients = std::move(temp);
+
+    // The iterators into (and the links between the clients of)
+    // the previous set are no longer valid.
+    index.clear();
+    for (auto it = clients.begin(); it != clients.end(); ++it) {
+      index[it->name] = it;
+      it->next = std::next(it) != clients.end() ? &*std::next(it) : nullptr;
+    }
 
     // Reset dirty to false so as not to re-calculate *all*
     // shares unless another dirtying operation occurs.
     dirty = false;
-  }
-
-  vector<string> result;
-  result.reserve(clients.size());
+  } else {
+    // Only the clients that changed since the last sort are moved.
+    foreachpair (const string& name, uint64_t allocations, pending) {
+      set<Client, DRFComparator>::iterator it = find(name);
+      CHECK(it != clients.end());
 
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    result.push_back((*it).name);
+      reposition(it, calculateShare(name), it->allocations + allocations);
+    }
   }
 
-  return result;
+  pending.clear();
+
+  return Clients(
+      clients.empty() ? nullptr : &*clients.begin(),
+      [](const void* client) -> const string& {
+        return static_cast<const Client*>(client)->name;
+      },
+      [](const void* client) -> const void* {
+        return static_cast<const Client*>(client)->next;
+      });
 }
 
 
@@ -400,67 +423,54 @@ int DRFSorter::count()
 
 void DRFSorter::update(const string& name)
 {
-  set<Client, DRFComparator>::iterator it = find(name);
-
-  if (it != clients.end()) {
-    Client client(*it);
-
-    // Update the 'share' to get proper sorting.
-    client.share = calculateShare(client.name);
-
-    // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
+  if (find(name) != clients.end()) {
+    pending.emplace(name, 0);
   }
 }
 
 
 double DRFSorter::calculateShare(const string& name)
 {
-  double share = 0.0;
-
   // TODO(benh): This implementation of "dominant resource fairness"
   // currently does not take into account resources that are not
   // scalars.
 
-  foreach (const string& scalar, total_.scalarQuantities.names()) {
-    // Filter out the resources excluded from fair sharing.
-    if (fairnessExcludeResourceNames.isSome() &&
-        fairnessExcludeResourceNames->count(scalar) > 0) {
-      continue;
-    }
+  // Lazily (re-)calculate the totals after the total resources
+  // have changed, so that we only do it once for all clients.
+  if (totals.empty()) {
+    foreach (const Resource& resource, total_.scalarQuantities) {
+      // Filter out the resources excluded from fair sharing.
+      if (fairnessExcludeResourceNames.isSome() &&
+          fairnessExcludeResourceNames->count(resource.name()) > 0) {
+        continue;
+      }
 
-    // We collect the scalar accumulated total value from the
-    // `Resources` object.
-    //
-    // NOTE: Although in principle scalar resources may be spread
-    // across multiple `Resource` objects (e.g., persistent volumes),
-    // we currently strip persistence and reservation metadata from
-    // the resources in `scalarQuantities`.
-    Option<Value::Scalar> __total =
-      total_.scalarQuantities.get<Value::Scalar>(scalar);
+      // NOTE: Although in principle scalar resources may be spread
+      // across multiple `Resource` objects (e.g., persistent
+      // volumes), we currently strip persistence and reservation
+      // metadata from the resources in `scalarQuantities`. Resources
+      // with the same name but different roles are summed up.
+      totals[resource.name()] += resource.scalar();
+    }
+  }
 
-    CHECK_SOME(__total);
-    const double _total = __total.get().value();
+  // We collect the scalar accumulated allocation values from the
+  // `Resources` object, see the note above.
+  hashmap<string, Value::Scalar> allocated;
+  foreach (const Resource& resource, allocations[name].scalarQuantities) {
+    if (totals.contains(resource.name())) {
+      allocated[resource.name()] += resource.scalar();
+    }
+  }
 
-    if (_total > 0.0) {
-      double allocation = 0.0;
+  double share = 0.0;
 
-      // We collect the scalar accumulated allocation value from the
-      // `Resources` object.
-      //
-      // NOTE: Although in principle scalar resources may be spread
-      // across multiple `Resource` objects (e.g., persistent volumes),
-      // we currently strip persistence and reservation metadata from
-      // the resources in `scalarQuantities`.
-      Option<Value::Scalar> _allocation =
-        allocations[name].scalarQuantities.get<Value::Scalar>(scalar);
-
-      if (_allocation.isSome()) {
-        allocation = _allocation.get().value();
-      }
+  foreachpair (const string& scalar, const Value::Scalar& allocation,
+               allocated) {
+    const double _total = totals.at(scalar).value();
 
-      share = std::max(share, allocation / _total);
+    if (_total > 0.0) {
+      share = std::max(share, allocation.value() / _total);
     }
   }
 
@@ -470,14 +480,59 @@ double DRFSorter::calculateShare(const string& name)
 
 set<Client, DRFComparator>::iterator DRFSorter::find(const string& name)
 {
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    if (name == (*it).name) {
-      break;
-    }
+  Option<set<Client, DRFComparator>::iterator> it = index.get(name);
+
+  if (it.isNone()) {
+    return clients.end();
   }
 
-  return it;
+  return it.get();
+}
+
+
+void DRFSorter::insert(const Client& client)
+{
+  set<Client, DRFComparator>::iterator it = clients.insert(client).first;
+
+  it->next = std::next(it) != clients.end() ? &*std::next(it) : nullptr;
+
+  if (it != clients.begin()) {
+    std::prev(it)->next = &*it;
+  }
+
+  index[client.name] = it;
+}
+
+
+void DRFSorter::erase(set<Client, DRFComparator>::iterator it)
+{
+  if (it != clients.begin()) {
+    std::prev(it)->next = it->next;
+  }
+
+  index.erase(it->name);
+  clients.erase(it);
+}
+
+
+void DRFSorter::reposition(
+    set<Client, DRFComparator>::iterator it,
+    double share,
+    uint64_t allocations)
+{
+  if (share == it->share && allocations == it->allocations) {
+    return;
+  }
+
+  // The share and the allocations determine the position of the
+  // client in 'clients', so we remove and reinsert it to update the
+  // ordering appropriately.
+  Client client(*it);
+  client.share = share;
+  client.allocations = allocations;
+
+  erase(it);
+  insert(client);
 }
 
 } // namespace allocator {
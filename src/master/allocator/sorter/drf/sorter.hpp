@@ -53,6 +53,11 @@ struct Client
   // having allocations restart at 0 after a master failover should be
   // sufficient (famous last words.)
   uint64_t allocations;
+
+  // The next client in sort order, or `nullptr` for the last one.
+  // The clients returned by `DRFSorter::sort()` are iterated along
+  // these links, which the sorter maintains as it moves clients.
+  mutable const Client* next = nullptr;
 };
 
 
@@ -118,15 +123,15 @@ public:
 
   virtual void remove(const SlaveID& slaveId, const Resources& resources);
 
-  virtual std::vector<std::string> sort();
+  virtual Clients sort();
 
   virtual bool contains(const std::string& name);
 
   virtual int count();
 
 private:
-  // Recalculates the share for the client and moves
-  // it in 'clients' accordingly.
+  // Marks the share of the client for recalculation by the next
+  // sort(), which then moves it in 'clients' accordingly.
   void update(const std::string& name);
 
   // Returns the dominant resource share for the client.
@@ -139,12 +144,43 @@ private:
   // it exists in this Sorter.
   std::set<Client, DRFComparator>::iterator find(const std::string& name);
 
+  // Inserts the client into 'clients', links it to its neighbors
+  // and indexes it.
+  void insert(const Client& client);
+
+  // Removes the client from 'clients', its neighbors and its index.
+  void erase(std::set<Client, DRFComparator>::iterator it);
+
+  // Updates the share and the allocations of the client, which
+  // reinserts it into 'clients' if either changed.
+  void reposition(
+      std::set<Client, DRFComparator>::iterator it,
+      double share,
+      uint64_t allocations);
+
   // If true, sort() will recalculate all shares.
   bool dirty = false;
 
-  // A set of Clients (names and shares) sorted by share.
+  // A set of Clients (names and shares) sorted by share. Each
+  // client is linked to the next one, see `Client::next`.
   std::set<Client, DRFComparator> clients;
 
+  // Index of the active clients in 'clients', by name. This
+  // avoids a linear search through 'clients' on every update.
+  hashmap<std::string, std::set<Client, DRFComparator>::iterator> index;
+
+  // The active clients whose share or allocations changed since the
+  // last sort(), with the number of allocations made to them since.
+  // They are only moved in 'clients' by the next sort(), so that the
+  // clients returned by sort() can be iterated while allocating.
+  hashmap<std::string, uint64_t> pending;
+
+  // The total scalar quantity of each resource (by name) that is
+  // considered for fair sharing. This is recalculated whenever the
+  // total changes (i.e., when 'dirty' is set) rather than for every
+  // share calculation.
+  hashmap<std::string, Value::Scalar> totals;
+
   // Maps client names to the weights that should be applied to their shares.
   hashmap<std::string, double> weights;
 
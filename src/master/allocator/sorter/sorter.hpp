@@ -18,6 +18,7 @@
 #define __MASTER_ALLOCATOR_SORTER_SORTER_HPP__
 
 #include <functional>
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -41,6 +42,81 @@ namespace allocator {
 class Sorter
 {
 public:
+  // A view of the clients of a sorter in sort order, see `sort()`.
+  //
+  // The view does not know how a sorter stores its clients: it is
+  // given the first client and functions to get the name of a client
+  // and the client that follows it in sort order (or `nullptr` for
+  // the last one), so that the clients can be iterated without
+  // copying their names.
+  class Clients
+  {
+  public:
+    typedef const std::string& (*Name)(const void* client);
+    typedef const void* (*Next)(const void* client);
+
+    class const_iterator
+      : public std::iterator<std::forward_iterator_tag, const std::string>
+    {
+    public:
+      const_iterator(const void* _client, Name _name, Next _next)
+        : client(_client), name(_name), next(_next) {}
+
+      const std::string& operator*() const { return name(client); }
+      const std::string* operator->() const { return &name(client); }
+
+      const_iterator& operator++()
+      {
+        client = next(client);
+        return *this;
+      }
+
+      const_iterator operator++(int)
+      {
+        const_iterator that = *this;
+        client = next(client);
+        return that;
+      }
+
+      bool operator==(const const_iterator& that) const
+      {
+        return client == that.client;
+      }
+
+      bool operator!=(const const_iterator& that) const
+      {
+        return client != that.client;
+      }
+
+    private:
+      const void* client;
+      Name name;
+      Next next;
+    };
+
+    typedef const_iterator iterator;
+
+    Clients(const void* _first, Name _name, Next _next)
+      : first(_first), name(_name), next(_next) {}
+
+    const_iterator begin() const { return const_iterator(first, name, next); }
+    const_iterator end() const { return const_iterator(nullptr, name, next); }
+
+    bool empty() const { return first == nullptr; }
+
+    // Copies the names of the clients, e.g., in order to keep the
+    // current sort order around.
+    operator std::vector<std::string>() const
+    {
+      return std::vector<std::string>(begin(), end());
+    }
+
+  private:
+    const void* first;
+    Name name;
+    Next next;
+  };
+
   Sorter() = default;
 
   // Provides the allocator's execution context (via a UPID)
@@ -130,7 +206,16 @@ public:
 
   // Returns all of the clients in the order that they should
   // be allocated to, according to this Sorter's policy.
-  virtual std::vector<std::string> sort() = 0;
+  //
+  // NOTE: The returned clients are a view into the sorter rather than
+  // a copy. Calling `add()`, `remove()`, `activate()` or `deactivate()`
+  // for a client invalidates the view, as does the next call to
+  // `sort()`. Allocation changes (`allocated()`, `update()`,
+  // `unallocated()`) and changes to the total resources do not move
+  // any client until the next call to `sort()`, so callers may
+  // iterate over the view while allocating. Callers that need the
+  // order beyond that must copy it into a vector.
+  virtual Clients sort() = 0;
 
   // Returns true if this Sorter contains the specified client,
   // either active or deactivated.
@@ -91,6 +91,18 @@ constexpr Duration WHITELIST_WATCH_INTERVAL = Seconds(5);
 // Default number of tasks (limit) for /master/tasks endpoint.
 constexpr size_t TASK_LIMIT = 100;
 
+// Maximum total size of the cached responses of the
+// /master/state-summary endpoint.
+constexpr Bytes MAX_STATE_SUMMARY_CACHE_SIZE = Megabytes(64);
+
+// Default number of registrar operation log entries between two full
+// snapshots of the registry.
+constexpr size_t DEFAULT_REGISTRY_OPERATIONS_BETWEEN_SNAPSHOTS = 1000;
+
+// Default maximum number of registrar operation log entries that are
+// being appended at the same time.
+constexpr size_t DEFAULT_REGISTRY_MAX_OUTSTANDING_APPENDS = 16;
+
 /**
  * Label used by the Leader Contender and Detector.
  *
@@ -115,6 +127,10 @@ constexpr char DEFAULT_AUTHENTICATOR[] = "crammd5";
 // Name of the default, HierarchicalDRF authenticator.
 constexpr char DEFAULT_ALLOCATOR[] = "HierarchicalDRF";
 
+// Name of the HierarchicalDRF allocator that allocates shards of agents
+// in parallel.
+constexpr char SHARDED_ALLOCATOR[] = "HierarchicalDRFSharded";
+
 // The default interval between allocations.
 constexpr Duration DEFAULT_ALLOCATION_INTERVAL = Seconds(1);
 
@@ -117,6 +117,47 @@ mesos::internal::master::Flags::Flags()
       "after which the operation is considered a failure.",
       Seconds(20));
 
+  add(&Flags::registry_operation_log,
+      "registry_operation_log",
+      "Whether the registrar persists registry updates by appending the\n"
+      "semantic operations (e.g., admitting an agent or updating a quota)\n"
+      "to an operation log rather than storing the whole registry on\n"
+      "every update. The cost of an update is then independent of the\n"
+      "size of the registry. A full snapshot of the registry is stored\n"
+      "periodically (see `--registry_operations_between_snapshots`) and\n"
+      "when an operation can not be logged. Disabling the flag after it\n"
+      "has been enabled is safe: the log is replayed and folded into a\n"
+      "snapshot when the registrar recovers.",
+      false);
+
+  add(&Flags::registry_operations_between_snapshots,
+      "registry_operations_between_snapshots",
+      "Maximum number of operation log entries that the registrar appends\n"
+      "before it stores a full snapshot of the registry and discards the\n"
+      "entries. Only used with `--registry_operation_log`.",
+      DEFAULT_REGISTRY_OPERATIONS_BETWEEN_SNAPSHOTS,
+      [](size_t value) -> Option<Error> {
+        if (value == 0) {
+          return Error("Expected a positive number of operations");
+        }
+        return None();
+      });
+
+  add(&Flags::registry_max_outstanding_appends,
+      "registry_max_outstanding_appends",
+      "Maximum number of operation log entries that the registrar appends\n"
+      "at the same time. The operations that arrive while an entry is\n"
+      "being appended are appended as the next entry right away (up to\n"
+      "this limit) rather than after the previous entry has been stored.\n"
+      "Only used with `--registry_operation_log`.",
+      DEFAULT_REGISTRY_MAX_OUTSTANDING_APPENDS,
+      [](size_t value) -> Option<Error> {
+        if (value == 0) {
+          return Error("Expected a positive number of appends");
+        }
+        return None();
+      });
+
   add(&Flags::log_auto_initialize,
       "log_auto_initialize",
       "Whether to automatically initialize the replicated log used for the\n"
@@ -447,8 +488,10 @@ mesos::internal::master::Flags::Flags()
   add(&Flags::allocator,
       "allocator",
       "Allocator to use for resource allocation to frameworks.\n"
-      "Use the default `" + string(DEFAULT_ALLOCATOR) + "` allocator, or\n"
-      "load an alternate allocator module using `--modules`.",
+      "Use the default `" + string(DEFAULT_ALLOCATOR) + "` allocator, the\n"
+      "`" + string(SHARDED_ALLOCATOR) + "` allocator which allocates shards\n"
+      "of agents in parallel (for large clusters), or load an alternate\n"
+      "allocator module using `--modules`.",
       DEFAULT_ALLOCATOR);
 
   add(&Flags::fair_sharing_excluded_resource_names,
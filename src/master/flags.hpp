@@ -52,6 +52,9 @@ public:
   bool registry_strict;
   Duration registry_fetch_timeout;
   Duration registry_store_timeout;
+  bool registry_operation_log;
+  size_t registry_operations_between_snapshots;
+  size_t registry_max_outstanding_appends;
   bool log_auto_initialize;
   Duration agent_reregister_timeout;
   std::string recovery_agent_removal_limit;
@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <deque>
 #include <iomanip>
 #include <map>
 #include <memory>
@@ -2452,6 +2453,12 @@ string Master::Http::STATE_HELP()
         "The information shown might be filtered based on the user",
         "accessing the endpoint.",
         "",
+        "With the `stream=true` query parameter the response is streamed",
+        "one agent and framework at a time instead of being built at once,",
+        "which bounds the memory used and keeps the master responsive in",
+        "large clusters. Agents and frameworks that are removed while the",
+        "response is streamed are omitted.",
+        "",
         "Example (**Note**: this is not exhaustive):",
         "",
         "```",
@@ -2530,6 +2537,78 @@ string Master::Http::STATE_HELP()
 }
 
 
+// Writes the fields of a JSON object like `JSON::ObjectWriter`, but
+// without the enclosing braces, which lets a streamed response write
+// an object across several chunks. The caller writes the braces.
+class FieldWriter
+{
+public:
+  explicit FieldWriter(std::ostream* stream, size_t count = 0)
+    : stream_(stream), count_(count) {}
+
+  template <typename T>
+  void field(const string& key, const T& value)
+  {
+    this->key(key);
+    *stream_ << jsonify(value);
+  }
+
+  // Writes the key of a field whose value the caller writes itself.
+  void key(const string& key)
+  {
+    if (count_ > 0) {
+      *stream_ << ',';
+    }
+    *stream_ << jsonify(key) << ':';
+    ++count_;
+  }
+
+  size_t count() const { return count_; }
+
+private:
+  std::ostream* stream_;
+  size_t count_;
+};
+
+
+struct Master::Http::StateStream
+{
+  enum Stage
+  {
+    SLAVES,
+    FRAMEWORKS,
+    COMPLETED_FRAMEWORKS
+  };
+
+  explicit StateStream(const Pipe::Writer& _writer)
+    : writer(_writer), stage(SLAVES), fields(0), elements(0) {}
+
+  Pipe::Writer writer;
+  Option<string> jsonp;
+
+  Owned<ObjectApprover> frameworksApprover;
+  Owned<ObjectApprover> tasksApprover;
+  Owned<ObjectApprover> executorsApprover;
+
+  // The agents and frameworks that remain to be written. We only
+  // keep the IDs of agents and registered frameworks since they can
+  // be removed while the response is streamed, in which case they
+  // are skipped.
+  std::deque<SlaveID> slaves;
+  std::deque<FrameworkID> frameworks;
+  std::deque<std::shared_ptr<Framework>> completedFrameworks;
+
+  Stage stage;
+
+  // The number of fields written to the top-level object.
+  size_t fields;
+
+  // The number of elements written to the current array, used to
+  // determine whether a separator is needed.
+  size_t elements;
+};
+
+
 Future<Response> Master::Http::state(
     const Request& request,
     const Option<string>& principal) const
@@ -2580,75 +2659,79 @@ Future<Response> Master::Http::state(
                                     Owned<ObjectApprover>,
                                     Owned<ObjectApprover>>& approvers)
           -> Response {
-      // This lambda is consumed before the outer lambda
-      // returns, hence capture by reference is fine here.
-      auto state = [this, &approvers](JSON::ObjectWriter* writer) {
-        // Get approver from tuple.
-        Owned<ObjectApprover> frameworksApprover;
-        Owned<ObjectApprover> tasksApprover;
-        Owned<ObjectApprover> executorsApprover;
-        Owned<ObjectApprover> flagsApprover;
-        tie(frameworksApprover,
-            tasksApprover,
-            executorsApprover,
-            flagsApprover) = approvers;
-
-        writer->field("version", MESOS_VERSION);
-
-        if (build::GIT_SHA.isSome()) {
-          writer->field("git_sha", build::GIT_SHA.get());
+      // Get approver from tuple.
+      Owned<ObjectApprover> frameworksApprover;
+      Owned<ObjectApprover> tasksApprover;
+      Owned<ObjectApprover> executorsApprover;
+      Owned<ObjectApprover> flagsApprover;
+      tie(frameworksApprover,
+          tasksApprover,
+          executorsApprover,
+          flagsApprover) = approvers;
+
+      if (request.url.query.get("stream") == string("true")) {
+        Pipe pipe;
+        OK ok;
+
+        ok.type = Response::PIPE;
+        ok.reader = pipe.reader();
+
+        Owned<StateStream> stream(new StateStream(pipe.writer()));
+        stream->jsonp = request.url.query.get("jsonp");
+        stream->frameworksApprover = frameworksApprover;
+        stream->tasksApprover = tasksApprover;
+        stream->executorsApprover = executorsApprover;
+
+        foreachkey (const SlaveID& slaveId, master->slaves.registered) {
+          stream->slaves.push_back(slaveId);
         }
 
-        if (build::GIT_BRANCH.isSome()) {
-          writer->field("git_branch", build::GIT_BRANCH.get());
+        foreachkey (const FrameworkID& frameworkId,
+                    master->frameworks.registered) {
+          stream->frameworks.push_back(frameworkId);
         }
 
-        if (build::GIT_TAG.isSome()) {
-          writer->field("git_tag", build::GIT_TAG.get());
+        foreach (const std::shared_ptr<Framework>& framework,
+                 master->frameworks.completed) {
+          stream->completedFrameworks.push_back(framework);
         }
 
-        writer->field("build_date", build::DATE);
-        writer->field("build_time", build::TIME);
-        writer->field("build_user", build::USER);
-        writer->field("start_time", master->startTime.secs());
+        // The fields that precede the agents and frameworks are
+        // small, so we write them up front and open the agents array.
+        std::ostringstream out;
 
-        if (master->electedTime.isSome()) {
-          writer->field("elected_time", master->electedTime.get().secs());
+        if (stream->jsonp.isSome()) {
+          out << stream->jsonp.get() << "(";
+          ok.headers["Content-Type"] = "text/javascript";
+        } else {
+          ok.headers["Content-Type"] = "application/json";
         }
 
-        writer->field("id", master->info().id());
-        writer->field("pid", string(master->self()));
-        writer->field("hostname", master->info().hostname());
-        writer->field("activated_slaves", master->_slaves_active());
-        writer->field("deactivated_slaves", master->_slaves_inactive());
+        out << "{";
 
-        if (master->leader.isSome()) {
-          writer->field("leader", master->leader.get().pid());
-        }
+        FieldWriter fields(&out);
+        stateHeader(&fields, flagsApprover);
+        fields.key("slaves");
+        out << "[";
 
-        if (approveViewFlags(flagsApprover)) {
-          if (master->flags.cluster.isSome()) {
-            writer->field("cluster", master->flags.cluster.get());
-          }
+        stream->fields = fields.count();
+        stream->writer.write(out.str());
 
-          if (master->flags.log_dir.isSome()) {
-            writer->field("log_dir", master->flags.log_dir.get());
-          }
+        dispatch(master->self(), [this, stream]() {
+          _state(stream);
+        });
 
-          if (master->flags.external_log_file.isSome()) {
-            writer->field("external_log_file",
-                          master->flags.external_log_file.get());
-          }
+        return ok;
+      }
 
-          writer->field("flags", [this](JSON::ObjectWriter* writer) {
-              foreachvalue (const flags::Flag& flag, master->flags) {
-                Option<string> value = flag.stringify(master->flags);
-                if (value.isSome()) {
-                  writer->field(flag.effective_name().value, value.get());
-                }
-              }
-            });
-        }
+      // This lambda is consumed before the outer lambda
+      // returns, hence capture by reference is fine here.
+      auto state = [this,
+                    &frameworksApprover,
+                    &tasksApprover,
+                    &executorsApprover,
+                    &flagsApprover](JSON::ObjectWriter* writer) {
+        stateHeader(writer, flagsApprover);
 
         // Model all of the slaves.
         writer->field("slaves", [this](JSON::ArrayWriter* writer) {
@@ -2701,61 +2784,251 @@ Future<Response> Master::Http::state(
               }
             });
 
-        // Model all of the orphan tasks.
-        writer->field("orphan_tasks", [this, &tasksApprover](
-            JSON::ArrayWriter* writer) {
-          // Find those orphan tasks.
-          foreachvalue (const Slave* slave, master->slaves.registered) {
-            typedef hashmap<TaskID, Task*> TaskMap;
-            foreachvalue (const TaskMap& tasks, slave->tasks) {
-              foreachvalue (const Task* task, tasks) {
-                CHECK_NOTNULL(task);
-                const FrameworkID& frameworkId = task->framework_id();
-                if (!master->frameworks.registered.contains(frameworkId)) {
-                  // TODO(joerg84): This logic should be simplified after
-                  // a deprecation cycle starting with 1.0 as after that
-                  // we can rely on 'master->frameworks.recovered' containing
-                  // all FrameworkInfos.
-                  // Until then there are 3 cases:
-                  // - No authorization enabled: show all orphaned tasks.
-                  // - Authorization enabled, but no FrameworkInfo present:
-                  //   do not show orphaned tasks.
-                  // - Authorization enabled, FrameworkInfo present: filter
-                  //   based on 'approveViewTask'.
-                  if (master->authorizer.isSome() &&
-                     (!master->frameworks.recovered.contains(frameworkId) ||
-                      !approveViewTask(
-                          tasksApprover,
-                          *task,
-                          master->frameworks.recovered[frameworkId]))) {
-                    continue;
-                  }
-
-                  writer->element(*task);
-                }
-              }
-            }
+        stateOrphans(writer, tasksApprover);
+      };
+
+      return OK(jsonify(state), request.url.query.get("jsonp"));
+    }));
+}
+
+
+template <typename Writer>
+void Master::Http::stateHeader(
+    Writer* writer,
+    const Owned<ObjectApprover>& flagsApprover) const
+{
+  writer->field("version", MESOS_VERSION);
+
+  if (build::GIT_SHA.isSome()) {
+    writer->field("git_sha", build::GIT_SHA.get());
+  }
+
+  if (build::GIT_BRANCH.isSome()) {
+    writer->field("git_branch", build::GIT_BRANCH.get());
+  }
+
+  if (build::GIT_TAG.isSome()) {
+    writer->field("git_tag", build::GIT_TAG.get());
+  }
+
+  writer->field("build_date", build::DATE);
+  writer->field("build_time", build::TIME);
+  writer->field("build_user", build::USER);
+  writer->field("start_time", master->startTime.secs());
+
+  if (master->electedTime.isSome()) {
+    writer->field("elected_time", master->electedTime.get().secs());
+  }
+
+  writer->field("id", master->info().id());
+  writer->field("pid", string(master->self()));
+  writer->field("hostname", master->info().hostname());
+  writer->field("activated_slaves", master->_slaves_active());
+  writer->field("deactivated_slaves", master->_slaves_inactive());
+
+  if (master->leader.isSome()) {
+    writer->field("leader", master->leader.get().pid());
+  }
+
+  if (approveViewFlags(flagsApprover)) {
+    if (master->flags.cluster.isSome()) {
+      writer->field("cluster", master->flags.cluster.get());
+    }
+
+    if (master->flags.log_dir.isSome()) {
+      writer->field("log_dir", master->flags.log_dir.get());
+    }
+
+    if (master->flags.external_log_file.isSome()) {
+      writer->field("external_log_file",
+                    master->flags.external_log_file.get());
+    }
+
+    writer->field("flags", [this](JSON::ObjectWriter* writer) {
+        foreachvalue (const flags::Flag& flag, master->flags) {
+          Option<string> value = flag.stringify(master->flags);
+          if (value.isSome()) {
+            writer->field(flag.effective_name().value, value.get());
           }
-        });
+        }
+      });
+  }
+}
 
-        // Model all currently unregistered frameworks. This can happen
-        // when a framework has yet to re-register after master failover.
-        // TODO(vinod): Need to filter these frameworks based on authorization!
-        // See the TODO above for "orphan_tasks" for further details.
-        writer->field("unregistered_frameworks", [this](
-            JSON::ArrayWriter* writer) {
-          // Find unregistered frameworks.
-          foreachvalue (const Slave* slave, master->slaves.registered) {
-            foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-              if (!master->frameworks.registered.contains(frameworkId)) {
-                writer->element(frameworkId.value());
-              }
+
+template <typename Writer>
+void Master::Http::stateOrphans(
+    Writer* writer,
+    const Owned<ObjectApprover>& tasksApprover) const
+{
+  // Model all of the orphan tasks.
+  writer->field("orphan_tasks", [this, &tasksApprover](
+      JSON::ArrayWriter* writer) {
+    // Find those orphan tasks.
+    foreachvalue (const Slave* slave, master->slaves.registered) {
+      typedef hashmap<TaskID, Task*> TaskMap;
+      foreachvalue (const TaskMap& tasks, slave->tasks) {
+        foreachvalue (const Task* task, tasks) {
+          CHECK_NOTNULL(task);
+          const FrameworkID& frameworkId = task->framework_id();
+          if (!master->frameworks.registered.contains(frameworkId)) {
+            // TODO(joerg84): This logic should be simplified after
+            // a deprecation cycle starting with 1.0 as after that
+            // we can rely on 'master->frameworks.recovered' containing
+            // all FrameworkInfos.
+            // Until then there are 3 cases:
+            // - No authorization enabled: show all orphaned tasks.
+            // - Authorization enabled, but no FrameworkInfo present:
+            //   do not show orphaned tasks.
+            // - Authorization enabled, FrameworkInfo present: filter
+            //   based on 'approveViewTask'.
+            if (master->authorizer.isSome() &&
+               (!master->frameworks.recovered.contains(frameworkId) ||
+                !approveViewTask(
+                    tasksApprover,
+                    *task,
+                    master->frameworks.recovered[frameworkId]))) {
+              continue;
             }
+
+            writer->element(*task);
           }
-        });
-      };
+        }
+      }
+    }
+  });
+
+  // Model all currently unregistered frameworks. This can happen
+  // when a framework has yet to re-register after master failover.
+  // TODO(vinod): Need to filter these frameworks based on authorization!
+  // See the TODO above for "orphan_tasks" for further details.
+  writer->field("unregistered_frameworks", [this](
+      JSON::ArrayWriter* writer) {
+    // Find unregistered frameworks.
+    foreachvalue (const Slave* slave, master->slaves.registered) {
+      foreachkey (const FrameworkID& frameworkId, slave->tasks) {
+        if (!master->frameworks.registered.contains(frameworkId)) {
+          writer->element(frameworkId.value());
+        }
+      }
+    }
+  });
+}
 
-      return OK(jsonify(state), request.url.query.get("jsonp"));
+
+void Master::Http::_state(const Owned<StateStream>& stream) const
+{
+  std::ostringstream out;
+  FieldWriter fields(&out, stream->fields);
+
+  // Writes `element` to the current array.
+  auto write = [&out, &stream](JSON::Proxy&& element) {
+    if (stream->elements++ > 0) {
+      out << ",";
+    }
+
+    out << std::move(element);
+  };
+
+  switch (stream->stage) {
+    case StateStream::SLAVES: {
+      if (stream->slaves.empty()) {
+        out << "]";
+        fields.key("frameworks");
+        out << "[";
+        stream->stage = StateStream::FRAMEWORKS;
+        stream->elements = 0;
+        break;
+      }
+
+      Slave* slave = master->slaves.registered.get(stream->slaves.front());
+      stream->slaves.pop_front();
+
+      if (slave != nullptr) {
+        write(jsonify(Full<Slave>(*slave)));
+      }
+
+      break;
+    }
+
+    case StateStream::FRAMEWORKS: {
+      if (stream->frameworks.empty()) {
+        out << "]";
+        fields.key("completed_frameworks");
+        out << "[";
+        stream->stage = StateStream::COMPLETED_FRAMEWORKS;
+        stream->elements = 0;
+        break;
+      }
+
+      Option<Framework*> framework =
+        master->frameworks.registered.get(stream->frameworks.front());
+
+      stream->frameworks.pop_front();
+
+      // Skip removed and unauthorized frameworks.
+      if (framework.isSome() &&
+          approveViewFrameworkInfo(
+              stream->frameworksApprover, framework.get()->info)) {
+        auto frameworkWriter = FullFrameworkWriter(
+            stream->tasksApprover,
+            stream->executorsApprover,
+            framework.get());
+
+        write(jsonify(frameworkWriter));
+      }
+
+      break;
+    }
+
+    case StateStream::COMPLETED_FRAMEWORKS: {
+      if (stream->completedFrameworks.empty()) {
+        out << "]";
+        stateOrphans(&fields, stream->tasksApprover);
+        out << "}";
+
+        if (stream->jsonp.isSome()) {
+          out << ");";
+        }
+
+        stream->writer.write(out.str());
+        stream->writer.close();
+        return;
+      }
+
+      std::shared_ptr<Framework> framework =
+        stream->completedFrameworks.front();
+
+      stream->completedFrameworks.pop_front();
+
+      // Skip unauthorized frameworks.
+      if (approveViewFrameworkInfo(
+              stream->frameworksApprover, framework->info)) {
+        auto frameworkWriter = FullFrameworkWriter(
+            stream->tasksApprover,
+            stream->executorsApprover,
+            framework.get());
+
+        write(jsonify(frameworkWriter));
+      }
+
+      break;
+    }
+  }
+
+  stream->fields = fields.count();
+
+  // Stop if the client has gone away.
+  if (!stream->writer.write(out.str())) {
+    return;
+  }
+
+  // Only write the next element once the client has read everything
+  // written so far, so that a slow client does not make us buffer
+  // the whole state in the pipe. This fails if the client goes away.
+  stream->writer.drained()
+    .onReady(defer(master->self(), [this, stream](const Nothing&) {
+      _state(stream);
     }));
 }
 
@@ -2810,170 +3083,6 @@ Future<Response> Master::Http::readFile(
 }
 
 
-// This abstraction has no side-effects. It factors out computing the
-// mapping from 'slaves' to 'frameworks' to answer the questions 'what
-// frameworks are running on a given slave?' and 'what slaves are
-// running the given framework?'.
-class SlaveFrameworkMapping
-{
-public:
-  SlaveFrameworkMapping(const hashmap<FrameworkID, Framework*>& frameworks)
-  {
-    foreachpair (const FrameworkID& frameworkId,
-                 const Framework* framework,
-                 frameworks) {
-      foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
-        frameworksToSlaves[frameworkId].insert(taskInfo.slave_id());
-        slavesToFrameworks[taskInfo.slave_id()].insert(frameworkId);
-      }
-
-      foreachvalue (const Task* task, framework->tasks) {
-        frameworksToSlaves[frameworkId].insert(task->slave_id());
-        slavesToFrameworks[task->slave_id()].insert(frameworkId);
-      }
-
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-        frameworksToSlaves[frameworkId].insert(task->slave_id());
-        slavesToFrameworks[task->slave_id()].insert(frameworkId);
-      }
-    }
-  }
-
-  const hashset<FrameworkID>& frameworks(const SlaveID& slaveId) const
-  {
-    const auto iterator = slavesToFrameworks.find(slaveId);
-    return iterator != slavesToFrameworks.end() ?
-      iterator->second : hashset<FrameworkID>::EMPTY;
-  }
-
-  const hashset<SlaveID>& slaves(const FrameworkID& frameworkId) const
-  {
-    const auto iterator = frameworksToSlaves.find(frameworkId);
-    return iterator != frameworksToSlaves.end() ?
-      iterator->second : hashset<SlaveID>::EMPTY;
-  }
-
-private:
-  hashmap<SlaveID, hashset<FrameworkID>> slavesToFrameworks;
-  hashmap<FrameworkID, hashset<SlaveID>> frameworksToSlaves;
-};
-
-
-// This abstraction has no side-effects. It factors out the accounting
-// for a 'TaskState' summary. We use this to summarize 'TaskState's
-// for both frameworks as well as slaves.
-struct TaskStateSummary
-{
-  // TODO(jmlvanre): Possibly clean this up as per MESOS-2694.
-  const static TaskStateSummary EMPTY;
-
-  TaskStateSummary()
-    : staging(0),
-      starting(0),
-      running(0),
-      killing(0),
-      finished(0),
-      killed(0),
-      failed(0),
-      lost(0),
-      error(0),
-      dropped(0),
-      unreachable(0),
-      gone(0),
-      gone_by_operator(0),
-      unknown(0) {}
-
-  // Account for the state of the given task.
-  void count(const Task& task)
-  {
-    switch (task.state()) {
-      case TASK_STAGING: { ++staging; break; }
-      case TASK_STARTING: { ++starting; break; }
-      case TASK_RUNNING: { ++running; break; }
-      case TASK_KILLING: { ++killing; break; }
-      case TASK_FINISHED: { ++finished; break; }
-      case TASK_KILLED: { ++killed; break; }
-      case TASK_FAILED: { ++failed; break; }
-      case TASK_LOST: { ++lost; break; }
-      case TASK_ERROR: { ++error; break; }
-      case TASK_DROPPED: { ++dropped; break; }
-      case TASK_UNREACHABLE: { ++unreachable; break; }
-      case TASK_GONE: { ++gone; break; }
-      case TASK_GONE_BY_OPERATOR: { ++gone_by_operator; break; }
-      case TASK_UNKNOWN: { ++unknown; break; }
-      // No default case allows for a helpful compiler error if we
-      // introduce a new state.
-    }
-  }
-
-  size_t staging;
-  size_t starting;
-  size_t running;
-  size_t killing;
-  size_t finished;
-  size_t killed;
-  size_t failed;
-  size_t lost;
-  size_t error;
-  size_t dropped;
-  size_t unreachable;
-  size_t gone;
-  size_t gone_by_operator;
-  size_t unknown;
-};
-
-
-const TaskStateSummary TaskStateSummary::EMPTY;
-
-
-// This abstraction has no side-effects. It factors out computing the
-// 'TaskState' summaries for frameworks and slaves. This answers the
-// questions 'How many tasks are in each state for a given framework?'
-// and 'How many tasks are in each state for a given slave?'.
-class TaskStateSummaries
-{
-public:
-  TaskStateSummaries(const hashmap<FrameworkID, Framework*>& frameworks)
-  {
-    foreachpair (const FrameworkID& frameworkId,
-                 const Framework* framework,
-                 frameworks) {
-      foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
-        frameworkTaskSummaries[frameworkId].staging++;
-        slaveTaskSummaries[taskInfo.slave_id()].staging++;
-      }
-
-      foreachvalue (const Task* task, framework->tasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
-      }
-
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
-      }
-    }
-  }
-
-  const TaskStateSummary& framework(const FrameworkID& frameworkId) const
-  {
-    const auto iterator = frameworkTaskSummaries.find(frameworkId);
-    return iterator != frameworkTaskSummaries.end() ?
-      iterator->second : TaskStateSummary::EMPTY;
-  }
-
-  const TaskStateSummary& slave(const SlaveID& slaveId) const
-  {
-    const auto iterator = slaveTaskSummaries.find(slaveId);
-    return iterator != slaveTaskSummaries.end() ?
-      iterator->second : TaskStateSummary::EMPTY;
-  }
-private:
-  hashmap<FrameworkID, TaskStateSummary> frameworkTaskSummaries;
-  hashmap<SlaveID, TaskStateSummary> slaveTaskSummaries;
-};
-
-
 string Master::Http::STATESUMMARY_HELP()
 {
   return HELP(
@@ -2989,7 +3098,12 @@ string Master::Http::STATESUMMARY_HELP()
         "This endpoint gives a summary of the state of all tasks and",
         "registered frameworks in the cluster as a JSON object.",
         "The information shown might be filtered based on the user",
-        "accessing the endpoint."),
+        "accessing the endpoint.",
+        "",
+        "Responses carry an `ETag` header that changes whenever the",
+        "summary might have changed. Returns 304 NOT_MODIFIED if the",
+        "request carries the current tag in an `If-None-Match` header,",
+        "or (without the quotes) in the `since` query parameter."),
     AUTHENTICATION(true),
     AUTHORIZATION(
         "This endpoint might be filtered based on the user accessing it.",
@@ -2999,6 +3113,64 @@ string Master::Http::STATESUMMARY_HELP()
 }
 
 
+// Returns the entity tag identifying the given version of the
+// '/state-summary' response. We include the master's ID so that
+// versions from different masters can not be confused after a
+// failover.
+static string stateSummaryTag(const MasterInfo& info, uint64_t version)
+{
+  return "\"" + info.id() + "-" + stringify(version) + "\"";
+}
+
+
+static Response stateSummaryResponse(
+    const string& body,
+    const string& tag,
+    const Option<string>& jsonp)
+{
+  OK ok(jsonp.isSome() ? jsonp.get() + "(" + body + ");" : body);
+
+  ok.headers["Content-Type"] =
+    jsonp.isSome() ? "text/javascript" : "application/json";
+
+  ok.headers["ETag"] = tag;
+
+  return ok;
+}
+
+
+void Master::StateSummary::put(const string& key, const Response& response)
+{
+  // Drop the responses of previous generations and the one that is
+  // replaced, then make room for the new response, if it fits at all.
+  foreach (const string& principal, responses.keys()) {
+    const Response& cached = responses.at(principal);
+
+    if (cached.generation != response.generation || principal == key) {
+      size -= cached.body.size();
+      responses.erase(principal);
+    }
+  }
+
+  const Bytes bytes = response.body.size();
+
+  if (bytes > MAX_STATE_SUMMARY_CACHE_SIZE) {
+    return;
+  }
+
+  while (size + bytes > MAX_STATE_SUMMARY_CACHE_SIZE) {
+    auto evicted = responses.begin();
+    CHECK(evicted != responses.end());
+
+    size -= evicted->second.body.size();
+    responses.erase(evicted);
+  }
+
+  size += bytes;
+  responses[key] = response;
+}
+
+
 Future<Response> Master::Http::stateSummary(
     const Request& request,
     const Option<string>& principal) const
@@ -3008,6 +3180,31 @@ Future<Response> Master::Http::stateSummary(
     return redirect(request);
   }
 
+  // Clients that have already seen the current version, either via
+  // the 'ETag' header or the 'since' query parameter, are answered
+  // without generating a response body.
+  const string tag =
+    stateSummaryTag(master->info(), master->stateSummary.generation);
+
+  if (request.headers.get("If-None-Match") == tag ||
+      request.url.query.get("since") == strings::trim(tag, "\"")) {
+    Response response(process::http::Status::NOT_MODIFIED);
+    response.headers["ETag"] = tag;
+    return response;
+  }
+
+  // Without an authorizer the response is the same for everyone.
+  const string key =
+    master->authorizer.isSome() ? principal.getOrElse("") : "";
+
+  auto cached = master->stateSummary.responses.find(key);
+
+  if (cached != master->stateSummary.responses.end() &&
+      cached->second.generation == master->stateSummary.generation) {
+    return stateSummaryResponse(
+        cached->second.body, tag, request.url.query.get("jsonp"));
+  }
+
   Future<Owned<ObjectApprover>> frameworksApprover;
 
   if (master->authorizer.isSome()) {
@@ -3024,8 +3221,8 @@ Future<Response> Master::Http::stateSummary(
 
   return frameworksApprover
     .then(defer(master->self(),
-        [this, request](const Owned<ObjectApprover>& frameworksApprover)
-          -> Response {
+        [this, request, key](
+            const Owned<ObjectApprover>& frameworksApprover) -> Response {
       auto stateSummary =
           [this, &frameworksApprover](JSON::ObjectWriter* writer) {
         writer->field("hostname", master->info().hostname());
@@ -3040,29 +3237,23 @@ Future<Response> Master::Http::stateSummary(
         // provide summary information for frameworks that are currently
         // registered 3) the frameworks keep a circular buffer of completed
         // tasks that we can use to keep a limited view on the history of
-        // recent completed / failed tasks.
-
-        // Generate mappings from 'slave' to 'framework' and reverse.
-        SlaveFrameworkMapping slaveFrameworkMapping(
-            master->frameworks.registered);
-
-        // Generate 'TaskState' summaries for all framework and slave ids.
-        TaskStateSummaries taskStateSummaries(master->frameworks.registered);
+        // recent completed / failed tasks. The summaries are maintained
+        // by the master as the tasks change, see `Master::StateSummary`.
+        const Master::StateSummary& summaries = master->stateSummary;
 
         // Model all of the slaves.
         writer->field("slaves",
-                      [this,
-                       &slaveFrameworkMapping,
-                       &taskStateSummaries](JSON::ArrayWriter* writer) {
+                      [this, &summaries](JSON::ArrayWriter* writer) {
           foreachvalue (Slave* slave, master->slaves.registered) {
-            writer->element([&slave,
-                             &slaveFrameworkMapping,
-                             &taskStateSummaries](JSON::ObjectWriter* writer) {
+            writer->element([&slave, &summaries](JSON::ObjectWriter* writer) {
               json(writer, Summary<Slave>(*slave));
 
               // Add the 'TaskState' summary for this slave.
+              const auto tasks = summaries.tasks.find(slave->id);
+
               const TaskStateSummary& summary =
-                taskStateSummaries.slave(slave->id);
+                tasks != summaries.tasks.end() ?
+                  tasks->second : TaskStateSummary::EMPTY;
 
               // TODO(neilc): Update for new PARTITION_AWARE task statuses.
               writer->field("TASK_STAGING", summary.staging);
@@ -3076,8 +3267,11 @@ Future<Response> Master::Http::stateSummary(
               writer->field("TASK_ERROR", summary.error);
 
               // Add the ids of all the frameworks running on this slave.
+              const auto found = summaries.frameworks.find(slave->id);
+
               const hashset<FrameworkID>& frameworks =
-                slaveFrameworkMapping.frameworks(slave->id);
+                found != summaries.frameworks.end() ?
+                  found->second : hashset<FrameworkID>::EMPTY;
 
               writer->field("framework_ids",
                             [&frameworks](JSON::ArrayWriter* writer) {
@@ -3091,13 +3285,8 @@ Future<Response> Master::Http::stateSummary(
 
         // Model all of the frameworks.
         writer->field("frameworks",
-                      [this,
-                       &slaveFrameworkMapping,
-                       &taskStateSummaries,
-                       &frameworksApprover](JSON::ArrayWriter* writer) {
-          foreachpair (const FrameworkID& frameworkId,
-                       Framework* framework,
-                       master->frameworks.registered) {
+                      [this, &frameworksApprover](JSON::ArrayWriter* writer) {
+          foreachvalue (Framework* framework, master->frameworks.registered) {
             // Skip unauthorized frameworks.
             if (!approveViewFrameworkInfo(
                 frameworksApprover,
@@ -3105,15 +3294,11 @@ Future<Response> Master::Http::stateSummary(
               continue;
             }
 
-            writer->element([&frameworkId,
-                             &framework,
-                             &slaveFrameworkMapping,
-                             &taskStateSummaries](JSON::ObjectWriter* writer) {
+            writer->element([&framework](JSON::ObjectWriter* writer) {
               json(writer, Summary<Framework>(*framework));
 
               // Add the 'TaskState' summary for this framework.
-              const TaskStateSummary& summary =
-                taskStateSummaries.framework(frameworkId);
+              const TaskStateSummary& summary = framework->taskStateSummary;
 
               // TODO(neilc): Update for new PARTITION_AWARE task statuses.
               writer->field("TASK_STAGING", summary.staging);
@@ -3127,11 +3312,10 @@ Future<Response> Master::Http::stateSummary(
               writer->field("TASK_ERROR", summary.error);
 
               // Add the ids of all the slaves running this framework.
-              const hashset<SlaveID>& slaves =
-                slaveFrameworkMapping.slaves(frameworkId);
-
-              writer->field("slave_ids", [&slaves](JSON::ArrayWriter* writer) {
-                foreach (const SlaveID& slaveId, slaves) {
+              writer->field("slave_ids",
+                            [&framework](JSON::ArrayWriter* writer) {
+                foreachkey (const SlaveID& slaveId,
+                            framework->taskStateSummaries) {
                   writer->element(slaveId.value());
                 }
               });
@@ -3140,7 +3324,18 @@ Future<Response> Master::Http::stateSummary(
         });
       };
 
-      return OK(jsonify(stateSummary), request.url.query.get("jsonp"));
+      // NOTE: The generation may have changed while the approver was
+      // being retrieved, so we use the one the response is built from.
+      Master::StateSummary::Response response;
+      response.generation = master->stateSummary.generation;
+      response.body = jsonify(stateSummary);
+
+      master->stateSummary.put(key, response);
+
+      return stateSummaryResponse(
+          response.body,
+          stateSummaryTag(master->info(), response.generation),
+          request.url.query.get("jsonp"));
     }));
 }
 
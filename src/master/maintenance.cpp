@@ -42,6 +42,15 @@ UpdateSchedule::UpdateSchedule(
   : schedule(_schedule) {}
 
 
+Option<Registry::Operation> UpdateSchedule::record() const
+{
+  Registry::Operation operation;
+  operation.set_type(Registry::Operation::UPDATE_SCHEDULE);
+  operation.mutable_schedule()->CopyFrom(schedule);
+  return operation;
+}
+
+
 Try<bool> UpdateSchedule::perform(
     Registry* registry,
     hashset<SlaveID>* slaveIDs,
@@ -121,6 +130,19 @@ StartMaintenance::StartMaintenance(
 }
 
 
+Option<Registry::Operation> StartMaintenance::record() const
+{
+  Registry::Operation operation;
+  operation.set_type(Registry::Operation::START_MAINTENANCE);
+
+  foreach (const MachineID& id, ids) {
+    operation.add_machine_ids()->CopyFrom(id);
+  }
+
+  return operation;
+}
+
+
 Try<bool> StartMaintenance::perform(
     Registry* registry,
     hashset<SlaveID>* slaveIDs,
@@ -151,6 +173,19 @@ StopMaintenance::StopMaintenance(
 }
 
 
+Option<Registry::Operation> StopMaintenance::record() const
+{
+  Registry::Operation operation;
+  operation.set_type(Registry::Operation::STOP_MAINTENANCE);
+
+  foreach (const MachineID& id, ids) {
+    operation.add_machine_ids()->CopyFrom(id);
+  }
+
+  return operation;
+}
+
+
 Try<bool> StopMaintenance::perform(
     Registry* registry,
     hashset<SlaveID>* slaveIDs,
@@ -53,6 +53,8 @@ public:
   explicit UpdateSchedule(
       const mesos::maintenance::Schedule& _schedule);
 
+  Option<Registry::Operation> record() const;
+
 protected:
   Try<bool> perform(
       Registry* registry,
@@ -77,6 +79,8 @@ public:
   explicit StartMaintenance(
       const google::protobuf::RepeatedPtrField<MachineID>& _ids);
 
+  Option<Registry::Operation> record() const;
+
 protected:
   Try<bool> perform(
       Registry* registry,
@@ -100,6 +104,8 @@ public:
   explicit StopMaintenance(
       const google::protobuf::RepeatedPtrField<MachineID>& _ids);
 
+  Option<Registry::Operation> record() const;
+
 protected:
   Try<bool> perform(
       Registry* registry,
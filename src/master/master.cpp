@@ -2285,6 +2285,7 @@ void Master::_subscribe(
     LOG(INFO) << "Updating info for framework " << framework->id();
 
     framework->updateFrameworkInfo(frameworkInfo);
+    stateSummary.invalidate();
     allocator->updateFramework(framework->id(), framework->info);
 
     framework->reregisteredTime = Clock::now();
@@ -2569,6 +2570,7 @@ void Master::_subscribe(
     LOG(INFO) << "Updating info for framework " << framework->id();
 
     framework->updateFrameworkInfo(frameworkInfo);
+    stateSummary.invalidate();
     allocator->updateFramework(framework->id(), framework->info);
 
     framework->reregisteredTime = Clock::now();
@@ -2620,6 +2622,7 @@ void Master::_subscribe(
       // the allocator has the correct view of the framework's share.
       if (!framework->active) {
         framework->active = true;
+        stateSummary.invalidate();
         allocator->activateFramework(framework->id());
       }
 
@@ -2755,6 +2758,7 @@ void Master::deactivate(Framework* framework)
 
   // Stop sending offers here for now.
   framework->active = false;
+  stateSummary.invalidate();
 
   // Tell the allocator to stop allocating resources to this framework.
   allocator->deactivateFramework(framework->id());
@@ -2808,6 +2812,7 @@ void Master::deactivate(Slave* slave)
   LOG(INFO) << "Deactivating agent " << *slave;
 
   slave->active = false;
+  stateSummary.invalidate();
 
   allocator->deactivateSlave(slave->id);
 
@@ -2960,34 +2965,64 @@ void Master::launchTasks(
 }
 
 
-Future<bool> Master::authorizeTask(
-    const TaskInfo& task,
+vector<Future<bool>> Master::authorizeTasks(
+    const vector<TaskInfo>& tasks,
     Framework* framework)
 {
   if (authorizer.isNone()) {
-    return true; // Authorization is disabled.
+    // Authorization is disabled.
+    return vector<Future<bool>>(tasks.size(), true);
   }
 
-  // Authorize the task.
-  authorization::Request request;
+  vector<authorization::Request> requests;
+  requests.reserve(tasks.size());
 
-  if (framework->info.has_principal()) {
-    request.mutable_subject()->set_value(framework->info.principal());
-  }
+  foreach (const TaskInfo& task, tasks) {
+    // Authorize the task.
+    authorization::Request request;
 
-  request.set_action(authorization::RUN_TASK);
+    if (framework->info.has_principal()) {
+      request.mutable_subject()->set_value(framework->info.principal());
+    }
 
-  authorization::Object* object = request.mutable_object();
+    request.set_action(authorization::RUN_TASK);
 
-  object->mutable_task_info()->CopyFrom(task);
-  object->mutable_framework_info()->CopyFrom(framework->info);
+    authorization::Object* object = request.mutable_object();
 
-  LOG(INFO)
-    << "Authorizing framework principal '"
-    << (framework->info.has_principal() ? framework->info.principal() : "ANY")
-    << "' to launch task " << task.task_id();
+    object->mutable_task_info()->CopyFrom(task);
+    object->mutable_framework_info()->CopyFrom(framework->info);
 
-  return authorizer.get()->authorized(request);
+    LOG(INFO)
+      << "Authorizing framework principal '"
+      << (framework->info.has_principal() ? framework->info.principal() : "ANY")
+      << "' to launch task " << task.task_id();
+
+    requests.push_back(request);
+  }
+
+  return authorizer.get()->authorized(requests);
+}
+
+
+// Returns whether all of the requests are authorized. The requests
+// are evaluated with a single (batch) authorizer call.
+static Future<bool> authorizeAll(
+    Authorizer* authorizer,
+    const vector<authorization::Request>& requests)
+{
+  const vector<Future<bool>> authorizations = authorizer->authorized(requests);
+
+  return await(list<Future<bool>>(authorizations.begin(), authorizations.end()))
+      .then([](const list<Future<bool>>& authorizations)
+            -> Future<bool> {
+        // Compute a disjunction.
+        foreach (const Future<bool>& authorization, authorizations) {
+          if (!authorization.get()) {
+            return false;
+          }
+        }
+        return true;
+      });
 }
 
 
@@ -3010,13 +3045,13 @@ Future<bool> Master::authorizeReserveResources(
   // reservations for all roles included in `reserve.resources`.
   // Add an element to `request.roles` for each unique role in the resources.
   hashset<string> roles;
-  list<Future<bool>> authorizations;
+  vector<authorization::Request> authorizations;
   foreach (const Resource& resource, reserve.resources()) {
     if (!roles.contains(resource.role())) {
       roles.insert(resource.role());
 
       request.mutable_object()->set_value(resource.role());
-      authorizations.push_back(authorizer.get()->authorized(request));
+      authorizations.push_back(request);
     }
   }
 
@@ -3033,17 +3068,7 @@ Future<bool> Master::authorizeReserveResources(
     return authorizer.get()->authorized(request);
   }
 
-  return await(authorizations)
-      .then([](const list<Future<bool>>& authorizations)
-            -> Future<bool> {
-        // Compute a disjunction.
-        foreach (const Future<bool>& authorization, authorizations) {
-          if (!authorization.get()) {
-            return false;
-          }
-        }
-        return true;
-      });
+  return authorizeAll(authorizer.get(), authorizations);
 }
 
 
@@ -3062,7 +3087,7 @@ Future<bool> Master::authorizeUnreserveResources(
     request.mutable_subject()->set_value(principal.get());
   }
 
-  list<Future<bool>> authorizations;
+  vector<authorization::Request> authorizations;
   foreach (const Resource& resource, unreserve.resources()) {
     // NOTE: Since validation of this operation is performed after
     // authorization, we must check here that this resource is
@@ -3073,7 +3098,7 @@ Future<bool> Master::authorizeUnreserveResources(
       request.mutable_object()->set_value(
           resource.reservation().principal());
 
-      authorizations.push_back(authorizer.get()->authorized(request));
+      authorizations.push_back(request);
     }
   }
 
@@ -3086,17 +3111,7 @@ Future<bool> Master::authorizeUnreserveResources(
     return authorizer.get()->authorized(request);
   }
 
-  return await(authorizations)
-      .then([](const list<Future<bool>>& authorizations)
-            -> Future<bool> {
-        // Compute a disjunction.
-        foreach (const Future<bool>& authorization, authorizations) {
-          if (!authorization.get()) {
-            return false;
-          }
-        }
-        return true;
-      });
+  return authorizeAll(authorizer.get(), authorizations);
 }
 
 
@@ -3119,13 +3134,13 @@ Future<bool> Master::authorizeCreateVolume(
   // volumes for all roles included in `create.volumes`.
   // Add an element to `request.roles` for each unique role in the volumes.
   hashset<string> roles;
-  list<Future<bool>> authorizations;
+  vector<authorization::Request> authorizations;
   foreach (const Resource& volume, create.volumes()) {
     if (!roles.contains(volume.role())) {
       roles.insert(volume.role());
 
       request.mutable_object()->set_value(volume.role());
-      authorizations.push_back(authorizer.get()->authorized(request));
+      authorizations.push_back(request);
     }
   }
 
@@ -3138,17 +3153,7 @@ Future<bool> Master::authorizeCreateVolume(
     return authorizer.get()->authorized(request);
   }
 
-  return await(authorizations)
-      .then([](const list<Future<bool>>& authorizations)
-            -> Future<bool> {
-        // Compute a disjunction.
-        foreach (const Future<bool>& authorization, authorizations) {
-          if (!authorization.get()) {
-            return false;
-          }
-        }
-        return true;
-      });
+  return authorizeAll(authorizer.get(), authorizations);
 }
 
 
@@ -3167,7 +3172,7 @@ Future<bool> Master::authorizeDestroyVolume(
     request.mutable_subject()->set_value(principal.get());
   }
 
-  list<Future<bool>> authorizations;
+  vector<authorization::Request> authorizations;
   foreach (const Resource& volume, destroy.volumes()) {
     // NOTE: Since validation of this operation may be performed after
     // authorization, we must check here that this resource is a persistent
@@ -3176,7 +3181,7 @@ Future<bool> Master::authorizeDestroyVolume(
       request.mutable_object()->set_value(
           volume.disk().persistence().principal());
 
-      authorizations.push_back(authorizer.get()->authorized(request));
+      authorizations.push_back(request);
     }
   }
 
@@ -3190,17 +3195,7 @@ Future<bool> Master::authorizeDestroyVolume(
     return authorizer.get()->authorized(request);
   }
 
-  return await(authorizations)
-      .then([](const list<Future<bool>>& authorizations)
-            -> Future<bool> {
-        // Compute a disjunction.
-        foreach (const Future<bool>& authorization, authorizations) {
-          if (!authorization.get()) {
-            return false;
-          }
-        }
-        return true;
-      });
+  return authorizeAll(authorizer.get(), authorizations);
 }
 
 
@@ -3240,6 +3235,7 @@ Resources Master::addTask(
 
   slave->addTask(t);
   framework->addTask(t);
+  stateSummary.invalidate();
 
   return resources;
 }
@@ -3363,6 +3359,12 @@ void Master::accept(
   LOG(INFO) << "Processing ACCEPT call for offers: " << accept.offer_ids()
             << " on agent " << *slave << " for framework " << *framework;
 
+  // The tasks are authorized with a single (batch) authorizer call
+  // once all operations have been processed, see below. The
+  // authorization of each task is a continuation of the batch.
+  vector<TaskInfo> tasksToAuthorize;
+  Promise<vector<Future<bool>>> taskAuthorizations;
+
   list<Future<bool>> futures;
   foreach (const Offer::Operation& operation, accept.operations()) {
     switch (operation.type()) {
@@ -3380,7 +3382,13 @@ void Master::accept(
         // Authorize the tasks. A task is in 'framework->pendingTasks'
         // and 'slave->pendingTasks' before it is authorized.
         foreach (const TaskInfo& task, tasks) {
-          futures.push_back(authorizeTask(task, framework));
+          const size_t index = tasksToAuthorize.size();
+          tasksToAuthorize.push_back(task);
+
+          futures.push_back(taskAuthorizations.future()
+            .then([index](const vector<Future<bool>>& authorizations) {
+              return authorizations.at(index);
+            }));
 
           // Add to the framework's list of pending tasks.
           //
@@ -3392,7 +3400,7 @@ void Master::accept(
           // (removed from the map). So it's possible that we send
           // a TASK_ERROR after a TASK_KILLED (see _accept())!
           if (!framework->pendingTasks.contains(task.task_id())) {
-            framework->pendingTasks[task.task_id()] = task;
+            framework->addPendingTask(task);
           }
 
           // Add to the slave's list of pending tasks.
@@ -3470,6 +3478,8 @@ void Master::accept(
     }
   }
 
+  taskAuthorizations.set(authorizeTasks(tasksToAuthorize, framework));
+
   // Wait for all the tasks to be authorized.
   await(futures)
     .onAny(defer(self(),
@@ -3858,7 +3868,9 @@ void Master::_accept(
           // the task is invalid or unauthorized here.
 
           bool pending = framework->pendingTasks.contains(task.task_id());
-          framework->pendingTasks.erase(task.task_id());
+          if (pending) {
+            framework->removePendingTask(task.task_id());
+          }
           slave->pendingTasks[framework->id()].erase(task.task_id());
           if (slave->pendingTasks[framework->id()].empty()) {
             slave->pendingTasks.erase(framework->id());
@@ -4093,7 +4105,9 @@ void Master::_accept(
         hashset<TaskID> killed;
         foreach (const TaskInfo& task, taskGroup.tasks()) {
           bool pending = framework->pendingTasks.contains(task.task_id());
-          framework->pendingTasks.erase(task.task_id());
+          if (pending) {
+            framework->removePendingTask(task.task_id());
+          }
 
           if (!pending) {
             killed.insert(task.task_id());
@@ -4421,7 +4435,7 @@ void Master::kill(Framework* framework, const scheduler::Call::Kill& kill)
 
   if (framework->pendingTasks.contains(taskId)) {
     // Remove from pending tasks.
-    framework->pendingTasks.erase(taskId);
+    framework->removePendingTask(taskId);
 
     if (slaveId.isSome()) {
       Slave* slave = slaves.registered.get(slaveId.get());
@@ -5039,6 +5053,7 @@ void Master::reregisterSlave(
 
   if (slave != nullptr) {
     slave->reregisteredTime = Clock::now();
+    stateSummary.invalidate();
 
     // NOTE: This handles the case where a slave tries to
     // re-register with an existing master (e.g. because of a
@@ -5361,6 +5376,7 @@ void Master::updateSlave(
 
   slave->totalResources =
     slave->totalResources.nonRevocable() + oversubscribedResources.revocable();
+  stateSummary.invalidate();
 
   // Now, update the allocator with the new estimate.
   allocator->updateSlave(slaveId, oversubscribedResources);
@@ -6029,6 +6045,7 @@ void Master::offer(const FrameworkID& frameworkId,
 
     framework->addOffer(offer);
     slave->addOffer(offer);
+    stateSummary.invalidate();
 
     if (flags.offer_timeout.isSome()) {
       // Rescind the offer after the timeout elapses.
@@ -6446,6 +6463,7 @@ void Master::addFramework(Framework* framework)
     << "Framework " << *framework << " already exists!";
 
   frameworks.registered[framework->id()] = framework;
+  stateSummary.add(*framework);
 
   // Remove from 'frameworks.recovered' if necessary.
   if (frameworks.recovered.contains(framework->id())) {
@@ -6536,6 +6554,7 @@ void Master::failoverFramework(Framework* framework, const HttpConnection& http)
   }
 
   framework->updateConnection(http);
+  stateSummary.invalidate();
 
   http.closed()
     .onAny(defer(self(), &Self::exited, framework->id(), http));
@@ -6570,6 +6589,7 @@ void Master::failoverFramework(Framework* framework, const UPID& newPid)
   }
 
   framework->updateConnection(newPid);
+  stateSummary.invalidate();
   link(newPid);
 
   _failoverFramework(framework);
@@ -6620,6 +6640,7 @@ void Master::_failoverFramework(Framework* framework)
   // the allocator has the correct view of the framework's share.
   if (!framework->active) {
     framework->active = true;
+    stateSummary.invalidate();
     allocator->activateFramework(framework->id());
   }
 
@@ -6650,6 +6671,8 @@ void Master::removeFramework(Framework* framework)
 
   LOG(INFO) << "Removing framework " << *framework;
 
+  stateSummary.invalidate();
+
   if (framework->active) {
     // Tell the allocator to stop allocating resources to this framework.
     // TODO(vinod): Consider setting  framework->active to false here
@@ -6668,7 +6691,9 @@ void Master::removeFramework(Framework* framework)
   }
 
   // Remove the pending tasks from the framework.
-  framework->pendingTasks.clear();
+  foreach (const TaskID& taskId, framework->pendingTasks.keys()) {
+    framework->removePendingTask(taskId);
+  }
 
   // Remove pointers to the framework's tasks in slaves.
   foreachvalue (Task* task, utils::copy(framework->tasks)) {
@@ -6786,6 +6811,7 @@ void Master::removeFramework(Framework* framework)
 
   // Remove the framework.
   frameworks.registered.erase(framework->id());
+  stateSummary.remove(*framework);
   allocator->removeFramework(framework->id());
 
   // Remove from 'frameworks.recovered' if necessary.
@@ -6806,6 +6832,8 @@ void Master::removeFramework(Slave* slave, Framework* framework)
   LOG(INFO) << "Removing framework " << *framework
             << " from agent " << *slave;
 
+  stateSummary.invalidate();
+
   // Remove pointers to framework's tasks in slaves, and send status
   // updates.
   // NOTE: A copy is needed because removeTask modifies slave->tasks.
@@ -6852,6 +6880,7 @@ void Master::addSlave(
 
   slaves.removed.erase(slave->id);
   slaves.registered.put(slave);
+  stateSummary.invalidate();
 
   link(slave->pid);
 
@@ -6955,6 +6984,8 @@ void Master::removeSlave(
 
   LOG(INFO) << "Removing agent " << *slave << ": " << message;
 
+  stateSummary.invalidate();
+
   // We want to remove the slave first, to avoid the allocator
   // re-allocating the recovered resources.
   //
@@ -7118,6 +7149,21 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
 {
   CHECK_NOTNULL(task);
 
+  stateSummary.invalidate();
+
+  // The task states of the frameworks are accounted for in the
+  // '/state-summary' endpoint, so the framework (if it knows about
+  // the task) needs to make the transition.
+  Framework* framework = getFramework(task->framework_id());
+
+  auto setState = [task, framework](const TaskState& state) {
+    if (framework != nullptr && framework->tasks.contains(task->task_id())) {
+      framework->updateTaskState(task, state);
+    } else {
+      task->set_state(state);
+    }
+  };
+
   // Get the unacknowledged status.
   const TaskStatus& status = update.status();
 
@@ -7148,7 +7194,7 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
             *task, latestState.get()));
       }
 
-      task->set_state(latestState.get());
+      setState(latestState.get());
     }
   } else {
     terminated = !protobuf::isTerminalState(task->state()) &&
@@ -7165,7 +7211,7 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
             *task, status.state()));
       }
 
-      task->set_state(status.state());
+      setState(status.state());
     }
   }
 
@@ -7203,7 +7249,6 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
 
     slave->taskTerminated(task);
 
-    Framework* framework = getFramework(task->framework_id());
     if (framework != nullptr) {
       framework->taskTerminated(task);
     }
@@ -7265,6 +7310,8 @@ void Master::removeTask(Task* task)
   Slave* slave = slaves.registered.get(task->slave_id());
   CHECK_NOTNULL(slave);
 
+  stateSummary.invalidate();
+
   if (!protobuf::isTerminalState(task->state())) {
     LOG(WARNING) << "Removing task " << task->task_id()
                  << " with resources " << task->resources()
@@ -7322,6 +7369,7 @@ void Master::removeExecutor(
   }
 
   slave->removeExecutor(frameworkId, executorId);
+  stateSummary.invalidate();
 }
 
 
@@ -7338,6 +7386,7 @@ void Master::_apply(Slave* slave, const Offer::Operation& operation) {
   CHECK_NOTNULL(slave);
 
   slave->apply(operation);
+  stateSummary.invalidate();
 
   LOG(INFO) << "Sending checkpointed resources "
             << slave->checkpointedResources
@@ -7372,6 +7421,7 @@ void Master::removeOffer(Offer* offer, bool rescind)
     << " in the offer " << offer->id();
 
   framework->removeOffer(offer);
+  stateSummary.invalidate();
 
   // Remove from slave.
   Slave* slave = slaves.registered.get(offer->slave_id());
@@ -7812,6 +7862,181 @@ void Slave::addTask(Task* task)
 }
 
 
+const TaskStateSummary TaskStateSummary::EMPTY;
+
+
+TaskStateSummary& TaskStateSummary::operator+=(const TaskStateSummary& that)
+{
+  staging += that.staging;
+  starting += that.starting;
+  running += that.running;
+  killing += that.killing;
+  finished += that.finished;
+  killed += that.killed;
+  failed += that.failed;
+  lost += that.lost;
+  error += that.error;
+  dropped += that.dropped;
+  unreachable += that.unreachable;
+  gone += that.gone;
+  gone_by_operator += that.gone_by_operator;
+  unknown += that.unknown;
+  total += that.total;
+
+  return *this;
+}
+
+
+TaskStateSummary& TaskStateSummary::operator-=(const TaskStateSummary& that)
+{
+  CHECK_GE(total, that.total);
+
+  staging -= that.staging;
+  starting -= that.starting;
+  running -= that.running;
+  killing -= that.killing;
+  finished -= that.finished;
+  killed -= that.killed;
+  failed -= that.failed;
+  lost -= that.lost;
+  error -= that.error;
+  dropped -= that.dropped;
+  unreachable -= that.unreachable;
+  gone -= that.gone;
+  gone_by_operator -= that.gone_by_operator;
+  unknown -= that.unknown;
+  total -= that.total;
+
+  return *this;
+}
+
+
+size_t& TaskStateSummary::count(const TaskState& state)
+{
+  switch (state) {
+    case TASK_STAGING: return staging;
+    case TASK_STARTING: return starting;
+    case TASK_RUNNING: return running;
+    case TASK_KILLING: return killing;
+    case TASK_FINISHED: return finished;
+    case TASK_KILLED: return killed;
+    case TASK_FAILED: return failed;
+    case TASK_LOST: return lost;
+    case TASK_ERROR: return error;
+    case TASK_DROPPED: return dropped;
+    case TASK_UNREACHABLE: return unreachable;
+    case TASK_GONE: return gone;
+    case TASK_GONE_BY_OPERATOR: return gone_by_operator;
+    case TASK_UNKNOWN: return unknown;
+    // No default case allows for a helpful compiler error if we
+    // introduce a new state.
+  }
+
+  UNREACHABLE();
+}
+
+
+void Framework::countTask(const SlaveID& slaveId, const TaskState& state)
+{
+  taskStateSummary.add(state);
+  taskStateSummaries[slaveId].add(state);
+
+  if (master->frameworks.registered.get(id()) == this) {
+    master->stateSummary.add(*this, slaveId, state);
+  }
+}
+
+
+void Framework::uncountTask(const SlaveID& slaveId, const TaskState& state)
+{
+  CHECK(taskStateSummaries.contains(slaveId))
+    << "No task of framework " << id() << " on agent " << slaveId;
+
+  taskStateSummary.remove(state);
+  taskStateSummaries[slaveId].remove(state);
+
+  if (taskStateSummaries[slaveId].empty()) {
+    taskStateSummaries.erase(slaveId);
+  }
+
+  if (master->frameworks.registered.get(id()) == this) {
+    master->stateSummary.remove(*this, slaveId, state);
+  }
+}
+
+
+void Master::StateSummary::add(const Framework& framework)
+{
+  foreachpair (const SlaveID& slaveId,
+               const TaskStateSummary& summary,
+               framework.taskStateSummaries) {
+    tasks[slaveId] += summary;
+    frameworks[slaveId].insert(framework.id());
+  }
+
+  invalidate();
+}
+
+
+void Master::StateSummary::remove(const Framework& framework)
+{
+  foreachpair (const SlaveID& slaveId,
+               const TaskStateSummary& summary,
+               framework.taskStateSummaries) {
+    CHECK(tasks.contains(slaveId));
+    CHECK(frameworks.contains(slaveId));
+
+    tasks[slaveId] -= summary;
+    if (tasks[slaveId].empty()) {
+      tasks.erase(slaveId);
+    }
+
+    frameworks[slaveId].erase(framework.id());
+    if (frameworks[slaveId].empty()) {
+      frameworks.erase(slaveId);
+    }
+  }
+
+  invalidate();
+}
+
+
+void Master::StateSummary::add(
+    const Framework& framework,
+    const SlaveID& slaveId,
+    const TaskState& state)
+{
+  tasks[slaveId].add(state);
+  frameworks[slaveId].insert(framework.id());
+
+  invalidate();
+}
+
+
+void Master::StateSummary::remove(
+    const Framework& framework,
+    const SlaveID& slaveId,
+    const TaskState& state)
+{
+  CHECK(tasks.contains(slaveId));
+
+  tasks[slaveId].remove(state);
+  if (tasks[slaveId].empty()) {
+    tasks.erase(slaveId);
+  }
+
+  // The framework may still have other tasks on the agent.
+  if (!framework.taskStateSummaries.contains(slaveId)) {
+    frameworks[slaveId].erase(framework.id());
+    if (frameworks[slaveId].empty()) {
+      frameworks.erase(slaveId);
+    }
+  }
+
+  invalidate();
+}
+
+
 void Master::Subscribers::send(const mesos::master::Event& event)
 {
   VLOG(1) << "Notifying all active subscribers about " << event.type() << " "
@@ -107,6 +107,77 @@ struct Framework;
 struct Role;
 
 
+// The number of tasks in each state, which the '/state-summary'
+// endpoint shows for each framework and agent. Pending tasks are
+// accounted for as staging.
+struct TaskStateSummary
+{
+  // TODO(jmlvanre): Possibly clean this up as per MESOS-2694.
+  const static TaskStateSummary EMPTY;
+
+  TaskStateSummary()
+    : staging(0),
+      starting(0),
+      running(0),
+      killing(0),
+      finished(0),
+      killed(0),
+      failed(0),
+      lost(0),
+      error(0),
+      dropped(0),
+      unreachable(0),
+      gone(0),
+      gone_by_operator(0),
+      unknown(0),
+      total(0) {}
+
+  // Accounts for a task in the given state.
+  void add(const TaskState& state)
+  {
+    ++count(state);
+    ++total;
+  }
+
+  // Stops accounting for a task in the given state.
+  void remove(const TaskState& state)
+  {
+    size_t& tasks = count(state);
+
+    CHECK_GT(tasks, 0u) << "No task in state " << TaskState_Name(state);
+
+    --tasks;
+    --total;
+  }
+
+  TaskStateSummary& operator+=(const TaskStateSummary& that);
+  TaskStateSummary& operator-=(const TaskStateSummary& that);
+
+  bool empty() const { return total == 0; }
+
+  size_t staging;
+  size_t starting;
+  size_t running;
+  size_t killing;
+  size_t finished;
+  size_t killed;
+  size_t failed;
+  size_t lost;
+  size_t error;
+  size_t dropped;
+  size_t unreachable;
+  size_t gone;
+  size_t gone_by_operator;
+  size_t unknown;
+
+  // The number of tasks in any state.
+  size_t total;
+
+private:
+  size_t& count(const TaskState& state);
+};
+
+
 struct Slave
 {
   Slave(Master* const _master,
@@ -715,10 +786,12 @@ protected:
   process::Future<bool> authorizeFramework(
       const FrameworkInfo& frameworkInfo);
 
-  // Returns whether the task is authorized.
-  // Returns failure for transient authorization failures.
-  process::Future<bool> authorizeTask(
-      const TaskInfo& task,
+  // Returns whether each of the tasks is authorized, in the same
+  // order as the tasks. All tasks are authorized with a single
+  // (batch) call to the authorizer.
+  // Returns failure for transient authorization failures of a task.
+  std::vector<process::Future<bool>> authorizeTasks(
+      const std::vector<TaskInfo>& tasks,
       Framework* framework);
 
   /**
@@ -1385,6 +1458,28 @@ private:
     process::Future<std::vector<std::string>> _roles(
         const Option<std::string>& principal) const;
 
+    // Write the fields of /master/state that precede and follow the
+    // agents and frameworks. These are templated on the writer since
+    // a streamed response writes them without the enclosing braces.
+    template <typename Writer>
+    void stateHeader(
+        Writer* writer,
+        const process::Owned<ObjectApprover>& flagsApprover) const;
+
+    template <typename Writer>
+    void stateOrphans(
+        Writer* writer,
+        const process::Owned<ObjectApprover>& tasksApprover) const;
+
+    // The progress of a streamed /master/state response, see `state()`.
+    struct StateStream;
+
+    // Writes the next agent or framework of a streamed /master/state
+    // response and, once the client has read it, writes the one after
+    // it. This lets the master process other events in between and
+    // bounds what is buffered for a slow client.
+    void _state(const process::Owned<StateStream>& stream) const;
+
     // Master API handlers.
 
     process::Future<process::http::Response> getAgents(
@@ -1782,6 +1877,64 @@ private:
     hashmap<UUID, process::Owned<Subscriber>> subscribed;
   } subscribers;
 
+  // The '/state-summary' endpoint is polled frequently, so we cache
+  // the serialized responses of the current generation and maintain
+  // the task state summaries incrementally.
+  struct StateSummary
+  {
+    StateSummary() : generation(0) {}
+
+    // Must be called whenever anything shown by the endpoint changes,
+    // i.e., the agents, frameworks, tasks or offers.
+    void invalidate() { generation++; }
+
+    // Accounts for the tasks of a framework once it is registered,
+    // and stops accounting for them once it is removed.
+    void add(const Framework& framework);
+    void remove(const Framework& framework);
+
+    // Accounts for a task of a registered framework on the given agent
+    // entering or leaving the given state. The framework must have
+    // updated its own summaries already, see `Framework::countTask()`.
+    void add(
+        const Framework& framework,
+        const SlaveID& slaveId,
+        const TaskState& state);
+
+    void remove(
+        const Framework& framework,
+        const SlaveID& slaveId,
+        const TaskState& state);
+
+    struct Response
+    {
+      uint64_t generation;
+      std::string body;
+    };
+
+    // The cached responses keyed by principal, since the response is
+    // filtered based on the user accessing it. Without an authorizer
+    // the response is the same for everyone and only the empty
+    // principal is used.
+    hashmap<std::string, Response> responses;
+
+    // The total size of the cached bodies, which is bounded by
+    // MAX_STATE_SUMMARY_CACHE_SIZE.
+    Bytes size;
+
+    // Caches the response for the given key, dropping the responses
+    // of previous generations and evicting others to stay in bounds.
+    void put(const std::string& key, const Response& response);
+
+    uint64_t generation;
+
+    // The summary of the states of the tasks of the registered
+    // frameworks on each agent, and the registered frameworks that
+    // have (pending, active or completed) tasks on each agent.
+    hashmap<SlaveID, TaskStateSummary> tasks;
+    hashmap<SlaveID, hashset<FrameworkID>> frameworks;
+  } stateSummary;
+
   hashmap<OfferID, Offer*> offers;
   hashmap<OfferID, process::Timer> offerTimers;
 
@@ -1904,6 +2057,14 @@ public:
     CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
   }
 
+  virtual Option<Registry::Operation> record() const
+  {
+    Registry::Operation operation;
+    operation.set_type(Registry::Operation::ADMIT_SLAVE);
+    operation.mutable_slave_info()->CopyFrom(info);
+    return operation;
+  }
+
 protected:
   virtual Try<bool> perform(
       Registry* registry,
@@ -1938,10 +2099,26 @@ private:
 class MarkSlaveUnreachable : public Operation
 {
 public:
-  explicit MarkSlaveUnreachable(const SlaveInfo& _info) : info(_info) {
+  explicit MarkSlaveUnreachable(const SlaveInfo& _info)
+    : info(_info), timestamp(protobuf::getCurrentTime()) {
     CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
   }
 
+  // Used when replaying the registrar's operation log.
+  MarkSlaveUnreachable(const SlaveInfo& _info, const TimeInfo& _timestamp)
+    : info(_info), timestamp(_timestamp) {
+    CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
+  }
+
+  virtual Option<Registry::Operation> record() const
+  {
+    Registry::Operation operation;
+    operation.set_type(Registry::Operation::MARK_SLAVE_UNREACHABLE);
+    operation.mutable_slave_info()->CopyFrom(info);
+    operation.mutable_timestamp()->CopyFrom(timestamp);
+    return operation;
+  }
+
 protected:
   virtual Try<bool> perform(
       Registry* registry,
@@ -1966,7 +2143,7 @@ protected:
           registry->mutable_unreachable()->add_slaves();
 
         unreachable->mutable_id()->CopyFrom(info.id());
-        unreachable->mutable_timestamp()->CopyFrom(protobuf::getCurrentTime());
+        unreachable->mutable_timestamp()->CopyFrom(timestamp);
 
         return true; // Mutation.
       }
@@ -1978,6 +2155,11 @@ protected:
 
 private:
   const SlaveInfo info;
+
+  // NOTE: The time is taken when the operation is created (rather
+  // than when it is performed) so that replaying the operation from
+  // the registrar's operation log yields the same registry.
+  const TimeInfo timestamp;
 };
 
 
@@ -1994,6 +2176,14 @@ public:
     CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
   }
 
+  virtual Option<Registry::Operation> record() const
+  {
+    Registry::Operation operation;
+    operation.set_type(Registry::Operation::MARK_SLAVE_REACHABLE);
+    operation.mutable_slave_info()->CopyFrom(info);
+    return operation;
+  }
+
 protected:
   virtual Try<bool> perform(
       Registry* registry,
@@ -2053,6 +2243,14 @@ public:
     CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
   }
 
+  virtual Option<Registry::Operation> record() const
+  {
+    Registry::Operation operation;
+    operation.set_type(Registry::Operation::READMIT_SLAVE);
+    operation.mutable_slave_info()->CopyFrom(info);
+    return operation;
+  }
+
 protected:
   virtual Try<bool> perform(
       Registry* registry,
@@ -2087,6 +2285,14 @@ public:
     CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
   }
 
+  virtual Option<Registry::Operation> record() const
+  {
+    Registry::Operation operation;
+    operation.set_type(Registry::Operation::REMOVE_SLAVE);
+    operation.mutable_slave_info()->CopyFrom(info);
+    return operation;
+  }
+
 protected:
   virtual Try<bool> perform(
       Registry* registry,
@@ -2221,6 +2427,39 @@ struct Framework
       totalUsedResources += task->resources();
       usedResources[task->slave_id()] += task->resources();
     }
+
+    countTask(task->slave_id(), task->state());
+  }
+
+  // Transitions an active task of this framework to the given state.
+  void updateTaskState(Task* task, const TaskState& state)
+  {
+    CHECK(tasks.contains(task->task_id()))
+      << "Unknown task " << task->task_id()
+      << " of framework " << task->framework_id();
+
+    uncountTask(task->slave_id(), task->state());
+    task->set_state(state);
+    countTask(task->slave_id(), task->state());
+  }
+
+  void addPendingTask(const TaskInfo& task)
+  {
+    CHECK(!pendingTasks.contains(task.task_id()))
+      << "Duplicate pending task " << task.task_id()
+      << " of framework " << id();
+
+    pendingTasks[task.task_id()] = task;
+    countTask(task.slave_id(), TASK_STAGING);
+  }
+
+  void removePendingTask(const TaskID& taskId)
+  {
+    CHECK(pendingTasks.contains(taskId))
+      << "Unknown pending task " << taskId << " of framework " << id();
+
+    uncountTask(pendingTasks.at(taskId).slave_id(), TASK_STAGING);
+    pendingTasks.erase(taskId);
   }
 
   // Notification of task termination, for resource accounting.
@@ -2263,8 +2502,19 @@ struct Framework
 
   void addCompletedTask(const Task& task)
   {
+    if (completedTasks.capacity() == 0) {
+      return;
+    }
+
+    // The oldest completed task is dropped once the buffer is full.
+    if (completedTasks.full()) {
+      const Task& dropped = *completedTasks.front();
+      uncountTask(dropped.slave_id(), dropped.state());
+    }
+
     // TODO(adam-mesos): Check if completed task already exists.
     completedTasks.push_back(std::shared_ptr<Task>(new Task(task)));
+    countTask(task.slave_id(), task.state());
   }
 
   void removeTask(Task* task)
@@ -2281,6 +2531,8 @@ struct Framework
       }
     }
 
+    uncountTask(task->slave_id(), task->state());
+
     addCompletedTask(*task);
 
     tasks.erase(task->task_id());
@@ -2531,6 +2783,13 @@ struct Framework
   // attempts to do some memset's which are unsafe).
   boost::circular_buffer<std::shared_ptr<Task>> completedTasks;
 
+  // The states of the pending, active and completed tasks above, in
+  // total and for each agent that any of them is on. These are kept
+  // up to date as the tasks change, so that the '/state-summary'
+  // endpoint does not need to walk all of the tasks.
+  TaskStateSummary taskStateSummary;
+  hashmap<SlaveID, TaskStateSummary> taskStateSummaries;
+
   hashset<Offer*> offers; // Active offers for framework.
 
   hashset<InverseOffer*> inverseOffers; // Active inverse offers for framework.
@@ -2574,6 +2833,12 @@ struct Framework
   Option<process::Owned<Heartbeater>> heartbeater;
 
 private:
+  // Accounts for a (pending, active or completed) task on the given
+  // agent entering or leaving the given state, in the summaries of
+  // this framework and, if it is registered, of the master.
+  void countTask(const SlaveID& slaveId, const TaskState& state);
+  void uncountTask(const SlaveID& slaveId, const TaskState& state);
+
   Framework(const Framework&);              // No copying.
   Framework& operator=(const Framework&); // No assigning.
 };
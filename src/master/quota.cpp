@@ -41,6 +41,15 @@ UpdateQuota::UpdateQuota(const QuotaInfo& quotaInfo)
   : info(quotaInfo) {}
 
 
+Option<Registry::Operation> UpdateQuota::record() const
+{
+  Registry::Operation operation;
+  operation.set_type(Registry::Operation::UPDATE_QUOTA);
+  operation.mutable_quota_info()->CopyFrom(info);
+  return operation;
+}
+
+
 Try<bool> UpdateQuota::perform(
     Registry* registry,
     hashset<SlaveID>*,
@@ -64,6 +73,15 @@ Try<bool> UpdateQuota::perform(
 RemoveQuota::RemoveQuota(const string& _role) : role(_role) {}
 
 
+Option<Registry::Operation> RemoveQuota::record() const
+{
+  Registry::Operation operation;
+  operation.set_type(Registry::Operation::REMOVE_QUOTA);
+  operation.set_role(role);
+  return operation;
+}
+
+
 Try<bool> RemoveQuota::perform(
     Registry* registry,
     hashset<SlaveID>*,
@@ -66,6 +66,8 @@ class UpdateQuota : public Operation
 public:
   explicit UpdateQuota(const mesos::quota::QuotaInfo& quotaInfo);
 
+  Option<Registry::Operation> record() const;
+
 protected:
   Try<bool> perform(
       Registry* registry,
@@ -88,6 +90,8 @@ class RemoveQuota : public Operation
 public:
   explicit RemoveQuota(const std::string& _role);
 
+  Option<Registry::Operation> record() const;
+
 protected:
   Try<bool> perform(
       Registry* registry,
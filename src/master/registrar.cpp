@@ -14,13 +14,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <deque>
+#include <list>
+#include <set>
 #include <string>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
 #include <mesos/state/protobuf.hpp>
 
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -37,12 +42,18 @@
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
 
+#include "master/maintenance.hpp"
+#include "master/master.hpp"
+#include "master/quota.hpp"
 #include "master/registrar.hpp"
 #include "master/registry.hpp"
+#include "master/weights.hpp"
 
 using mesos::state::protobuf::State;
 using mesos::state::protobuf::Variable;
@@ -69,7 +80,10 @@ using process::metrics::Gauge;
 using process::metrics::Timer;
 
 using std::deque;
+using std::list;
+using std::set;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -187,6 +201,10 @@ private:
 
   Future<double> _registry_size_bytes()
   {
+    if (current.isSome()) {
+      return current->ByteSize();
+    }
+
     if (variable.isSome()) {
       return variable.get().get().ByteSize();
     }
@@ -201,12 +219,31 @@ private:
   void __recover(const Future<bool>& recover);
   Future<bool> _apply(Owned<Operation> operation);
 
+  // Helpers for replaying the operation log on top of the recovered
+  // snapshot of the registry.
+  Future<Variable<Registry>> replay(const Variable<Registry>& snapshot);
+  Future<Variable<Registry>> _replay(
+      const Variable<Registry>& snapshot,
+      const set<string>& names);
+  Future<Variable<Registry>> __replay(
+      const Variable<Registry>& snapshot,
+      const list<Variable<Registry::Operations>>& entries);
+
   // Helper for updating state (performing store).
   void update();
   void _update(
       const Future<Option<Variable<Registry>>>& store,
       deque<Owned<Operation>> operations);
 
+  // Helpers for appending an entry to the operation log.
+  Future<bool> append(
+      const Registry::Operations& entry,
+      const Variable<Registry::Operations>& variable);
+  void _append();
+
+  // Expunges the operation log entries in [from, to).
+  void expunge(uint64_t from, uint64_t to);
+
   // Fails all pending operations and transitions the Registrar
   // into an error state in which all subsequent operations will fail.
   // This ensures we don't attempt to re-acquire log leadership by
@@ -215,7 +252,50 @@ private:
 
   Option<Variable<Registry>> variable;
   deque<Owned<Operation>> operations;
-  bool updating; // Used to signify fetching (recovering) or storing.
+
+  // The operation log, see Flags::registry_operation_log. Entry `i`
+  // is stored in the variable named `entryName(i)`. The entries below
+  // `snapshot` are reflected in the registry stored in `variable`,
+  // they are only kept around until they have been expunged.
+  struct Log
+  {
+    Log() : first(0), snapshot(0), next(0) {}
+
+    uint64_t first; // The lowest index of a stored entry.
+    uint64_t snapshot; // The first entry not reflected in `variable`.
+    uint64_t next; // The index of the next entry to append.
+  } log;
+
+  // An entry of the operation log that is being appended, see
+  // Flags::registry_max_outstanding_appends.
+  struct Append
+  {
+    uint64_t index;
+    deque<Owned<Operation>> operations;
+    Future<bool> future;
+    Stopwatch stopwatch;
+  };
+
+  // The outstanding appends, ordered by index.
+  deque<Append> appends;
+
+  // When appending to the operation log, the current registry (i.e.,
+  // the snapshot in `variable` with all the entries applied) and the
+  // 'slaveIDs' accumulator for it. Both are updated in place so that
+  // applying an operation does not need to copy the registry.
+  Option<Registry> current;
+  hashset<SlaveID> currentSlaveIDs;
+
+  // The registry with only the operations of the appends that have
+  // completed applied, which is what `/registry` serves: a failover
+  // loses the operations of the outstanding appends. Both it and its
+  // 'slaveIDs' accumulator are updated in place as well.
+  Option<Registry> durable;
+  hashset<SlaveID> durableSlaveIDs;
+
+  // Used to signify fetching (recovering) or storing the registry,
+  // the appends to the operation log are tracked in `appends`.
+  bool updating;
 
   const Flags flags;
   State* state;
@@ -257,13 +337,68 @@ void fail(deque<Owned<Operation>>* operations, const string& message)
 }
 
 
+// Prefix of the names of the variables holding the entries of the
+// registrar's operation log.
+static const char OPERATION_LOG_PREFIX[] = "registry.operations.";
+
+
+static string entryName(uint64_t index)
+{
+  return OPERATION_LOG_PREFIX + stringify(index);
+}
+
+
+// Reconstructs an operation that was recorded in the operation log,
+// see `Operation::record()`.
+static Try<Owned<Operation>> reconstruct(const Registry::Operation& operation)
+{
+  switch (operation.type()) {
+    case Registry::Operation::ADMIT_SLAVE:
+      return Owned<Operation>(new AdmitSlave(operation.slave_info()));
+    case Registry::Operation::READMIT_SLAVE:
+      return Owned<Operation>(new ReadmitSlave(operation.slave_info()));
+    case Registry::Operation::MARK_SLAVE_UNREACHABLE:
+      return Owned<Operation>(new MarkSlaveUnreachable(
+          operation.slave_info(), operation.timestamp()));
+    case Registry::Operation::MARK_SLAVE_REACHABLE:
+      return Owned<Operation>(new MarkSlaveReachable(operation.slave_info()));
+    case Registry::Operation::REMOVE_SLAVE:
+      return Owned<Operation>(new RemoveSlave(operation.slave_info()));
+    case Registry::Operation::UPDATE_QUOTA:
+      return Owned<Operation>(new quota::UpdateQuota(operation.quota_info()));
+    case Registry::Operation::REMOVE_QUOTA:
+      return Owned<Operation>(new quota::RemoveQuota(operation.role()));
+    case Registry::Operation::UPDATE_WEIGHTS:
+      return Owned<Operation>(new weights::UpdateWeights(vector<WeightInfo>(
+          operation.weight_infos().begin(), operation.weight_infos().end())));
+    case Registry::Operation::UPDATE_SCHEDULE:
+      return Owned<Operation>(
+          new maintenance::UpdateSchedule(operation.schedule()));
+    case Registry::Operation::START_MAINTENANCE:
+      return Owned<Operation>(
+          new maintenance::StartMaintenance(operation.machine_ids()));
+    case Registry::Operation::STOP_MAINTENANCE:
+      return Owned<Operation>(
+          new maintenance::StopMaintenance(operation.machine_ids()));
+    case Registry::Operation::UNKNOWN:
+      break;
+  }
+
+  return Error(
+      "Unknown operation type " +
+      Registry::Operation::Type_Name(operation.type()));
+}
+
+
 Future<Response> RegistrarProcess::registry(
     const Request& request,
     const Option<string>& /* principal */)
 {
   JSON::Object result;
 
-  if (variable.isSome()) {
+  if (durable.isSome()) {
+    result = JSON::protobuf(durable.get());
+  } else if (variable.isSome()) {
     result = JSON::protobuf(variable.get().get());
   }
 
@@ -333,6 +468,7 @@ Future<Registry> RegistrarProcess::recover(const MasterInfo& info)
 
     metrics.state_fetch.start();
     state->fetch<Registry>("registry")
+      .then(defer(self(), &Self::replay, lambda::_1))
       .after(flags.registry_fetch_timeout,
              lambda::bind(
                  &timeout<Variable<Registry>>,
@@ -369,6 +505,24 @@ void RegistrarProcess::_recover(
     // Save the registry.
     variable = recovery.get();
 
+    // In the operation log mode we keep the current registry around
+    // and apply the operations to it in place, see `update()`.
+    if (flags.registry_operation_log) {
+      current = variable.get().get();
+
+      currentSlaveIDs.clear();
+      foreach (const Registry::Slave& slave, current->slaves().slaves()) {
+        currentSlaveIDs.insert(slave.info().id());
+      }
+
+      durable = current;
+      durableSlaveIDs = currentSlaveIDs;
+    }
+
+    // NOTE: The 'Recover' operation can not be recorded in the
+    // operation log, hence `update()` stores a snapshot of the
+    // registry which folds in any entries replayed above.
+
     // Perform the Recover operation to add the new MasterInfo.
     Owned<Operation> operation(new Recover(info));
     operations.push_back(operation);
@@ -403,6 +557,135 @@ void RegistrarProcess::__recover(const Future<bool>& recover)
 }
 
 
+Future<Variable<Registry>> RegistrarProcess::replay(
+    const Variable<Registry>& snapshot)
+{
+  // NOTE: We replay the operation log even if the operation log mode
+  // is disabled, as it might have been enabled for a previous master.
+  return state->names()
+    .then(defer(self(), &Self::_replay, snapshot, lambda::_1));
+}
+
+
+Future<Variable<Registry>> RegistrarProcess::_replay(
+    const Variable<Registry>& snapshot,
+    const set<string>& names)
+{
+  const uint64_t index = snapshot.get().operation_log_index();
+
+  // Collect the entries that are not reflected in the snapshot,
+  // the remaining ones are expunged after the next snapshot.
+  uint64_t first = index;
+  vector<uint64_t> indices;
+
+  foreach (const string& name, names) {
+    if (!strings::startsWith(name, OPERATION_LOG_PREFIX)) {
+      continue;
+    }
+
+    Try<uint64_t> i = numify<uint64_t>(
+        strings::remove(name, OPERATION_LOG_PREFIX, strings::PREFIX));
+
+    if (i.isError()) {
+      LOG(WARNING) << "Ignoring unexpected variable '" << name << "'"
+                   << " in the registry: " << i.error();
+      continue;
+    }
+
+    first = std::min(first, i.get());
+
+    if (i.get() >= index) {
+      indices.push_back(i.get());
+    }
+  }
+
+  std::sort(indices.begin(), indices.end());
+
+  // The entries are appended without waiting for the previous ones
+  // (see `update()`), so the entries following one that failed to be
+  // appended might have been stored nonetheless. Their operations were
+  // never reported as applied (see `_append()`), hence we only replay
+  // the entries up to the first missing one. The new entries are
+  // appended past the remaining ones, which are then expunged after
+  // the next snapshot like the replayed ones.
+  size_t count = 0;
+  while (count < indices.size() && indices[count] == index + count) {
+    count++;
+  }
+
+  if (count < indices.size()) {
+    LOG(WARNING) << "Ignoring " << indices.size() - count << " entries"
+                 << " of the registry operation log following the missing"
+                 << " entry " << index + count;
+  }
+
+  log.first = first;
+  log.snapshot = index;
+  log.next = indices.empty() ? index : std::max(index, indices.back() + 1);
+
+  if (count == 0) {
+    return snapshot;
+  }
+
+  list<Future<Variable<Registry::Operations>>> entries;
+  for (size_t i = 0; i < count; i++) {
+    entries.push_back(
+        state->fetch<Registry::Operations>(entryName(indices[i])));
+  }
+
+  return collect(entries)
+    .then(defer(self(), &Self::__replay, snapshot, lambda::_1));
+}
+
+
+Future<Variable<Registry>> RegistrarProcess::__replay(
+    const Variable<Registry>& snapshot,
+    const list<Variable<Registry::Operations>>& entries)
+{
+  Registry registry = snapshot.get();
+
+  hashset<SlaveID> slaveIDs;
+  foreach (const Registry::Slave& slave, registry.slaves().slaves()) {
+    slaveIDs.insert(slave.info().id());
+  }
+
+  size_t replayed = 0;
+
+  foreach (const Variable<Registry::Operations>& entry, entries) {
+    foreach (const Registry::Operation& record, entry.get().operations()) {
+      Try<Owned<Operation>> operation = reconstruct(record);
+
+      if (operation.isError()) {
+        return Failure(
+            "Failed to replay the registry operation log: " +
+            operation.error());
+      }
+
+      // The operations are replayed with the strictness they were
+      // applied with, and each of them mutated the registry then, so
+      // anything else means the registry diverged from the log.
+      Try<bool> mutation =
+        (*operation.get())(&registry, &slaveIDs, entry.get().strict());
+
+      if (mutation.isError() || !mutation.get()) {
+        return Failure(
+            "Failed to replay the registry operation log: operation " +
+            Registry::Operation::Type_Name(record.type()) +
+            " did not apply as recorded" +
+            (mutation.isError() ? ": " + mutation.error() : ""));
+      }
+
+      replayed++;
+    }
+  }
+
+  LOG(INFO) << "Replayed " << replayed << " operations from "
+            << entries.size() << " entries of the registry operation log";
+
+  return snapshot.mutate(registry);
+}
+
+
 Future<bool> RegistrarProcess::apply(Owned<Operation> operation)
 {
   if (recovered.isNone()) {
@@ -445,26 +728,119 @@ void RegistrarProcess::update()
   Stopwatch stopwatch;
   stopwatch.start();
 
+  if (current.isSome()) {
+    // Both the next append and a snapshot wait for an outstanding
+    // append to complete once the limit is reached, see below.
+    if (appends.size() >= flags.registry_max_outstanding_appends) {
+      return;
+    }
+
+    // Record the operations as the next log entry, unless it is time
+    // to store a snapshot instead or one of them can not be recorded.
+    // NOTE: We decide before applying the operations to the current
+    // registry since a snapshot has to wait for the outstanding
+    // appends (it reflects their entries).
+    bool snapshot =
+      log.next - log.snapshot >= flags.registry_operations_between_snapshots;
+
+    foreach (Owned<Operation> operation, operations) {
+      if (operation->record().isNone()) {
+        snapshot = true;
+      }
+    }
+
+    if (!snapshot) {
+      // The entries are appended without waiting for the previous
+      // ones (up to the limit, after which the operations that arrive
+      // are batched into the next entry, see `_append()`).
+      Registry::Operations entry;
+      entry.set_strict(flags.registry_strict);
+
+      // Apply the operations to the current registry in place and
+      // record the ones that mutated it.
+      foreach (Owned<Operation> operation, operations) {
+        Try<bool> mutation = (*operation)(
+            &current.get(), &currentSlaveIDs, flags.registry_strict);
+
+        if (mutation.isSome() && mutation.get()) {
+          entry.add_operations()->CopyFrom(operation->record().get());
+        }
+      }
+
+      LOG(INFO) << "Applied " << operations.size() << " operations in "
+                << stopwatch.elapsed() << "; attempting to append entry "
+                << log.next << " to the registry operation log";
+
+      // Perform the append, and time the operation.
+      Append append;
+      append.index = log.next++;
+      append.operations = operations;
+      append.stopwatch.start();
+      append.future = metrics.state_store.time(
+          state->fetch<Registry::Operations>(entryName(append.index))
+            .then(defer(self(), &Self::append, entry, lambda::_1))
+            .after(flags.registry_store_timeout,
+                   lambda::bind(
+                       &timeout<bool>,
+                       "store",
+                       flags.registry_store_timeout,
+                       lambda::_1)));
+
+      appends.push_back(append);
+
+      append.future.onAny(defer(self(), &Self::_append));
+
+      // Clear the operations, _append will transition the Promises!
+      operations.clear();
+
+      return;
+    }
+
+    if (!appends.empty()) {
+      return; // The last append to complete calls `update()` again.
+    }
+
+    foreach (Owned<Operation> operation, operations) {
+      // No need to process the result of the operation.
+      (*operation)(&current.get(), &currentSlaveIDs, flags.registry_strict);
+    }
+  }
+
   updating = true;
 
-  // Create a snapshot of the current registry.
-  Registry registry = variable.get().get();
+  Registry registry;
 
-  // Create the 'slaveIDs' accumulator.
-  hashset<SlaveID> slaveIDs;
-  foreach (const Registry::Slave& slave, registry.slaves().slaves()) {
-    slaveIDs.insert(slave.info().id());
+  if (current.isSome()) {
+    registry = current.get();
+  } else {
+    // Create a snapshot of the current registry.
+    registry = variable.get().get();
+
+    // Create the 'slaveIDs' accumulator.
+    hashset<SlaveID> slaveIDs;
+    foreach (const Registry::Slave& slave, registry.slaves().slaves()) {
+      slaveIDs.insert(slave.info().id());
+    }
+
+    foreach (Owned<Operation> operation, operations) {
+      // No need to process the result of the operation.
+      (*operation)(&registry, &slaveIDs, flags.registry_strict);
+    }
   }
 
-  foreach (Owned<Operation> operation, operations) {
-    // No need to process the result of the operation.
-    (*operation)(&registry, &slaveIDs, flags.registry_strict);
+  // Fold all entries of the operation log into the snapshot.
+  if (log.next > 0) {
+    registry.set_operation_log_index(log.next);
   }
 
   LOG(INFO) << "Applied " << operations.size() << " operations in "
             << stopwatch.elapsed() << "; attempting to update the registry";
 
   // Perform the store, and time the operation.
+  // NOTE: Only one store of the registry is outstanding at a time,
+  // since each store has to be based on the version of the previous
+  // one; the operations that arrive in the meantime are batched into
+  // the next store.
   metrics.state_store.start();
   state->store(variable.get().mutate(registry))
     .after(flags.registry_store_timeout,
@@ -510,6 +886,22 @@ void RegistrarProcess::_update(
 
   variable = store.get().get();
 
+  // No appends are outstanding while storing a snapshot, so the
+  // current registry is durable now.
+  if (current.isSome()) {
+    durable = current;
+    durableSlaveIDs = currentSlaveIDs;
+  }
+
+  // The snapshot includes all entries of the operation log (see
+  // `update()`), which are no longer needed.
+  if (log.first < log.next) {
+    expunge(log.first, log.next);
+  }
+
+  log.first = log.next;
+  log.snapshot = log.next;
+
   // Remove the operations.
   while (!applied.empty()) {
     Owned<Operation> operation = applied.front();
@@ -524,6 +916,97 @@ void RegistrarProcess::_update(
 }
 
 
+Future<bool> RegistrarProcess::append(
+    const Registry::Operations& entry,
+    const Variable<Registry::Operations>& variable)
+{
+  return state->store(variable.mutate(entry))
+    .then([](const Option<Variable<Registry::Operations>>& variable) {
+      return variable.isSome();
+    });
+}
+
+
+void RegistrarProcess::_append()
+{
+  // Complete the appends in the order of their entries, up to the
+  // first one that is still outstanding, so that no operation is
+  // reported as applied before the ones preceding it.
+  while (!appends.empty() && !appends.front().future.isPending()) {
+    Append append = appends.front();
+    appends.pop_front();
+
+    // Once aborted, the operations of the following appends fail too.
+    if (error.isSome()) {
+      fail(&append.operations, error->message);
+      continue;
+    }
+
+    // Abort if the storage operation did not succeed.
+    if (!append.future.isReady() || !append.future.get()) {
+      string message = "Failed to update registry: ";
+
+      if (append.future.isFailed()) {
+        message += append.future.failure();
+      } else if (append.future.isDiscarded()) {
+        message += "discarded";
+      } else {
+        message += "version mismatch";
+      }
+
+      fail(&append.operations, message);
+      abort(message);
+
+      continue;
+    }
+
+    LOG(INFO) << "Successfully appended entry " << append.index
+              << " to the registry operation log in "
+              << append.stopwatch.elapsed();
+
+    // Remove the operations, after applying them to the durable
+    // registry in the same order as they were applied to the current
+    // one in `update()`.
+    while (!append.operations.empty()) {
+      Owned<Operation> operation = append.operations.front();
+      append.operations.pop_front();
+
+      // No need to process the result of the operation.
+      (*operation)(&durable.get(), &durableSlaveIDs, flags.registry_strict);
+
+      operation->set();
+    }
+  }
+
+  if (!operations.empty()) {
+    update();
+  }
+}
+
+
+void RegistrarProcess::expunge(uint64_t from, uint64_t to)
+{
+  VLOG(1) << "Expunging entries [" << from << ", " << to << ")"
+          << " of the registry operation log";
+
+  for (uint64_t index = from; index < to; index++) {
+    const string name = entryName(index);
+
+    // NOTE: Failing to expunge an entry is harmless, it is skipped
+    // (and expunged again) when the registrar recovers.
+    state->fetch<Registry::Operations>(name)
+      .then(defer(self(), [this](
+          const Variable<Registry::Operations>& variable) {
+        return state->expunge(variable);
+      }))
+      .onFailed([name](const string& failure) {
+        LOG(WARNING) << "Failed to expunge '" << name << "' from the"
+                     << " registry: " << failure;
+      });
+  }
+}
+
+
 void RegistrarProcess::abort(const string& message)
 {
   error = Error(message);
@@ -26,6 +26,8 @@
 #include <process/pid.hpp>
 
 #include <stout/hashset.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
 
 #include "master/flags.hpp"
 #include "master/registry.hpp"
@@ -73,6 +75,13 @@ public:
   // Sets the promise based on whether the operation was successful.
   bool set() { return process::Promise<bool>::set(success); }
 
+  // Returns the semantic representation of the operation that the
+  // registrar appends to its operation log (see
+  // Flags::registry_operation_log), or none if the operation can not
+  // be replayed, in which case the registrar stores a full snapshot
+  // of the registry instead.
+  virtual Option<Registry::Operation> record() const { return None(); }
+
 protected:
   virtual Try<bool> perform(
       Registry* registry,
@@ -25,6 +25,19 @@ UpdateWeights::UpdateWeights(const std::vector<WeightInfo>& _weightInfos)
   : weightInfos(_weightInfos) {}
 
 
+Option<Registry::Operation> UpdateWeights::record() const
+{
+  Registry::Operation operation;
+  operation.set_type(Registry::Operation::UPDATE_WEIGHTS);
+
+  foreach (const WeightInfo& weightInfo, weightInfos) {
+    operation.add_weight_infos()->CopyFrom(weightInfo);
+  }
+
+  return operation;
+}
+
+
 Try<bool> UpdateWeights::perform(Registry* registry, hashset<SlaveID>*, bool)
 {
   bool mutated = false;
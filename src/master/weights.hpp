@@ -55,6 +55,8 @@ class UpdateWeights : public Operation
 public:
   explicit UpdateWeights(const std::vector<WeightInfo>& _weightInfos);
 
+  Option<Registry::Operation> record() const;
+
 protected:
   Try<bool> perform(Registry* registry, hashset<SlaveID>*, bool);
 
@@ -64,6 +64,14 @@ constexpr Duration DISK_WATCH_INTERVAL = Minutes(1);
 // Minimum free disk capacity enforced by the garbage collector.
 constexpr double GC_DISK_HEADROOM = 0.1;
 
+// Maximum number of paths removed by the garbage collector in a
+// single batch on its removal thread.
+constexpr size_t GC_REMOVAL_BATCH_SIZE = 32;
+
+// Maximum number of directory entries whose names the posix disk
+// isolator keeps around between two walks of the sandboxes.
+constexpr size_t DISK_USAGE_CACHE_CAPACITY = 100000;
+
 // Maximum number of completed frameworks to store in memory.
 constexpr size_t MAX_COMPLETED_FRAMEWORKS = 50;
 
@@ -73,6 +81,10 @@ constexpr size_t MAX_COMPLETED_EXECUTORS_PER_FRAMEWORK = 150;
 // Maximum number of completed tasks per executor to store in memory.
 constexpr size_t MAX_COMPLETED_TASKS_PER_EXECUTOR = 200;
 
+// Maximum number of resource statistics samples per container to
+// store in memory (see '--statistics_sampling_interval').
+constexpr size_t MAX_STATISTICS_SAMPLES_PER_CONTAINER = 60;
+
 // Default cpus offered by the slave.
 constexpr double DEFAULT_CPUS = 1;
 
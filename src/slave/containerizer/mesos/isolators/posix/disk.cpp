@@ -14,42 +14,32 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <signal.h>
-
-#ifdef __linux__
-#include <sys/prctl.h>
-#endif
 #include <sys/types.h>
 
 #include <deque>
-#include <tuple>
 
 #include <glog/logging.h>
 
 #include <process/check.hpp>
-#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/id.hpp>
-#include <process/io.hpp>
-#include <process/subprocess.hpp>
 
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
-#include <stout/numify.hpp>
-#include <stout/strings.hpp>
 #include <stout/path.hpp>
 
 #include <stout/os/exists.hpp>
-#include <stout/os/killtree.hpp>
 #include <stout/os/stat.hpp>
 
+#include "common/disk_usage.hpp"
+#include "common/job_threads.hpp"
 #include "common/protobuf_utils.hpp"
 
-#include "slave/containerizer/mesos/isolators/posix/disk.hpp"
+#include "slave/constants.hpp"
 
-namespace io = process::io;
+#include "slave/containerizer/mesos/isolators/posix/disk.hpp"
 
 using std::deque;
 using std::list;
@@ -58,20 +48,15 @@ using std::vector;
 
 using process::Failure;
 using process::Future;
-using process::MONITOR;
-using process::NO_SETSID;
 using process::Owned;
 using process::PID;
 using process::Process;
 using process::Promise;
-using process::Subprocess;
 
-using process::await;
 using process::defer;
 using process::delay;
 using process::dispatch;
 using process::spawn;
-using process::subprocess;
 using process::terminate;
 
 using mesos::slave::ContainerConfig;
@@ -86,8 +71,6 @@ namespace slave {
 
 Try<Isolator*> PosixDiskIsolatorProcess::create(const Flags& flags)
 {
-  // TODO(jieyu): Check the availability of command 'du'.
-
   return new MesosIsolator(process::Owned<MesosIsolatorProcess>(
         new PosixDiskIsolatorProcess(flags)));
 }
@@ -288,8 +271,9 @@ Future<Bytes> PosixDiskIsolatorProcess::collect(
     }
   }
 
-  // We append "/" at the end to make sure that 'du' runs on actual
-  // directory pointed by the symlink (and not the symlink itself).
+  // We append "/" at the end to make sure that the usage is collected
+  // for the actual directory pointed by the symlink (and not the
+  // symlink itself).
   string _path = path;
   if (path != info->directory && os::stat::islink(path)) {
     _path = path::join(path, "");
@@ -430,17 +414,14 @@ class DiskUsageCollectorProcess : public Process<DiskUsageCollectorProcess>
 public:
   DiskUsageCollectorProcess(const Duration& _interval)
     : ProcessBase(process::ID::generate("posix-disk-usage-collector")),
-      interval(_interval) {}
+      interval(_interval),
+      cache(DISK_USAGE_CACHE_CAPACITY) {}
   virtual ~DiskUsageCollectorProcess() {}
 
   Future<Bytes> usage(
       const string& path,
       const vector<string>& excludes)
   {
-    // TODO(jieyu): 'excludes' is not supported on OSX. We should
-    // either return a Failure here, or does not allow 'excludes' to
-    // be specified on OSX.
-
     foreach (const Owned<Entry>& entry, entries) {
       if (entry->path == path) {
         return entry->promise.future();
@@ -465,10 +446,6 @@ protected:
   void finalize()
   {
     foreach (const Owned<Entry>& entry, entries) {
-      if (entry->du.isSome() && entry->du.get().status().isPending()) {
-        os::killtree(entry->du.get().pid(), SIGKILL);
-      }
-
       entry->promise.fail("DiskUsageCollector is destroyed");
     }
   }
@@ -479,19 +456,20 @@ private:
   {
     explicit Entry(const string& _path, const vector<string>& _excludes)
       : path(_path),
-        excludes(_excludes) {}
+        excludes(_excludes),
+        started(false) {}
 
     string path;
     vector<string> excludes;
-    Option<Subprocess> du;
+    bool started;
     Promise<Bytes> promise;
   };
 
   void discard(const string& path)
   {
     for (auto it = entries.begin(); it != entries.end(); ++it) {
-      // We only cancel those checks whose 'du' haven't been launched.
-      if ((*it)->path == path && (*it)->du.isNone()) {
+      // We only cancel those checks whose walk hasn't been started.
+      if ((*it)->path == path && !(*it)->started) {
         (*it)->promise.discard();
         entries.erase(it);
         break;
@@ -499,10 +477,10 @@ private:
     }
   }
 
-  // Schedule a 'du' to be invoked. The current implementation does
-  // not allow multiple 'du's running concurrently. The minimal
-  // interval between two subsequent 'du's is controlled by 'interval'
-  // for throttling purpose.
+  // Schedule a walk. The current implementation does not allow
+  // multiple walks running concurrently. The minimal interval between
+  // two subsequent walks is controlled by 'interval' for throttling
+  // purpose.
   void schedule()
   {
     if (entries.empty()) {
@@ -511,119 +489,35 @@ private:
     }
 
     const Owned<Entry>& entry = entries.front();
+    entry->started = true;
 
-    // Invoke 'du' and report number of 1K-byte blocks. We fix the
-    // block size here so that we can get consistent results on all
-    // platforms (e.g., OS X uses 512 byte blocks).
-    //
-    // NOTE: The 'du' processes are run in the slave's cgroup and it
-    // will be that cgroup that is charged for (a) memory to cache the
-    // fs data structures, (b) disk I/O to read those structures, and
-    // (c) the cpu time to traverse.
-
-    // Construct the 'du' command.
-    vector<string> command = {
-      "du",
-      "-k", // Use 1K size blocks for consistent results across platforms.
-      "-s", // Use 'silent' output mode.
-    };
-
-#ifdef __linux__
-    // Add paths that need to be excluded.
-    foreach (const string& exclude, entry->excludes) {
-      command.push_back("--exclude");
-      command.push_back(exclude);
-    }
-#endif
-
-    // Add path on which 'du' must be run.
-    command.push_back(entry->path);
-
-    // NOTE: The monitor watchdog will watch the parent process and kill
-    // the 'du' process in case that the parent die.
-    Try<Subprocess> s = subprocess(
-        "du",
-        command,
-        Subprocess::PATH("/dev/null"),
-        Subprocess::PIPE(),
-        Subprocess::PIPE(),
-        NO_SETSID,
-        nullptr,
-        None(),
-        None(),
-        Subprocess::Hook::None(),
-        None(),
-        MONITOR);
-
-    if (s.isError()) {
-      entry->promise.fail("Failed to exec 'du': " + s.error());
-
-      entries.pop_front();
-      delay(interval, self(), &Self::schedule);
-      return;
-    }
+    const string path = entry->path;
+    const vector<string> excludes = entry->excludes;
 
-    entry->du = s.get();
+    // NOTE: The cache is only used by the walks, which run one at a
+    // time, and 'walker' waits for the running walk when the process
+    // is destroyed.
+    DiskUsageCache* cache = &this->cache;
 
-    await(s.get().status(),
-          io::read(s.get().out().get()),
-          io::read(s.get().err().get()))
+    walker.run<Bytes>([path, excludes, cache]() {
+        return diskUsage(path, excludes, cache);
+      })
       .onAny(defer(self(), &Self::_schedule, lambda::_1));
   }
 
-  void _schedule(const Future<std::tuple<
-      Future<Option<int>>,
-      Future<string>,
-      Future<string>>>& future)
+  void _schedule(const Future<Bytes>& bytes)
   {
-    CHECK_READY(future);
     CHECK(!entries.empty());
 
     const Owned<Entry>& entry = entries.front();
-    CHECK_SOME(entry->du);
-
-    Future<Option<int>> status = std::get<0>(future.get());
+    CHECK(entry->started);
 
-    if (!status.isReady()) {
+    if (!bytes.isReady()) {
       entry->promise.fail(
-          "Failed to perform 'du': " +
-          (status.isFailed() ? status.failure() : "discarded"));
-    } else if (status.get().isNone()) {
-      entry->promise.fail("Failed to reap the status of 'du'");
-    } else if (status.get().get() != 0) {
-      Future<string> error = std::get<2>(future.get());
-      if (!error.isReady()) {
-        entry->promise.fail(
-            "Failed to perform 'du'. Reading stderr failed: " +
-            (error.isFailed() ? error.failure() : "discarded"));
-      } else {
-        entry->promise.fail("Failed to perform 'du': " + error.get());
-      }
+          bytes.isFailed() ? bytes.failure() : "discarded");
     } else {
-      Future<string> output = std::get<1>(future.get());
-      if (!output.isReady()) {
-        entry->promise.fail(
-            "Failed to read stdout from 'du': " +
-            (output.isFailed() ? output.failure() : "discarded"));
-      } else {
-        // Parsing the output from 'du'. The following is a sample
-        // output. Tab is used as the delimiter between the number of
-        // blocks and the checked path.
-        // $ du /var/lib/mesos/.../runs/container_id
-        // 1024   /var/lib/mesos/.../runs/container_id
-        vector<string> tokens = strings::tokenize(output.get(), " \t");
-        if (tokens.empty()) {
-          entry->promise.fail("Unexpected output from 'du': " + output.get());
-        } else {
-          Try<size_t> value = numify<size_t>(tokens[0]);
-          if (value.isError()) {
-            entry->promise.fail("Unexpected output from 'du': " + output.get());
-          } else {
-            // Notify the callers.
-            entry->promise.set(Kilobytes(value.get()));
-          }
-        }
-      }
+      // Notify the callers.
+      entry->promise.set(bytes.get());
     }
 
     entries.pop_front();
@@ -634,6 +528,16 @@ private:
 
   // A queue of pending checks.
   deque<Owned<Entry>> entries;
+
+  // The listings of the directories walked, across all paths.
+  DiskUsageCache cache;
+
+  // Walking a large sandbox can take a long time. Like the 'du'
+  // processes used before, the thread is charged to the agent's
+  // cgroup.
+  // NOTE: This is declared last so that it is destroyed (and the
+  // running walk is waited for) before the cache.
+  JobThreads walker;
 };
 
 
@@ -39,7 +39,12 @@ class DiskUsageCollectorProcess;
 
 
 // Responsible for collecting disk usage for paths, while ensuring
-// that an interval elapses between each collection.
+// that an interval elapses between each collection. The usage is
+// collected in-process by walking the tree rooted at each path.
+// The directory listings taken by a walk are reused by the next walks
+// for the directories that have not been modified since, up to a
+// bounded number of cached names (see `DiskUsageCache`), so only the
+// entries of those directories need to be stat'ed again.
 class DiskUsageCollector
 {
 public:
@@ -60,8 +65,8 @@ private:
 // This isolator monitors the disk usage for containers, and reports
 // ContainerLimitation when a container exceeds its disk quota. This
 // leverages the DiskUsageCollector to ensure that we don't induce too
-// much CPU usage and disk caching effects from running 'du' too
-// often.
+// much CPU usage and disk caching effects from walking the sandboxes
+// too often.
 //
 // NOTE: Currently all containers are processed in the same queue,
 // which means that when a container starts, it could take many disk
@@ -30,6 +30,8 @@
 
 #include <mesos/appc/spec.hpp>
 
+#include "slave/containerizer/mesos/provisioner/layer_cache.hpp"
+
 #include "slave/containerizer/mesos/provisioner/appc/cache.hpp"
 #include "slave/containerizer/mesos/provisioner/appc/fetcher.hpp"
 #include "slave/containerizer/mesos/provisioner/appc/paths.hpp"
@@ -56,7 +58,8 @@ public:
   StoreProcess(
       const string& rootDir,
       Owned<Cache> cache,
-      Owned<Fetcher> fetcher);
+      Owned<Fetcher> fetcher,
+      const Option<Bytes>& capacity);
 
   ~StoreProcess() {}
 
@@ -64,7 +67,13 @@ public:
 
   Future<ImageInfo> get(const Image& image);
 
+  void acquire(const vector<string>& layers);
+
+  void release(const vector<string>& layers);
+
 private:
+  Future<Nothing> _recover();
+
   Future<vector<string>> fetchImage(
       const Image::Appc& appc,
       bool cached);
@@ -79,12 +88,25 @@ private:
       const string& imageId,
       bool cached);
 
+  // Returns the id of the image whose rootfs is at the given path, or
+  // none if the path does not belong to the store.
+  Option<string> getImageId(const string& rootfsPath);
+
+  // Removes the images selected by the layer cache from the store.
+  void evict();
+
   // Absolute path to the root directory of the store as defined by
   // --appc_store_dir.
   const string rootDir;
 
   Owned<Cache> cache;
   Owned<Fetcher> fetcher;
+
+  // Every image in the store is a layer of the images depending on it.
+  LayerCache layerCache;
+
+  // Number of 'get()' calls in progress.
+  size_t pending;
 };
 
 
@@ -130,7 +152,8 @@ Try<Owned<slave::Store>> Store::create(const Flags& flags)
   return Owned<slave::Store>(new Store(Owned<StoreProcess>(new StoreProcess(
       rootDir.get(),
       cache.get(),
-      fetcher.get()))));
+      fetcher.get(),
+      flags.image_store_size_limit))));
 }
 
 
@@ -160,14 +183,29 @@ Future<ImageInfo> Store::get(const Image& image)
 }
 
 
+void Store::acquire(const vector<string>& layers)
+{
+  dispatch(process.get(), &StoreProcess::acquire, layers);
+}
+
+
+void Store::release(const vector<string>& layers)
+{
+  dispatch(process.get(), &StoreProcess::release, layers);
+}
+
+
 StoreProcess::StoreProcess(
     const string& _rootDir,
     Owned<Cache> _cache,
-    Owned<Fetcher> _fetcher)
+    Owned<Fetcher> _fetcher,
+    const Option<Bytes>& capacity)
   : ProcessBase(process::ID::generate("appc-provisioner-store")),
     rootDir(_rootDir),
     cache(_cache),
-    fetcher(_fetcher) {}
+    fetcher(_fetcher),
+    layerCache("containerizer/mesos/provisioner/appc/store/", capacity),
+    pending(0) {}
 
 
 Future<Nothing> StoreProcess::recover()
@@ -177,7 +215,42 @@ Future<Nothing> StoreProcess::recover()
     return Failure("Failed to recover cache: " + recover.error());
   }
 
-  return Nothing();
+  return _recover();
+}
+
+
+Future<Nothing> StoreProcess::_recover()
+{
+  const string imagesDir = paths::getImagesDir(rootDir);
+
+  Try<list<string>> imageIds = os::ls(imagesDir);
+  if (imageIds.isError()) {
+    return Failure(
+        "Failed to list images under '" + imagesDir + "': " +
+        imageIds.error());
+  }
+
+  list<Future<Bytes>> sizes;
+  foreach (const string& imageId, imageIds.get()) {
+    sizes.push_back(
+        layerCache.measure(paths::getImagePath(rootDir, imageId)));
+  }
+
+  // NOTE: The images are measured one at a time by the layer cache.
+  // The order in which images were last used is not persisted, so the
+  // recovered images are considered least recently used in the order
+  // they are listed.
+  return collect(sizes)
+    .then(defer(self(), [=](const list<Bytes>& _sizes) -> Future<Nothing> {
+      list<Bytes>::const_iterator size = _sizes.begin();
+      foreach (const string& imageId, imageIds.get()) {
+        layerCache.put(imageId, *size++);
+      }
+
+      evict();
+
+      return Nothing();
+    }));
 }
 
 
@@ -196,6 +269,8 @@ Future<ImageInfo> StoreProcess::get(const Image& image)
     return Failure("Failed to create staging directory: " + staging.error());
   }
 
+  pending++;
+
   return fetchImage(appc, image.cached())
     .then(defer(self(), [=](const vector<string>& imageIds)
           -> Future<ImageInfo> {
@@ -217,13 +292,46 @@ Future<ImageInfo> StoreProcess::get(const Image& image)
       // situation.
       foreach (const string& imageId, imageIds) {
         rootfses.emplace_back(paths::getImageRootfsPath(rootDir, imageId));
+
+        // The images are referenced on behalf of the caller, who
+        // releases them once the rootfs provisioned from them is
+        // destroyed.
+        layerCache.reference(imageId);
       }
 
       return ImageInfo{rootfses, None(), manifest.get()};
+    }))
+    .onAny(defer(self(), [=](const Future<ImageInfo>&) {
+      pending--;
+      evict();
     }));
 }
 
 
+void StoreProcess::acquire(const vector<string>& layers)
+{
+  foreach (const string& layer, layers) {
+    Option<string> imageId = getImageId(layer);
+    if (imageId.isSome()) {
+      layerCache.reference(imageId.get());
+    }
+  }
+}
+
+
+void StoreProcess::release(const vector<string>& layers)
+{
+  foreach (const string& layer, layers) {
+    Option<string> imageId = getImageId(layer);
+    if (imageId.isSome()) {
+      layerCache.unreference(imageId.get());
+    }
+  }
+
+  evict();
+}
+
+
 // Fetches the image into the 'staging' directory, and recursively
 // fetches the image's dependencies in a depth first order.
 Future<vector<string>> StoreProcess::fetchImage(
@@ -236,6 +344,9 @@ Future<vector<string>> StoreProcess::fetchImage(
       VLOG(1) << "Image '" << appc.name() << "' is found in cache with "
               << "image id '" << imageId.get() << "'";
 
+      ++layerCache.metrics.layer_hits;
+      layerCache.touch(imageId.get());
+
       return __fetchImage(imageId.get(), cached);
     }
   }
@@ -279,9 +390,14 @@ Future<string> StoreProcess::_fetchImage(const Image::Appc& appc)
       const string source = path::join(tmpFetchDir, imageId);
       const string target = paths::getImagePath(rootDir, imageId);
 
-      if (os::exists(target)) {
+      const bool exists = os::exists(target);
+
+      if (exists) {
         LOG(WARNING) << "Image id '" << imageId
                      << "' already exists in the store";
+
+        ++layerCache.metrics.layer_hits;
+        layerCache.touch(imageId);
       } else {
         Try<Nothing> rename = os::rename(source, target);
         if (rename.isError()) {
@@ -289,6 +405,8 @@ Future<string> StoreProcess::_fetchImage(const Image::Appc& appc)
               "Failed to rename directory '" + source +
               "' to '" + target + "': " + rename.error());
         }
+
+        ++layerCache.metrics.layer_misses;
       }
 
       Try<Nothing> addCache = cache->add(imageId);
@@ -306,7 +424,15 @@ Future<string> StoreProcess::_fetchImage(const Image::Appc& appc)
             rmdir.error());
       }
 
-      return imageId;
+      if (exists) {
+        return imageId;
+      }
+
+      return layerCache.measure(target)
+        .then(defer(self(), [=](const Bytes& size) {
+          layerCache.put(imageId, size);
+          return imageId;
+        }));
     }));
 }
 
@@ -380,6 +506,80 @@ Future<vector<string>> StoreProcess::fetchDependencies(
     }));
 }
 
+
+Option<string> StoreProcess::getImageId(const string& rootfsPath)
+{
+  const string imageId = Path(Path(rootfsPath).dirname()).basename();
+
+  if (rootfsPath != paths::getImageRootfsPath(rootDir, imageId)) {
+    return None();
+  }
+
+  return imageId;
+}
+
+
+void StoreProcess::evict()
+{
+  // Evicting an image while an image is being retrieved could remove
+  // a dependency that the retrieval has already found in the store,
+  // so eviction is postponed until no retrieval is in progress.
+  if (pending > 0) {
+    return;
+  }
+
+  const vector<string> imageIds = layerCache.evict();
+  if (imageIds.empty()) {
+    return;
+  }
+
+  // The evicted images are moved out of the store synchronously, so
+  // that a subsequent 'get()' fetches them again. Only the removal of
+  // the files, which can be slow for large images, is done
+  // asynchronously by the layer cache.
+  Try<Nothing> mkdir = os::mkdir(paths::getStagingDir(rootDir));
+  if (mkdir.isError()) {
+    LOG(WARNING) << "Failed to create staging directory for evicting "
+                 << imageIds.size() << " images: " << mkdir.error();
+    return;
+  }
+
+  Try<string> staging = os::mkdtemp(
+      path::join(paths::getStagingDir(rootDir), "XXXXXX"));
+
+  if (staging.isError()) {
+    // The images are left in the store untracked until the next
+    // recovery.
+    LOG(WARNING) << "Failed to create staging directory for evicting "
+                 << imageIds.size() << " images: " << staging.error();
+    return;
+  }
+
+  foreach (const string& imageId, imageIds) {
+    const string source = paths::getImagePath(rootDir, imageId);
+    const string target = path::join(staging.get(), imageId);
+
+    Try<Nothing> rename = os::rename(source, target);
+    if (rename.isError()) {
+      LOG(WARNING) << "Failed to evict image '" << imageId << "': "
+                   << rename.error();
+      continue;
+    }
+
+    VLOG(1) << "Evicted image '" << imageId << "' from the store";
+
+    ++layerCache.metrics.layer_evictions;
+  }
+
+  const string directory = staging.get();
+
+  layerCache.remove(directory)
+    .onFailed([directory](const string& failure) {
+      LOG(WARNING) << "Failed to remove evicted images at '" << directory
+                   << "': " << failure;
+    });
+}
+
 } // namespace appc {
 } // namespace slave {
 } // namespace internal {
@@ -44,6 +44,10 @@ public:
   // have dependencies and we should add it later.
   virtual process::Future<ImageInfo> get(const Image& image);
 
+  virtual void acquire(const std::vector<std::string>& layers);
+
+  virtual void release(const std::vector<std::string>& layers);
+
 private:
   Store(process::Owned<StoreProcess> process);
 
@@ -63,6 +63,8 @@ hashmap<string, Owned<Backend>> Backend::create(const Flags& flags)
   } else if (overlayfsSupported.get()) {
     creators.put("overlay", &OverlayBackend::create);
   }
+
+  creators.put("reflink", &CopyBackend::createReflink);
 #endif // __linux__
 
   creators.put("copy", &CopyBackend::create);
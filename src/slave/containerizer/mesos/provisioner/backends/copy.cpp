@@ -14,6 +14,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#ifdef __linux__
+#include <sys/ioctl.h>
+#endif // __linux__
+
 #include <list>
 
 #include <process/collect.hpp>
@@ -27,11 +31,22 @@
 
 #include <stout/foreach.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
 
 #include "common/status_utils.hpp"
 
+#include "slave/paths.hpp"
+
 #include "slave/containerizer/mesos/provisioner/backends/copy.hpp"
 
+#ifdef __linux__
+// The generic 'FICLONE' ioctl was introduced in Linux 4.5 (it was
+// previously btrfs specific), so older headers may not define it.
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+#endif // __linux__
 
 using namespace process;
 
@@ -46,8 +61,11 @@ namespace slave {
 class CopyBackendProcess : public Process<CopyBackendProcess>
 {
 public:
-  CopyBackendProcess()
-    : ProcessBase(process::ID::generate("copy-provisioner-backend")) {}
+  explicit CopyBackendProcess(bool _reflink)
+    : ProcessBase(process::ID::generate(
+          _reflink ? "reflink-provisioner-backend"
+                   : "copy-provisioner-backend")),
+      reflink(_reflink) {}
 
   Future<Nothing> provision(const vector<string>& layers, const string& rootfs);
 
@@ -55,13 +73,109 @@ public:
 
 private:
   Future<Nothing> _provision(string layer, const string& rootfs);
+
+  // Whether the file data is cloned with reflinks rather than copied.
+  const bool reflink;
 };
 
 
 Try<Owned<Backend>> CopyBackend::create(const Flags&)
 {
   return Owned<Backend>(new CopyBackend(
-      Owned<CopyBackendProcess>(new CopyBackendProcess())));
+      Owned<CopyBackendProcess>(new CopyBackendProcess(false))));
+}
+
+
+Try<Owned<Backend>> CopyBackend::createReflink(const Flags& flags)
+{
+#ifdef __linux__
+  // Reflinks cannot cross filesystems, so the layers in every image
+  // store need to be clonable into the provisioner directory (which
+  // is created before the backends are).
+  const string provisionerDir = paths::getProvisionerDir(flags.work_dir);
+
+  vector<string> storeDirs;
+  if (flags.image_providers.isSome()) {
+    foreach (const string& type,
+             strings::tokenize(flags.image_providers.get(), ",")) {
+      if (strings::upper(type) == "APPC") {
+        storeDirs.push_back(flags.appc_store_dir);
+      } else if (strings::upper(type) == "DOCKER") {
+        storeDirs.push_back(flags.docker_store_dir);
+      }
+    }
+  }
+
+  foreach (const string& storeDir, storeDirs) {
+    Try<Nothing> supported = checkReflink(storeDir, provisionerDir);
+    if (supported.isError()) {
+      return Error(
+          "Reflinks from '" + storeDir + "' to '" + provisionerDir +
+          "' are not supported: " + supported.error());
+    }
+  }
+
+  return Owned<Backend>(new CopyBackend(
+      Owned<CopyBackendProcess>(new CopyBackendProcess(true))));
+#else
+  return Error("Reflinks are only supported on Linux");
+#endif // __linux__
+}
+
+
+Try<Nothing> CopyBackend::checkReflink(
+    const string& sourceDir,
+    const string& targetDir)
+{
+#ifdef __linux__
+  Try<string> source = os::mktemp(path::join(sourceDir, ".reflink.XXXXXX"));
+  if (source.isError()) {
+    return Error(
+        "Failed to create a file under '" + sourceDir + "': " +
+        source.error());
+  }
+
+  Try<string> target = os::mktemp(path::join(targetDir, ".reflink.XXXXXX"));
+  if (target.isError()) {
+    os::rm(source.get());
+    return Error(
+        "Failed to create a file under '" + targetDir + "': " +
+        target.error());
+  }
+
+  // NOTE: The source has some data since some filesystems accept
+  // cloning an empty file even though they do not support reflinks.
+  Try<Nothing> result = os::write(source.get(), string(4096, '\0'));
+
+  if (result.isSome()) {
+    Try<int> in = os::open(source.get(), O_RDONLY | O_CLOEXEC);
+    Try<int> out = os::open(target.get(), O_WRONLY | O_CLOEXEC);
+
+    if (in.isError()) {
+      result = Error("Failed to open '" + source.get() + "': " + in.error());
+    } else if (out.isError()) {
+      result = Error("Failed to open '" + target.get() + "': " + out.error());
+    } else if (::ioctl(out.get(), FICLONE, in.get()) < 0) {
+      result = ErrnoError(
+          "Failed to clone '" + source.get() + "' to '" + target.get() + "'");
+    }
+
+    if (in.isSome()) {
+      os::close(in.get());
+    }
+
+    if (out.isSome()) {
+      os::close(out.get());
+    }
+  }
+
+  os::rm(source.get());
+  os::rm(target.get());
+
+  return result;
+#else
+  return Error("Reflinks are only supported on Linux");
+#endif // __linux__
 }
 
 
@@ -142,6 +256,12 @@ Future<Nothing> CopyBackendProcess::_provision(
   vector<string> args{"cp", "-a", layer, rootfs};
 #else
   vector<string> args{"cp", "-aT", layer, rootfs};
+
+  // With '--reflink=auto', GNU cp clones the data of each file with
+  // 'FICLONE' and falls back to copying it if the clone fails.
+  if (reflink) {
+    args.insert(args.begin() + 2, "--reflink=auto");
+  }
 #endif // __APPLE__ || __FreeBSD__
 
   Try<Subprocess> s = subprocess(
@@ -35,6 +35,15 @@ class CopyBackendProcess;
 //    allocation.
 // 2) The task can write unrestrictedly into the provisioned rootfs
 //    which is not accounted for (in terms of disk usage) either.
+//
+// On Linux the backend can instead clone the file data of the layers
+// with reflinks (i.e., 'FICLONE'), which is registered as the
+// 'reflink' backend. The clones share the data blocks of the layers
+// in the store until they are written to, so a rootfs is provisioned
+// with (nearly) zero data IO and no extra disk space, yet remains
+// fully writable. Reflinks can only be created within a single
+// filesystem that supports them (e.g., XFS with 'reflink=1', btrfs),
+// files that cannot be cloned are copied.
 class CopyBackend : public Backend
 {
 public:
@@ -43,6 +52,16 @@ public:
   // CopyBackend doesn't use any flag.
   static Try<process::Owned<Backend>> create(const Flags&);
 
+  // Creates a backend that clones the layers with reflinks. This
+  // fails unless the layers in every image store can be cloned into
+  // the provisioner directory.
+  static Try<process::Owned<Backend>> createReflink(const Flags& flags);
+
+  // Checks that a file in 'sourceDir' can be cloned into 'targetDir'.
+  static Try<Nothing> checkReflink(
+      const std::string& sourceDir,
+      const std::string& targetDir);
+
   // Provisions a rootfs given the layers' paths and target rootfs
   // path.
   virtual process::Future<Nothing> provision(
@@ -66,7 +66,7 @@ public:
       const spec::ImageReference& reference,
       bool cached);
 
-  // TODO(chenlily): Implement removal of unreferenced images.
+  Future<Nothing> prune(const hashset<string>& layerIds);
 
 private:
   // Write out metadata manager state to persistent store.
@@ -133,6 +133,12 @@ Future<Option<Image>> MetadataManager::get(
 }
 
 
+Future<Nothing> MetadataManager::prune(const hashset<string>& layerIds)
+{
+  return dispatch(process.get(), &MetadataManagerProcess::prune, layerIds);
+}
+
+
 Future<Image> MetadataManagerProcess::put(
     const spec::ImageReference& reference,
     const vector<string>& layerIds)
@@ -179,6 +185,40 @@ Future<Option<Image>> MetadataManagerProcess::get(
 }
 
 
+Future<Nothing> MetadataManagerProcess::prune(const hashset<string>& layerIds)
+{
+  vector<string> imageReferences;
+
+  foreachpair (const string& imageReference,
+               const Image& image,
+               storedImages) {
+    foreach (const string& layerId, image.layer_ids()) {
+      if (layerIds.contains(layerId)) {
+        imageReferences.push_back(imageReference);
+        break;
+      }
+    }
+  }
+
+  if (imageReferences.empty()) {
+    return Nothing();
+  }
+
+  foreach (const string& imageReference, imageReferences) {
+    storedImages.erase(imageReference);
+
+    VLOG(1) << "Removed image '" << imageReference << "'";
+  }
+
+  Try<Nothing> status = persist();
+  if (status.isError()) {
+    return Failure("Failed to save state of Docker images: " + status.error());
+  }
+
+  return Nothing();
+}
+
+
 Try<Nothing> MetadataManagerProcess::persist()
 {
   Images images;
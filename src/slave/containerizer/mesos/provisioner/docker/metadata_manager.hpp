@@ -21,6 +21,7 @@
 #include <string>
 
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
 #include <stout/option.hpp>
 #include <stout/protobuf.hpp>
@@ -51,8 +52,8 @@ class MetadataManagerProcess;
  * provisioner that are stored on disk. It keeps track of the layers
  * that Docker images are composed of and recovers Image objects
  * upon initialization by checking for dependent layers stored on disk.
- * Currently, image layers are stored indefinitely, with no garbage
- * collection of unreferenced image layers.
+ * Images are removed when any of their layers is evicted from the
+ * store.
  */
 class MetadataManager
 {
@@ -92,6 +93,15 @@ public:
       const ::docker::spec::ImageReference& reference,
       bool cached);
 
+  /**
+   * Remove all the Images that are composed of any of the given
+   * layers and persist the reference store state to disk.
+   *
+   * @param layerIds the ids of the layers that are being removed from
+   *                 the store.
+   */
+  process::Future<Nothing> prune(const hashset<std::string>& layerIds);
+
 private:
   explicit MetadataManager(process::Owned<MetadataManagerProcess> process);
 
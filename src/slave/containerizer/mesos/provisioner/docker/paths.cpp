@@ -38,9 +38,15 @@ string getStagingTempDir(const string& storeDir)
 }
 
 
+string getImageLayersDir(const string& storeDir)
+{
+  return path::join(storeDir, "layers");
+}
+
+
 string getImageLayerPath(const string& storeDir, const string& layerId)
 {
-  return path::join(storeDir, "layers", layerId);
+  return path::join(getImageLayersDir(storeDir), layerId);
 }
 
 
@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <deque>
+
 #include <glog/logging.h>
 
 #include <process/collect.hpp>
@@ -21,6 +23,11 @@
 #include <process/dispatch.hpp>
 #include <process/http.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/hashmap.hpp>
 #include <stout/os/exists.hpp>
 #include <stout/os/mkdir.hpp>
 #include <stout/os/rm.hpp>
@@ -36,6 +43,7 @@
 namespace http = process::http;
 namespace spec = docker::spec;
 
+using std::deque;
 using std::list;
 using std::string;
 using std::vector;
@@ -44,8 +52,12 @@ using process::Failure;
 using process::Future;
 using process::Owned;
 using process::Process;
+using process::Promise;
 using process::Shared;
 
+using process::metrics::Counter;
+using process::metrics::Timer;
+
 using process::defer;
 using process::dispatch;
 using process::spawn;
@@ -62,12 +74,16 @@ public:
   RegistryPullerProcess(
       const string& _storeDir,
       const http::URL& _defaultRegistryUrl,
-      const Shared<uri::Fetcher>& _fetcher);
+      const Shared<uri::Fetcher>& _fetcher,
+      const Option<size_t>& _fetchConcurrency);
 
   Future<vector<string>> pull(
       const spec::ImageReference& reference,
       const string& directory);
 
+protected:
+  virtual void finalize();
+
 private:
   Future<vector<string>> _pull(
       const spec::ImageReference& reference,
@@ -84,6 +100,43 @@ private:
     const string& directory,
     const spec::v2::ImageManifest& manifest);
 
+  // Pipelined counterpart of `fetchBlobs` and `__pull`: each blob is
+  // verified and its layers are extracted as soon as the blob has
+  // been fetched, while the other blobs are still being fetched.
+  Future<vector<string>> pipeline(
+    const spec::ImageReference& reference,
+    const string& directory,
+    const spec::v2::ImageManifest& manifest);
+
+  // Fetches, verifies and extracts a blob into the given layers.
+  Future<Nothing> pullBlob(
+    const spec::ImageReference& reference,
+    const string& directory,
+    const string& blobSum,
+    const vector<string>& layerIds);
+
+  // Fetches the blob once fewer than `fetchConcurrency` blobs are
+  // being fetched.
+  Future<Nothing> fetchBlob(const URI& blobUri, const string& directory);
+  void _fetchBlob();
+
+  Future<Nothing> verifyBlob(const string& blobSum, const string& directory);
+
+  Future<Nothing> extractBlob(
+    const string& blobSum,
+    const string& directory,
+    const vector<string>& layerIds);
+
+  Try<URI> getBlobUri(
+    const spec::ImageReference& reference,
+    const string& blobSum);
+
+  // Creates the directory and writes the manifest of a layer before
+  // its blob can be extracted into it.
+  Try<Nothing> prepareLayer(
+    const string& directory,
+    const spec::v1::ImageManifest& v1);
+
   RegistryPullerProcess(const RegistryPullerProcess&) = delete;
   RegistryPullerProcess& operator=(const RegistryPullerProcess&) = delete;
 
@@ -94,6 +147,38 @@ private:
   const http::URL defaultRegistryUrl;
 
   Shared<uri::Fetcher> fetcher;
+
+  // Enables the pipelined mode if set, see
+  // `--docker_registry_fetch_concurrency`.
+  const Option<size_t> fetchConcurrency;
+
+  // Blob fetches waiting for one of the `fetchConcurrency` slots.
+  struct PendingFetch
+  {
+    URI blobUri;
+    string directory;
+    Owned<Promise<Nothing>> promise;
+  };
+
+  deque<PendingFetch> pendingFetches;
+  size_t activeFetches;
+
+  struct Metrics
+  {
+    Metrics();
+    ~Metrics();
+
+    // Time spent fetching, verifying and extracting each layer's blob
+    // in the pipelined mode. Fetch times include the time spent
+    // waiting for a fetch slot.
+    Timer<Milliseconds> layer_fetch;
+    Timer<Milliseconds> layer_verify;
+    Timer<Milliseconds> layer_extract;
+
+    // Number of layers which did not need to be pulled since they
+    // were already in the store.
+    Counter layers_skipped;
+  } metrics;
 };
 
 
@@ -115,7 +200,8 @@ Try<Owned<Puller>> RegistryPuller::create(
       new RegistryPullerProcess(
           flags.docker_store_dir,
           defaultRegistryUrl.get(),
-          fetcher));
+          fetcher,
+          flags.docker_registry_fetch_concurrency));
 
   return Owned<Puller>(new RegistryPuller(process));
 }
@@ -150,11 +236,50 @@ Future<vector<string>> RegistryPuller::pull(
 RegistryPullerProcess::RegistryPullerProcess(
     const string& _storeDir,
     const http::URL& _defaultRegistryUrl,
-    const Shared<uri::Fetcher>& _fetcher)
+    const Shared<uri::Fetcher>& _fetcher,
+    const Option<size_t>& _fetchConcurrency)
   : ProcessBase(process::ID::generate("docker-provisioner-registry-puller")),
     storeDir(_storeDir),
     defaultRegistryUrl(_defaultRegistryUrl),
-    fetcher(_fetcher) {}
+    fetcher(_fetcher),
+    fetchConcurrency(_fetchConcurrency),
+    activeFetches(0) {}
+
+
+RegistryPullerProcess::Metrics::Metrics()
+  : layer_fetch(
+        "containerizer/mesos/provisioner/docker/layer_fetch", Hours(1)),
+    layer_verify(
+        "containerizer/mesos/provisioner/docker/layer_verify", Hours(1)),
+    layer_extract(
+        "containerizer/mesos/provisioner/docker/layer_extract", Hours(1)),
+    layers_skipped(
+        "containerizer/mesos/provisioner/docker/layers_skipped")
+{
+  process::metrics::add(layer_fetch);
+  process::metrics::add(layer_verify);
+  process::metrics::add(layer_extract);
+  process::metrics::add(layers_skipped);
+}
+
+
+RegistryPullerProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(layer_fetch);
+  process::metrics::remove(layer_verify);
+  process::metrics::remove(layer_extract);
+  process::metrics::remove(layers_skipped);
+}
+
+
+void RegistryPullerProcess::finalize()
+{
+  foreach (const PendingFetch& fetch, pendingFetches) {
+    fetch.promise->fail("Registry puller is terminating");
+  }
+
+  pendingFetches.clear();
+}
 
 
 static spec::ImageReference normalize(
@@ -265,6 +390,10 @@ Future<vector<string>> RegistryPullerProcess::_pull(
     return Failure("'fsLayers' and 'history' have different size in manifest");
   }
 
+  if (fetchConcurrency.isSome()) {
+    return pipeline(reference, directory, manifest.get());
+  }
+
   return fetchBlobs(reference, directory, manifest.get())
     .then(defer(self(),
                 &Self::__pull,
@@ -301,24 +430,13 @@ Future<vector<string>> RegistryPullerProcess::__pull(
     const string layerPath = path::join(directory, v1.id());
     const string tar = path::join(directory, blobSum);
     const string rootfs = paths::getImageLayerRootfsPath(layerPath);
-    const string json = paths::getImageLayerManifestPath(layerPath);
 
     VLOG(1) << "Extracting layer tar ball '" << tar
             << " to rootfs '" << rootfs << "'";
 
-    // NOTE: This will create 'layerPath' as well.
-    Try<Nothing> mkdir = os::mkdir(rootfs, true);
-    if (mkdir.isError()) {
-      return Failure(
-          "Failed to create rootfs directory '" + rootfs + "' "
-          "for layer '" + v1.id() + "': " + mkdir.error());
-    }
-
-    Try<Nothing> write = os::write(json, stringify(JSON::protobuf(v1)));
-    if (write.isError()) {
-      return Failure(
-          "Failed to save the layer manifest for layer '" +
-          v1.id() + "': " + write.error());
+    Try<Nothing> prepare = prepareLayer(directory, v1);
+    if (prepare.isError()) {
+      return Failure(prepare.error());
     }
 
     futures.push_back(command::untar(Path(tar), Path(rootfs)));
@@ -376,50 +494,266 @@ Future<hashset<string>> RegistryPullerProcess::fetchBlobs(
   list<Future<Nothing>> futures;
 
   foreach (const string& blobSum, blobSums) {
-    URI blobUri;
+    Try<URI> blobUri = getBlobUri(reference, blobSum);
+    if (blobUri.isError()) {
+      return Failure(blobUri.error());
+    }
+
+    futures.push_back(fetcher->fetch(blobUri.get(), directory));
+  }
+
+  return collect(futures)
+    .then([blobSums]() -> hashset<string> { return blobSums; });
+}
+
+
+Future<vector<string>> RegistryPullerProcess::pipeline(
+    const spec::ImageReference& reference,
+    const string& directory,
+    const spec::v2::ImageManifest& manifest)
+{
+  vector<string> layerIds;
+
+  // The layers (not yet in the store) to extract each blob into.
+  //
+  // NOTE: There might exist duplicated blob sums in 'fsLayers'. We
+  // just need to fetch one of them.
+  hashmap<string, vector<string>> blobs;
+
+  // The blob sums in the order of the layers, from the base layer.
+  vector<string> blobSums;
+
+  for (int i = manifest.fslayers_size() - 1; i >= 0; i--) {
+    CHECK(manifest.history(i).has_v1());
+    const spec::v1::ImageManifest& v1 = manifest.history(i).v1();
+    const string& blobSum = manifest.fslayers(i).blobsum();
+
+    // NOTE: We put parent layer ids in front because that's what the
+    // provisioner backends assume.
+    layerIds.push_back(v1.id());
+
+    // Skip if the layer is already in the store.
+    if (os::exists(paths::getImageLayerPath(storeDir, v1.id()))) {
+      ++metrics.layers_skipped;
+      continue;
+    }
+
+    Try<Nothing> prepare = prepareLayer(directory, v1);
+    if (prepare.isError()) {
+      return Failure(prepare.error());
+    }
+
+    if (!blobs.contains(blobSum)) {
+      blobSums.push_back(blobSum);
+    }
+
+    blobs[blobSum].push_back(v1.id());
+  }
+
+  // Start with the base layers, which are usually the largest.
+  list<Future<Nothing>> futures;
+  foreach (const string& blobSum, blobSums) {
+    VLOG(1) << "Pulling blob '" << blobSum << "' for layers '"
+            << stringify(blobs[blobSum]) << "' of image '" << reference << "'";
+
+    futures.push_back(
+        pullBlob(reference, directory, blobSum, blobs[blobSum]));
+  }
+
+  return collect(futures)
+    .then([layerIds]() { return layerIds; });
+}
+
+
+Future<Nothing> RegistryPullerProcess::pullBlob(
+    const spec::ImageReference& reference,
+    const string& directory,
+    const string& blobSum,
+    const vector<string>& layerIds)
+{
+  Try<URI> blobUri = getBlobUri(reference, blobSum);
+  if (blobUri.isError()) {
+    return Failure(blobUri.error());
+  }
+
+  return metrics.layer_fetch.time(fetchBlob(blobUri.get(), directory))
+    .then(defer(self(), [=]() {
+      return metrics.layer_verify.time(verifyBlob(blobSum, directory));
+    }))
+    .then(defer(self(), [=]() {
+      return metrics.layer_extract.time(
+          extractBlob(blobSum, directory, layerIds));
+    }));
+}
+
+
+Future<Nothing> RegistryPullerProcess::fetchBlob(
+    const URI& blobUri,
+    const string& directory)
+{
+  PendingFetch fetch;
+  fetch.blobUri = blobUri;
+  fetch.directory = directory;
+  fetch.promise.reset(new Promise<Nothing>());
+
+  pendingFetches.push_back(fetch);
+
+  Future<Nothing> future = fetch.promise->future();
+
+  _fetchBlob();
+
+  return future;
+}
+
+
+void RegistryPullerProcess::_fetchBlob()
+{
+  CHECK_SOME(fetchConcurrency);
 
-    if (reference.has_registry()) {
-      Result<int> port = spec::getRegistryPort(reference.registry());
-      if (port.isError()) {
-        return Failure("Failed to get registry port: " + port.error());
+  while (activeFetches < fetchConcurrency.get() && !pendingFetches.empty()) {
+    PendingFetch fetch = pendingFetches.front();
+    pendingFetches.pop_front();
+
+    ++activeFetches;
+
+    Future<Nothing> future = fetcher->fetch(fetch.blobUri, fetch.directory);
+
+    fetch.promise->associate(future);
+
+    future.onAny(defer(self(), [=](const Future<Nothing>&) {
+      --activeFetches;
+      _fetchBlob();
+    }));
+  }
+}
+
+
+Future<Nothing> RegistryPullerProcess::verifyBlob(
+    const string& blobSum,
+    const string& directory)
+{
+  // Blob sums are of the form '<algorithm>:<hex>', we only know how
+  // to verify SHA 256 digests (which are all that registries use).
+  vector<string> digest = strings::split(blobSum, ":", 2);
+  if (digest.size() != 2 || digest[0] != "sha256") {
+    VLOG(1) << "Skipping verification of blob '" << blobSum << "'";
+    return Nothing();
+  }
+
+  const string tar = path::join(directory, blobSum);
+
+  return command::sha256(Path(tar))
+    .then([=](const string& sha256) -> Future<Nothing> {
+      if (sha256 != digest[1]) {
+        return Failure(
+            "Digest mismatch for blob '" + blobSum + "': "
+            "got '" + sha256 + "'");
       }
 
-      Try<string> scheme = spec::getRegistryScheme(reference.registry());
-      if (scheme.isError()) {
-        return Failure("Failed to get registry scheme: " + scheme.error());
+      return Nothing();
+    });
+}
+
+
+Future<Nothing> RegistryPullerProcess::extractBlob(
+    const string& blobSum,
+    const string& directory,
+    const vector<string>& layerIds)
+{
+  const string tar = path::join(directory, blobSum);
+
+  list<Future<Nothing>> futures;
+  foreach (const string& layerId, layerIds) {
+    const string rootfs = paths::getImageLayerRootfsPath(
+        path::join(directory, layerId));
+
+    VLOG(1) << "Extracting layer tar ball '" << tar
+            << " to rootfs '" << rootfs << "'";
+
+    futures.push_back(command::untar(Path(tar), Path(rootfs)));
+  }
+
+  return collect(futures)
+    .then([tar]() -> Future<Nothing> {
+      // Remove the tarball after the extraction.
+      Try<Nothing> rm = os::rm(tar);
+      if (rm.isError()) {
+        return Failure(
+            "Failed to remove '" + tar + "' after extraction: " + rm.error());
       }
 
-      // If users want to use the registry specified in '--docker_image',
-      // an URL scheme must be specified in '--docker_registry', because
-      // there is no scheme allowed in docker image name.
-      blobUri = uri::docker::blob(
-          reference.repository(),
-          blobSum,
-          spec::getRegistryHost(reference.registry()),
-          scheme.get(),
-          port.isSome() ? port.get() : Option<int>());
-    } else {
-      const string registry = defaultRegistryUrl.domain.isSome()
-        ? defaultRegistryUrl.domain.get()
-        : stringify(defaultRegistryUrl.ip.get());
-
-      const Option<int> port = defaultRegistryUrl.port.isSome()
-        ? static_cast<int>(defaultRegistryUrl.port.get())
-        : Option<int>();
-
-      blobUri = uri::docker::blob(
-          reference.repository(),
-          blobSum,
-          registry,
-          defaultRegistryUrl.scheme,
-          port);
+      return Nothing();
+    });
+}
+
+
+Try<URI> RegistryPullerProcess::getBlobUri(
+    const spec::ImageReference& reference,
+    const string& blobSum)
+{
+  if (reference.has_registry()) {
+    Result<int> port = spec::getRegistryPort(reference.registry());
+    if (port.isError()) {
+      return Error("Failed to get registry port: " + port.error());
+    }
+
+    Try<string> scheme = spec::getRegistryScheme(reference.registry());
+    if (scheme.isError()) {
+      return Error("Failed to get registry scheme: " + scheme.error());
     }
 
-    futures.push_back(fetcher->fetch(blobUri, directory));
+    // If users want to use the registry specified in '--docker_image',
+    // an URL scheme must be specified in '--docker_registry', because
+    // there is no scheme allowed in docker image name.
+    return uri::docker::blob(
+        reference.repository(),
+        blobSum,
+        spec::getRegistryHost(reference.registry()),
+        scheme.get(),
+        port.isSome() ? port.get() : Option<int>());
   }
 
-  return collect(futures)
-    .then([blobSums]() -> hashset<string> { return blobSums; });
+  const string registry = defaultRegistryUrl.domain.isSome()
+    ? defaultRegistryUrl.domain.get()
+    : stringify(defaultRegistryUrl.ip.get());
+
+  const Option<int> port = defaultRegistryUrl.port.isSome()
+    ? static_cast<int>(defaultRegistryUrl.port.get())
+    : Option<int>();
+
+  return uri::docker::blob(
+      reference.repository(),
+      blobSum,
+      registry,
+      defaultRegistryUrl.scheme,
+      port);
+}
+
+
+Try<Nothing> RegistryPullerProcess::prepareLayer(
+    const string& directory,
+    const spec::v1::ImageManifest& v1)
+{
+  const string layerPath = path::join(directory, v1.id());
+  const string rootfs = paths::getImageLayerRootfsPath(layerPath);
+  const string json = paths::getImageLayerManifestPath(layerPath);
+
+  // NOTE: This will create 'layerPath' as well.
+  Try<Nothing> mkdir = os::mkdir(rootfs, true);
+  if (mkdir.isError()) {
+    return Error(
+        "Failed to create rootfs directory '" + rootfs + "' "
+        "for layer '" + v1.id() + "': " + mkdir.error());
+  }
+
+  Try<Nothing> write = os::write(json, stringify(JSON::protobuf(v1)));
+  if (write.isError()) {
+    return Error(
+        "Failed to save the layer manifest for layer '" +
+        v1.id() + "': " + write.error());
+  }
+
+  return Nothing();
 }
 
 } // namespace docker {
@@ -20,8 +20,10 @@
 #include <glog/logging.h>
 
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
 
 #include <process/collect.hpp>
 #include <process/defer.hpp>
@@ -30,6 +32,8 @@
 
 #include <mesos/docker/spec.hpp>
 
+#include "slave/containerizer/mesos/provisioner/layer_cache.hpp"
+
 #include "slave/containerizer/mesos/provisioner/docker/metadata_manager.hpp"
 #include "slave/containerizer/mesos/provisioner/docker/paths.hpp"
 #include "slave/containerizer/mesos/provisioner/docker/puller.hpp"
@@ -60,7 +64,11 @@ public:
     : ProcessBase(process::ID::generate("docker-provisioner-store")),
       flags(_flags),
       metadataManager(_metadataManager),
-      puller(_puller) {}
+      puller(_puller),
+      layerCache(
+          "containerizer/mesos/provisioner/docker/store/",
+          _flags.image_store_size_limit),
+      pending(0) {}
 
   ~StoreProcess() {}
 
@@ -68,7 +76,13 @@ public:
 
   Future<ImageInfo> get(const mesos::Image& image);
 
+  void acquire(const vector<string>& layers);
+
+  void release(const vector<string>& layers);
+
 private:
+  Future<Nothing> _recover();
+
   Future<Image> _get(
       const spec::ImageReference& reference,
       const Option<Image>& image);
@@ -83,11 +97,23 @@ private:
       const string& staging,
       const string& layerId);
 
+  // Returns the id of the layer whose rootfs is at the given path, or
+  // none if the path does not belong to the store.
+  Option<string> getLayerId(const string& layerPath);
+
+  // Removes the layers selected by the layer cache from the store.
+  void evict();
+
   const Flags flags;
 
   Owned<MetadataManager> metadataManager;
   Owned<Puller> puller;
   hashmap<string, Owned<Promise<Image>>> pulling;
+
+  LayerCache layerCache;
+
+  // Number of 'get()' calls in progress.
+  size_t pending;
 };
 
 
@@ -174,9 +200,64 @@ Future<ImageInfo> Store::get(const mesos::Image& image)
 }
 
 
+void Store::acquire(const vector<string>& layers)
+{
+  dispatch(process.get(), &StoreProcess::acquire, layers);
+}
+
+
+void Store::release(const vector<string>& layers)
+{
+  dispatch(process.get(), &StoreProcess::release, layers);
+}
+
+
 Future<Nothing> StoreProcess::recover()
 {
-  return metadataManager->recover();
+  return metadataManager->recover()
+    .then(defer(self(), &Self::_recover));
+}
+
+
+Future<Nothing> StoreProcess::_recover()
+{
+  const string layersDir = paths::getImageLayersDir(flags.docker_store_dir);
+
+  if (!os::exists(layersDir)) {
+    return Nothing();
+  }
+
+  Try<list<string>> layerIds = os::ls(layersDir);
+  if (layerIds.isError()) {
+    return Failure(
+        "Failed to list layers under '" + layersDir + "': " +
+        layerIds.error());
+  }
+
+  list<Future<Bytes>> sizes;
+  foreach (const string& layerId, layerIds.get()) {
+    sizes.push_back(layerCache.measure(
+        paths::getImageLayerPath(flags.docker_store_dir, layerId)));
+  }
+
+  // NOTE: The layers are measured one at a time by the layer cache.
+  // The order in which layers were last used is not persisted, so the
+  // recovered layers are considered least recently used in the order
+  // they are listed.
+  return collect(sizes)
+    .then(defer(self(), [=](const list<Bytes>& _sizes) -> Future<Nothing> {
+      list<Bytes>::const_iterator size = _sizes.begin();
+      foreach (const string& layerId, layerIds.get()) {
+        layerCache.put(layerId, *size++);
+      }
+
+      LOG(INFO) << "Recovered " << layerIds->size() << " Docker layers ("
+                << layerCache.size() << ")";
+
+      evict();
+
+      return Nothing();
+    }));
 }
 
 
@@ -194,9 +275,39 @@ Future<ImageInfo> StoreProcess::get(const mesos::Image& image)
                    "': " + reference.error());
   }
 
+  pending++;
+
   return metadataManager->get(reference.get(), image.cached())
     .then(defer(self(), &Self::_get, reference.get(), lambda::_1))
-    .then(defer(self(), &Self::__get, lambda::_1));
+    .then(defer(self(), &Self::__get, lambda::_1))
+    .onAny(defer(self(), [=](const Future<ImageInfo>&) {
+      pending--;
+      evict();
+    }));
+}
+
+
+void StoreProcess::acquire(const vector<string>& layers)
+{
+  foreach (const string& layer, layers) {
+    Option<string> layerId = getLayerId(layer);
+    if (layerId.isSome()) {
+      layerCache.reference(layerId.get());
+    }
+  }
+}
+
+
+void StoreProcess::release(const vector<string>& layers)
+{
+  foreach (const string& layer, layers) {
+    Option<string> layerId = getLayerId(layer);
+    if (layerId.isSome()) {
+      layerCache.unreference(layerId.get());
+    }
+  }
+
+  evict();
 }
 
 
@@ -206,11 +317,11 @@ Future<Image> StoreProcess::_get(
 {
   // NOTE: Here, we assume that image layers are not removed without
   // first removing the metadata in the metadata manager first.
-  // Otherwise, the image we return here might miss some layers. At
-  // the time we introduce cache eviction, we also want to avoid the
-  // situation where a layer was returned to the provisioner but is
-  // later evicted.
+  // Otherwise, the image we return here might miss some layers. This
+  // holds since 'evict()' prunes the metadata of evicted layers and
+  // does not run while any 'get()' is in progress.
   if (image.isSome()) {
+    layerCache.metrics.layer_hits += image->layer_ids_size();
     return image.get();
   }
 
@@ -261,6 +372,11 @@ Future<ImageInfo> StoreProcess::__get(const Image& image)
   foreach (const string& layerId, image.layer_ids()) {
     layerPaths.push_back(
         paths::getImageLayerRootfsPath(flags.docker_store_dir, layerId));
+
+    // The layers are referenced on behalf of the caller, who releases
+    // them once the rootfs provisioned from them is destroyed.
+    layerCache.touch(layerId);
+    layerCache.reference(layerId);
   }
 
   // Read the manifest from the last layer because all runtime config
@@ -310,6 +426,7 @@ Future<Nothing> StoreProcess::moveLayer(
   //
   // TODO(jieyu): Verify that the layer is actually in the store.
   if (!os::exists(source)) {
+    ++layerCache.metrics.layer_hits;
     return Nothing();
   }
 
@@ -321,6 +438,7 @@ Future<Nothing> StoreProcess::moveLayer(
   // already exists in the store, we'll skip the moving since they are
   // expected to be the same.
   if (os::exists(target)) {
+    ++layerCache.metrics.layer_hits;
     return Nothing();
   }
 
@@ -338,7 +456,93 @@ Future<Nothing> StoreProcess::moveLayer(
         "' to '" + target + "': " + rename.error());
   }
 
-  return Nothing();
+  ++layerCache.metrics.layer_misses;
+
+  return layerCache.measure(target)
+    .then(defer(self(), [=](const Bytes& size) {
+      layerCache.put(layerId, size);
+      return Nothing();
+    }));
+}
+
+
+Option<string> StoreProcess::getLayerId(const string& layerPath)
+{
+  const string layerId = Path(Path(layerPath).dirname()).basename();
+
+  if (layerPath !=
+      paths::getImageLayerRootfsPath(flags.docker_store_dir, layerId)) {
+    return None();
+  }
+
+  return layerId;
+}
+
+
+void StoreProcess::evict()
+{
+  // Evicting a layer while an image is being retrieved could remove a
+  // layer that the retrieval has already decided to reuse (e.g., the
+  // puller skips the layers that exist in the store), so eviction is
+  // postponed until no retrieval is in progress.
+  if (pending > 0) {
+    return;
+  }
+
+  const vector<string> layerIds = layerCache.evict();
+  if (layerIds.empty()) {
+    return;
+  }
+
+  // The evicted layers are moved out of the store and the images
+  // composed of them are pruned from the metadata before any
+  // subsequent 'get()' can look them up. Only the removal of the
+  // files, which can be slow for large layers, is done asynchronously
+  // by the layer cache.
+  Try<string> staging =
+    os::mkdtemp(paths::getStagingTempDir(flags.docker_store_dir));
+
+  if (staging.isError()) {
+    // The layers are left in the store untracked until the next
+    // recovery, which is safe since their metadata is not pruned.
+    LOG(WARNING) << "Failed to create a staging directory for evicting "
+                 << layerIds.size() << " layers: " << staging.error();
+    return;
+  }
+
+  hashset<string> evicted;
+
+  foreach (const string& layerId, layerIds) {
+    const string source =
+      paths::getImageLayerPath(flags.docker_store_dir, layerId);
+
+    const string target = path::join(staging.get(), layerId);
+
+    Try<Nothing> rename = os::rename(source, target);
+    if (rename.isError()) {
+      LOG(WARNING) << "Failed to evict layer '" << layerId << "': "
+                   << rename.error();
+      continue;
+    }
+
+    VLOG(1) << "Evicted layer '" << layerId << "' from the store";
+
+    evicted.insert(layerId);
+    ++layerCache.metrics.layer_evictions;
+  }
+
+  metadataManager->prune(evicted)
+    .onFailed([](const string& failure) {
+      LOG(WARNING) << "Failed to prune images of evicted layers: " << failure;
+    });
+
+  const string directory = staging.get();
+
+  layerCache.remove(directory)
+    .onFailed([directory](const string& failure) {
+      LOG(WARNING) << "Failed to remove evicted layers at '" << directory
+                   << "': " << failure;
+    });
 }
 
 } // namespace docker {
@@ -17,6 +17,9 @@
 #ifndef __PROVISIONER_DOCKER_STORE_HPP__
 #define __PROVISIONER_DOCKER_STORE_HPP__
 
+#include <string>
+#include <vector>
+
 #include <process/owned.hpp>
 
 #include <stout/try.hpp>
@@ -52,6 +55,10 @@ public:
 
   virtual process::Future<ImageInfo> get(const mesos::Image& image);
 
+  virtual void acquire(const std::vector<std::string>& layers);
+
+  virtual void release(const std::vector<std::string>& layers);
+
 private:
   explicit Store(process::Owned<StoreProcess> process);
 
@@ -0,0 +1,167 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+
+#include <process/metrics/metrics.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/try.hpp>
+
+#include <stout/os/rmdir.hpp>
+
+#include "common/disk_usage.hpp"
+
+#include "slave/containerizer/mesos/provisioner/layer_cache.hpp"
+
+using namespace process;
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+LayerCache::LayerCache(const string& prefix, const Option<Bytes>& _capacity)
+  : metrics(prefix),
+    capacity(_capacity),
+    tally(0) {}
+
+
+void LayerCache::put(const string& layer, const Bytes& size)
+{
+  if (layers.contains(layer)) {
+    tally -= layers.at(layer);
+    layers.erase(layer);
+  }
+
+  layers[layer] = size;
+  tally += size;
+}
+
+
+bool LayerCache::touch(const string& layer)
+{
+  if (!layers.contains(layer)) {
+    return false;
+  }
+
+  // Re-insert the layer to move it to the most recently used end.
+  const Bytes size = layers.at(layer);
+  layers.erase(layer);
+  layers[layer] = size;
+
+  return true;
+}
+
+
+void LayerCache::reference(const string& layer)
+{
+  references[layer]++;
+}
+
+
+void LayerCache::unreference(const string& layer)
+{
+  if (!references.contains(layer)) {
+    VLOG(1) << "Ignoring unreference of unreferenced layer '" << layer << "'";
+    return;
+  }
+
+  if (--references[layer] == 0) {
+    references.erase(layer);
+  }
+}
+
+
+vector<string> LayerCache::evict()
+{
+  vector<string> victims;
+
+  if (capacity.isNone() || tally <= capacity.get()) {
+    return victims;
+  }
+
+  foreach (const string& layer, layers.keys()) {
+    if (tally <= capacity.get()) {
+      break;
+    }
+
+    if (references.contains(layer)) {
+      continue;
+    }
+
+    tally -= layers.at(layer);
+    layers.erase(layer);
+
+    victims.push_back(layer);
+  }
+
+  if (tally > capacity.get()) {
+    VLOG(1) << "Layers in use (" << tally << ") exceed the store capacity ("
+            << capacity.get() << ")";
+  }
+
+  return victims;
+}
+
+
+Future<Bytes> LayerCache::measure(const string& path)
+{
+  if (capacity.isNone()) {
+    return Bytes(0);
+  }
+
+  // Count allocated blocks rather than the apparent size, which is
+  // what evicting the layer will give back.
+  return walker.run<Bytes>([path]() { return diskUsage(path); })
+    .repair([path](const Future<Bytes>& future) {
+      LOG(WARNING) << "Failed to get the disk usage of layer '" << path
+                   << "': " << future.failure();
+
+      return Bytes(0);
+    });
+}
+
+
+Future<Nothing> LayerCache::remove(const string& path)
+{
+  return walker.run<Nothing>([path]() { return os::rmdir(path); });
+}
+
+
+LayerCache::Metrics::Metrics(const string& prefix)
+  : layer_hits(prefix + "layer_hits"),
+    layer_misses(prefix + "layer_misses"),
+    layer_evictions(prefix + "layer_evictions")
+{
+  process::metrics::add(layer_hits);
+  process::metrics::add(layer_misses);
+  process::metrics::add(layer_evictions);
+}
+
+
+LayerCache::Metrics::~Metrics()
+{
+  process::metrics::remove(layer_hits);
+  process::metrics::remove(layer_misses);
+  process::metrics::remove(layer_evictions);
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
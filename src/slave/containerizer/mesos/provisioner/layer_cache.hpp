@@ -0,0 +1,127 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __PROVISIONER_LAYER_CACHE_HPP__
+#define __PROVISIONER_LAYER_CACHE_HPP__
+
+#include <string>
+#include <vector>
+
+#include <process/future.hpp>
+
+#include <process/metrics/counter.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/linkedhashmap.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+
+#include "common/job_threads.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Bookkeeping for the layers kept on disk by an image store. The
+// cache tracks the size of every layer in least recently used order,
+// together with the number of provisioned rootfses that reference
+// each layer. A referenced layer is never selected for eviction.
+//
+// NOTE: This class is not thread safe; it is meant to be owned by
+// the store process and only accessed from within it. The file trees
+// of the layers are walked and removed (see 'measure()' and
+// 'remove()') one at a time on a thread owned by the cache, the store
+// process must `defer` the callbacks on the returned futures.
+class LayerCache
+{
+public:
+  // The metrics are registered under the given 'prefix', e.g.,
+  // 'containerizer/mesos/provisioner/docker/store/'. If no 'capacity'
+  // is specified, layers are tracked but never evicted.
+  LayerCache(const std::string& prefix, const Option<Bytes>& capacity);
+
+  // Adds a layer that is now present in the store (or updates the
+  // size of an existing one) and marks it as the most recently used.
+  void put(const std::string& layer, const Bytes& size);
+
+  // Marks the layer as the most recently used. Returns false if the
+  // layer is not in the cache.
+  bool touch(const std::string& layer);
+
+  // References are counted independently of whether the layer is in
+  // the cache, so that references recovered from the provisioner can
+  // be taken before the store has finished scanning its layers.
+  void reference(const std::string& layer);
+  void unreference(const std::string& layer);
+
+  // Removes the least recently used unreferenced layers from the
+  // cache until the total size of the cached layers is within the
+  // capacity, and returns them in eviction order.
+  std::vector<std::string> evict();
+
+  // Returns the total size of the layers in the cache.
+  Bytes size() const { return tally; }
+
+  // Returns the disk space used by the file tree rooted at 'path'.
+  // A failure to walk the tree is logged and accounted as zero bytes.
+  // Without a capacity the sizes are never used, so the tree is not
+  // walked and the layer is accounted as zero bytes as well.
+  process::Future<Bytes> measure(const std::string& path);
+
+  // Removes the file tree rooted at 'path', e.g., the directory the
+  // evicted layers have been moved to.
+  process::Future<Nothing> remove(const std::string& path);
+
+  struct Metrics
+  {
+    explicit Metrics(const std::string& prefix);
+    ~Metrics();
+
+    // Layers requested from the store that were already present.
+    process::metrics::Counter layer_hits;
+
+    // Layers requested from the store that had to be fetched.
+    process::metrics::Counter layer_misses;
+
+    // Layers removed from the store to stay within the capacity.
+    process::metrics::Counter layer_evictions;
+  } metrics;
+
+private:
+  LayerCache(const LayerCache&) = delete; // Not copyable.
+  LayerCache& operator=(const LayerCache&) = delete; // Not assignable.
+
+  const Option<Bytes> capacity;
+
+  // Walking or removing a large layer takes a while.
+  JobThreads walker;
+
+  // Mappings: layer -> size, in least recently used order.
+  LinkedHashMap<std::string, Bytes> layers;
+
+  // Mappings: layer -> number of rootfses using the layer.
+  hashmap<std::string, size_t> references;
+
+  // Total size of the layers in the cache.
+  Bytes tally;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __PROVISIONER_LAYER_CACHE_HPP__
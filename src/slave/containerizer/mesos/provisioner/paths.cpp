@@ -69,6 +69,12 @@ static string getRootfsDir(const string& rootfsesDir, const string& roofsId)
 }
 
 
+static string getLayersDir(const string& backendDir)
+{
+  return path::join(backendDir, "layers");
+}
+
+
 string getContainerDir(
     const string& provisionerDir,
     const ContainerID& containerId)
@@ -104,6 +110,24 @@ string getContainerRootfsDir(
 }
 
 
+string getContainerRootfsLayersPath(
+    const string& provisionerDir,
+    const ContainerID& containerId,
+    const string& backend,
+    const string& rootfsId)
+{
+  return path::join(
+      getLayersDir(
+          getBackendDir(
+              getBackendsDir(
+                  getContainerDir(
+                      provisionerDir,
+                      containerId)),
+              backend)),
+      rootfsId);
+}
+
+
 Try<hashset<ContainerID>> listContainers(
     const string& provisionerDir)
 {
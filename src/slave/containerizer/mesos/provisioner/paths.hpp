@@ -40,6 +40,8 @@ namespace paths {
 //                 |-- <backend> (copy, bind, etc.)
 //                     |-- rootfses
 //                         |-- <rootfs_id> (the rootfs)
+//                     |-- layers
+//                         |-- <rootfs_id> (image layers of the rootfs)
 //             |-- containers (nested sub-containers)
 //                 |-- <container_id>
 //                     |-- backends
@@ -64,6 +66,15 @@ std::string getContainerRootfsDir(
     const std::string& rootfsId);
 
 
+// Returns the path of the file listing the store layers (one path
+// per line) that the rootfs is provisioned from.
+std::string getContainerRootfsLayersPath(
+    const std::string& provisionerDir,
+    const ContainerID& containerId,
+    const std::string& backend,
+    const std::string& rootfsId);
+
+
 // Recursively "ls" the container directory and return a map of
 // backend -> {rootfsId, ...}
 Try<hashmap<std::string, hashset<std::string>>>
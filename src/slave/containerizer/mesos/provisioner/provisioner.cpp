@@ -32,9 +32,11 @@
 #include <stout/hashset.hpp>
 #include <stout/os.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 #include <stout/uuid.hpp>
 
 #include "slave/paths.hpp"
+#include "slave/state.hpp"
 
 #include "slave/containerizer/mesos/provisioner/backend.hpp"
 #include "slave/containerizer/mesos/provisioner/paths.hpp"
@@ -201,6 +203,36 @@ Future<Nothing> ProvisionerProcess::recover(
       }
 
       info->rootfses.put(backend, rootfses.get()[backend]);
+
+      // Re-reference the store layers used by the rootfses so that
+      // they are not evicted. Rootfses provisioned before the layers
+      // were checkpointed have no layers file.
+      foreach (const string& rootfsId, rootfses.get()[backend]) {
+        const string path = provisioner::paths::getContainerRootfsLayersPath(
+            rootDir,
+            containerId,
+            backend,
+            rootfsId);
+
+        if (!os::exists(path)) {
+          continue;
+        }
+
+        Try<string> read = os::read(path);
+        if (read.isError()) {
+          return Failure(
+              "Failed to read the layers of rootfs '" + rootfsId +
+              "' from '" + path + "': " + read.error());
+        }
+
+        const vector<string> layers = strings::tokenize(read.get(), "\n");
+
+        info->layers.put(rootfsId, layers);
+
+        foreachvalue (const Owned<Store>& store, stores) {
+          store->acquire(layers);
+        }
+      }
     }
 
     infos.put(containerId, info);
@@ -302,6 +334,25 @@ Future<ProvisionInfo> ProvisionerProcess::_provision(
 
   infos[containerId]->rootfses[backend].insert(rootfsId);
 
+  // The layers returned by the store are referenced until the rootfs
+  // is destroyed. They are checkpointed so that the references can be
+  // re-established after an agent restart.
+  infos[containerId]->layers.put(rootfsId, imageInfo.layers);
+
+  Try<Nothing> checkpoint = slave::state::checkpoint(
+      provisioner::paths::getContainerRootfsLayersPath(
+          rootDir,
+          containerId,
+          backend,
+          rootfsId),
+      strings::join("\n", imageInfo.layers));
+
+  if (checkpoint.isError()) {
+    return Failure(
+        "Failed to checkpoint the layers of rootfs '" + rootfs + "': " +
+        checkpoint.error());
+  }
+
   string backendDir = provisioner::paths::getBackendDir(
       rootDir,
       containerId,
@@ -442,6 +493,11 @@ Future<bool> ProvisionerProcess::destroy(const ContainerID& containerId)
   Owned<Info> info = infos[containerId];
   infos.erase(containerId);
 
+  vector<string> layers;
+  foreachvalue (const vector<string>& _layers, info->layers) {
+    layers.insert(layers.end(), _layers.begin(), _layers.end());
+  }
+
   list<Future<bool>> futures;
   foreachkey (const string& backend, info->rootfses) {
     if (!backends.contains(backend)) {
@@ -464,12 +520,20 @@ Future<bool> ProvisionerProcess::destroy(const ContainerID& containerId)
 
   // TODO(xujyan): Revisit the usefulness of this return value.
   return collect(futures)
-    .then(defer(self(), &ProvisionerProcess::_destroy, containerId));
+    .then(defer(self(), &ProvisionerProcess::_destroy, containerId, layers));
 }
 
 
-Future<bool> ProvisionerProcess::_destroy(const ContainerID& containerId)
+Future<bool> ProvisionerProcess::_destroy(
+    const ContainerID& containerId,
+    const vector<string>& layers)
 {
+  // The rootfses are gone, so the store layers they were provisioned
+  // from are no longer in use by this container.
+  foreachvalue (const Owned<Store>& store, stores) {
+    store->release(layers);
+  }
+
   // This should be fairly cheap as the directory should only
   // contain a few empty sub-directories at this point.
   //
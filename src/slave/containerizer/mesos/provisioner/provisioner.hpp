@@ -18,6 +18,8 @@
 #define __PROVISIONER_HPP__
 
 #include <list>
+#include <string>
+#include <vector>
 
 #include <mesos/resources.hpp>
 
@@ -139,7 +141,9 @@ private:
       const Image& image,
       const ImageInfo& imageInfo);
 
-  process::Future<bool> _destroy(const ContainerID& containerId);
+  process::Future<bool> _destroy(
+      const ContainerID& containerId,
+      const std::vector<std::string>& layers);
 
   const Flags flags;
 
@@ -157,6 +161,10 @@ private:
   {
     // Mappings: backend -> {rootfsId, ...}
     hashmap<std::string, hashset<std::string>> rootfses;
+
+    // Mappings: rootfsId -> [layer, ...]
+    // These are the store layers referenced by each rootfs.
+    hashmap<std::string, std::vector<std::string>> layers;
   };
 
   hashmap<ContainerID, process::Owned<Info>> infos;
@@ -81,7 +81,17 @@ public:
   //
   // The returned future fails if the requested image or any of its
   // dependencies cannot be found or failed to be fetched.
+  //
+  // NOTE: The returned layers are referenced on behalf of the caller
+  // and will not be evicted from the store until they are released.
   virtual process::Future<ImageInfo> get(const Image& image) = 0;
+
+  // Reference (or release a reference to) the layers, identified by
+  // the paths in 'ImageInfo::layers', that are used by a provisioned
+  // rootfs. Stores that evict layers must not evict a referenced
+  // layer. Paths that do not belong to the store are ignored.
+  virtual void acquire(const std::vector<std::string>& layers) {}
+  virtual void release(const std::vector<std::string>& layers) {}
 };
 
 } // namespace slave {
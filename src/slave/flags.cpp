@@ -127,9 +127,18 @@ mesos::internal::slave::Flags::Flags()
   add(&Flags::image_provisioner_backend,
       "image_provisioner_backend",
       "Strategy for provisioning container rootfs from images,\n"
-      "e.g., `aufs`, `bind`, `copy`, `overlay`.",
+      "e.g., `aufs`, `bind`, `copy`, `overlay`, `reflink`.",
       "copy");
 
+  add(&Flags::image_store_size_limit,
+      "image_store_size_limit",
+      "Maximum disk space to be used by the layers of each image store\n"
+      "(see `--appc_store_dir` and `--docker_store_dir`), e.g., `20GB`.\n"
+      "When a store exceeds this limit, the least recently used layers\n"
+      "that are not used by any provisioned container rootfs are evicted\n"
+      "from it. Layers in use are never evicted, so a store may exceed\n"
+      "the limit while they are. If not set, layers are never evicted.");
+
   add(&Flags::appc_simple_discovery_uri_prefix,
       "appc_simple_discovery_uri_prefix",
       "URI prefix to be used for simple discovery of appc images,\n"
@@ -154,6 +163,22 @@ mesos::internal::slave::Flags::Flags()
       "Directory the Docker provisioner will store images in",
       path::join(os::temp(), "mesos", "store", "docker"));
 
+  add(&Flags::docker_registry_fetch_concurrency,
+      "docker_registry_fetch_concurrency",
+      "If set, the Docker registry puller pipelines image pulls: each layer\n"
+      "is verified against its digest and extracted as soon as its blob has\n"
+      "been fetched, rather than after all the blobs of the image have been\n"
+      "fetched. At most this many blobs are fetched concurrently (across all\n"
+      "images being pulled). If not set, all the blobs of an image are\n"
+      "fetched concurrently before any layer is extracted.",
+      [](const Option<size_t>& concurrency) -> Option<Error> {
+        if (concurrency.isSome() && concurrency.get() == 0) {
+          return Error("`docker_registry_fetch_concurrency` must be positive");
+        }
+
+        return None();
+      });
+
   add(&Flags::docker_volume_checkpoint_dir,
       "docker_volume_checkpoint_dir",
       "The root directory where we checkpoint the information about docker\n"
@@ -883,6 +908,22 @@ mesos::internal::slave::Flags::Flags()
       "flag.",
       Seconds(15));
 
+  add(&Flags::statistics_sampling_interval,
+      "statistics_sampling_interval",
+      "If set, the agent samples the resource statistics of all running\n"
+      "containers at this interval and keeps the most recent samples of\n"
+      "each container in memory. The `/monitor/statistics` endpoint is\n"
+      "then served from these samples instead of collecting the statistics\n"
+      "of every container on each request, and its `since` parameter can\n"
+      "be used to retrieve all samples taken after a given timestamp.",
+      [](const Option<Duration>& interval) -> Option<Error> {
+        if (interval.isSome() && interval.get() <= Duration::zero()) {
+          return Error("`statistics_sampling_interval` must be positive");
+        }
+
+        return None();
+      });
+
   add(&Flags::master_detector,
       "master_detector",
       "The symbol name of the master detector to use. This symbol\n"
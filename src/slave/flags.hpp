@@ -49,12 +49,14 @@ public:
 
   Option<std::string> image_providers;
   std::string image_provisioner_backend;
+  Option<Bytes> image_store_size_limit;
 
   std::string appc_simple_discovery_uri_prefix;
   std::string appc_store_dir;
 
   std::string docker_registry;
   std::string docker_store_dir;
+  Option<size_t> docker_registry_fetch_concurrency;
   std::string docker_volume_checkpoint_dir;
 
   std::string default_role;
@@ -147,6 +149,7 @@ public:
   Option<std::string> qos_controller;
   Duration qos_correction_interval_min;
   Duration oversubscribed_resources_interval;
+  Option<Duration> statistics_sampling_interval;
   Option<std::string> master_detector;
 #if ENABLE_XFS_DISK_ISOLATOR
   std::string xfs_project_range;
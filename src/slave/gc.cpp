@@ -14,17 +14,30 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#ifndef __WINDOWS__
+#include <fts.h>
+#endif // __WINDOWS__
+
+#include <algorithm>
 #include <list>
+#include <vector>
 
+#include <process/check.hpp>
+#include <process/collect.hpp>
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
 
+#include <process/metrics/metrics.hpp>
+
 #include <stout/foreach.hpp>
 
+#include <stout/os/exists.hpp>
 #include <stout/os/rmdir.hpp>
 
 #include "logging/logging.hpp"
 
+#include "slave/constants.hpp"
 #include "slave/gc.hpp"
 
 using namespace process;
@@ -34,17 +47,144 @@ using process::wait; // Necessary on some OS's to disambiguate.
 using std::list;
 using std::map;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
 namespace slave {
 
 
+// Removes 'path' like `os::rmdir(path, true, true, true)` does, and
+// returns the number of bytes allocated to the removed entries.
+static Try<Bytes> removePath(const string& path)
+{
+#ifdef __WINDOWS__
+  Try<Nothing> rmdir = os::rmdir(path, true, true, true);
+  if (rmdir.isError()) {
+    return Error(rmdir.error());
+  }
+
+  // NOTE: The reclaimed bytes are not accounted for on Windows.
+  return Bytes(0);
+#else
+  // NOTE: `fts_open` will not always return `nullptr` if the path does
+  // not exist, so we check it upfront just like `os::rmdir`.
+  if (!os::exists(path)) {
+    errno = ENOENT;
+    return ErrnoError();
+  }
+
+  char* paths[] = {const_cast<char*>(path.c_str()), nullptr};
+
+  // The entries are stat'ed by `fts_read` anyway, so accounting for
+  // the reclaimed bytes here comes for free.
+  FTS* tree = ::fts_open(paths, FTS_NOCHDIR | FTS_PHYSICAL, nullptr);
+  if (tree == nullptr) {
+    return ErrnoError();
+  }
+
+  Bytes reclaimed;
+
+  for (FTSENT* node = ::fts_read(tree);
+       node != nullptr; node = ::fts_read(tree)) {
+    switch (node->fts_info) {
+      case FTS_DP:
+        if (::rmdir(node->fts_path) < 0) {
+          if (errno != ENOENT) {
+            // Keep going to free up disk space wherever we can, e.g.,
+            // in spite of a busy mount point in a sandbox.
+            LOG(ERROR) << "Failed to delete directory '" << node->fts_path
+                       << "': " << os::strerror(errno);
+          }
+        } else {
+          reclaimed += Bytes(node->fts_statp->st_blocks * 512);
+        }
+        break;
+      case FTS_DEFAULT:
+      case FTS_F:
+      case FTS_SL:
+      case FTS_SLNONE:
+        if (::unlink(node->fts_path) < 0) {
+          if (errno != ENOENT) {
+            LOG(ERROR) << "Failed to delete path '" << node->fts_path
+                       << "': " << os::strerror(errno);
+          }
+        } else if (node->fts_statp->st_nlink <= 1) {
+          // The blocks of a file with other links are not freed.
+          reclaimed += Bytes(node->fts_statp->st_blocks * 512);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (errno != 0) {
+    ::fts_close(tree);
+    return Error("rmdir failed in 'continueOnError' mode");
+  }
+
+  if (::fts_close(tree) < 0) {
+    return ErrnoError();
+  }
+
+  return reclaimed;
+#endif // __WINDOWS__
+}
+
+
+static vector<Try<Bytes>> removePaths(const vector<string>& paths)
+{
+  vector<Try<Bytes>> removed;
+
+  foreach (const string& path, paths) {
+    LOG(INFO) << "Deleting " << path;
+
+    removed.push_back(removePath(path));
+  }
+
+  return removed;
+}
+
+
+GarbageCollectorProcess::Metrics::Metrics(
+    const GarbageCollectorProcess& process)
+  : path_removals_pending(
+        "gc/path_removals_pending",
+        defer(process, &GarbageCollectorProcess::_path_removals_pending)),
+    path_removals_succeeded("gc/path_removals_succeeded"),
+    path_removals_failed("gc/path_removals_failed"),
+    bytes_reclaimed("gc/bytes_reclaimed")
+{
+  process::metrics::add(path_removals_pending);
+  process::metrics::add(path_removals_succeeded);
+  process::metrics::add(path_removals_failed);
+  process::metrics::add(bytes_reclaimed);
+}
+
+
+GarbageCollectorProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(path_removals_pending);
+  process::metrics::remove(path_removals_succeeded);
+  process::metrics::remove(path_removals_failed);
+  process::metrics::remove(bytes_reclaimed);
+}
+
+
 GarbageCollectorProcess::~GarbageCollectorProcess()
 {
   foreachvalue (const PathInfo& info, paths) {
     info.promise->discard();
   }
+
+  foreach (const PathInfo& info, removals) {
+    info.promise->discard();
+  }
+
+  foreach (const PathInfo& info, removing) {
+    info.promise->discard();
+  }
 }
 
 
@@ -55,9 +195,15 @@ Future<Nothing> GarbageCollectorProcess::schedule(
   LOG(INFO) << "Scheduling '" << path << "' for gc " << d << " in the future";
 
   // If there's an existing schedule for this path, we must remove
-  // it here in order to reschedule.
-  if (timeouts.contains(path)) {
-    CHECK(unschedule(path));
+  // it here in order to reschedule. This includes a path whose
+  // removal has not started yet.
+  auto queued = [&path](const PathInfo& info) { return info.path == path; };
+
+  if (timeouts.contains(path) ||
+      std::find_if(removals.begin(), removals.end(), queued) !=
+        removals.end()) {
+    Future<bool> unscheduled = unschedule(path);
+    CHECK(unscheduled.isReady() && unscheduled.get());
   }
 
   Owned<Promise<Nothing>> promise(new Promise<Nothing>());
@@ -78,11 +224,33 @@ Future<Nothing> GarbageCollectorProcess::schedule(
 }
 
 
-bool GarbageCollectorProcess::unschedule(const string& path)
+Future<bool> GarbageCollectorProcess::unschedule(const string& path)
 {
   LOG(INFO) << "Unscheduling '" << path << "' from gc";
 
   if (!timeouts.contains(path)) {
+    // The removal time of the path might have come already, in which
+    // case we can still take it back as long as the removal has not
+    // started yet.
+    for (auto it = removals.begin(); it != removals.end(); ++it) {
+      if (it->path == path) {
+        it->promise->discard();
+        removals.erase(it);
+        return true;
+      }
+    }
+
+    // Otherwise, if the path is being removed, the caller must not
+    // reuse it before the removal has finished.
+    foreach (const PathInfo& info, removing) {
+      if (info.path == path) {
+        LOG(INFO) << "Waiting for '" << path << "' to be removed";
+
+        return await(info.promise->future())
+          .then([]() { return false; });
+      }
+    }
+
     return false;
   }
 
@@ -125,32 +293,17 @@ void GarbageCollectorProcess::reset()
 
 void GarbageCollectorProcess::remove(const Timeout& removalTime)
 {
-  // TODO(bmahler): Other dispatches can block waiting for a removal
-  // operation. To fix this, the removal operation can be done
-  // asynchronously in another thread.
+  // The paths are removed in the background (see 'drain()') so that
+  // other dispatches are not blocked waiting for a removal operation.
   if (paths.count(removalTime) > 0) {
     foreach (const PathInfo& info, paths.get(removalTime)) {
-      LOG(INFO) << "Deleting " << info.path;
-
-      // Run rmdir with 'continueOnError = true'. It's possible for
-      // tasks and isolators to lay down files that are not deletable by
-      // GC. In the face of such errors GC needs to free up disk space
-      // wherever it can because it's already re-offered to frameworks.
-      Try<Nothing> rmdir = os::rmdir(info.path, true, true, true);
-
-      if (rmdir.isError()) {
-        LOG(WARNING) << "Failed to delete '" << info.path << "': "
-                     << rmdir.error();
-        info.promise->fail(rmdir.error());
-      } else {
-        LOG(INFO) << "Deleted '" << info.path << "'";
-        info.promise->set(rmdir.get());
-      }
-
+      removals.push_back(info);
       timeouts.erase(info.path);
     }
 
     paths.remove(removalTime);
+
+    drain();
   } else {
     // This occurs when either:
     //   1. The path(s) has already been removed (e.g. by prune()).
@@ -163,6 +316,62 @@ void GarbageCollectorProcess::remove(const Timeout& removalTime)
 }
 
 
+void GarbageCollectorProcess::drain()
+{
+  if (!removing.empty() || removals.empty()) {
+    return;
+  }
+
+  vector<string> paths;
+
+  while (!removals.empty() && paths.size() < GC_REMOVAL_BATCH_SIZE) {
+    paths.push_back(removals.front().path);
+
+    removing.push_back(removals.front());
+    removals.pop_front();
+  }
+
+  // The paths are removed with 'continueOnError = true' semantics.
+  // It's possible for tasks and isolators to lay down files that are
+  // not deletable by GC. In the face of such errors GC needs to free
+  // up disk space wherever it can because it's already re-offered to
+  // frameworks.
+  remover.run<vector<Try<Bytes>>>([paths]() { return removePaths(paths); })
+    .onAny(defer(self(), &Self::_drain, lambda::_1));
+}
+
+
+void GarbageCollectorProcess::_drain(
+    const Future<vector<Try<Bytes>>>& removed)
+{
+  CHECK_READY(removed);
+  CHECK_EQ(removing.size(), removed->size());
+
+  for (size_t i = 0; i < removed->size(); i++) {
+    const PathInfo info = removing.front();
+    removing.pop_front();
+
+    const Try<Bytes>& rmdir = removed->at(i);
+
+    if (rmdir.isError()) {
+      LOG(WARNING) << "Failed to delete '" << info.path << "': "
+                   << rmdir.error();
+      info.promise->fail(rmdir.error());
+
+      ++metrics.path_removals_failed;
+    } else {
+      LOG(INFO) << "Deleted '" << info.path << "'";
+      info.promise->set(Nothing());
+
+      ++metrics.path_removals_succeeded;
+      metrics.bytes_reclaimed += rmdir->bytes();
+    }
+  }
+
+  drain();
+}
+
+
 void GarbageCollectorProcess::prune(const Duration& d)
 {
   foreach (const Timeout& removalTime, paths.keys()) {
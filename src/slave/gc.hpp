@@ -17,6 +17,7 @@
 #ifndef __SLAVE_GC_HPP__
 #define __SLAVE_GC_HPP__
 
+#include <list>
 #include <string>
 #include <vector>
 
@@ -27,12 +28,19 @@
 #include <process/timeout.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
+
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/multimap.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/try.hpp>
 
+#include "common/job_threads.hpp"
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -68,9 +76,12 @@ public:
       const std::string& path);
 
   // Unschedules the specified path for removal.
-  // The future will be true if the path has been unscheduled.
+  // The future will be true if the path has been unscheduled, this
+  // includes a path whose removal time has come but whose removal
+  // has not started yet.
   // The future will be false if the path is not scheduled for
-  // removal, or the path has already being removed.
+  // removal. If the path is being removed, the future will be false
+  // once the removal has finished.
   // Note that you currently cannot discard a returned future.
   virtual process::Future<bool> unschedule(const std::string& path);
 
@@ -88,7 +99,8 @@ class GarbageCollectorProcess :
 {
 public:
   GarbageCollectorProcess()
-    : ProcessBase(process::ID::generate("agent-garbage-collector")) {}
+    : ProcessBase(process::ID::generate("agent-garbage-collector")),
+      metrics(*this) {}
 
   virtual ~GarbageCollectorProcess();
 
@@ -96,7 +108,7 @@ public:
       const Duration& d,
       const std::string& path);
 
-  bool unschedule(const std::string& path);
+  process::Future<bool> unschedule(const std::string& path);
 
   void prune(const Duration& d);
 
@@ -120,6 +132,28 @@ private:
     const process::Owned<process::Promise<Nothing>> promise;
   };
 
+  // Hands the next batch of queued paths to 'remover', if it is not
+  // removing a batch already.
+  void drain();
+
+  void _drain(const process::Future<std::vector<Try<Bytes>>>& removed);
+
+  double _path_removals_pending()
+  {
+    return static_cast<double>(removals.size() + removing.size());
+  }
+
+  struct Metrics
+  {
+    explicit Metrics(const GarbageCollectorProcess& process);
+    ~Metrics();
+
+    process::metrics::Gauge path_removals_pending;
+    process::metrics::Counter path_removals_succeeded;
+    process::metrics::Counter path_removals_failed;
+    process::metrics::Counter bytes_reclaimed;
+  } metrics;
+
   // Store all the timeouts and corresponding paths to delete.
   // NOTE: We are using Multimap here instead of Multihashmap, because
   // we need the keys of the map (deletion time) to be sorted.
@@ -130,6 +164,14 @@ private:
   hashmap<std::string, process::Timeout> timeouts;
 
   process::Timer timer;
+
+  // Paths whose removal time has come, waiting to be removed in the
+  // background, and the batch of paths that is being removed.
+  std::list<PathInfo> removals;
+  std::list<PathInfo> removing;
+
+  // A removal can block for a long time, e.g., on a slow disk.
+  JobThreads remover;
 };
 
 } // namespace slave {
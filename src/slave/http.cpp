@@ -1521,7 +1521,20 @@ string Slave::Http::STATISTICS_HELP()
           "        \"timestamp\":1388534400.0",
           "    }",
           "}]",
-          "```"),
+          "```",
+          "",
+          "If the agent samples the resource statistics (see the",
+          "`--statistics_sampling_interval` flag), the most recent sample",
+          "of each container is returned instead of collecting the current",
+          "statistics.",
+          "",
+          "Query parameters:",
+          "",
+          ">        since=VALUE         Only return the statistics with a",
+          "`timestamp` greater than this value (in seconds since the epoch).",
+          "If the agent samples the resource statistics, all the samples",
+          "kept in memory that were taken after this timestamp are returned,",
+          "oldest first."),
       AUTHENTICATION(true),
       AUTHORIZATION(
           "The request principal should be authorized to query this endpoint.",
@@ -1544,6 +1557,17 @@ Future<Response> Slave::Http::statistics(
     return Failure("Failed to extract endpoint: " + endpoint.error());
   }
 
+  Option<double> since;
+  if (request.url.query.contains("since")) {
+    Try<double> timestamp = numify<double>(request.url.query.at("since"));
+    if (timestamp.isError()) {
+      return BadRequest(
+          "Failed to parse query parameter 'since': " + timestamp.error());
+    }
+
+    since = timestamp.get();
+  }
+
   return authorizeEndpoint(
       endpoint.get(),
       request.method,
@@ -1551,16 +1575,23 @@ Future<Response> Slave::Http::statistics(
       principal)
     .then(defer(
         slave->self(),
-        [this, request](bool authorized) -> Future<Response> {
+        [this, request, since](bool authorized) -> Future<Response> {
           if (!authorized) {
             return Forbidden();
           }
 
+          // Serve the request from the samples if there are any, they
+          // are cheap to read so there is no need for rate limiting.
+          if (slave->flags.statistics_sampling_interval.isSome()) {
+            return _statistics(
+                slave->sampledUsage(since.isSome()), since, request);
+          }
+
           return statisticsLimiter->acquire()
             .then(defer(slave->self(), &Slave::usage))
             .then(defer(slave->self(),
-                  [this, request](const ResourceUsage& usage) {
-              return _statistics(usage, request);
+                  [this, request, since](const ResourceUsage& usage) {
+              return _statistics(usage, since, request);
             }));
         }));
 }
@@ -1568,11 +1599,17 @@ Future<Response> Slave::Http::statistics(
 
 Response Slave::Http::_statistics(
     const ResourceUsage& usage,
+    const Option<double>& since,
     const Request& request) const
 {
   JSON::Array result;
 
   foreach (const ResourceUsage::Executor& executor, usage.executors()) {
+    if (since.isSome() &&
+        executor.statistics().timestamp() <= since.get()) {
+      continue;
+    }
+
     if (executor.has_statistics()) {
       const ExecutorInfo info = executor.executor_info();
 
@@ -5265,6 +5265,11 @@ void Slave::__recover(const Future<Nothing>& future)
 
     // Start acting on correction from QoS Controller.
     qosCorrections();
+
+    // Start sampling the resource statistics of the executors.
+    if (flags.statistics_sampling_interval.isSome()) {
+      sampleStatistics();
+    }
   } else {
     // Slave started in cleanup mode.
     CHECK_EQ("cleanup", flags.recover);
@@ -5652,6 +5657,83 @@ Future<ResourceUsage> Slave::usage()
 }
 
 
+void Slave::sampleStatistics()
+{
+  usage()
+    .onAny(defer(self(), &Self::_sampleStatistics, lambda::_1));
+}
+
+
+void Slave::_sampleStatistics(const Future<ResourceUsage>& usage)
+{
+  CHECK_SOME(flags.statistics_sampling_interval);
+
+  // Make sure the next sample is scheduled.
+  delay(flags.statistics_sampling_interval.get(),
+        self(),
+        &Self::sampleStatistics);
+
+  if (!usage.isReady()) {
+    LOG(WARNING) << "Failed to sample resource statistics: "
+                 << (usage.isFailed() ? usage.failure() : "discarded");
+    return;
+  }
+
+  hashset<ContainerID> containerIds;
+
+  foreach (const ResourceUsage::Executor& executor, usage->executors()) {
+    containerIds.insert(executor.container_id());
+
+    if (!executor.has_statistics()) {
+      continue;
+    }
+
+    StatisticsSamples& samples = statisticsSamples[executor.container_id()];
+    samples.executorInfo = executor.executor_info();
+    samples.samples.push_back(executor.statistics());
+
+    // The timestamp identifies a sample for the 'since' parameter of
+    // '/monitor/statistics', so make sure that every sample has one.
+    if (!samples.samples.back().has_timestamp()) {
+      samples.samples.back().set_timestamp(Clock::now().secs());
+    }
+  }
+
+  // Drop the samples of the containers that are gone.
+  foreach (const ContainerID& containerId, statisticsSamples.keys()) {
+    if (!containerIds.contains(containerId)) {
+      statisticsSamples.erase(containerId);
+    }
+  }
+}
+
+
+ResourceUsage Slave::sampledUsage(bool history) const
+{
+  ResourceUsage usage;
+
+  foreachpair (const ContainerID& containerId,
+               const StatisticsSamples& samples,
+               statisticsSamples) {
+    if (samples.samples.empty()) {
+      continue;
+    }
+
+    auto begin =
+      history ? samples.samples.begin() : samples.samples.end() - 1;
+
+    for (auto it = begin; it != samples.samples.end(); ++it) {
+      ResourceUsage::Executor* executor = usage.add_executors();
+      executor->mutable_executor_info()->CopyFrom(samples.executorInfo);
+      executor->mutable_container_id()->CopyFrom(containerId);
+      executor->mutable_statistics()->CopyFrom(*it);
+    }
+  }
+
+  return usage;
+}
+
+
 // TODO(dhamon): Move these to their own metrics.hpp|cpp.
 double Slave::_tasks_staging()
 {
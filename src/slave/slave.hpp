@@ -512,6 +512,7 @@ private:
     // execute when the invoking `Http` is already destructed.
     process::http::Response _statistics(
         const ResourceUsage& usage,
+        const Option<double>& since,
         const process::http::Request& request) const;
 
     // Continuation for `/containers` endpoint
@@ -659,6 +660,15 @@ private:
   void _forwardOversubscribed(
       const process::Future<Resources>& oversubscribable);
 
+  // Samples the resource statistics of all executors into
+  // 'statisticsSamples' (see 'flags.statistics_sampling_interval').
+  void sampleStatistics();
+  void _sampleStatistics(const process::Future<ResourceUsage>& usage);
+
+  // Returns the sampled resource usage: the most recent sample of
+  // each executor, or all the samples kept if 'history' is true.
+  ResourceUsage sampledUsage(bool history) const;
+
   const Flags flags;
 
   const Http http;
@@ -748,6 +758,19 @@ private:
   // The most recent estimate of the total amount of oversubscribed
   // (allocated and oversubscribable) resources.
   Option<Resources> oversubscribedResources;
+
+  // The resource statistics sampled for the containers of the
+  // executors that were running at the last sample, oldest first.
+  struct StatisticsSamples
+  {
+    StatisticsSamples()
+      : samples(MAX_STATISTICS_SAMPLES_PER_CONTAINER) {}
+
+    ExecutorInfo executorInfo;
+    boost::circular_buffer<ResourceStatistics> samples;
+  };
+
+  hashmap<ContainerID, StatisticsSamples> statisticsSamples;
 };
 
 
@@ -30,7 +30,6 @@
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
-#include <process/mutex.hpp>
 #include <process/process.hpp>
 
 #include <process/metrics/metrics.hpp>
@@ -77,10 +76,17 @@ namespace state {
 // implying the operation was not atomic and subsequent operations
 // will re-'start()' which will again read all positions to make sure
 // operations are consistent.
+//
+// Sets and expunges do not wait for the previous ones to be appended:
+// they check the version against (and compute diffs from) the entries
+// that are still being appended, and the Log::Writer completes the
+// appends in order. If an append fails (or the writer gets demoted)
+// then the operations queued behind it, which were based on its
+// entry, fail as well.
 // TODO(benh): Log demotion does not necessarily imply a non-atomic
 // read/modify/write. An alternative strategy might be to retry after
-// restarting via 'start' (and holding on to the mutex so no other
-// operations are attempted).
+// restarting via 'start' (and holding back the other operations in the
+// meantime).
 class LogStorageProcess : public Process<LogStorageProcess>
 {
 public:
@@ -109,25 +115,35 @@ private:
 
   // Helper for performing truncation.
   void truncate();
-  Future<Nothing> _truncate();
-  Future<Nothing> __truncate(
+  void _truncate(
       const Log::Position& minimum,
-      const Option<Log::Position>& position);
+      const Future<Option<Log::Position>>& position);
+
+  // Helpers for appending an operation on the entry with the given
+  // name (none for an expunge) without waiting for the outstanding
+  // appends, see 'Appending' below.
+  Future<Option<Log::Position>> append(
+      const string& name,
+      const Option<Entry>& entry,
+      size_t diffs,
+      const string& value);
+  void appended(const string& name);
+  void abandon(uint64_t generation);
 
   // Continuations.
   Future<Option<Entry>> _get(const string& name);
 
   Future<bool> _set(const Entry& entry, const UUID& uuid);
-  Future<bool> __set(const Entry& entry, const UUID& uuid);
-  Future<bool> ___set(
+  Future<bool> __set(
       const Entry& entry,
       size_t diff,
+      uint64_t generation,
       Option<Log::Position> position);
 
   Future<bool> _expunge(const Entry& entry);
-  Future<bool> __expunge(const Entry& entry);
-  Future<bool> ___expunge(
+  Future<bool> __expunge(
       const Entry& entry,
+      uint64_t generation,
       const Option<Log::Position>& position);
 
   Future<std::set<string>> _names();
@@ -137,9 +153,6 @@ private:
 
   const size_t diffsBetweenSnapshots;
 
-  // Used to serialize Log::Writer::append/truncate operations.
-  Mutex mutex;
-
   // Whether or not we've started the ability to append to log.
   Option<Future<Nothing>> starting;
 
@@ -149,6 +162,10 @@ private:
   // Last position in the log up to which we've truncated.
   Option<Log::Position> truncated;
 
+  // Position up to which we're truncating, if a truncation is
+  // outstanding.
+  Option<Log::Position> truncating;
+
   // Note that while it would be nice to just use Operation::Snapshot
   // modified to include a required field called 'position' we don't
   // know the position (nor can we determine it) before we've done the
@@ -204,6 +221,34 @@ private:
   // a default/empty constructor.
   hashmap<string, Snapshot> snapshots;
 
+  // The entries that are still being appended, indexed by name. Each
+  // holds the latest version of the entry (none if it's being
+  // expunged), i.e., the snapshot once all the outstanding appends
+  // for the entry have succeeded. Sets and expunges check the version
+  // against these before the snapshots.
+  struct Appending
+  {
+    Appending(const Option<Entry>& entry, size_t diffs)
+      : entry(entry),
+        diffs(diffs),
+        outstanding(1) {}
+
+    Option<Entry> entry;
+
+    // See 'Snapshot::diffs'.
+    size_t diffs;
+
+    // The number of outstanding appends for the entry.
+    size_t outstanding;
+  };
+
+  hashmap<string, Appending> appending;
+
+  // Incremented when an append fails or returns none so that the
+  // appends that were queued behind it (and were based on its entry)
+  // fail too, see 'abandon()'.
+  uint64_t generation;
+
   struct Metrics
   {
     Metrics()
@@ -226,7 +271,8 @@ LogStorageProcess::LogStorageProcess(Log* log, size_t diffsBetweenSnapshots)
   : ProcessBase(process::ID::generate("log-storage")),
     reader(log),
     writer(log),
-    diffsBetweenSnapshots(diffsBetweenSnapshots) {}
+    diffsBetweenSnapshots(diffsBetweenSnapshots),
+    generation(0) {}
 
 
 LogStorageProcess::~LogStorageProcess() {}
@@ -381,17 +427,6 @@ Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
 // of time and their associated snapshots are causing the log to grow
 // very big.
 void LogStorageProcess::truncate()
-{
-  // We lock the truncation since it includes a call to
-  // Log::Writer::truncate which must be serialized with calls to
-  // Log::Writer::append.
-  mutex.lock()
-    .then(defer(self(), &Self::_truncate))
-    .onAny(lambda::bind(&Mutex::unlock, mutex));
-}
-
-
-Future<Nothing> LogStorageProcess::_truncate()
 {
   // Determine the minimum necessary position for all the snapshots.
   Option<Log::Position> minimum = None();
@@ -409,9 +444,17 @@ Future<Nothing> LogStorageProcess::_truncate()
 
   CHECK_SOME(truncated);
 
-  if (minimum.isSome() && minimum.get() > truncated.get()) {
-    return writer.truncate(minimum.get())
-      .then(defer(self(), &Self::__truncate, minimum.get(), lambda::_1));
+  // NOTE: The snapshots only reflect the appends that have succeeded,
+  // so the entries that are still being appended can not be truncated.
+  // We skip the truncation if an outstanding one already covers the
+  // minimum since every truncation is itself appended to the log.
+  if (minimum.isSome() &&
+      minimum.get() > truncated.get() &&
+      (truncating.isNone() || minimum.get() > truncating.get())) {
+    truncating = minimum;
+
+    writer.truncate(minimum.get())
+      .onAny(defer(self(), &Self::_truncate, minimum.get(), lambda::_1));
 
     // NOTE: Any failure from Log::Writer::truncate doesn't propagate
     // since the expectation is any subsequent Log::Writer::append
@@ -419,24 +462,81 @@ Future<Nothing> LogStorageProcess::_truncate()
     // temporary any subsequent Log::Writer::truncate should rectify a
     // "missing" truncation.
   }
-
-  return Nothing();
 }
 
 
-Future<Nothing> LogStorageProcess::__truncate(
+void LogStorageProcess::_truncate(
     const Log::Position& minimum,
-    const Option<Log::Position>& position)
+    const Future<Option<Log::Position>>& position)
 {
+  if (truncating.isSome() && truncating.get() == minimum) {
+    truncating = None();
+  }
+
   // Don't bother retrying truncation if we're demoted, we'll
   // just try again the next time 'truncate()' gets called
   // (after we've done what's necessary to append again).
-  if (position.isSome()) {
+  if (position.isReady() && position.get().isSome()) {
     truncated = max(truncated, minimum);
-    index = max(index, position);
+    index = max(index, position.get());
   }
+}
 
-  return Nothing();
+
+Future<Option<Log::Position>> LogStorageProcess::append(
+    const string& name,
+    const Option<Entry>& entry,
+    size_t diffs,
+    const string& value)
+{
+  if (appending.contains(name)) {
+    Appending& latest = appending.at(name);
+    latest.entry = entry;
+    latest.diffs = diffs;
+    latest.outstanding++;
+  } else {
+    appending.put(name, Appending(entry, diffs));
+  }
+
+  // The Log::Writer completes the appends in order, so any append
+  // queued behind a failed one learns about the failure (from the
+  // incremented 'generation') before it completes.
+  return writer.append(value)
+    .onFailed(defer(self(), &Self::abandon, generation))
+    .onDiscarded(defer(self(), &Self::abandon, generation));
+}
+
+
+void LogStorageProcess::appended(const string& name)
+{
+  CHECK(appending.contains(name));
+
+  Appending& latest = appending.at(name);
+
+  CHECK_GT(latest.outstanding, 0u);
+  if (--latest.outstanding == 0) {
+    appending.erase(name);
+  }
+}
+
+
+void LogStorageProcess::abandon(uint64_t generation)
+{
+  // Only the first failed append of a generation needs to be handled.
+  if (generation != this->generation) {
+    return;
+  }
+
+  this->generation++;
+
+  // The outstanding appends (if any) are about to fail, the snapshots
+  // are up to date with the ones that succeeded.
+  appending.clear();
+
+  // Reset 'starting' so we try again, unless we're already doing so.
+  if (starting.isSome() && !starting.get().isPending()) {
+    starting = None();
+  }
 }
 
 
@@ -462,43 +562,41 @@ Future<Option<Entry>> LogStorageProcess::_get(const string& name)
 Future<bool> LogStorageProcess::set(
     const Entry& entry,
     const UUID& uuid)
-{
-  return mutex.lock()
-    .then(defer(self(), &Self::_set, entry, uuid))
-    .onAny(lambda::bind(&Mutex::unlock, mutex));
-}
-
-
-Future<bool> LogStorageProcess::_set(
-    const Entry& entry,
-    const UUID& uuid)
 {
   return start()
-    .then(defer(self(), &Self::__set, entry, uuid));
+    .then(defer(self(), &Self::_set, entry, uuid));
 }
 
 
-Future<bool> LogStorageProcess::__set(
+Future<bool> LogStorageProcess::_set(
     const Entry& entry,
     const UUID& uuid)
 {
-  Option<Snapshot> snapshot = snapshots.get(entry.name());
+  // Determine the latest version of the entry, which might still be
+  // being appended, and the number of diffs since its snapshot.
+  Option<Entry> latest = None();
+  size_t diffs = 0;
+
+  if (appending.contains(entry.name())) {
+    latest = appending.at(entry.name()).entry;
+    diffs = appending.at(entry.name()).diffs;
+  } else if (snapshots.contains(entry.name())) {
+    latest = snapshots.at(entry.name()).entry;
+    diffs = snapshots.at(entry.name()).diffs;
+  }
 
-  // Check the version first (if we've already got a snapshot).
-  if (snapshot.isSome() &&
-      UUID::fromBytes(snapshot.get().entry.uuid()).get() != uuid) {
+  // Check the version first (if we've already got an entry).
+  if (latest.isSome() && UUID::fromBytes(latest.get().uuid()).get() != uuid) {
     return false;
   }
 
   // Check if we should try to compute a diff.
-  if (snapshot.isSome() && snapshot.get().diffs < diffsBetweenSnapshots) {
+  if (latest.isSome() && diffs < diffsBetweenSnapshots) {
     // Keep metrics for the time to calculate diffs.
     metrics.diff.start();
 
-    // Construct the diff of the last snapshot.
-    Try<svn::Diff> diff = svn::diff(
-        snapshot.get().entry.value(),
-        entry.value());
+    // Construct the diff of the latest entry.
+    Try<svn::Diff> diff = svn::diff(latest.get().value(), entry.value());
 
     Duration elapsed = metrics.diff.stop();
 
@@ -525,11 +623,12 @@ Future<bool> LogStorageProcess::__set(
         return Failure("Failed to serialize DIFF Operation");
       }
 
-      return writer.append(value)
+      return append(entry.name(), entry, diffs + 1, value)
         .then(defer(self(),
-                    &Self::___set,
+                    &Self::__set,
                     entry,
-                    snapshot.get().diffs + 1,
+                    diffs + 1,
+                    generation,
                     lambda::_1));
     }
   }
@@ -544,21 +643,28 @@ Future<bool> LogStorageProcess::__set(
     return Failure("Failed to serialize SNAPSHOT Operation");
   }
 
-  return writer.append(value)
-    .then(defer(self(), &Self::___set, entry, 0, lambda::_1));
+  return append(entry.name(), entry, 0, value)
+    .then(defer(self(), &Self::__set, entry, 0, generation, lambda::_1));
 }
 
 
-Future<bool> LogStorageProcess::___set(
+Future<bool> LogStorageProcess::__set(
     const Entry& entry,
     size_t diffs,
+    uint64_t generation,
     Option<Log::Position> position)
 {
+  if (generation != this->generation) {
+    return Failure("Failed to append: a preceding append failed");
+  }
+
   if (position.isNone()) {
-    starting = None(); // Reset 'starting' so we try again.
+    abandon(generation);
     return false;
   }
 
+  appended(entry.name());
+
   // Update index so we don't bother reading anything before this
   // position again (if we don't have to).
   index = max(index, position);
@@ -566,7 +672,9 @@ Future<bool> LogStorageProcess::___set(
   // Determine the position that represents the snapshot: if we just
   // wrote a diff then we want to use the existing position of the
   // snapshot, otherwise we just overwrote the snapshot so we should
-  // use the returned position (i.e., do nothing).
+  // use the returned position (i.e., do nothing). The preceding
+  // appends have completed by now, so the snapshot is the entry the
+  // diff was computed from.
   if (diffs > 0) {
     CHECK(snapshots.contains(entry.name()));
     position = snapshots.get(entry.name()).get().position;
@@ -583,30 +691,30 @@ Future<bool> LogStorageProcess::___set(
 
 
 Future<bool> LogStorageProcess::expunge(const Entry& entry)
-{
-  return mutex.lock()
-    .then(defer(self(), &Self::_expunge, entry))
-    .onAny(lambda::bind(&Mutex::unlock, mutex));
-}
-
-
-Future<bool> LogStorageProcess::_expunge(const Entry& entry)
 {
   return start()
-    .then(defer(self(), &Self::__expunge, entry));
+    .then(defer(self(), &Self::_expunge, entry));
 }
 
 
-Future<bool> LogStorageProcess::__expunge(const Entry& entry)
+Future<bool> LogStorageProcess::_expunge(const Entry& entry)
 {
-  Option<Snapshot> snapshot = snapshots.get(entry.name());
+  // Determine the latest version of the entry, which might still be
+  // being appended (or expunged).
+  Option<Entry> latest = None();
+
+  if (appending.contains(entry.name())) {
+    latest = appending.at(entry.name()).entry;
+  } else if (snapshots.contains(entry.name())) {
+    latest = snapshots.at(entry.name()).entry;
+  }
 
-  if (snapshot.isNone()) {
+  if (latest.isNone()) {
     return false;
   }
 
   // Check the version first.
-  if (UUID::fromBytes(snapshot.get().entry.uuid()).get() !=
+  if (UUID::fromBytes(latest.get().uuid()).get() !=
       UUID::fromBytes(entry.uuid()).get()) {
     return false;
   }
@@ -621,20 +729,27 @@ Future<bool> LogStorageProcess::__expunge(const Entry& entry)
     return Failure("Failed to serialize Operation");
   }
 
-  return writer.append(value)
-    .then(defer(self(), &Self::___expunge, entry, lambda::_1));
+  return append(entry.name(), None(), 0, value)
+    .then(defer(self(), &Self::__expunge, entry, generation, lambda::_1));
 }
 
 
-Future<bool> LogStorageProcess::___expunge(
+Future<bool> LogStorageProcess::__expunge(
     const Entry& entry,
+    uint64_t generation,
     const Option<Log::Position>& position)
 {
+  if (generation != this->generation) {
+    return Failure("Failed to append: a preceding append failed");
+  }
+
   if (position.isNone()) {
-    starting = None(); // Reset 'starting' so we try again.
+    abandon(generation);
     return false;
   }
 
+  appended(entry.name());
+
   // Remove from snapshots and truncate the log if possible.
   CHECK(snapshots.contains(entry.name()));
   snapshots.erase(entry.name());
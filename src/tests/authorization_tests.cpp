@@ -14,7 +14,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <iostream>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -24,6 +26,10 @@
 
 #include <mesos/module/authorizer.hpp>
 
+#include <process/future.hpp>
+
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
 #include "authorizer/local/authorizer.hpp"
@@ -37,7 +43,13 @@ namespace mesos {
 namespace internal {
 namespace tests {
 
+using std::cout;
+using std::endl;
 using std::string;
+using std::vector;
+
+using testing::_;
+using testing::Return;
 
 
 template <typename T>
@@ -2451,6 +2463,184 @@ TYPED_TEST(AuthorizationTest, ViewRole)
   }
 }
 
+
+// This tests that a batch of requests is authorized in the same way
+// as the individual requests, and that the results are in order.
+TYPED_TEST(AuthorizationTest, BatchRunTask)
+{
+  ACLs acls;
+  acls.set_permissive(false); // Restrictive.
+
+  {
+    // Principal "foo" can run as "user1".
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->add_values("foo");
+    acl->mutable_users()->add_values("user1");
+  }
+
+  {
+    // Any principal can run as "guest".
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+    acl->mutable_users()->add_values("guest");
+  }
+
+  // Create an `Authorizer` with the ACLs.
+  Try<Authorizer*> create = TypeParam::create(parameterize(acls));
+  ASSERT_SOME(create);
+  Owned<Authorizer> authorizer(create.get());
+
+  auto request = [](const string& principal, const string& user) {
+    authorization::Request request;
+    request.set_action(authorization::RUN_TASK);
+    request.mutable_subject()->set_value(principal);
+
+    TaskInfo taskInfo;
+    taskInfo.mutable_command()->set_user(user);
+
+    request.mutable_object()->mutable_task_info()->CopyFrom(taskInfo);
+
+    return request;
+  };
+
+  vector<authorization::Request> requests = {
+    request("foo", "user1"),
+    request("foo", "user2"),
+    request("bar", "guest"),
+    request("bar", "user1")
+  };
+
+  vector<Future<bool>> authorizations = authorizer->authorized(requests);
+  ASSERT_EQ(4u, authorizations.size());
+
+  AWAIT_EXPECT_TRUE(authorizations[0]);
+  AWAIT_EXPECT_FALSE(authorizations[1]);
+  AWAIT_EXPECT_TRUE(authorizations[2]);
+  AWAIT_EXPECT_FALSE(authorizations[3]);
+
+  // An empty batch has no results.
+  authorizations = authorizer->authorized(vector<authorization::Request>());
+  EXPECT_TRUE(authorizations.empty());
+}
+
+
+// This tests that the default implementation of a batch of requests
+// reports the result of each request separately, i.e., a failed
+// request does not fail the other requests of the batch.
+TEST(AuthorizerTest, BatchFailedRequest)
+{
+  MockAuthorizer authorizer;
+
+  EXPECT_CALL(authorizer, authorized(_))
+    .WillOnce(Return(true))
+    .WillOnce(Return(Failure("Authorization failure")))
+    .WillOnce(Return(false));
+
+  vector<Future<bool>> authorizations =
+    authorizer.authorized(vector<authorization::Request>(3));
+
+  ASSERT_EQ(3u, authorizations.size());
+
+  AWAIT_EXPECT_TRUE(authorizations[0]);
+  AWAIT_EXPECT_FAILED(authorizations[1]);
+  AWAIT_EXPECT_FALSE(authorizations[2]);
+}
+
+
+class LocalAuthorizer_BENCHMARK_Test
+  : public ::testing::Test,
+    public ::testing::WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
+
+
+// The local authorizer benchmark tests are parameterized by the
+// number of ACLs and the number of tasks to authorize.
+INSTANTIATE_TEST_CASE_P(
+    ACLsAndTasks,
+    LocalAuthorizer_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(10U, 100U, 1000U, 5000U),
+      ::testing::Values(1000U, 10000U, 50000U))
+    );
+
+
+// This benchmark measures how long it takes to authorize a batch of
+// tasks (as done by the master when a framework launches tasks)
+// against a large number of `RunTask` ACLs.
+TEST_P(LocalAuthorizer_BENCHMARK_Test, RunTask)
+{
+  size_t aclCount = std::tr1::get<0>(GetParam());
+  size_t taskCount = std::tr1::get<1>(GetParam());
+
+  // Each principal can run tasks as its own user, followed by a
+  // catch-all ACL at the end of the list.
+  ACLs acls;
+  acls.set_permissive(false);
+
+  for (size_t i = 0; i < aclCount; i++) {
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->add_values("principal" + stringify(i));
+    acl->mutable_users()->add_values("user" + stringify(i));
+  }
+
+  {
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+    acl->mutable_users()->add_values("guest");
+  }
+
+  Try<Authorizer*> create = LocalAuthorizer::create(acls);
+  ASSERT_SOME(create);
+  Owned<Authorizer> authorizer(create.get());
+
+  // Half of the tasks run as the principal's user, the other half
+  // fall through to the catch-all ACL.
+  vector<authorization::Request> requests;
+  requests.reserve(taskCount);
+
+  for (size_t i = 0; i < taskCount; i++) {
+    size_t principal = i % aclCount;
+
+    authorization::Request request;
+    request.set_action(authorization::RUN_TASK);
+    request.mutable_subject()->set_value("principal" + stringify(principal));
+    request.mutable_object()->mutable_task_info()->mutable_command()->set_user(
+        i % 2 == 0 ? "user" + stringify(principal) : "guest");
+
+    requests.push_back(request);
+  }
+
+  cout << "Authorizing " << taskCount << " tasks"
+       << " against " << aclCount << " ACLs" << endl;
+
+  Stopwatch watch;
+  watch.start();
+
+  vector<Future<bool>> authorizations;
+  authorizations.reserve(taskCount);
+
+  foreach (const authorization::Request& request, requests) {
+    authorizations.push_back(authorizer->authorized(request));
+  }
+
+  foreach (const Future<bool>& authorization, authorizations) {
+    AWAIT_EXPECT_TRUE(authorization);
+  }
+
+  cout << "Authorized " << taskCount << " tasks"
+       << " in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  authorizations = authorizer->authorized(requests);
+
+  foreach (const Future<bool>& authorization, authorizations) {
+    AWAIT_EXPECT_TRUE(authorization);
+  }
+
+  cout << "Authorized " << taskCount << " tasks"
+       << " in a single batch in " << watch.elapsed() << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
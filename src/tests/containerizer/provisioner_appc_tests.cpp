@@ -56,6 +56,7 @@ using std::list;
 using std::string;
 using std::vector;
 
+using process::Clock;
 using process::Future;
 using process::Owned;
 using process::Process;
@@ -272,6 +273,60 @@ TEST_F(AppcStoreTest, Recover)
 }
 
 
+// This test verifies that the store evicts images once it exceeds
+// '--image_store_size_limit', but not while they are referenced by a
+// provisioned rootfs.
+TEST_F(AppcStoreTest, EvictUnreferencedImage)
+{
+  slave::Flags flags;
+  flags.appc_store_dir = path::join(os::getcwd(), "store");
+  flags.image_store_size_limit = Bytes(1);
+
+  Try<Owned<slave::Store>> store = Store::create(flags);
+  ASSERT_SOME(store);
+
+  Try<string> createImage = createTestImage(
+      flags.appc_store_dir,
+      getManifest());
+
+  ASSERT_SOME(createImage);
+
+  Result<string> imagePath = os::realpath(createImage.get());
+  ASSERT_SOME(imagePath);
+
+  const vector<string> layers = {path::join(imagePath.get(), "rootfs")};
+
+  // Reference the image as the provisioner does for the rootfses it
+  // recovers, before the store itself is recovered.
+  store.get()->acquire(layers);
+
+  AWAIT_READY(store.get()->recover());
+
+  EXPECT_TRUE(os::exists(imagePath.get()));
+
+  JSON::Object metrics = Metrics();
+  EXPECT_EQ(
+      0u,
+      metrics.values["containerizer/mesos/provisioner/appc/store/"
+                     "layer_evictions"]);
+
+  store.get()->release(layers);
+
+  // Wait for the release to be processed.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  EXPECT_FALSE(os::exists(imagePath.get()));
+
+  metrics = Metrics();
+  EXPECT_EQ(
+      1u,
+      metrics.values["containerizer/mesos/provisioner/appc/store/"
+                     "layer_evictions"]);
+}
+
+
 class ProvisionerAppcTest : public AppcStoreTest {};
 
 
@@ -480,6 +535,59 @@ TEST_F(ProvisionerAppcTest, Recover)
 }
 
 
+// This test verifies that the provisioner re-references the store
+// layers of the rootfses it recovers, so that they are not evicted
+// until the recovered container is destroyed.
+TEST_F(ProvisionerAppcTest, RecoverLayerReferences)
+{
+  slave::Flags flags;
+  flags.image_providers = "APPC";
+  flags.appc_store_dir = path::join(os::getcwd(), "store");
+  flags.image_provisioner_backend = "copy";
+  flags.work_dir = path::join(sandbox.get(), "work_dir");
+
+  Try<Owned<Provisioner>> provisioner1 = Provisioner::create(flags);
+  ASSERT_SOME(provisioner1);
+
+  Try<string> createImage = createTestImage(
+      flags.appc_store_dir,
+      getManifest());
+
+  ASSERT_SOME(createImage);
+
+  AWAIT_READY(provisioner1.get()->recover({}));
+
+  Image image;
+  image.mutable_appc()->CopyFrom(getTestImage());
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  AWAIT_READY(provisioner1.get()->provision(containerId, image));
+
+  // Recover with a store size limit which the image exceeds, so that
+  // only the recovered reference keeps the image in the store.
+  flags.image_store_size_limit = Bytes(1);
+
+  Try<Owned<Provisioner>> provisioner2 = Provisioner::create(flags);
+  ASSERT_SOME(provisioner2);
+
+  AWAIT_READY(provisioner2.get()->recover({containerId}));
+
+  EXPECT_TRUE(os::exists(createImage.get()));
+
+  Future<bool> destroy = provisioner2.get()->destroy(containerId);
+  AWAIT_READY(destroy);
+  EXPECT_TRUE(destroy.get());
+
+  // Wait for the release of the image to be processed.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  EXPECT_FALSE(os::exists(createImage.get()));
+}
+
 // This test verifies that the provisioner can recover the rootfses
 // for both parent and child containers.
 TEST_F(ProvisionerAppcTest, RecoverNestedContainer)
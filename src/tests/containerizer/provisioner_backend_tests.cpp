@@ -14,13 +14,22 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#ifdef __linux__
+#include <sys/statvfs.h>
+#endif // __linux__
+
+#include <iostream>
+
 #include <process/gtest.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/os.hpp>
 #include <stout/os/permissions.hpp>
 #include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 
 #include <stout/tests/utils.hpp>
@@ -29,6 +38,8 @@
 #include "linux/fs.hpp"
 #endif // __linux__
 
+#include "slave/paths.hpp"
+
 #include "slave/containerizer/mesos/provisioner/backends/bind.hpp"
 #include "slave/containerizer/mesos/provisioner/backends/copy.hpp"
 #include "slave/containerizer/mesos/provisioner/backends/overlay.hpp"
@@ -39,9 +50,13 @@ using namespace process;
 
 using namespace mesos::internal::slave;
 
+using std::cout;
+using std::endl;
 using std::string;
 using std::vector;
 
+using testing::WithParamInterface;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -251,6 +266,173 @@ TEST_F(CopyBackendTest, ROOT_CopyBackend)
   EXPECT_FALSE(os::exists(rootfs));
 }
 
+
+// Provision a rootfs using multiple layers with the copy backend
+// cloning the layers with reflinks.
+TEST_F(CopyBackendTest, REFLINK_ReflinkBackend)
+{
+  slave::Flags flags;
+  flags.work_dir = path::join(sandbox.get(), "work_dir");
+  flags.image_providers = "DOCKER";
+  flags.docker_store_dir = path::join(sandbox.get(), "store");
+
+  const string provisionerDir =
+    slave::paths::getProvisionerDir(flags.work_dir);
+
+  ASSERT_SOME(os::mkdir(provisionerDir));
+
+  string layer1 = path::join(flags.docker_store_dir, "source1");
+  ASSERT_SOME(os::mkdir(layer1));
+  ASSERT_SOME(os::mkdir(path::join(layer1, "dir1")));
+  ASSERT_SOME(os::write(path::join(layer1, "dir1", "1"), "1"));
+  ASSERT_SOME(os::write(path::join(layer1, "file"), "test1"));
+
+  string layer2 = path::join(flags.docker_store_dir, "source2");
+  ASSERT_SOME(os::mkdir(layer2));
+  ASSERT_SOME(os::mkdir(path::join(layer2, "dir2")));
+  ASSERT_SOME(os::write(path::join(layer2, "dir2", "2"), "2"));
+  ASSERT_SOME(os::write(path::join(layer2, "file"), "test2"));
+
+  string rootfs = path::join(provisionerDir, "rootfs");
+
+  hashmap<string, Owned<Backend>> backends = Backend::create(flags);
+  ASSERT_TRUE(backends.contains("reflink"));
+
+  AWAIT_READY(backends["reflink"]->provision(
+      {layer1, layer2},
+      rootfs,
+      sandbox.get()));
+
+  EXPECT_SOME_EQ("1", os::read(path::join(rootfs, "dir1", "1")));
+  EXPECT_SOME_EQ("2", os::read(path::join(rootfs, "dir2", "2")));
+
+  // Last layer should overwrite existing file.
+  EXPECT_SOME_EQ("test2", os::read(path::join(rootfs, "file")));
+
+  // Writing to the rootfs must not modify the cloned layer.
+  ASSERT_SOME(os::write(path::join(rootfs, "file"), "rootfs"));
+  EXPECT_SOME_EQ("rootfs", os::read(path::join(rootfs, "file")));
+  EXPECT_SOME_EQ("test2", os::read(path::join(layer2, "file")));
+
+  AWAIT_READY(backends["reflink"]->destroy(rootfs));
+
+  EXPECT_FALSE(os::exists(rootfs));
+  EXPECT_TRUE(os::exists(path::join(layer2, "file")));
+}
+
+
+
+#ifdef __linux__
+class ProvisionerBackend_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<string>
+{
+protected:
+  // Returns the free space of the filesystem holding 'path' after
+  // flushing the pending writes, which may not have been allocated
+  // on disk yet.
+  static Bytes available(const string& path)
+  {
+    ::sync();
+
+    struct statvfs buf;
+    EXPECT_EQ(0, ::statvfs(path.c_str(), &buf));
+
+    return Bytes(buf.f_bavail * buf.f_frsize);
+  }
+};
+
+
+// The backend benchmark tests are parameterized by the backend, which
+// all copy the layers into the rootfs. The 'reflink' backend is only
+// available if the sandbox is on a filesystem supporting reflinks
+// (e.g., XFS, btrfs), otherwise its instantiation is filtered.
+INSTANTIATE_TEST_CASE_P(
+    Copy,
+    ProvisionerBackend_BENCHMARK_Test,
+    ::testing::Values(string("copy")));
+
+
+INSTANTIATE_TEST_CASE_P(
+    REFLINK_Reflink,
+    ProvisionerBackend_BENCHMARK_Test,
+    ::testing::Values(string("reflink")));
+
+
+// Measures the time it takes to provision rootfses from a multi-layer
+// image and the disk space written for them.
+TEST_P(ProvisionerBackend_BENCHMARK_Test, Provision)
+{
+  const string backend = GetParam();
+
+  slave::Flags flags;
+  flags.work_dir = path::join(sandbox.get(), "work_dir");
+  flags.image_providers = "DOCKER";
+  flags.docker_store_dir = path::join(sandbox.get(), "store");
+
+  const string provisionerDir =
+    slave::paths::getProvisionerDir(flags.work_dir);
+
+  ASSERT_SOME(os::mkdir(provisionerDir));
+  ASSERT_SOME(os::mkdir(flags.docker_store_dir));
+
+  hashmap<string, Owned<Backend>> backends = Backend::create(flags);
+  ASSERT_TRUE(backends.contains(backend));
+
+  const size_t layerCount = 4;
+  const size_t fileCount = 32;
+  const Bytes fileSize = Megabytes(1);
+
+  vector<string> layers;
+  for (size_t i = 0; i < layerCount; i++) {
+    const string layer =
+      path::join(flags.docker_store_dir, "layer" + stringify(i));
+
+    ASSERT_SOME(os::mkdir(layer));
+
+    for (size_t j = 0; j < fileCount; j++) {
+      ASSERT_SOME(os::write(
+          path::join(layer, "file" + stringify(j)),
+          string(fileSize.bytes(), 'a' + i)));
+    }
+
+    layers.push_back(layer);
+  }
+
+  const size_t count = 10;
+
+  vector<string> rootfses;
+  for (size_t i = 0; i < count; i++) {
+    rootfses.push_back(path::join(provisionerDir, "rootfs" + stringify(i)));
+  }
+
+  const Bytes before = available(sandbox.get());
+
+  Stopwatch watch;
+  watch.start();
+
+  foreach (const string& rootfs, rootfses) {
+    AWAIT_READY_FOR(
+        backends[backend]->provision(layers, rootfs, sandbox.get()),
+        Minutes(5));
+  }
+
+  const Duration elapsed = watch.elapsed();
+
+  const Bytes after = available(sandbox.get());
+
+  cout << "Provisioned " << count << " rootfses from " << layerCount
+       << " layers of " << fileSize * fileCount << " with the '" << backend
+       << "' backend in " << elapsed << " ("
+       << (before > after ? before - after : Bytes(0)) << " written)"
+       << endl;
+
+  foreach (const string& rootfs, rootfses) {
+    AWAIT_READY_FOR(backends[backend]->destroy(rootfs), Minutes(5));
+  }
+}
+#endif // __linux__
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -16,18 +16,27 @@
 
 #include <gmock/gmock.h>
 
+#include <set>
+
 #include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
 #include <stout/stringify.hpp>
 
+#include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/owned.hpp>
+#include <process/shared.hpp>
 
 #include <mesos/docker/spec.hpp>
 
+#include <mesos/uri/fetcher.hpp>
+
+#include "common/command_utils.hpp"
+
 #include "slave/containerizer/mesos/provisioner/docker/metadata_manager.hpp"
 #include "slave/containerizer/mesos/provisioner/docker/paths.hpp"
 #include "slave/containerizer/mesos/provisioner/docker/puller.hpp"
@@ -45,13 +54,17 @@ namespace paths = mesos::internal::slave::docker::paths;
 namespace slave = mesos::internal::slave;
 namespace spec = ::docker::spec;
 
+using std::set;
 using std::string;
 using std::vector;
 
+using process::Clock;
+using process::Failure;
 using process::Future;
 using process::Owned;
 using process::PID;
 using process::Promise;
+using process::Shared;
 
 using master::Master;
 
@@ -64,6 +77,8 @@ using slave::docker::Puller;
 using slave::docker::RegistryPuller;
 using slave::docker::Store;
 
+using testing::Property;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -317,6 +332,419 @@ TEST_F(ProvisionerDockerLocalStoreTest, PullingSameImageSimutanuously)
 }
 
 
+// This test verifies that the store evicts layers once it exceeds
+// '--image_store_size_limit', but not while they are referenced by
+// the caller of 'get()'.
+TEST_F(ProvisionerDockerLocalStoreTest, EvictUnreferencedLayer)
+{
+  slave::Flags flags;
+  flags.docker_store_dir = path::join(os::getcwd(), "store");
+  flags.image_store_size_limit = Bytes(1);
+
+  MockPuller* puller = new MockPuller();
+  Future<string> directory;
+  Promise<vector<string>> promise;
+
+  EXPECT_CALL(*puller, pull(_, _))
+    .WillOnce(testing::DoAll(FutureArg<1>(&directory),
+                             Return(promise.future())));
+
+  Try<Owned<slave::Store>> store =
+      slave::docker::Store::create(flags, Owned<Puller>(puller));
+  ASSERT_SOME(store);
+
+  AWAIT_READY(store.get()->recover());
+
+  Image mesosImage;
+  mesosImage.set_type(Image::DOCKER);
+  mesosImage.mutable_docker()->set_name("abc");
+
+  Future<slave::ImageInfo> imageInfo = store.get()->get(mesosImage);
+  AWAIT_READY(directory);
+
+  const string layerPath = path::join(directory.get(), "456");
+  const string rootfs = paths::getImageLayerRootfsPath(layerPath);
+
+  ASSERT_SOME(os::mkdir(rootfs));
+  ASSERT_SOME(os::write(path::join(rootfs, "test"), "test"));
+
+  JSON::Value manifest = JSON::parse(
+        "{"
+        "  \"parent\": \"\""
+        "}").get();
+
+  ASSERT_SOME(os::write(
+      paths::getImageLayerManifestPath(layerPath),
+      stringify(manifest)));
+
+  promise.set(vector<string>({"456"}));
+
+  AWAIT_READY(imageInfo);
+
+  // Wait for the store to try to evict the layer after the 'get()'.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  const string storeLayerPath =
+    paths::getImageLayerPath(flags.docker_store_dir, "456");
+
+  EXPECT_TRUE(os::exists(storeLayerPath));
+
+  JSON::Object metrics = Metrics();
+  EXPECT_EQ(
+      0u,
+      metrics.values["containerizer/mesos/provisioner/docker/store/"
+                     "layer_evictions"]);
+
+  store.get()->release(imageInfo->layers);
+
+  // Wait for the release to be processed.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  EXPECT_FALSE(os::exists(storeLayerPath));
+
+  metrics = Metrics();
+  EXPECT_EQ(
+      1u,
+      metrics.values["containerizer/mesos/provisioner/docker/store/"
+                     "layer_evictions"]);
+}
+
+
+// A fake registry which serves the manifest and the blobs of a single
+// image from memory, so that the registry puller can be tested
+// without a network connection.
+class MockRegistryFetcherPlugin : public uri::Fetcher::Plugin
+{
+public:
+  MockRegistryFetcherPlugin(
+      const string& _manifest,
+      const hashmap<string, string>& _blobs)
+    : manifest(_manifest),
+      blobs(_blobs)
+  {
+    EXPECT_CALL(*this, fetch(_, _))
+      .WillRepeatedly(Invoke(this, &MockRegistryFetcherPlugin::unmocked_fetch));
+  }
+
+  virtual ~MockRegistryFetcherPlugin() {}
+
+  virtual set<string> schemes() const
+  {
+    return {"docker-manifest", "docker-blob"};
+  }
+
+  virtual string name() const
+  {
+    return "docker";
+  }
+
+  MOCK_CONST_METHOD2(
+      fetch,
+      Future<Nothing>(const URI&, const string&));
+
+  Future<Nothing> unmocked_fetch(const URI& uri, const string& directory)
+  {
+    if (uri.scheme() == "docker-manifest") {
+      Try<Nothing> write = os::write(
+          path::join(directory, "manifest"),
+          manifest);
+
+      if (write.isError()) {
+        return Failure(write.error());
+      }
+
+      return Nothing();
+    }
+
+    // The digest of a blob is the query of its URI, see
+    // `uri::docker::blob`.
+    if (!blobs.contains(uri.query())) {
+      return Failure("Unknown blob '" + uri.query() + "'");
+    }
+
+    Try<Nothing> write = os::write(
+        path::join(directory, uri.query()),
+        blobs.at(uri.query()));
+
+    if (write.isError()) {
+      return Failure(write.error());
+    }
+
+    return Nothing();
+  }
+
+private:
+  const string manifest;
+  const hashmap<string, string> blobs;
+};
+
+
+class RegistryPullerTest : public TemporaryDirectoryTest
+{
+protected:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    // Create one blob per layer, starting with the base layer.
+    layerIds = {"base", "middle", "top"};
+
+    foreach (const string& layerId, layerIds) {
+      const string layer = path::join(sandbox.get(), "layers", layerId);
+      const string tar = path::join(sandbox.get(), "blobs", layerId);
+
+      ASSERT_SOME(os::mkdir(layer));
+      ASSERT_SOME(os::mkdir(Path(tar).dirname()));
+      ASSERT_SOME(os::write(path::join(layer, layerId), layerId));
+
+      AWAIT_READY(command::tar(Path("."), Path(tar), Path(layer)));
+
+      Future<string> sha256 = command::sha256(Path(tar));
+      AWAIT_READY(sha256);
+
+      Try<string> blob = os::read(tar);
+      ASSERT_SOME(blob);
+
+      digests[layerId] = "sha256:" + sha256.get();
+      blobs[digests[layerId]] = blob.get();
+    }
+
+    flags.docker_registry = "https://registry.test";
+    flags.docker_store_dir = path::join(sandbox.get(), "store");
+    flags.docker_registry_fetch_concurrency = 1;
+
+    directory = path::join(sandbox.get(), "staging");
+    ASSERT_SOME(os::mkdir(directory));
+  }
+
+  // Returns a schema 1 manifest of the image, whose 'fsLayers' and
+  // 'history' list the layers starting with the top layer.
+  string getManifest() const
+  {
+    JSON::Array fsLayers;
+    JSON::Array history;
+
+    for (size_t i = layerIds.size(); i > 0; i--) {
+      const string& layerId = layerIds[i - 1];
+
+      JSON::Object v1;
+      v1.values["id"] = layerId;
+      if (i > 1) {
+        v1.values["parent"] = layerIds[i - 2];
+      }
+
+      JSON::Object fsLayer;
+      fsLayer.values["blobSum"] = digests.at(layerId);
+      fsLayers.values.push_back(fsLayer);
+
+      JSON::Object v1Compatibility;
+      v1Compatibility.values["v1Compatibility"] = stringify(v1);
+      history.values.push_back(v1Compatibility);
+    }
+
+    JSON::Object jwk;
+    jwk.values["crv"] = "P-256";
+    jwk.values["kid"] = "kid";
+    jwk.values["kty"] = "EC";
+    jwk.values["x"] = "x";
+    jwk.values["y"] = "y";
+
+    JSON::Object header;
+    header.values["jwk"] = jwk;
+    header.values["alg"] = "ES256";
+
+    JSON::Object signature;
+    signature.values["header"] = header;
+    signature.values["signature"] = "signature";
+    signature.values["protected"] = "protected";
+
+    JSON::Array signatures;
+    signatures.values.push_back(signature);
+
+    JSON::Object manifest;
+    manifest.values["name"] = "library/test";
+    manifest.values["tag"] = "latest";
+    manifest.values["architecture"] = "amd64";
+    manifest.values["fsLayers"] = fsLayers;
+    manifest.values["history"] = history;
+    manifest.values["schemaVersion"] = 1;
+    manifest.values["signatures"] = signatures;
+
+    return stringify(manifest);
+  }
+
+  Try<Owned<Puller>> createPuller(MockRegistryFetcherPlugin* plugin)
+  {
+    vector<Owned<uri::Fetcher::Plugin>> plugins;
+    plugins.push_back(Owned<uri::Fetcher::Plugin>(plugin));
+
+    return RegistryPuller::create(
+        flags,
+        Shared<uri::Fetcher>(new uri::Fetcher(plugins)));
+  }
+
+  slave::Flags flags;
+  string directory;
+
+  vector<string> layerIds;
+  hashmap<string, string> digests;
+  hashmap<string, string> blobs;
+};
+
+
+// This test verifies that the pipelined registry puller does not
+// fetch more than `--docker_registry_fetch_concurrency` blobs at a
+// time, and that it extracts every layer of the image.
+TEST_F(RegistryPullerTest, FetchConcurrency)
+{
+  MockRegistryFetcherPlugin* plugin =
+    new MockRegistryFetcherPlugin(getManifest(), blobs);
+
+  Future<URI> blob1;
+  Future<URI> blob2;
+  Future<URI> blob3;
+  Promise<Nothing> promise1;
+  Promise<Nothing> promise2;
+  Promise<Nothing> promise3;
+
+  EXPECT_CALL(*plugin, fetch(_, _))
+    .WillOnce(Invoke(plugin, &MockRegistryFetcherPlugin::unmocked_fetch))
+    .WillOnce(testing::DoAll(FutureArg<0>(&blob1), Return(promise1.future())))
+    .WillOnce(testing::DoAll(FutureArg<0>(&blob2), Return(promise2.future())))
+    .WillOnce(testing::DoAll(FutureArg<0>(&blob3), Return(promise3.future())));
+
+  Try<Owned<Puller>> puller = createPuller(plugin);
+  ASSERT_SOME(puller);
+
+  spec::ImageReference reference;
+  reference.set_repository("library/test");
+
+  Future<vector<string>> layers = puller.get()->pull(reference, directory);
+
+  // The blobs are fetched one by one, starting with the base layer.
+  AWAIT_READY(blob1);
+  EXPECT_EQ(digests["base"], blob1->query());
+
+  Clock::pause();
+  Clock::settle();
+
+  EXPECT_TRUE(blob2.isPending());
+
+  Clock::resume();
+
+  ASSERT_SOME(os::write(
+      path::join(directory, blob1->query()),
+      blobs[blob1->query()]));
+
+  promise1.set(Nothing());
+
+  AWAIT_READY(blob2);
+  EXPECT_EQ(digests["middle"], blob2->query());
+
+  Clock::pause();
+  Clock::settle();
+
+  EXPECT_TRUE(blob3.isPending());
+
+  Clock::resume();
+
+  ASSERT_SOME(os::write(
+      path::join(directory, blob2->query()),
+      blobs[blob2->query()]));
+
+  promise2.set(Nothing());
+
+  AWAIT_READY(blob3);
+  EXPECT_EQ(digests["top"], blob3->query());
+
+  ASSERT_SOME(os::write(
+      path::join(directory, blob3->query()),
+      blobs[blob3->query()]));
+
+  promise3.set(Nothing());
+
+  AWAIT_READY(layers);
+  EXPECT_EQ(layerIds, layers.get());
+
+  foreach (const string& layerId, layerIds) {
+    const string rootfs =
+      paths::getImageLayerRootfsPath(path::join(directory, layerId));
+
+    EXPECT_SOME_EQ(layerId, os::read(path::join(rootfs, layerId)));
+    EXPECT_FALSE(os::exists(path::join(directory, digests[layerId])));
+  }
+}
+
+
+// This test verifies that the pipelined registry puller rejects a
+// blob whose content does not match its digest in the manifest.
+TEST_F(RegistryPullerTest, DigestMismatch)
+{
+  // Serve the top layer in place of the middle layer.
+  blobs[digests["middle"]] = blobs[digests["top"]];
+
+  MockRegistryFetcherPlugin* plugin =
+    new MockRegistryFetcherPlugin(getManifest(), blobs);
+
+  Try<Owned<Puller>> puller = createPuller(plugin);
+  ASSERT_SOME(puller);
+
+  spec::ImageReference reference;
+  reference.set_repository("library/test");
+
+  Future<vector<string>> layers = puller.get()->pull(reference, directory);
+
+  AWAIT_FAILED(layers);
+  EXPECT_TRUE(strings::contains(
+      layers.failure(),
+      "Digest mismatch for blob '" + digests["middle"] + "'"));
+}
+
+
+// This test verifies that the pipelined registry puller does not
+// fetch the blobs of the layers which are already in the store.
+TEST_F(RegistryPullerTest, SkipExistingLayer)
+{
+  ASSERT_SOME(os::mkdir(
+      paths::getImageLayerPath(flags.docker_store_dir, "base")));
+
+  MockRegistryFetcherPlugin* plugin =
+    new MockRegistryFetcherPlugin(getManifest(), blobs);
+
+  EXPECT_CALL(*plugin, fetch(Property(&URI::query, digests["base"]), _))
+    .Times(0);
+
+  Try<Owned<Puller>> puller = createPuller(plugin);
+  ASSERT_SOME(puller);
+
+  spec::ImageReference reference;
+  reference.set_repository("library/test");
+
+  Future<vector<string>> layers = puller.get()->pull(reference, directory);
+
+  // The skipped layer is still part of the image.
+  AWAIT_READY(layers);
+  EXPECT_EQ(layerIds, layers.get());
+
+  EXPECT_FALSE(os::exists(path::join(directory, "base")));
+  EXPECT_TRUE(os::exists(path::join(directory, "middle")));
+  EXPECT_TRUE(os::exists(path::join(directory, "top")));
+
+  JSON::Object metrics = Metrics();
+  ASSERT_EQ(
+      1u,
+      metrics.values.count(
+          "containerizer/mesos/provisioner/docker/layers_skipped"));
+  EXPECT_EQ(
+      1,
+      metrics.values["containerizer/mesos/provisioner/docker/layers_skipped"]);
+}
+
+
 #ifdef __linux__
 class ProvisionerDockerPullerTest : public MesosTest {};
 
@@ -475,6 +903,85 @@ TEST_F(ProvisionerDockerPullerTest, ROOT_INTERNET_CURL_SimpleCommand)
 }
 
 
+// This test verifies that an image can be pulled from the registry
+// in the pipelined mode, i.e., with layers being extracted while the
+// other blobs are still being fetched.
+//
+// TODO(jieyu): This is a ROOT test because of MESOS-4757. Remove the
+// ROOT restriction after MESOS-4757 is resolved.
+TEST_F(ProvisionerDockerPullerTest, ROOT_INTERNET_CURL_PipelinedPull)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.isolation = "docker/runtime,filesystem/linux";
+  flags.image_providers = "docker";
+  flags.docker_registry_fetch_concurrency = 1;
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_EQ(1u, offers->size());
+
+  const Offer& offer = offers.get()[0];
+
+  CommandInfo command;
+  command.set_shell(false);
+  command.set_value("/bin/ls");
+  command.add_arguments("ls");
+  command.add_arguments("-al");
+  command.add_arguments("/");
+
+  TaskInfo task = createTask(
+      offer.slave_id(),
+      Resources::parse("cpus:1;mem:128").get(),
+      command);
+
+  Image image;
+  image.set_type(Image::DOCKER);
+  image.mutable_docker()->set_name("library/alpine");
+
+  ContainerInfo* container = task.mutable_container();
+  container->set_type(ContainerInfo::MESOS);
+  container->mutable_mesos()->mutable_image()->CopyFrom(image);
+
+  Future<TaskStatus> statusRunning;
+  Future<TaskStatus> statusFinished;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&statusRunning))
+    .WillOnce(FutureArg<1>(&statusFinished));
+
+  driver.launchTasks(offer.id(), {task});
+
+  AWAIT_READY_FOR(statusRunning, Seconds(60));
+  EXPECT_EQ(task.task_id(), statusRunning->task_id());
+  EXPECT_EQ(TASK_RUNNING, statusRunning->state());
+
+  AWAIT_READY(statusFinished);
+  EXPECT_EQ(task.task_id(), statusFinished->task_id());
+  EXPECT_EQ(TASK_FINISHED, statusFinished->state());
+
+  driver.stop();
+  driver.join();
+}
+
+
 // This test verifies the normalization of the Docker repository name.
 // For official Docker images, users can omit the 'library/' prefix
 // when specifying the repository name (e.g., 'busybox').
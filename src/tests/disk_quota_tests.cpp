@@ -32,6 +32,8 @@
 #include <stout/path.hpp>
 #include <stout/try.hpp>
 
+#include "common/disk_usage.hpp"
+
 #include "master/master.hpp"
 
 #include "slave/constants.hpp"
@@ -172,6 +174,100 @@ TEST_F(DiskUsageCollectorTest, ExcludeRelativePath)
 #endif
 
 
+// This test verifies that a file which grows in a directory that has
+// not been modified since the previous check (whose listing is thus
+// reused) is accounted for, as well as a file created afterwards.
+TEST_F(DiskUsageCollectorTest, RepeatedCheck)
+{
+  string dir = path::join(os::getcwd(), "dir");
+  string file1 = path::join(dir, "file1");
+  string file2 = path::join(dir, "file2");
+
+  ASSERT_SOME(os::mkdir(dir));
+  ASSERT_SOME(os::write(file1, string(Kilobytes(8).bytes(), 'x')));
+
+  // Make sure that the directories are not modified in the same
+  // second in which they are listed, otherwise their listings are
+  // not reused.
+  os::sleep(Seconds(1));
+
+  DiskUsageCollector collector(Milliseconds(1));
+
+  Future<Bytes> usage1 = collector.usage(os::getcwd(), {});
+  AWAIT_READY(usage1);
+  EXPECT_GE(usage1.get(), Kilobytes(8));
+  EXPECT_LT(usage1.get(), Kilobytes(128));
+
+  // Grow 'file1', which does not modify 'dir'.
+  ASSERT_SOME(os::write(file1, string(Kilobytes(128).bytes(), 'x')));
+
+  Future<Bytes> usage2 = collector.usage(os::getcwd(), {});
+  AWAIT_READY(usage2);
+  EXPECT_GE(usage2.get(), Kilobytes(128));
+  EXPECT_LT(usage2.get(), Kilobytes(256));
+
+  ASSERT_SOME(os::write(file2, string(Kilobytes(128).bytes(), 'y')));
+
+  Future<Bytes> usage3 = collector.usage(os::getcwd(), {});
+  AWAIT_READY(usage3);
+  EXPECT_GE(usage3.get(), Kilobytes(256));
+}
+
+
+// This test verifies that a file with multiple hard links is only
+// counted once.
+TEST_F(DiskUsageCollectorTest, HardLink)
+{
+  string file = path::join(os::getcwd(), "file");
+  ASSERT_SOME(os::write(file, string(Kilobytes(128).bytes(), 'x')));
+
+  string link = path::join(os::getcwd(), "link");
+  ASSERT_EQ(0, ::link(file.c_str(), link.c_str()));
+
+  DiskUsageCollector collector(Milliseconds(1));
+
+  Future<Bytes> usage = collector.usage(os::getcwd(), {});
+  AWAIT_READY(usage);
+  EXPECT_GE(usage.get(), Kilobytes(128));
+  EXPECT_LT(usage.get(), Kilobytes(256));
+}
+
+
+// This test verifies that a cached listing is not reused once the
+// directory is modified, and that the listings of the least recently
+// walked directories are dropped once the cache is full.
+TEST(DiskUsageCacheTest, Capacity)
+{
+  DiskUsageCache cache(3);
+
+  const DiskUsageCache::Version a = {1, 1, 0};
+  const DiskUsageCache::Version b = {1, 2, 0};
+  const DiskUsageCache::Version c = {1, 3, 0};
+
+  cache.put("a", a, {"1", "2"});
+  ASSERT_TRUE(cache.get("a", a) != nullptr);
+  EXPECT_EQ(2u, cache.get("a", a)->size());
+
+  DiskUsageCache::Version modified = a;
+  modified.modified++;
+
+  EXPECT_TRUE(cache.get("a", modified) == nullptr);
+  EXPECT_TRUE(cache.get("a", a) == nullptr);
+
+  cache.put("a", a, {"1", "2"});
+  cache.put("b", b, {"3"});
+
+  // Walking 'a' again makes 'b' the least recently walked directory.
+  EXPECT_TRUE(cache.get("a", a) != nullptr);
+
+  cache.put("c", c, {"4"});
+
+  EXPECT_TRUE(cache.get("a", a) != nullptr);
+  EXPECT_TRUE(cache.get("b", b) == nullptr);
+  EXPECT_TRUE(cache.get("c", c) != nullptr);
+}
+
+
 class DiskQuotaTest : public MesosTest {};
 
 
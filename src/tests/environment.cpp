@@ -57,6 +57,8 @@
 
 #include "logging/logging.hpp"
 
+#include "slave/containerizer/mesos/provisioner/backends/copy.hpp"
+
 #include "tests/environment.hpp"
 #include "tests/flags.hpp"
 #include "tests/utils.hpp"
@@ -629,6 +631,36 @@ private:
 };
 
 
+class ReflinkFilter : public TestFilter
+{
+public:
+  ReflinkFilter()
+  {
+    // The tests create their sandboxes in the temporary directory.
+    Try<Nothing> check =
+      slave::CopyBackend::checkReflink(os::temp(), os::temp());
+
+    if (check.isError()) {
+      reflinkError = check.error();
+
+      std::cerr
+        << "-------------------------------------------------------------\n"
+        << "We cannot run any reflink tests because:\n"
+        << reflinkError->message << "\n"
+        << "-------------------------------------------------------------\n";
+    }
+  }
+
+  bool disable(const ::testing::TestInfo* test) const
+  {
+    return matches(test, "REFLINK_") && reflinkError.isSome();
+  }
+
+private:
+  Option<Error> reflinkError;
+};
+
+
 class RootFilter : public TestFilter
 {
 public:
@@ -756,6 +788,7 @@ Environment::Environment(const Flags& _flags) : flags(_flags)
   filters.push_back(Owned<TestFilter>(new OverlayFSFilter()));
   filters.push_back(Owned<TestFilter>(new PerfCPUCyclesFilter()));
   filters.push_back(Owned<TestFilter>(new PerfFilter()));
+  filters.push_back(Owned<TestFilter>(new ReflinkFilter()));
   filters.push_back(Owned<TestFilter>(new RootFilter()));
   filters.push_back(Owned<TestFilter>(new UnzipFilter()));
   filters.push_back(Owned<TestFilter>(new XfsFilter()));
@@ -238,6 +238,98 @@ TEST_F(FilesTest, ReadTest)
 }
 
 
+// Tests that the raw contents of a file, or a range of them, can be
+// read with 'raw=true'.
+TEST_F(FilesTest, ReadRawTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::write("file", "body"));
+  AWAIT_EXPECT_READY(files.attach("file", "myname"));
+
+  Future<Response> response =
+    process::http::get(upid, "read", "path=myname&raw=true");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes", "Accept-Ranges", response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("body", response);
+
+  process::http::Headers headers;
+  headers["Range"] = "bytes=1-2";
+
+  response = process::http::get(upid, "read", "path=myname&raw=true", headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      process::http::Status::string(
+          process::http::Status::PARTIAL_CONTENT),
+      response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 1-2/4", "Content-Range", response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("od", response);
+
+  // The range is given by the 'Range' header only.
+  response = process::http::get(upid, "read", "path=myname&raw=true&offset=1");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, response);
+
+  // Missing file.
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      NotFound().status,
+      process::http::get(upid, "read", "path=missing&raw=true"));
+}
+
+
+// Tests that a read with 'follow=true' at the end of a file returns
+// the data appended to the file.
+TEST_F(FilesTest, ReadFollowTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::write("file", "body"));
+  AWAIT_EXPECT_READY(files.attach("file", "myname"));
+
+  // Appends to the file, rather than rewriting it, so that the file
+  // does not appear truncated while it is being followed.
+  auto append = [](const string& data) {
+    Try<int> fd = os::open("file", O_WRONLY | O_APPEND | O_CLOEXEC);
+    ASSERT_SOME(fd);
+    ASSERT_SOME(os::write(fd.get(), data));
+    ASSERT_SOME(os::close(fd.get()));
+  };
+
+  Future<Response> response =
+    process::http::get(upid, "read", "path=myname&offset=4&follow=true");
+
+  append(" more");
+
+  JSON::Object expected;
+  expected.values["offset"] = 4;
+  expected.values["data"] = " more";
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+
+  // Follow the raw contents of the file from the end of the file.
+  process::http::Headers headers;
+  headers["Range"] = "bytes=9-";
+
+  response = process::http::get(
+      upid,
+      "read",
+      "path=myname&raw=true&follow=true",
+      headers);
+
+  append(" data");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      process::http::Status::string(
+          process::http::Status::PARTIAL_CONTENT),
+      response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(" data", response);
+}
+
+
 TEST_F(FilesTest, ResolveTest)
 {
   Files files;
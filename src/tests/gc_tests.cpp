@@ -16,6 +16,7 @@
 
 #include <list>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -25,6 +26,7 @@
 #include <mesos/resources.hpp>
 #include <mesos/scheduler.hpp>
 
+#include <process/collect.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
@@ -39,6 +41,7 @@
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/synchronized.hpp>
 
 #ifdef __linux__
 #include "linux/fs.hpp"
@@ -58,6 +61,7 @@
 
 #include "tests/containerizer.hpp"
 #include "tests/mesos.hpp"
+#include "tests/mock_slave.hpp"
 #include "tests/utils.hpp"
 
 using mesos::internal::master::Master;
@@ -81,6 +85,7 @@ using std::vector;
 
 using testing::_;
 using testing::AtMost;
+using testing::Invoke;
 using testing::Return;
 using testing::SaveArg;
 
@@ -200,6 +205,36 @@ TEST_F(GarbageCollectorTest, Unschedule)
 }
 
 
+// This test verifies that unscheduling a path whose removal has
+// started only completes once the path has been removed, so that the
+// path can be safely reused afterwards.
+TEST_F(GarbageCollectorTest, UnscheduleRemoving)
+{
+  GarbageCollector gc;
+
+  const string& dir = "dir";
+
+  ASSERT_SOME(os::mkdir(path::join(dir, "sub")));
+  ASSERT_SOME(os::touch(path::join(dir, "sub", "file")));
+
+  Clock::pause();
+
+  Future<Nothing> schedule = gc.schedule(Seconds(10), dir);
+
+  // Trigger the removal of the directory.
+  Clock::advance(Seconds(10));
+  Clock::settle();
+
+  AWAIT_ASSERT_FALSE(gc.unschedule(dir));
+
+  EXPECT_FALSE(os::exists(dir));
+
+  AWAIT_READY(schedule);
+
+  Clock::resume();
+}
+
+
 TEST_F(GarbageCollectorTest, Prune)
 {
   GarbageCollector gc;
@@ -254,7 +289,97 @@ TEST_F(GarbageCollectorTest, Prune)
 }
 
 
-class GarbageCollectorIntegrationTest : public MesosTest {};
+// This test verifies that the removals and the reclaimed bytes are
+// reported in the metrics.
+TEST_F(GarbageCollectorTest, Metrics)
+{
+  GarbageCollector gc;
+
+  const string& dir = "dir";
+  const string& file = path::join(dir, "file");
+
+  ASSERT_SOME(os::mkdir(dir));
+  ASSERT_SOME(os::write(file, string(Kilobytes(64).bytes(), 'x')));
+
+  Clock::pause();
+
+  Future<Nothing> schedule1 = gc.schedule(Seconds(10), dir);
+  Future<Nothing> schedule2 = gc.schedule(Seconds(10), "missing");
+
+  Clock::advance(Seconds(10));
+  Clock::settle();
+
+  AWAIT_READY(schedule1);
+  AWAIT_FAILED(schedule2);
+
+  EXPECT_FALSE(os::exists(dir));
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(0, metrics.values["gc/path_removals_pending"]);
+  EXPECT_EQ(1, metrics.values["gc/path_removals_succeeded"]);
+  EXPECT_EQ(1, metrics.values["gc/path_removals_failed"]);
+
+#ifndef __WINDOWS__
+  ASSERT_EQ(1u, metrics.values.count("gc/bytes_reclaimed"));
+  ASSERT_TRUE(metrics.values["gc/bytes_reclaimed"].is<JSON::Number>());
+  EXPECT_LE(
+      Kilobytes(64).bytes(),
+      metrics.values["gc/bytes_reclaimed"].as<JSON::Number>().as<uint64_t>());
+#endif // __WINDOWS__
+
+  Clock::resume();
+}
+
+
+class GarbageCollectorIntegrationTest : public MesosTest
+{
+protected:
+  GarbageCollectorIntegrationTest()
+  {
+    // Forward the agent's calls to a real garbage collector, keeping
+    // the futures of the removals it schedules.
+    EXPECT_CALL(gc, schedule(_, _))
+      .WillRepeatedly(
+          Invoke(this, &GarbageCollectorIntegrationTest::schedule));
+
+    EXPECT_CALL(gc, unschedule(_))
+      .WillRepeatedly(Invoke(&collector, &GarbageCollector::unschedule));
+
+    EXPECT_CALL(gc, prune(_))
+      .WillRepeatedly(Invoke(&collector, &GarbageCollector::prune));
+  }
+
+  // Returns a future that is satisfied once every removal the agent
+  // has scheduled so far has completed. Paths are removed on a thread
+  // that 'Clock::settle()' does not wait for, hence the tests await
+  // this future before looking at the filesystem.
+  Future<list<Future<Nothing>>> removed()
+  {
+    synchronized (mutex) {
+      return process::await(removals);
+    }
+  }
+
+  MockGarbageCollector gc;
+
+private:
+  Future<Nothing> schedule(const Duration& d, const string& path)
+  {
+    Future<Nothing> removal = collector.schedule(d, path);
+
+    synchronized (mutex) {
+      removals.push_back(removal);
+    }
+
+    return removal;
+  }
+
+  GarbageCollector collector;
+
+  std::mutex mutex;
+  list<Future<Nothing>> removals;
+};
 
 
 // This test ensures that garbage collection removes
@@ -352,7 +477,7 @@ TEST_F(GarbageCollectorIntegrationTest, Restart)
   Future<Nothing> schedule =
     FUTURE_DISPATCH(_, &GarbageCollectorProcess::schedule);
 
-  slave = StartSlave(detector.get(), flags);
+  slave = StartSlave(detector.get(), &gc, flags);
   ASSERT_SOME(slave);
 
   AWAIT_READY(schedule);
@@ -363,6 +488,8 @@ TEST_F(GarbageCollectorIntegrationTest, Restart)
 
   Clock::settle();
 
+  AWAIT_READY(removed());
+
   // By this time the old slave directory should be cleaned up.
   ASSERT_FALSE(os::exists(slaveDir));
 
@@ -389,7 +516,7 @@ TEST_F(GarbageCollectorIntegrationTest, ExitedFramework)
   Owned<MasterDetector> detector = master.get()->createDetector();
 
   Try<Owned<cluster::Slave>> slave =
-    StartSlave(detector.get(), &containerizer, flags);
+    StartSlave(detector.get(), &containerizer, &gc, flags);
   ASSERT_SOME(slave);
 
   AWAIT_READY(slaveRegisteredMessage);
@@ -474,6 +601,8 @@ TEST_F(GarbageCollectorIntegrationTest, ExitedFramework)
 
   Clock::settle();
 
+  AWAIT_READY(removed());
+
   // Framework's directory should be gc'ed by now.
   const string& frameworkDir = slave::paths::getFrameworkPath(
       flags.work_dir, slaveId, frameworkId);
@@ -509,7 +638,7 @@ TEST_F(GarbageCollectorIntegrationTest, ExitedExecutor)
   Owned<MasterDetector> detector = master.get()->createDetector();
 
   Try<Owned<cluster::Slave>> slave =
-    StartSlave(detector.get(), &containerizer, flags);
+    StartSlave(detector.get(), &containerizer, &gc, flags);
   ASSERT_SOME(slave);
 
   AWAIT_READY(slaveRegisteredMessage);
@@ -584,6 +713,8 @@ TEST_F(GarbageCollectorIntegrationTest, ExitedExecutor)
 
   Clock::settle();
 
+  AWAIT_READY(removed());
+
   // Executor's directory should be gc'ed by now.
   ASSERT_FALSE(os::exists(executorDir));
 
@@ -619,7 +750,7 @@ TEST_F(GarbageCollectorIntegrationTest, DiskUsage)
   Owned<MasterDetector> detector = master.get()->createDetector();
 
   Try<Owned<cluster::Slave>> slave =
-    StartSlave(detector.get(), &containerizer, flags);
+    StartSlave(detector.get(), &containerizer, &gc, flags);
   ASSERT_SOME(slave);
 
   AWAIT_READY(slaveRegisteredMessage);
@@ -705,6 +836,8 @@ TEST_F(GarbageCollectorIntegrationTest, DiskUsage)
 
   Clock::settle(); // Wait for Slave::_checkDiskUsage to complete.
 
+  AWAIT_READY(removed());
+
   // Executor's directory should be gc'ed by now.
   ASSERT_FALSE(os::exists(executorDir));
 
@@ -868,7 +1001,7 @@ TEST_F(GarbageCollectorIntegrationTest, ROOT_BusyMountPoint)
 
   slave::Flags flags = CreateSlaveFlags();
   Owned<MasterDetector> detector = master.get()->createDetector();
-  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), flags);
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), &gc, flags);
 
   ASSERT_SOME(slave);
 
@@ -960,6 +1093,8 @@ TEST_F(GarbageCollectorIntegrationTest, ROOT_BusyMountPoint)
   Clock::advance(flags.gc_delay);
   Clock::settle();
 
+  AWAIT_READY(removed());
+
   EXPECT_TRUE(os::exists(sandbox));
   EXPECT_TRUE(os::exists(path::join(sandbox, mountPoint)));
   EXPECT_FALSE(os::exists(path::join(sandbox, regularFile)));
@@ -28,6 +28,7 @@
 #include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gtest.hpp>
+#include <process/id.hpp>
 #include <process/queue.hpp>
 
 #include <stout/duration.hpp>
@@ -53,6 +54,9 @@ using mesos::internal::master::MIN_CPUS;
 using mesos::internal::master::MIN_MEM;
 
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
+using mesos::internal::master::allocator::MesosAllocator;
+using mesos::internal::master::allocator::ShardedHierarchicalDRFAllocator;
+using mesos::internal::master::allocator::ShardedHierarchicalDRFAllocatorProcess;
 
 using mesos::internal::protobuf::createLabel;
 
@@ -183,7 +187,11 @@ class HierarchicalAllocatorTestBase : public ::testing::Test
 {
 protected:
   HierarchicalAllocatorTestBase()
-    : allocator(createAllocator<HierarchicalDRFAllocator>()),
+    : HierarchicalAllocatorTestBase(
+          createAllocator<HierarchicalDRFAllocator>()) {}
+
+  explicit HierarchicalAllocatorTestBase(Allocator* _allocator)
+    : allocator(_allocator),
       nextSlaveId(1),
       nextFrameworkId(1) {}
 
@@ -3546,6 +3554,415 @@ TEST_F(HierarchicalAllocatorTest, ReviveOffers)
 }
 
 
+// A sharded allocator that always partitions the agents into four
+// shards, so that the tests below exercise the sharded allocation
+// regardless of the number of CPUs of the machine running them.
+class FourShardHierarchicalDRFAllocatorProcess
+  : public ShardedHierarchicalDRFAllocatorProcess
+{
+public:
+  FourShardHierarchicalDRFAllocatorProcess()
+    : process::ProcessBase(process::ID::generate("hierarchical-allocator"))
+  {
+    allocationShards = 4;
+  }
+};
+
+
+typedef MesosAllocator<FourShardHierarchicalDRFAllocatorProcess>
+FourShardHierarchicalDRFAllocator;
+
+
+class ShardedHierarchicalAllocatorTest : public HierarchicalAllocatorTestBase
+{
+protected:
+  ShardedHierarchicalAllocatorTest()
+    : HierarchicalAllocatorTestBase(
+          createAllocator<FourShardHierarchicalDRFAllocator>()) {}
+
+  // Adds `count` agents with the given resources, before any framework
+  // is added, so that the next allocation covers all of them at once.
+  vector<SlaveInfo> addSlaves(size_t count, const Resources& resources)
+  {
+    vector<SlaveInfo> agents;
+
+    for (size_t i = 0; i < count; i++) {
+      SlaveInfo agent = createSlaveInfo(resources);
+      allocator->addSlave(agent.id(), agent, None(), resources, {});
+      agents.push_back(agent);
+    }
+
+    return agents;
+  }
+};
+
+
+// Checks that the shards do not allocate the resources set aside for
+// an unsatisfied quota, even though each shard on its own stays within
+// the remaining cluster resources.
+TEST_F(ShardedHierarchicalAllocatorTest, QuotaHeadroom)
+{
+  Clock::pause();
+
+  const string QUOTA_ROLE{"quota-role"};
+  const string NO_QUOTA_ROLE{"no-quota-role"};
+
+  initialize();
+
+  // Total cluster resources: cpus=4, mem=2048.
+  vector<SlaveInfo> agents =
+    addSlaves(4, Resources::parse("cpus:1;mem:512;disk:0").get());
+
+  // There are no frameworks in `QUOTA_ROLE`, hence cpus=2, mem=1024
+  // have to be laid away for it.
+  const Quota quota = createQuota(QUOTA_ROLE, "cpus:2;mem:1024");
+  allocator->setQuota(QUOTA_ROLE, quota);
+
+  FrameworkInfo framework = createFrameworkInfo(NO_QUOTA_ROLE);
+  allocator->addFramework(framework.id(), framework, {});
+
+  // Each of the four shards proposes its agent to `framework`, only
+  // the proposals of two shards fit into the remaining resources.
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(2u, allocation.get().resources.size());
+  EXPECT_EQ(Resources::parse("cpus:2;mem:1024;disk:0").get(),
+            Resources::sum(allocation.get().resources));
+
+  // The quota is still unsatisfied, so a batch allocation does not
+  // offer the agents of the dropped proposals either.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  allocation = allocations.get();
+  EXPECT_TRUE(allocation.isPending());
+}
+
+
+// Checks that the agents of proposals dropped during the reconciliation
+// of the shards are offered in the next allocation cycle.
+TEST_F(ShardedHierarchicalAllocatorTest, DroppedProposalsReoffered)
+{
+  Clock::pause();
+
+  const string QUOTA_ROLE{"quota-role"};
+  const string NO_QUOTA_ROLE{"no-quota-role"};
+
+  initialize();
+
+  // Total cluster resources: cpus=4, mem=2048.
+  vector<SlaveInfo> agents =
+    addSlaves(4, Resources::parse("cpus:1;mem:512;disk:0").get());
+
+  const Quota quota = createQuota(QUOTA_ROLE, "cpus:2;mem:1024");
+  allocator->setQuota(QUOTA_ROLE, quota);
+
+  FrameworkInfo framework = createFrameworkInfo(NO_QUOTA_ROLE);
+  allocator->addFramework(framework.id(), framework, {});
+
+  // The proposals of two shards are dropped to preserve the headroom
+  // of the quota.
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  ASSERT_EQ(2u, allocation.get().resources.size());
+
+  hashset<SlaveID> offered;
+  foreachkey (const SlaveID& slaveId, allocation.get().resources) {
+    offered.insert(slaveId);
+  }
+
+  // Removing the quota triggers the next allocation cycle, which
+  // offers the two remaining agents.
+  allocator->removeQuota(QUOTA_ROLE);
+
+  allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  ASSERT_EQ(2u, allocation.get().resources.size());
+
+  foreachkey (const SlaveID& slaveId, allocation.get().resources) {
+    EXPECT_FALSE(offered.contains(slaveId));
+    offered.insert(slaveId);
+  }
+
+  foreach (const SlaveInfo& agent, agents) {
+    EXPECT_TRUE(offered.contains(agent.id()));
+  }
+}
+
+
+// Checks that every agent is offered exactly once in an allocation
+// cycle, and that the shards start from different frameworks so
+// that one framework does not receive all the agents.
+TEST_F(ShardedHierarchicalAllocatorTest, AgentsOfferedOnce)
+{
+  Clock::pause();
+
+  initialize();
+
+  vector<SlaveInfo> agents =
+    addSlaves(4, Resources::parse("cpus:1;mem:512;disk:0").get());
+
+  FrameworkInfo framework1 = createFrameworkInfo("role1");
+  allocator->addFramework(framework1.id(), framework1, {});
+
+  // `framework1` is offered all the agents in a single offer.
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework1.id(), allocation.get().frameworkId);
+  EXPECT_EQ(4u, allocation.get().resources.size());
+
+  // `framework1` declines all the agents, without a filter.
+  foreachpair (const SlaveID& slaveId,
+               const Resources& resources,
+               allocation.get().resources) {
+    allocator->recoverResources(framework1.id(), slaveId, resources, None());
+  }
+
+  // Adding `framework2` triggers an allocation cycle for all agents.
+  FrameworkInfo framework2 = createFrameworkInfo("role2");
+  allocator->addFramework(framework2.id(), framework2, {});
+
+  // Both frameworks are offered in the same allocation cycle, in
+  // either order.
+  hashmap<FrameworkID, hashmap<SlaveID, Resources>> offered;
+  for (size_t i = 0; i < 2; i++) {
+    allocation = allocations.get();
+    AWAIT_READY(allocation);
+    offered[allocation.get().frameworkId] = allocation.get().resources;
+  }
+
+  ASSERT_TRUE(offered.contains(framework1.id()));
+  ASSERT_TRUE(offered.contains(framework2.id()));
+
+  // Each shard holds one agent and starts from the other role than
+  // the previous shard.
+  EXPECT_EQ(2u, offered[framework1.id()].size());
+  EXPECT_EQ(2u, offered[framework2.id()].size());
+
+  foreach (const SlaveInfo& agent, agents) {
+    EXPECT_NE(
+        offered[framework1.id()].contains(agent.id()),
+        offered[framework2.id()].contains(agent.id()));
+  }
+}
+
+
+// Checks that the shards respect offer filters.
+TEST_F(ShardedHierarchicalAllocatorTest, OfferFilter)
+{
+  Clock::pause();
+
+  initialize();
+
+  vector<SlaveInfo> agents =
+    addSlaves(4, Resources::parse("cpus:1;mem:512;disk:0").get());
+
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(framework.id(), framework, {});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(4u, allocation.get().resources.size());
+
+  // `framework` declines all the agents, with a filter for the first
+  // agent only.
+  Filters offerFilter;
+  offerFilter.set_refuse_seconds((flags.allocation_interval * 2).secs());
+
+  foreachpair (const SlaveID& slaveId,
+               const Resources& resources,
+               allocation.get().resources) {
+    allocator->recoverResources(
+        framework.id(),
+        slaveId,
+        resources,
+        slaveId == agents[0].id() ? offerFilter : Option<Filters>::none());
+  }
+
+  // Ensure the offer filter timeout is set before advancing the clock.
+  Clock::settle();
+
+  // Trigger a batch allocation.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(3u, allocation.get().resources.size());
+  EXPECT_FALSE(allocation.get().resources.contains(agents[0].id()));
+}
+
+
+// Checks that the shards only offer agents with GPUs to frameworks
+// that are capable of receiving GPUs.
+TEST_F(ShardedHierarchicalAllocatorTest, GPUResources)
+{
+  Clock::pause();
+
+  initialize();
+
+  vector<SlaveInfo> gpuAgents =
+    addSlaves(2, Resources::parse("gpus:1;cpus:1;mem:512;disk:0").get());
+
+  vector<SlaveInfo> agents =
+    addSlaves(2, Resources::parse("cpus:1;mem:512;disk:0").get());
+
+  // `framework1` is not capable of receiving GPUs.
+  FrameworkInfo framework1 = createFrameworkInfo("role1");
+  allocator->addFramework(framework1.id(), framework1, {});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework1.id(), allocation.get().frameworkId);
+  EXPECT_EQ(2u, allocation.get().resources.size());
+
+  foreach (const SlaveInfo& agent, agents) {
+    EXPECT_TRUE(allocation.get().resources.contains(agent.id()));
+  }
+
+  FrameworkInfo framework2 = createFrameworkInfo(
+      "role2",
+      {FrameworkInfo::Capability::GPU_RESOURCES});
+  allocator->addFramework(framework2.id(), framework2, {});
+
+  // `framework2` is offered the agents with GPUs.
+  allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework2.id(), allocation.get().frameworkId);
+  EXPECT_EQ(2u, allocation.get().resources.size());
+
+  foreach (const SlaveInfo& agent, gpuAgents) {
+    EXPECT_TRUE(allocation.get().resources.contains(agent.id()));
+  }
+}
+
+
+// Checks that the shards only offer revocable resources to frameworks
+// that opted in for them.
+TEST_F(ShardedHierarchicalAllocatorTest, RevocableResources)
+{
+  Clock::pause();
+
+  initialize();
+
+  const Resources resources =
+    Resources::parse("cpus:1;mem:512;disk:0").get() +
+    createRevocableResources("cpus", "1");
+
+  vector<SlaveInfo> agents = addSlaves(4, resources);
+
+  // `framework1` has not opted in for revocable resources.
+  FrameworkInfo framework1 = createFrameworkInfo("role1");
+  allocator->addFramework(framework1.id(), framework1, {});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework1.id(), allocation.get().frameworkId);
+  EXPECT_EQ(4u, allocation.get().resources.size());
+
+  foreach (const SlaveInfo& agent, agents) {
+    EXPECT_EQ(resources.nonRevocable(),
+              allocation.get().resources.get(agent.id()).get());
+  }
+
+  FrameworkInfo framework2 = createFrameworkInfo(
+      "role2",
+      {FrameworkInfo::Capability::REVOCABLE_RESOURCES});
+  allocator->addFramework(framework2.id(), framework2, {});
+
+  // `framework2` is offered the revocable resources of all agents.
+  allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework2.id(), allocation.get().frameworkId);
+  EXPECT_EQ(4u, allocation.get().resources.size());
+
+  foreach (const SlaveInfo& agent, agents) {
+    EXPECT_EQ(resources.revocable(),
+              allocation.get().resources.get(agent.id()).get());
+  }
+}
+
+
+// Checks that the shards only offer shared resources to frameworks
+// that opted in for them, and offer them once per allocation cycle.
+TEST_F(ShardedHierarchicalAllocatorTest, SharedResources)
+{
+  Clock::pause();
+
+  initialize();
+
+  // Each agent has a shared volume of its own.
+  hashmap<SlaveID, Resource> volumes;
+  vector<SlaveInfo> agents;
+
+  for (size_t i = 0; i < 4; i++) {
+    SlaveInfo agent = createSlaveInfo("cpus:1;mem:512;disk(role1):95");
+
+    Resource volume = createDiskResource(
+        "5", "role1", "id" + stringify(i), None(), None(), true);
+
+    allocator->addSlave(
+        agent.id(), agent, None(), agent.resources() + volume, {});
+
+    volumes[agent.id()] = volume;
+    agents.push_back(agent);
+  }
+
+  // `framework1` has not opted in for shared resources.
+  FrameworkInfo framework1 = createFrameworkInfo("role1");
+  allocator->addFramework(framework1.id(), framework1, {});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework1.id(), allocation.get().frameworkId);
+  EXPECT_EQ(4u, allocation.get().resources.size());
+
+  // `framework1` declines all the agents, without a filter.
+  foreachpair (const SlaveID& slaveId,
+               const Resources& resources,
+               allocation.get().resources) {
+    EXPECT_TRUE(resources.shared().empty());
+
+    allocator->recoverResources(framework1.id(), slaveId, resources, None());
+  }
+
+  // `framework2` has opted in for shared resources.
+  FrameworkInfo framework2 = createFrameworkInfo(
+      "role1",
+      {FrameworkInfo::Capability::SHARED_RESOURCES});
+  allocator->addFramework(framework2.id(), framework2, {});
+
+  // Both frameworks are offered in the same allocation cycle, in
+  // either order.
+  hashmap<FrameworkID, hashmap<SlaveID, Resources>> offered;
+  for (size_t i = 0; i < 2; i++) {
+    allocation = allocations.get();
+    AWAIT_READY(allocation);
+    offered[allocation.get().frameworkId] = allocation.get().resources;
+  }
+
+  ASSERT_TRUE(offered.contains(framework1.id()));
+  ASSERT_TRUE(offered.contains(framework2.id()));
+
+  foreachvalue (const Resources& resources, offered[framework1.id()]) {
+    EXPECT_TRUE(resources.shared().empty());
+  }
+
+  // The volume of an agent is offered along with the agent, once.
+  foreachpair (const SlaveID& slaveId,
+               const Resources& resources,
+               offered[framework2.id()]) {
+    EXPECT_EQ(Resources(volumes[slaveId]), resources.shared());
+    EXPECT_FALSE(offered[framework1.id()].contains(slaveId));
+  }
+}
+
+
 class HierarchicalAllocator_BENCHMARK_Test
   : public HierarchicalAllocatorTestBase,
     public WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
@@ -4127,6 +4544,123 @@ TEST_P(HierarchicalAllocator_BENCHMARK_Test, SuppressOffers)
 }
 
 
+// This benchmark measures a full allocation cycle of the default
+// allocator and of the sharded allocator, which evaluates shards of
+// agents in parallel, on the same cluster.
+TEST_P(HierarchicalAllocator_BENCHMARK_Test, ShardedAllocation)
+{
+  size_t slaveCount = std::tr1::get<0>(GetParam());
+  size_t frameworkCount = std::tr1::get<1>(GetParam());
+
+  // Pause the clock because we want to manually drive the allocations.
+  Clock::pause();
+
+  struct OfferedResources {
+    FrameworkID   frameworkId;
+    SlaveID       slaveId;
+    Resources     resources;
+  };
+
+  vector<OfferedResources> offers;
+
+  auto offerCallback = [&offers](
+      const FrameworkID& frameworkId,
+      const hashmap<SlaveID, Resources>& resources_)
+  {
+    foreach (auto resources, resources_) {
+      offers.push_back(
+          OfferedResources{frameworkId, resources.first, resources.second});
+    }
+  };
+
+  auto inverseOfferCallback = [](
+      const FrameworkID& frameworkId,
+      const hashmap<SlaveID, UnavailableResources>& resources) {};
+
+  cout << "Using " << slaveCount << " agents and "
+       << frameworkCount << " frameworks" << endl;
+
+  vector<SlaveInfo> slaves;
+  slaves.reserve(slaveCount);
+
+  for (size_t i = 0; i < slaveCount; i++) {
+    slaves.push_back(createSlaveInfo(
+        "cpus:24;mem:4096;disk:4096;ports:[31000-32000]"));
+  }
+
+  // Spread the frameworks across a few roles.
+  vector<FrameworkInfo> frameworks;
+  frameworks.reserve(frameworkCount);
+
+  for (size_t i = 0; i < frameworkCount; i++) {
+    frameworks.push_back(createFrameworkInfo("role" + stringify(i % 10)));
+  }
+
+  vector<std::pair<string, Allocator*>> allocators = {
+    {"default", createAllocator<HierarchicalDRFAllocator>()},
+    {"sharded", createAllocator<ShardedHierarchicalDRFAllocator>()}
+  };
+
+  vector<Duration> elapsed;
+
+  foreach (const auto& named, allocators) {
+    Allocator* allocator_ = named.second;
+
+    allocator_->initialize(
+        flags.allocation_interval,
+        offerCallback,
+        inverseOfferCallback,
+        {});
+
+    foreach (const FrameworkInfo& framework, frameworks) {
+      allocator_->addFramework(framework.id(), framework, {});
+    }
+
+    foreach (const SlaveInfo& slave, slaves) {
+      allocator_->addSlave(
+          slave.id(), slave, None(), slave.resources(), {});
+    }
+
+    // Wait for all the `addFramework` and `addSlave` operations (and
+    // the resulting allocations) to be processed.
+    Clock::settle();
+
+    // Recover all the offered resources (without filters) so that
+    // the next allocation cycle allocates all agents.
+    foreach (const OfferedResources& offer, offers) {
+      allocator_->recoverResources(
+          offer.frameworkId, offer.slaveId, offer.resources, None());
+    }
+
+    Clock::settle();
+    offers.clear();
+
+    Stopwatch watch;
+    watch.start();
+
+    // Advance the clock and trigger a background allocation cycle.
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    watch.stop();
+
+    elapsed.push_back(watch.elapsed());
+
+    cout << "The " << named.first << " allocator took " << watch.elapsed()
+         << " to make " << offers.size() << " offers" << endl;
+
+    offers.clear();
+
+    delete allocator_;
+  }
+
+  cout << "Speedup of the sharded allocator: "
+       << elapsed[0].secs() / elapsed[1].secs() << "x" << endl;
+
+  Clock::resume();
+}
+
+
 // Measures the processing time required for the allocator metrics.
 //
 // TODO(bmahler): Add allocations to this benchmark.
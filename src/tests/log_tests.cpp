@@ -16,15 +16,18 @@
 
 #include <stdint.h>
 
+#include <iostream>
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
 #include <mesos/log/log.hpp>
 
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -34,6 +37,7 @@
 #include <process/protobuf.hpp>
 #include <process/shared.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/gtest.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
@@ -65,14 +69,18 @@ using namespace mesos::internal::log;
 
 using namespace process;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::set;
 using std::string;
+using std::vector;
 
 using testing::_;
 using testing::Eq;
 using testing::Invoke;
 using testing::Return;
+using testing::WithParamInterface;
 
 using mesos::log::Log;
 
@@ -253,6 +261,113 @@ TYPED_TEST(LogStorageTest, Truncate)
 }
 
 
+// Tests that a batch of actions is persisted in order, i.e., the last
+// action for a position wins, including learned truncations.
+TYPED_TEST(LogStorageTest, PersistBatch)
+{
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(os::getcwd() + "/.log");
+  ASSERT_SOME(state);
+
+  vector<Action> actions;
+
+  for (uint64_t i = 0; i < 3; i++) {
+    Action action;
+    action.set_position(i);
+    action.set_promised(1);
+    action.set_performed(1);
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes(stringify(i));
+    actions.push_back(action);
+  }
+
+  // Learn position 2 within the same batch.
+  Action learned = actions.back();
+  learned.set_learned(true);
+  actions.push_back(learned);
+
+  // Truncate to position 1 (at position 3).
+  Action truncate;
+  truncate.set_position(3);
+  truncate.set_promised(1);
+  truncate.set_performed(1);
+  truncate.set_learned(true);
+  truncate.set_type(Action::TRUNCATE);
+  truncate.mutable_truncate()->set_to(1);
+  actions.push_back(truncate);
+
+  ASSERT_SOME(storage.persist(actions));
+
+  EXPECT_ERROR(storage.read(0));
+
+  Try<Action> action = storage.read(1);
+  ASSERT_SOME(action);
+  EXPECT_FALSE(action.get().has_learned());
+  EXPECT_EQ("1", action.get().append().bytes());
+
+  action = storage.read(2);
+  ASSERT_SOME(action);
+  EXPECT_TRUE(action.get().learned());
+  EXPECT_EQ("2", action.get().append().bytes());
+
+  action = storage.read(3);
+  ASSERT_SOME(action);
+  EXPECT_EQ(Action::TRUNCATE, action.get().type());
+}
+
+
+// Tests that a range of positions is read in order, skipping the
+// positions that are not in storage, and stopping at the size limit.
+TYPED_TEST(LogStorageTest, ReadRange)
+{
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(os::getcwd() + "/.log");
+  ASSERT_SOME(state);
+
+  vector<Action> actions;
+
+  // Leave a hole at position 5.
+  for (uint64_t i = 0; i < 10; i++) {
+    if (i == 5) {
+      continue;
+    }
+
+    Action action;
+    action.set_position(i);
+    action.set_promised(1);
+    action.set_performed(1);
+    action.set_learned(true);
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes(string(100, 'x'));
+    actions.push_back(action);
+  }
+
+  ASSERT_SOME(storage.persist(actions));
+
+  Try<vector<Action>> range = storage.read(3, 7);
+  ASSERT_SOME(range);
+  ASSERT_EQ(4u, range->size());
+  EXPECT_EQ(3u, range->at(0).position());
+  EXPECT_EQ(4u, range->at(1).position());
+  EXPECT_EQ(6u, range->at(2).position());
+  EXPECT_EQ(7u, range->at(3).position());
+
+  // Past the end of the log.
+  range = storage.read(8, 20);
+  ASSERT_SOME(range);
+  ASSERT_EQ(2u, range->size());
+  EXPECT_EQ(9u, range->back().position());
+
+  // The action at which the limit is reached is still returned.
+  range = storage.read(0, 9, Bytes(150));
+  ASSERT_SOME(range);
+  ASSERT_EQ(2u, range->size());
+  EXPECT_EQ(1u, range->back().position());
+}
+
+
 TYPED_TEST(LogStorageTest, TruncateWithEmptyLog)
 {
   TypeParam storage;
@@ -581,6 +696,75 @@ TEST_F(ReplicaTest, NonVoting)
 }
 
 
+class Replica_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t>
+{
+protected:
+  // Used to change the status of a replicated log from `EMPTY` to `VOTING`.
+  tool::Initialize initializer;
+};
+
+
+// The replica benchmark tests are parameterized by the entry size.
+INSTANTIATE_TEST_CASE_P(
+    EntrySize,
+    Replica_BENCHMARK_Test,
+    ::testing::Values(100U, 1000U, 10000U, 100000U));
+
+
+// Measures the rate at which a replica persists appends with an
+// increasing number of outstanding write requests, which the replica
+// can persist using a single sync (i.e., a group commit).
+TEST_P(Replica_BENCHMARK_Test, Append)
+{
+  const string path = os::getcwd() + "/.log";
+  initializer.flags.path = path;
+  ASSERT_SOME(initializer.execute());
+
+  Replica replica(path);
+
+  const uint64_t proposal = 1;
+
+  PromiseRequest promise;
+  promise.set_proposal(proposal);
+
+  AWAIT_READY(protocol::promise(replica.pid(), promise));
+
+  const string bytes(GetParam(), 'x');
+  const size_t count = 1000;
+
+  uint64_t position = 1;
+
+  foreach (size_t concurrency, vector<size_t>({1U, 10U, 100U})) {
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < count; i += concurrency) {
+      list<Future<WriteResponse>> responses;
+
+      for (size_t j = 0; j < concurrency; j++) {
+        WriteRequest request;
+        request.set_proposal(proposal);
+        request.set_position(position++);
+        request.set_type(Action::APPEND);
+        request.mutable_append()->set_bytes(bytes);
+
+        responses.push_back(protocol::write(replica.pid(), request));
+      }
+
+      AWAIT_READY_FOR(collect(responses), Minutes(1));
+    }
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Appended " << count << " entries of " << Bytes(bytes.size())
+         << " with " << concurrency << " outstanding write(s) in " << elapsed
+         << " (" << count / elapsed.secs() << " appends/sec)" << endl;
+  }
+}
+
+
 class CoordinatorTest : public TemporaryDirectoryTest
 {
 protected:
@@ -1214,6 +1398,153 @@ TEST_F(CoordinatorTest, MultipleAppends)
 }
 
 
+// Tests that appends can be pipelined, i.e., that they do not wait
+// for the previous ones to be done.
+TEST_F(CoordinatorTest, PipelinedAppends)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  list<Future<Option<uint64_t>>> appendings;
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    appendings.push_back(coord.append(stringify(position)));
+  }
+
+  // A truncate can be pipelined with the appends too.
+  Future<Option<uint64_t>> truncating = coord.truncate(5);
+
+  uint64_t position = 1;
+  foreach (const Future<Option<uint64_t>>& appending, appendings) {
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position++, appending.get());
+  }
+
+  AWAIT_READY(truncating);
+  EXPECT_SOME_EQ(11u, truncating.get());
+
+  {
+    Future<list<Action>> actions = replica1->read(5, 10);
+    AWAIT_READY(actions);
+    EXPECT_EQ(6u, actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
+// Tests that pipelined appends are completed in order, and that the
+// coordinator is demoted if one of them does not succeed.
+TEST_F(CoordinatorTest, PipelinedAppendsDemoted)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  // Make sure that the first append can not get a quorum.
+  DROP_PROTOBUF(WriteRequest(), _, Eq(replica2->pid()));
+
+  Clock::pause();
+
+  Future<Option<uint64_t>> appending1 = coord.append("hello world");
+  Future<Option<uint64_t>> appending2 = coord.append("hello moto");
+  Future<Option<uint64_t>> appending3 = coord.append("hello hello");
+
+  Clock::settle();
+
+  // The following appends are done, but they are not completed
+  // before the first one.
+  {
+    Future<list<Action>> actions = replica1->read(2, 3);
+    AWAIT_READY(actions);
+    ASSERT_EQ(2u, actions.get().size());
+    EXPECT_TRUE(actions.get().front().learned());
+    EXPECT_TRUE(actions.get().back().learned());
+  }
+
+  EXPECT_TRUE(appending1.isPending());
+  EXPECT_TRUE(appending2.isPending());
+  EXPECT_TRUE(appending3.isPending());
+
+  appending1.discard();
+
+  Clock::resume();
+
+  AWAIT_DISCARDED(appending1);
+
+  AWAIT_READY(appending2);
+  EXPECT_NONE(appending2.get());
+
+  AWAIT_READY(appending3);
+  EXPECT_NONE(appending3.get());
+
+  // The coordinator needs to be elected again.
+  {
+    Future<Option<uint64_t>> appending = coord.append("hello");
+    AWAIT_READY(appending);
+    EXPECT_NONE(appending.get());
+  }
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(3u, electing.get());
+  }
+
+  {
+    Future<Option<uint64_t>> appending = coord.append("hello");
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(4u, appending.get());
+  }
+}
+
+
 TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -1659,6 +1990,77 @@ TEST_F(CoordinatorTest, RecoveryRace)
 }
 
 
+class Coordinator_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t>
+{
+protected:
+  // Used to change the status of a replicated log from `EMPTY` to `VOTING`.
+  tool::Initialize initializer;
+};
+
+
+// The coordinator benchmark tests are parameterized by the entry size.
+INSTANTIATE_TEST_CASE_P(
+    EntrySize,
+    Coordinator_BENCHMARK_Test,
+    ::testing::Values(100U, 1000U, 10000U, 100000U));
+
+
+// Measures the rate at which a coordinator appends to a log of three
+// replicas with an increasing number of outstanding appends. The
+// replicas persist the writes (and learned notices) of the
+// outstanding appends using a single sync.
+TEST_P(Coordinator_BENCHMARK_Test, Append)
+{
+  set<UPID> pids;
+  vector<Shared<Replica>> replicas;
+
+  for (int i = 0; i < 3; i++) {
+    const string path = os::getcwd() + "/.log" + stringify(i);
+    initializer.flags.path = path;
+    ASSERT_SOME(initializer.execute());
+
+    replicas.push_back(Shared<Replica>(new Replica(path)));
+    pids.insert(replicas.back()->pid());
+  }
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replicas.front(), network);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  const string bytes(GetParam(), 'x');
+  const size_t count = 1000;
+
+  foreach (size_t concurrency, vector<size_t>({1U, 10U, 100U})) {
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < count; i += concurrency) {
+      list<Future<Option<uint64_t>>> appendings;
+
+      for (size_t j = 0; j < concurrency; j++) {
+        appendings.push_back(coord.append(bytes));
+      }
+
+      AWAIT_READY_FOR(collect(appendings), Minutes(1));
+    }
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Appended " << count << " entries of " << Bytes(bytes.size())
+         << " with " << concurrency << " outstanding append(s) in " << elapsed
+         << " (" << count / elapsed.secs() << " appends/sec)" << endl;
+  }
+}
+
+
 class RecoverTest : public TemporaryDirectoryTest
 {
 protected:
@@ -1819,6 +2221,9 @@ TEST_F(RecoverTest, CatchupRetry)
 
   Shared<Network> network2(new Network(pids));
 
+  // Make the catch-up process use consensus for all the positions.
+  DROP_PROTOBUFS(CatchUpRequest(), _, _);
+
   // Drop a promise request to replica1 so that the catch-up process
   // won't be able to get a quorum of explicit promises. Also, since
   // learned messages are blocked from being sent replica2, the
@@ -1853,6 +2258,146 @@ TEST_F(RecoverTest, CatchupRetry)
 }
 
 
+// Tests that a replica catches up the positions that the other
+// replicas have learned without running consensus.
+TEST_F(RecoverTest, CatchupStream)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids{replica1->pid(), replica2->pid()};
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  IntervalSet<uint64_t> positions;
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t>> appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  // The local replica of the coordinator has learned all the
+  // positions, so no consensus is needed.
+  EXPECT_NO_FUTURE_PROTOBUFS(PromiseRequest(), _, _);
+
+  Future<Nothing> catching =
+    catchup(2, replica3, network2, None(), positions, Seconds(10));
+
+  AWAIT_READY(catching);
+
+  Future<list<Action>> actions = replica3->read(1, 10);
+  AWAIT_READY(actions);
+  ASSERT_EQ(10u, actions->size());
+
+  foreach (const Action& action, actions.get()) {
+    EXPECT_TRUE(action.learned());
+    ASSERT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(stringify(action.position()), action.append().bytes());
+  }
+}
+
+
+// Tests that the catch-up from learned replicas does not wait for the
+// replicas that do not respond once a quorum of replicas has none of
+// the missing positions.
+TEST_F(RecoverTest, CatchupStreamQuorum)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  // Make sure replica1 does not receive learned messages.
+  DROP_PROTOBUFS(LearnedMessage(), _, Eq(replica1->pid()));
+
+  set<UPID> pids{replica1->pid(), replica2->pid()};
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica2, network1);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  IntervalSet<uint64_t> positions;
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t>> appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  // Replica2 does not respond, as if it ran an older version.
+  DROP_PROTOBUFS(CatchUpRequest(), _, Eq(replica2->pid()));
+
+  // No timeout can expire while the clock is paused. The proposal
+  // hint avoids a rejected first proposal, whose retry needs the
+  // clock to advance.
+  Clock::pause();
+
+  Future<Nothing> catching =
+    catchup(2, replica3, network2, 2u, positions, Seconds(10));
+
+  AWAIT_READY(catching);
+
+  Clock::resume();
+
+  Future<list<Action>> actions = replica3->read(1, 10);
+  AWAIT_READY(actions);
+  ASSERT_EQ(10u, actions->size());
+
+  foreach (const Action& action, actions.get()) {
+    EXPECT_TRUE(action.learned());
+    ASSERT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(stringify(action.position()), action.append().bytes());
+  }
+}
+
+
 TEST_F(RecoverTest, AutoInitialization)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -2001,6 +2546,98 @@ TEST_F(RecoverTest, AutoInitializationRetry)
 }
 
 
+class CatchUp_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t>
+{
+protected:
+  // Used to change the status of a replicated log from `EMPTY` to `VOTING`.
+  tool::Initialize initializer;
+};
+
+
+// The catch-up benchmark tests are parameterized by the entry size.
+INSTANTIATE_TEST_CASE_P(
+    EntrySize,
+    CatchUp_BENCHMARK_Test,
+    ::testing::Values(100U, 1000U, 10000U, 100000U));
+
+
+// Measures the rate at which an empty replica catches up positions
+// that the other replicas have learned, by copying them in batches,
+// compared to running consensus for each position.
+TEST_P(CatchUp_BENCHMARK_Test, Learned)
+{
+  const string bytes(GetParam(), 'x');
+  const uint64_t count = 1000;
+
+  const string path1 = os::getcwd() + "/.log1";
+  const string path2 = os::getcwd() + "/.log2";
+
+  // Fill the logs of two replicas directly through their storage.
+  foreach (const string& path, vector<string>({path1, path2})) {
+    initializer.flags.path = path;
+    ASSERT_SOME(initializer.execute());
+
+    LevelDBStorage storage;
+    ASSERT_SOME(storage.restore(path));
+
+    vector<Action> actions;
+
+    for (uint64_t position = 1; position <= count; position++) {
+      Action action;
+      action.set_position(position);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_learned(true);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(bytes);
+      actions.push_back(action);
+    }
+
+    ASSERT_SOME(storage.persist(actions));
+  }
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  IntervalSet<uint64_t> positions;
+  positions += (Bound<uint64_t>::closed(1), Bound<uint64_t>::closed(count));
+
+  foreach (bool consensus, vector<bool>({false, true})) {
+    const string path3 = os::getcwd() + "/.log3-" + stringify(consensus);
+
+    Shared<Replica> replica3(new Replica(path3));
+
+    set<UPID> pids{replica1->pid(), replica2->pid(), replica3->pid()};
+
+    Shared<Network> network(new Network(pids));
+
+    if (consensus) {
+      // NOTE: This adds a single timeout to the elapsed time, before
+      // falling back to consensus.
+      DROP_PROTOBUFS(CatchUpRequest(), _, _);
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    // Use a proposal number higher than the promised one (as recovery
+    // would) so that consensus does not need to retry.
+    AWAIT_READY_FOR(
+        catchup(2, replica3, network, 2u, positions, Seconds(1)),
+        Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Caught-up " << count << " positions of " << Bytes(bytes.size())
+         << (consensus ? " using consensus" : " from learned replicas")
+         << " in " << elapsed << " (" << count / elapsed.secs()
+         << " positions/sec)" << endl;
+  }
+}
+
+
 class LogTest : public TemporaryDirectoryTest
 {
 protected:
@@ -3163,6 +3163,78 @@ TEST_F(MasterTest, StateEndpointFrameworkInfo)
 }
 
 
+// This test ensures that the streamed state endpoint returns the
+// same document as the regular one.
+TEST_F(MasterTest, StateEndpointStreaming)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureSatisfy(&registered));
+
+  // Wait for the offer so that the state does not change between
+  // the two requests.
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(registered);
+  AWAIT_READY(offers);
+
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Future<Response> streamed = process::http::get(
+      master.get()->pid,
+      "state",
+      "stream=true",
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, streamed);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(APPLICATION_JSON, "Content-Type", streamed);
+
+  Try<JSON::Object> expected = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(expected);
+
+  Try<JSON::Object> actual = JSON::parse<JSON::Object>(streamed->body);
+  ASSERT_SOME(actual);
+
+  ASSERT_TRUE(actual->values["slaves"].is<JSON::Array>());
+  EXPECT_EQ(1u, actual->values["slaves"].as<JSON::Array>().values.size());
+
+  ASSERT_TRUE(actual->values["frameworks"].is<JSON::Array>());
+  EXPECT_EQ(1u, actual->values["frameworks"].as<JSON::Array>().values.size());
+
+  EXPECT_EQ(expected.get(), actual.get());
+
+  driver.stop();
+  driver.join();
+}
+
+
 TEST_F(MasterTest, StateSummaryEndpoint)
 {
   master::Flags flags = CreateMasterFlags();
@@ -3269,6 +3341,325 @@ TEST_F(MasterTest, StateSummaryEndpoint)
 }
 
 
+// This test verifies that the state summary endpoint supports
+// conditional requests, and that the tag changes once the summary
+// has changed.
+TEST_F(MasterTest, StateSummaryEndpointConditional)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  const string notModified =
+    process::http::Status::string(process::http::Status::NOT_MODIFIED);
+
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "state-summary",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Option<string> tag = response->headers.get("ETag");
+  ASSERT_SOME(tag);
+
+  process::http::Headers headers = createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+  headers["If-None-Match"] = tag.get();
+
+  response = process::http::get(
+      master.get()->pid,
+      "state-summary",
+      None(),
+      headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(notModified, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(tag.get(), "ETag", response);
+
+  response = process::http::get(
+      master.get()->pid,
+      "state-summary",
+      "since=" + strings::trim(tag.get(), "\""),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(notModified, response);
+
+  // Registering an agent changes the summary.
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  response = process::http::get(
+      master.get()->pid,
+      "state-summary",
+      None(),
+      headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  EXPECT_NE(tag, response->headers.get("ETag"));
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> slaves = parse->find<JSON::Array>("slaves");
+  ASSERT_SOME(slaves);
+  EXPECT_EQ(1u, slaves->values.size());
+
+  tag = response->headers.get("ETag");
+  ASSERT_SOME(tag);
+
+  headers["If-None-Match"] = tag.get();
+
+  // Deactivating the agent changes the summary.
+  Future<Nothing> deactivateSlave =
+    FUTURE_DISPATCH(_, &MesosAllocatorProcess::deactivateSlave);
+
+  slave.get()->terminate();
+  slave->reset();
+
+  AWAIT_READY(deactivateSlave);
+
+  response = process::http::get(
+      master.get()->pid,
+      "state-summary",
+      None(),
+      headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  EXPECT_NE(tag, response->headers.get("ETag"));
+
+  parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  EXPECT_SOME_FALSE(parse->find<JSON::Boolean>("slaves[0].active"));
+}
+
+
+// This test verifies that reading the state of the master, e.g., via
+// its other endpoints or its metrics, does not change the tag of the
+// state summary.
+TEST_F(MasterTest, StateSummaryEndpointUnchangedByReads)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // Pause the clock so that no timer changes the state meanwhile.
+  Clock::pause();
+  Clock::settle();
+
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "state-summary",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Option<string> tag = response->headers.get("ETag");
+  ASSERT_SOME(tag);
+
+  Metrics();
+
+  foreach (const string& endpoint,
+           vector<string>({"state", "frameworks", "slaves", "tasks"})) {
+    response = process::http::get(
+        master.get()->pid,
+        endpoint,
+        None(),
+        createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  }
+
+  response = process::http::get(master.get()->pid, "health");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  process::http::Headers headers = createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+  headers["If-None-Match"] = tag.get();
+
+  response = process::http::get(
+      master.get()->pid,
+      "state-summary",
+      None(),
+      headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      process::http::Status::string(process::http::Status::NOT_MODIFIED),
+      response);
+
+  Clock::resume();
+}
+
+
+// This test verifies that the state summary reflects the changes to
+// frameworks, offers and tasks, and that each change changes its tag.
+TEST_F(MasterTest, StateSummaryEndpointTracksTasks)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), &containerizer);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  Option<string> tag;
+
+  // Returns the state summary after checking that it has changed.
+  auto stateSummary = [&master, &tag]() -> Try<JSON::Object> {
+    Future<Response> response = process::http::get(
+        master.get()->pid,
+        "state-summary",
+        None(),
+        createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+    response.await(Seconds(15));
+
+    if (!response.isReady() || response->status != OK().status) {
+      return Error("Failed to get the state summary");
+    }
+
+    if (response->headers.get("ETag") == tag) {
+      return Error("The tag of the state summary did not change");
+    }
+
+    tag = response->headers.get("ETag");
+
+    return JSON::parse<JSON::Object>(response->body);
+  };
+
+  Try<JSON::Object> state = stateSummary();
+  ASSERT_SOME(state);
+
+  EXPECT_SOME_EQ(0u, state->find<JSON::Number>("slaves[0].TASK_RUNNING"));
+
+  // Registering a framework, which is then offered resources.
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_FALSE(offers->empty());
+
+  state = stateSummary();
+  ASSERT_SOME(state);
+
+  Result<JSON::Array> frameworks = state->find<JSON::Array>("frameworks");
+  ASSERT_SOME(frameworks);
+  EXPECT_EQ(1u, frameworks->values.size());
+
+  EXPECT_SOME(
+      state->find<JSON::Number>("frameworks[0].offered_resources.cpus"));
+
+  // Launching a task.
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status->state());
+
+  state = stateSummary();
+  ASSERT_SOME(state);
+
+  EXPECT_SOME_EQ(1u, state->find<JSON::Number>("slaves[0].TASK_RUNNING"));
+  EXPECT_SOME_EQ(1u, state->find<JSON::Number>("frameworks[0].TASK_RUNNING"));
+
+  Result<JSON::Array> frameworkIds =
+    state->find<JSON::Array>("slaves[0].framework_ids");
+  ASSERT_SOME(frameworkIds);
+  EXPECT_EQ(1u, frameworkIds->values.size());
+
+  Result<JSON::Array> slaveIds =
+    state->find<JSON::Array>("frameworks[0].slave_ids");
+  ASSERT_SOME(slaveIds);
+  EXPECT_EQ(1u, slaveIds->values.size());
+
+  // Killing the task.
+  EXPECT_CALL(exec, killTask(_, _))
+    .WillOnce(SendStatusUpdateFromTaskID(TASK_KILLED));
+
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.killTask(task.task_id());
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_KILLED, status->state());
+
+  state = stateSummary();
+  ASSERT_SOME(state);
+
+  EXPECT_SOME_EQ(0u, state->find<JSON::Number>("slaves[0].TASK_RUNNING"));
+  EXPECT_SOME_EQ(1u, state->find<JSON::Number>("slaves[0].TASK_KILLED"));
+  EXPECT_SOME_EQ(0u, state->find<JSON::Number>("frameworks[0].TASK_RUNNING"));
+  EXPECT_SOME_EQ(1u, state->find<JSON::Number>("frameworks[0].TASK_KILLED"));
+
+  // Tearing down the framework.
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  Future<Nothing> removeFramework =
+    FUTURE_DISPATCH(_, &MesosAllocatorProcess::removeFramework);
+
+  driver.stop();
+  driver.join();
+
+  AWAIT_READY(removeFramework);
+
+  state = stateSummary();
+  ASSERT_SOME(state);
+
+  frameworks = state->find<JSON::Array>("frameworks");
+  ASSERT_SOME(frameworks);
+  EXPECT_TRUE(frameworks->values.empty());
+
+  EXPECT_SOME_EQ(0u, state->find<JSON::Number>("slaves[0].TASK_KILLED"));
+
+  frameworkIds = state->find<JSON::Array>("slaves[0].framework_ids");
+  ASSERT_SOME(frameworkIds);
+  EXPECT_TRUE(frameworkIds->values.empty());
+}
+
+
 // This test verifies that executor labels are
 // exposed in the master's state endpoint.
 TEST_F(MasterTest, ExecutorLabels)
@@ -343,6 +343,21 @@ Try<Owned<cluster::Slave>> MesosTest::StartSlave(
 }
 
 
+Try<Owned<cluster::Slave>> MesosTest::StartSlave(
+    MasterDetector* detector,
+    slave::Containerizer* containerizer,
+    slave::GarbageCollector* gc,
+    const Option<slave::Flags>& flags)
+{
+  return cluster::Slave::start(
+      detector,
+      flags.isNone() ? CreateSlaveFlags() : flags.get(),
+      None(),
+      containerizer,
+      gc);
+}
+
+
 Try<Owned<cluster::Slave>> MesosTest::StartSlave(
     MasterDetector* detector,
     mesos::slave::ResourceEstimator* resourceEstimator,
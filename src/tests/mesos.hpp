@@ -179,6 +179,14 @@ protected:
       slave::GarbageCollector* gc,
       const Option<slave::Flags>& flags = None());
 
+  // Starts a slave with the specified detector, containerizer, GC,
+  // and flags.
+  virtual Try<process::Owned<cluster::Slave>> StartSlave(
+      mesos::master::detector::MasterDetector* detector,
+      slave::Containerizer* containerizer,
+      slave::GarbageCollector* gc,
+      const Option<slave::Flags>& flags = None());
+
   // Starts a slave with the specified detector, resource estimator, and flags.
   virtual Try<process::Owned<cluster::Slave>> StartSlave(
       mesos::master::detector::MasterDetector* detector,
@@ -1333,6 +1341,10 @@ public:
   MockAuthorizer();
   virtual ~MockAuthorizer();
 
+  // NOTE: Batches of requests are (by default) broken down into
+  // calls to the mocked `authorized()` for each request.
+  using Authorizer::authorized;
+
   MOCK_METHOD1(
       authorized, process::Future<bool>(const authorization::Request& request));
 
@@ -15,7 +15,9 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
+#include <list>
 #include <map>
 #include <set>
 #include <string>
@@ -33,12 +35,14 @@
 #include <mesos/state/storage.hpp>
 
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
 #include <stout/bytes.hpp>
+#include <stout/json.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/uuid.hpp>
 
@@ -69,6 +73,7 @@ using mesos::internal::log::Replica;
 
 using std::cout;
 using std::endl;
+using std::list;
 using std::map;
 using std::set;
 using std::string;
@@ -116,6 +121,7 @@ using mesos::http::authentication::BasicAuthenticatorFactory;
 using mesos::state::LogStorage;
 using mesos::state::Storage;
 using mesos::state::protobuf::State;
+using mesos::state::protobuf::Variable;
 
 using state::Entry;
 
@@ -1044,9 +1050,209 @@ TEST_P(RegistrarTest, Bootstrap)
 }
 
 
+// Tests that the operations appended to the registrar's operation
+// log are replayed on recovery, with and without snapshots in between,
+// and that a registrar without the operation log folds them into the
+// registry.
+TEST_P(RegistrarTest, OperationLog)
+{
+  flags.registry_operation_log = true;
+  flags.registry_operations_between_snapshots = 2;
+
+  SlaveInfo info1 = slave;
+
+  SlaveInfo info2 = slave;
+  info2.mutable_id()->set_value("2");
+
+  SlaveInfo info3 = slave;
+  info3.mutable_id()->set_value("3");
+
+  QuotaInfo quotaInfo;
+  quotaInfo.set_role("role1");
+  quotaInfo.mutable_guarantee()->CopyFrom(Resources::parse("cpus:1").get());
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(info1))));
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(info2))));
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(info3))));
+
+    AWAIT_TRUE(
+        registrar.apply(Owned<Operation>(new MarkSlaveUnreachable(info1))));
+
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new UpdateQuota(quotaInfo))));
+  }
+
+  // The entries since the last snapshot are replayed on recovery.
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(2, registry.get().slaves().slaves().size());
+    EXPECT_EQ(info2, registry.get().slaves().slaves(0).info());
+    EXPECT_EQ(info3, registry.get().slaves().slaves(1).info());
+
+    ASSERT_EQ(1, registry.get().unreachable().slaves().size());
+    EXPECT_EQ(info1.id(), registry.get().unreachable().slaves(0).id());
+
+    ASSERT_EQ(1, registry.get().quotas().size());
+    EXPECT_EQ(quotaInfo.role(), registry.get().quotas(0).info().role());
+    EXPECT_EQ(
+        Resources(quotaInfo.guarantee()),
+        Resources(registry.get().quotas(0).info().guarantee()));
+
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new RemoveSlave(info2))));
+  }
+
+  // Disabling the operation log replays (and folds in) the entries
+  // appended so far.
+  flags.registry_operation_log = false;
+
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(1, registry.get().slaves().slaves().size());
+    EXPECT_EQ(info3, registry.get().slaves().slaves(0).info());
+
+    ASSERT_EQ(1, registry.get().unreachable().slaves().size());
+    ASSERT_EQ(1, registry.get().quotas().size());
+  }
+}
+
+
+// Tests that the operation log is replayed with the strictness the
+// operations were applied with, rather than the current one.
+TEST_P(RegistrarTest, OperationLogStrictness)
+{
+  flags.registry_operation_log = true;
+
+  SlaveInfo info2 = slave;
+  info2.mutable_id()->set_value("2");
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(slave))));
+
+    // Readmitting an unknown agent only admits it if not strict.
+    if (flags.registry_strict) {
+      AWAIT_FALSE(registrar.apply(Owned<Operation>(new ReadmitSlave(info2))));
+    } else {
+      AWAIT_TRUE(registrar.apply(Owned<Operation>(new ReadmitSlave(info2))));
+    }
+  }
+
+  const bool strict = flags.registry_strict;
+  flags.registry_strict = !strict;
+
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    if (strict) {
+      ASSERT_EQ(1, registry.get().slaves().slaves().size());
+      EXPECT_EQ(slave, registry.get().slaves().slaves(0).info());
+    } else {
+      ASSERT_EQ(2, registry.get().slaves().slaves().size());
+      EXPECT_EQ(slave, registry.get().slaves().slaves(0).info());
+      EXPECT_EQ(info2, registry.get().slaves().slaves(1).info());
+    }
+  }
+}
+
+
+// Tests that the registrar appends the operations that arrive while
+// an entry is being appended as separate entries right away, and
+// that recovery only replays the entries up to a missing one (i.e.,
+// one that failed to be appended while the following ones succeeded).
+TEST_P(RegistrarTest, OperationLogPipeline)
+{
+  flags.registry_operation_log = true;
+
+  SlaveInfo info1 = slave;
+
+  SlaveInfo info2 = slave;
+  info2.mutable_id()->set_value("2");
+
+  SlaveInfo info3 = slave;
+  info3.mutable_id()->set_value("3");
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    Future<bool> admit1 =
+      registrar.apply(Owned<Operation>(new AdmitSlave(info1)));
+    Future<bool> admit2 =
+      registrar.apply(Owned<Operation>(new AdmitSlave(info2)));
+    Future<bool> admit3 =
+      registrar.apply(Owned<Operation>(new AdmitSlave(info3)));
+
+    AWAIT_TRUE(admit1);
+    AWAIT_TRUE(admit2);
+    AWAIT_TRUE(admit3);
+  }
+
+  Future<set<string>> names = state->names();
+  AWAIT_READY(names);
+
+  EXPECT_EQ(1u, names.get().count("registry.operations.0"));
+  EXPECT_EQ(1u, names.get().count("registry.operations.1"));
+  EXPECT_EQ(1u, names.get().count("registry.operations.2"));
+
+  // Remove the second entry, as if it failed to be appended.
+  Future<Variable<Registry::Operations>> entry =
+    state->fetch<Registry::Operations>("registry.operations.1");
+  AWAIT_READY(entry);
+  AWAIT_TRUE(state->expunge(entry.get()));
+
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(1, registry.get().slaves().slaves().size());
+    EXPECT_EQ(info1, registry.get().slaves().slaves(0).info());
+
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(info3))));
+  }
+
+  // The ignored entry is not replayed after the new one.
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(2, registry.get().slaves().slaves().size());
+    EXPECT_EQ(info1, registry.get().slaves().slaves(0).info());
+    EXPECT_EQ(info3, registry.get().slaves().slaves(1).info());
+  }
+}
+
+
 class MockStorage : public Storage
 {
 public:
+  MockStorage()
+  {
+    // The registrar lists the operation log entries to replay when it
+    // recovers, there are none by default.
+    EXPECT_CALL(*this, names())
+      .WillRepeatedly(Return(std::set<string>()));
+  }
+
   MOCK_METHOD1(get, Future<Option<Entry>>(const string&));
   MOCK_METHOD2(set, Future<bool>(const Entry&, const UUID&));
   MOCK_METHOD1(expunge, Future<bool>(const Entry&));
@@ -1140,6 +1346,60 @@ TEST_P(RegistrarTest, Abort)
 }
 
 
+// Tests that the '/registry' endpoint does not serve the operations
+// whose entries of the operation log are still being appended, since
+// a failover would lose them.
+TEST_P(RegistrarTest, OperationLogDurableRegistry)
+{
+  flags.registry_operation_log = true;
+
+  MockStorage storage;
+  State state(&storage);
+
+  Registrar registrar(flags, &state);
+
+  EXPECT_CALL(storage, get(_))
+    .WillRepeatedly(Return(None()));
+
+  Promise<bool> promise;
+  Future<Nothing> set;
+  EXPECT_CALL(storage, set(_, _))
+    .WillOnce(Return(Future<bool>(true)))                  // Recovery.
+    .WillOnce(DoAll(FutureSatisfy(&set),
+                    Return(promise.future())));            // Append.
+
+  AWAIT_READY(registrar.recover(master));
+
+  Future<bool> admit =
+    registrar.apply(Owned<Operation>(new AdmitSlave(slave)));
+
+  AWAIT_READY(set);
+
+  Future<Response> response = process::http::get(registrar.pid(), "registry");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+  EXPECT_NONE(parse->find<JSON::Array>("slaves.slaves"));
+
+  EXPECT_TRUE(admit.isPending());
+
+  promise.set(true);
+
+  AWAIT_TRUE(admit);
+
+  response = process::http::get(registrar.pid(), "registry");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> slaves = parse->find<JSON::Array>("slaves.slaves");
+  ASSERT_SOME(slaves);
+  EXPECT_EQ(1u, slaves->values.size());
+}
+
+
 // Tests that requests to the '/registry' endpoint are authenticated when HTTP
 // authentication is enabled.
 TEST_P(RegistrarTest, Authentication)
@@ -1278,6 +1538,133 @@ TEST_P(Registrar_BENCHMARK_Test, Performance)
   cout << "Removed " << slaveCount << " agents in " << watch.elapsed() << endl;
 }
 
+
+// Measures admitting agents one at a time into a registry of the
+// given size, which (unlike in the `Performance` test) prevents the
+// registrar from batching, with and without the operation log.
+TEST_P(Registrar_BENCHMARK_Test, OperationLog)
+{
+  Resources resources =
+    Resources::parse("cpus(*):1.0;mem(*):512;disk(*):2048").get();
+
+  size_t slaveCount = GetParam();
+  size_t admitCount = 1000;
+
+  foreach (bool operationLog, vector<bool>({false, true})) {
+    flags.registry_operation_log = operationLog;
+
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    vector<SlaveInfo> infos;
+    for (size_t i = 0; i < slaveCount + admitCount; ++i) {
+      SlaveInfo info;
+      info.set_hostname("localhost");
+      info.mutable_id()->set_value(
+          string("201310101658-2280333834-5050-48574-") +
+          stringify(operationLog) + "-" + stringify(i));
+      info.mutable_resources()->MergeFrom(resources);
+      infos.push_back(info);
+    }
+
+    // Grow the registry, the registrar batches these.
+    Future<bool> result;
+    for (size_t i = 0; i < slaveCount; ++i) {
+      result = registrar.apply(Owned<Operation>(new AdmitSlave(infos[i])));
+    }
+    AWAIT_READY_FOR(result, Minutes(5));
+
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = slaveCount; i < slaveCount + admitCount; ++i) {
+      AWAIT_TRUE_FOR(
+          registrar.apply(Owned<Operation>(new AdmitSlave(infos[i]))),
+          Minutes(5));
+    }
+
+    cout << "Admitted " << admitCount << " agents one at a time into a"
+         << " registry of " << slaveCount << " agents "
+         << (operationLog ? "with" : "without") << " the operation log in "
+         << watch.elapsed() << endl;
+  }
+}
+
+
+class RegistrarThroughput_BENCHMARK_Test
+  : public RegistrarTestBase,
+    public WithParamInterface<size_t> {};
+
+
+// The Registrar throughput benchmark tests are parameterized by the
+// number of clients applying operations at the same time.
+INSTANTIATE_TEST_CASE_P(
+    ClientCount,
+    RegistrarThroughput_BENCHMARK_Test,
+    ::testing::Values(1U, 10U, 100U));
+
+
+// Measures the throughput of the registrar with the operation log
+// when each client applies its operations one after the other (e.g.,
+// agents registering), with a single and with several outstanding
+// appends (see `--registry_max_outstanding_appends`).
+TEST_P(RegistrarThroughput_BENCHMARK_Test, OperationLog)
+{
+  flags.registry_operation_log = true;
+
+  size_t clientCount = GetParam();
+  size_t operationCount = 1000;
+
+  Resources resources =
+    Resources::parse("cpus(*):1.0;mem(*):512;disk(*):2048").get();
+
+  foreach (size_t outstanding,
+           vector<size_t>({1U, DEFAULT_REGISTRY_MAX_OUTSTANDING_APPENDS})) {
+    flags.registry_max_outstanding_appends = outstanding;
+
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    // Admits the agents of a client one at a time.
+    std::function<Future<Nothing>(size_t, size_t)> admit =
+      [&](size_t client, size_t i) -> Future<Nothing> {
+        if (i == operationCount / clientCount) {
+          return Nothing();
+        }
+
+        SlaveInfo info;
+        info.set_hostname("localhost");
+        info.mutable_id()->set_value(
+            string("201310101658-2280333834-5050-48574-") +
+            stringify(outstanding) + "-" + stringify(client) + "-" +
+            stringify(i));
+        info.mutable_resources()->MergeFrom(resources);
+
+        return registrar.apply(Owned<Operation>(new AdmitSlave(info)))
+          .then([&admit, client, i]() {
+            return admit(client, i + 1);
+          });
+      };
+
+    Stopwatch watch;
+    watch.start();
+
+    list<Future<Nothing>> clients;
+    for (size_t client = 0; client < clientCount; ++client) {
+      clients.push_back(admit(client, 0));
+    }
+
+    AWAIT_READY_FOR(collect(clients), Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Applied " << operationCount << " operations from "
+         << clientCount << " clients with " << outstanding
+         << " outstanding appends in " << elapsed << " ("
+         << operationCount / elapsed.secs() << " operations/sec)" << endl;
+  }
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -19,6 +19,7 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 
 #include <gtest/gtest.h>
 
@@ -1122,6 +1123,106 @@ TEST(ResourcesTest, ScalarSubtraction2)
 }
 
 
+// Tests that plain scalar quantities (i.e., unreserved, non-revocable,
+// non-shared scalars without DiskInfo) are only combined with the
+// same plain quantities, and never with other resources of the same
+// name.
+TEST(ResourcesTest, ScalarPlainQuantities)
+{
+  Resources plain = Resources::parse("cpus:1;mem:10").get();
+
+  EXPECT_EQ(
+      Resources::parse("cpus:3;mem:10").get(),
+      plain + Resources::parse("cpus:2").get());
+
+  EXPECT_EQ(
+      Resources::parse("mem:10").get(),
+      plain - Resources::parse("cpus:1").get());
+
+  EXPECT_TRUE(plain.contains(Resources::parse("cpus:0.5;mem:10").get()));
+  EXPECT_FALSE(plain.contains(Resources::parse("cpus:1.5").get()));
+  EXPECT_FALSE(plain.contains(Resources::parse("disk:1").get()));
+
+  // Reserved resources.
+  Resources reserved = Resources::parse("cpus(role):1").get();
+
+  Resources resources = plain + reserved;
+  EXPECT_EQ(3u, resources.size());
+  EXPECT_TRUE(resources.contains(reserved));
+  EXPECT_FALSE(resources.contains(Resources::parse("cpus:2").get()));
+  EXPECT_FALSE(plain.contains(reserved));
+  EXPECT_FALSE(reserved.contains(Resources::parse("cpus:1").get()));
+  EXPECT_EQ(plain, resources - reserved);
+  EXPECT_EQ(resources, resources - Resources::parse("cpus(role2):1").get());
+
+  // Flattening recomputes whether the resources are plain quantities.
+  Resources flattened = plain.flatten("role").get();
+  EXPECT_EQ(4u, (plain + flattened).size());
+  EXPECT_FALSE(flattened.contains(Resources::parse("cpus:1").get()));
+  EXPECT_EQ(plain, flattened.flatten());
+  EXPECT_EQ(plain + plain, plain + flattened.flatten());
+
+  // Revocable resources.
+  Resource revocable = Resources::parse("cpus", "1", "*").get();
+  revocable.mutable_revocable();
+
+  resources = plain + revocable;
+  EXPECT_EQ(3u, resources.size());
+  EXPECT_FALSE(resources.contains(Resources::parse("cpus:2").get()));
+  EXPECT_EQ(plain, resources - revocable);
+  EXPECT_EQ(Resources(revocable), resources - plain);
+
+  // Resources with DiskInfo.
+  Resource mount =
+    createDiskResource("10", "*", None(), None(), createDiskSourceMount("mnt"));
+
+  resources = Resources::parse("disk:10").get() + mount;
+  EXPECT_EQ(2u, resources.size());
+  EXPECT_FALSE(resources.contains(Resources::parse("disk:20").get()));
+  EXPECT_EQ(Resources(mount), resources - Resources::parse("disk:10").get());
+}
+
+
+// Tests that resource names interned concurrently are consistent
+// across threads.
+TEST(ResourcesTest, ScalarPlainQuantitiesConcurrently)
+{
+  const size_t threadCount = 8;
+  const size_t nameCount = 100;
+
+  vector<Resources> results(threadCount);
+  vector<std::thread> threads;
+
+  for (size_t i = 0; i < threadCount; i++) {
+    threads.emplace_back([i, &results]() {
+      for (size_t j = 0; j < nameCount; j++) {
+        results[i] += Resources::parse(
+            "concurrent" + stringify(j), "1", "*").get();
+      }
+    });
+  }
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+
+  Resources expected;
+  for (size_t j = 0; j < nameCount; j++) {
+    expected += Resources::parse(
+        "concurrent" + stringify(j), stringify(threadCount), "*").get();
+  }
+
+  Resources total;
+  foreach (const Resources& result, results) {
+    EXPECT_EQ(nameCount, result.size());
+    total += result;
+  }
+
+  EXPECT_EQ(nameCount, total.size());
+  EXPECT_EQ(expected, total);
+}
+
+
 TEST(ResourcesTest, RangesEquals)
 {
   Resource ports1 = Resources::parse(
@@ -2893,6 +2994,104 @@ TEST_P(Resources_BENCHMARK_Test, Arithmetic)
   ASSERT_TRUE(total.empty()) << total;
 }
 
+
+TEST_P(Resources_BENCHMARK_Test, Contains)
+{
+  const Resources& resources = GetParam().resources;
+  size_t totalOperations = GetParam().totalOperations;
+
+  Resources total;
+  for (int i = 0; i < 10; i++) {
+    total += resources;
+  }
+
+  Stopwatch watch;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    ASSERT_TRUE(total.contains(resources));
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed()
+       << " to perform " << totalOperations << " 'total.contains(r)' operations"
+       << " on " << abbreviate(stringify(resources), 50) << endl;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    ASSERT_EQ(resources, resources);
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed()
+       << " to perform " << totalOperations << " 'r == r' operations"
+       << " on " << abbreviate(stringify(resources), 50) << endl;
+}
+
+
+class Resources_Agent_BENCHMARK_Test
+  : public ::testing::Test,
+    public ::testing::WithParamInterface<size_t> {};
+
+
+// The agent benchmark is parameterized by the number of agents.
+INSTANTIATE_TEST_CASE_P(
+    AgentCount,
+    Resources_Agent_BENCHMARK_Test,
+    ::testing::Values(1000U, 5000U, 10000U));
+
+
+// Mimics the resource arithmetic of an allocation cycle: each agent
+// is packed with small tasks by repeatedly checking whether the task
+// fits into what is still available and then subtracting it, which
+// is dominated by the plain scalar quantities on typical agents.
+TEST_P(Resources_Agent_BENCHMARK_Test, PackTasks)
+{
+  size_t agentCount = GetParam();
+
+  const Resources agent = Resources::parse(
+      "cpus:32;mem:131072;disk:1048576;ports:[31000-32000]").get();
+
+  const Resources task = Resources::parse("cpus:0.5;mem:512;disk:1024").get();
+
+  vector<Resources> available(agentCount, agent);
+
+  size_t tasks = 0;
+  Resources allocated;
+
+  Stopwatch watch;
+  watch.start();
+
+  foreach (Resources& resources, available) {
+    while (resources.contains(task)) {
+      resources -= task;
+      allocated += task;
+      tasks++;
+    }
+  }
+
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to pack " << tasks << " tasks"
+       << " onto " << agentCount << " agents" << endl;
+
+  watch.start();
+
+  foreach (Resources& resources, available) {
+    while (allocated.contains(task) && agent.contains(resources + task)) {
+      resources += task;
+      allocated -= task;
+    }
+  }
+
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to unpack " << tasks << " tasks"
+       << " from " << agentCount << " agents" << endl;
+
+  EXPECT_TRUE(allocated.empty()) << allocated;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
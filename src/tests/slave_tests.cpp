@@ -88,6 +88,7 @@ using process::PID;
 using process::Promise;
 using process::UPID;
 
+using process::http::BadRequest;
 using process::http::InternalServerError;
 using process::http::OK;
 using process::http::Response;
@@ -2008,6 +2009,134 @@ TEST_F(SlaveTest, StatisticsEndpointRunningExecutor)
 }
 
 
+// This test verifies that the /monitor/statistics endpoint is served
+// from the sampled resource statistics when sampling is enabled, and
+// that the 'since' parameter only returns the newer samples.
+TEST_F(SlaveTest, StatisticsEndpointSampledUsage)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.statistics_sampling_interval = Seconds(1);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return());        // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_FALSE(offers.get().empty());
+
+  const Offer& offer = offers.get()[0];
+
+  TaskInfo task = createTask(
+      offer.slave_id(),
+      Resources::parse("cpus:1;mem:32").get(),
+      "sleep 1000");
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offer.id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  // Make sure that the running container has been sampled. The clock
+  // stays paused so that no newer sample is taken afterwards. We
+  // align it to a whole second first, so that the timestamps of the
+  // samples are represented exactly in the JSON responses.
+  Clock::pause();
+  Clock::advance(
+      Seconds(1) - Nanoseconds(Clock::now().duration().ns() % Seconds(1).ns()));
+  Clock::advance(flags.statistics_sampling_interval.get());
+  Clock::settle();
+
+  Future<Response> response = process::http::get(
+      slave.get()->pid,
+      "monitor/statistics",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Array> samples = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(samples);
+  ASSERT_EQ(1u, samples.get().values.size());
+
+  Result<JSON::Number> timestamp = samples.get().values[0]
+    .as<JSON::Object>().find<JSON::Number>("statistics.timestamp");
+  ASSERT_SOME(timestamp);
+
+  // There is no sample newer than the most recent one, while the most
+  // recent one is newer than anything before its timestamp.
+  response = process::http::get(
+      slave.get()->pid,
+      "monitor/statistics",
+      strings::format("since=%f", timestamp.get().as<double>()).get(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("[]", response);
+
+  response = process::http::get(
+      slave.get()->pid,
+      "monitor/statistics",
+      strings::format("since=%f", timestamp.get().as<double>() - 1e-6).get(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  samples = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(samples);
+  ASSERT_EQ(1u, samples.get().values.size());
+
+  Result<JSON::Number> newer = samples.get().values[0]
+    .as<JSON::Object>().find<JSON::Number>("statistics.timestamp");
+  ASSERT_SOME(newer);
+  EXPECT_EQ(timestamp.get().as<double>(), newer.get().as<double>());
+
+  response = process::http::get(
+      slave.get()->pid,
+      "monitor/statistics",
+      "since=0",
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  samples = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(samples);
+  EXPECT_LE(1u, samples.get().values.size());
+
+  response = process::http::get(
+      slave.get()->pid,
+      "monitor/statistics",
+      "since=foo",
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, response);
+
+  Clock::resume();
+
+  driver.stop();
+  driver.join();
+}
+
+
 // This test confirms that an agent's statistics endpoint is
 // authenticated. We rely on the agent implicitly having HTTP
 // authentication enabled.
@@ -42,6 +42,31 @@ using std::vector;
 
 namespace mesos {
 namespace internal {
+namespace master {
+namespace allocator {
+
+// Compares the clients returned by `Sorter::sort()` with the expected
+// names in sort order. NOTE: This is declared in the namespace of
+// `Sorter::Clients` so that `EXPECT_EQ` finds it.
+static bool operator==(
+    const vector<string>& names,
+    const Sorter::Clients& clients)
+{
+  Sorter::Clients::const_iterator client = clients.begin();
+
+  for (auto name = names.begin(); name != names.end(); ++name, ++client) {
+    if (client == clients.end() || *client != *name) {
+      return false;
+    }
+  }
+
+  return client == clients.end();
+}
+
+} // namespace allocator {
+} // namespace master {
+
+
 namespace tests {
 
 
@@ -485,6 +510,73 @@ TEST(SorterTest, RevocableResources)
 }
 
 
+// This test verifies that the clients returned by sort() can be
+// iterated while allocating to them, and that the allocations are
+// reflected by the next sort().
+TEST(SorterTest, AllocateWhileIterating)
+{
+  DRFSorter sorter;
+
+  SlaveID slaveId;
+  slaveId.set_value("agentId");
+
+  sorter.add(slaveId, Resources::parse("cpus:100;mem:100").get());
+
+  sorter.add("a");
+  sorter.add("b");
+  sorter.add("c");
+
+  sorter.allocated("a", slaveId, Resources::parse("cpus:3;mem:3").get());
+  sorter.allocated("b", slaveId, Resources::parse("cpus:2;mem:2").get());
+  sorter.allocated("c", slaveId, Resources::parse("cpus:1;mem:1").get());
+
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), sorter.sort());
+
+  // Allocating to a client moves it to the end of the sort order, but
+  // not while iterating over the current sort order.
+  vector<string> visited;
+  foreach (const string& client, sorter.sort()) {
+    visited.push_back(client);
+    sorter.allocated(client, slaveId, Resources::parse("cpus:5;mem:5").get());
+  }
+
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), visited);
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), sorter.sort());
+
+  // Changing the total resources while iterating does not change
+  // the current sort order either.
+  SlaveID slaveId2;
+  slaveId2.set_value("agentId2");
+
+  visited.clear();
+  foreach (const string& client, sorter.sort()) {
+    visited.push_back(client);
+
+    if (client == "c") {
+      sorter.add(slaveId2, Resources::parse("cpus:100;mem:100").get());
+    }
+  }
+
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), visited);
+
+  sorter.remove(slaveId2, Resources::parse("cpus:100;mem:100").get());
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), sorter.sort());
+
+  // An allocation that does not change the order.
+  sorter.allocated("c", slaveId, Resources::parse("cpus:0.5;mem:0.5").get());
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), sorter.sort());
+
+  sorter.allocated("c", slaveId, Resources::parse("cpus:2;mem:2").get());
+  EXPECT_EQ(vector<string>({"b", "a", "c"}), sorter.sort());
+
+  sorter.deactivate("a");
+  EXPECT_EQ(vector<string>({"b", "c"}), sorter.sort());
+
+  sorter.unallocated("b", slaveId, Resources::parse("cpus:7;mem:7").get());
+  EXPECT_EQ(vector<string>({"b", "c"}), sorter.sort());
+}
+
+
 class Sorter_BENCHMARK_Test
   : public ::testing::Test,
     public ::testing::WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
@@ -723,6 +815,87 @@ TEST_P(Sorter_BENCHMARK_Test, FullSort)
 }
 
 
+// This benchmark simulates the sorter usage of an allocation cycle:
+// for every agent we sort the clients and allocate the agent to the
+// first client, i.e., every sort follows a change in a single share.
+TEST_P(Sorter_BENCHMARK_Test, AllocationCycle)
+{
+  size_t agentCount = std::tr1::get<0>(GetParam());
+  size_t clientCount = std::tr1::get<1>(GetParam());
+
+  cout << "Using " << agentCount << " agents and "
+       << clientCount << " clients" << endl;
+
+  vector<SlaveID> agents;
+  agents.reserve(agentCount);
+
+  DRFSorter sorter;
+
+  for (size_t i = 0; i < clientCount; i++) {
+    sorter.add(stringify(i));
+  }
+
+  Resources agentResources = Resources::parse(
+      "cpus:24;mem:4096;disk:4096;ports:[31000-32000]").get();
+
+  for (size_t i = 0; i < agentCount; i++) {
+    SlaveID slaveId;
+    slaveId.set_value("agent" + stringify(i));
+
+    agents.push_back(slaveId);
+
+    sorter.add(slaveId, agentResources);
+  }
+
+  // The client that each agent was allocated to.
+  vector<string> owners;
+  owners.reserve(agentCount);
+
+  Stopwatch watch;
+  watch.start();
+
+  {
+    foreach (const SlaveID& slaveId, agents) {
+      // Only the first client is visited since it is allocated the
+      // whole agent ("coarse-grained" allocation).
+      foreach (const string& client, sorter.sort()) {
+        sorter.allocated(client, slaveId, agentResources);
+        owners.push_back(client);
+        break;
+      }
+    }
+  }
+
+  watch.stop();
+
+  ASSERT_EQ(agentCount, owners.size());
+
+  // Since sort() only repositions the clients allocated to since the
+  // previous sort(), the cost per agent should grow logarithmically,
+  // not linearly, with the number of clients.
+  cout << "Allocation cycle of " << agentCount << " agents and "
+       << clientCount << " clients took " << watch.elapsed()
+       << " (" << watch.elapsed() / agentCount << " per agent)" << endl;
+
+  watch.start();
+
+  {
+    // Recover the agents while sorting, as happens when offers are
+    // declined in between allocation cycles.
+    for (size_t i = 0; i < agentCount; i++) {
+      sorter.unallocated(owners[i], agents[i], agentResources);
+      sorter.sort();
+    }
+  }
+
+  watch.stop();
+
+  cout << "Unallocation cycle of " << agentCount << " agents and "
+       << clientCount << " clients took " << watch.elapsed()
+       << " (" << watch.elapsed() / agentCount << " per agent)" << endl;
+}
+
+
 // This test verifies that shared resources are properly accounted for in
 // the DRF sorter.
 TEST(SorterTest, SharedResources)
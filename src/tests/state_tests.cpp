@@ -691,6 +691,86 @@ TEST_F(LogStateTest, Diff)
 }
 
 
+// Tests that a set does not wait for the previous sets to be appended
+// to the log, i.e., that the version is checked against the entries
+// that are still being appended.
+TEST_F(LogStateTest, Pipeline)
+{
+  // Start the writer first so that the sets get appended together.
+  AWAIT_READY(storage->names());
+
+  mesos::internal::state::Entry entry1;
+  entry1.set_name("entry");
+  entry1.set_uuid(UUID::random().toBytes());
+  entry1.set_value("value1");
+
+  mesos::internal::state::Entry entry2 = entry1;
+  entry2.set_uuid(UUID::random().toBytes());
+  entry2.set_value("value2");
+
+  mesos::internal::state::Entry entry3 = entry1;
+  entry3.set_uuid(UUID::random().toBytes());
+  entry3.set_value("value3");
+
+  const UUID uuid1 = UUID::fromBytes(entry1.uuid()).get();
+
+  Future<bool> set1 = storage->set(entry1, UUID::random());
+  Future<bool> set2 = storage->set(entry2, uuid1);
+
+  // The version replaced by the outstanding 'set2'.
+  Future<bool> set3 = storage->set(entry3, uuid1);
+
+  AWAIT_TRUE(set1);
+  AWAIT_TRUE(set2);
+  AWAIT_FALSE(set3);
+
+  Future<Option<mesos::internal::state::Entry>> entry = storage->get("entry");
+  AWAIT_READY(entry);
+  ASSERT_SOME(entry.get());
+  EXPECT_EQ("value2", entry.get().get().value());
+}
+
+
+// Tests that the sets queued behind a failed append fail as well,
+// since they were based on its entry.
+TEST_F(LogStateTest, PipelineFailure)
+{
+  AWAIT_READY(storage->names());
+
+  mesos::internal::state::Entry entry1;
+  entry1.set_name("entry");
+  entry1.set_uuid(UUID::random().toBytes());
+  entry1.set_value("value1");
+
+  mesos::internal::state::Entry entry2 = entry1;
+  entry2.set_uuid(UUID::random().toBytes());
+  entry2.set_value("value2");
+
+  // Now terminate the replica so the appends can not complete.
+  terminate(replica2->pid());
+  wait(replica2->pid());
+
+  Clock::pause();
+
+  Future<bool> set1 = storage->set(entry1, UUID::random());
+  Future<bool> set2 =
+    storage->set(entry2, UUID::fromBytes(entry1.uuid()).get());
+
+  // Both sets are being appended.
+  Clock::settle();
+
+  ASSERT_TRUE(set1.isPending());
+  ASSERT_TRUE(set2.isPending());
+
+  set1.discard();
+
+  AWAIT_DISCARDED(set1);
+  AWAIT_FAILED(set2);
+
+  Clock::resume();
+}
+
+
 #ifdef MESOS_HAS_JAVA
 class ZooKeeperStateTest : public tests::ZooKeeperTest
 {